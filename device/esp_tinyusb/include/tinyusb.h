@@ -48,13 +48,57 @@ typedef struct {
                                              Ignored when `self_powered` is `false`. */
 } tinyusb_phy_config_t;
 
+/**
+ * @brief Hook invoked by the TinyUSB task around a batch of device events.
+ *
+ * The hook runs in the context of the TinyUSB task, the same context as the
+ * TinyUSB class callbacks.
+ *
+ * @param[in] arg User argument from tinyusb_task_config_t.hook_arg.
+ */
+typedef void (*tinyusb_task_hook_t)(void *arg);
+
+/**
+ * @brief Callback invoked every time TinyUSB queues a device event.
+ *
+ * With CONFIG_TINYUSB_EVENT_HOOK_CALLBACK, esp_tinyusb implements the TinyUSB `tud_event_hook_cb()` callback
+ * and calls this one from it.
+ * The callback may be invoked from an interrupt.
+ *
+ * @param[in] rhport  USB Peripheral hardware port number.
+ * @param[in] eventid TinyUSB device event ID.
+ * @param[in] in_isr  True when called from an interrupt.
+ */
+typedef void (*tinyusb_event_hook_t)(uint8_t rhport, uint32_t eventid, bool in_isr);
+
 /**
  * @brief TinyUSB task configuration.
+ *
+ * Members after `xCoreID` are optional. When all of them are zero, the task runs tud_task()
+ * in a loop. Otherwise the task runs a batched event loop: it sleeps until an event is queued
+ * or `idle_timeout_ms` expires, drains the event queue up to `drain_passes` times and calls
+ * `post_hook`. The optional members require CONFIG_TINYUSB_EVENT_HOOK_CALLBACK.
  */
 typedef struct {
     size_t size;                             /*!< USB device task stack size in bytes. */
     uint8_t priority;                        /*!< USB device task priority. */
     int xCoreID;                             /*!< USB device task core affinity. */
+    uint32_t idle_timeout_ms;                /*!< Maximum time in ms the task sleeps while there are no events.
+                                                  0 sleeps until the next event. When the timeout expires,
+                                                  `post_hook` is called without any handled events. */
+    uint8_t drain_passes;                    /*!< Maximum number of times the event queue is drained per wake-up.
+                                                  A pass handles events until the queue is empty, including events
+                                                  queued while it runs, so it does not limit the number of events
+                                                  handled before `post_hook`. Further passes only run for events
+                                                  queued after the previous pass emptied the queue. 0 means one pass. */
+    tinyusb_task_hook_t pre_hook;            /*!< Optional hook, called before the task sleeps waiting for the next events. */
+    tinyusb_task_hook_t post_hook;           /*!< Optional hook, called after a batch of events was handled.
+                                                  Use it to process the data of several class callbacks together. */
+    void *hook_arg;                          /*!< User argument passed to `pre_hook` and `post_hook`. */
+    tinyusb_event_hook_t event_hook;         /*!< Optional callback, called every time an event is queued. Replaces
+                                                  the TinyUSB `tud_event_hook_cb()`, which is implemented by esp_tinyusb
+                                                  with CONFIG_TINYUSB_EVENT_HOOK_CALLBACK.
+                                                  Does not enable the batched event loop. */
 } tinyusb_task_config_t;
 
 /**
@@ -139,6 +183,7 @@ typedef struct {
  *      - ESP_OK on success
  *      - ESP_ERR_INVALID_ARG if `config` is NULL or contains unsupported port or task settings
  *      - ESP_ERR_INVALID_STATE if the TinyUSB device task is already running
+ *      - ESP_ERR_NOT_SUPPORTED if the batched event loop or `event_hook` is configured without CONFIG_TINYUSB_EVENT_HOOK_CALLBACK
  *      - ESP_ERR_NO_MEM if memory allocation fails during startup
  *      - Other error codes from TinyUSB task startup, USB PHY setup, or descriptor setup
  */
@@ -21,6 +21,7 @@ extern "C" {
  * @param task_cfg TinyUSB Task configuration
  * @retval
  *   - ESP_ERR_INVALID_ARG if task_cfg is NULL, size is 0, priority is 0 or affinity is invalid
+ *   - ESP_ERR_NOT_SUPPORTED if the batched event loop or the event hook is configured without CONFIG_TINYUSB_EVENT_HOOK_CALLBACK
  *   - ESP_OK if task_cfg is valid
  */
 esp_err_t tinyusb_task_check_config(const tinyusb_task_config_t *task_cfg);
@@ -25,6 +25,7 @@
 #include "test_task.h"
 #include "sdkconfig.h"
 #include "device_handling.h"
+#include "device/usbd_pvt.h"
 
 // ============================= Tests =========================================
 
@@ -101,4 +102,174 @@ TEST_CASE("Task: Default configuration, pin to CPU1", "[task][default]")
 }
 #endif // CONFIG_FREERTOS_UNICORE
 
+static volatile unsigned int test_event_hook_calls;
+
+// Called from tud_event_hook_cb(), possibly from an interrupt
+static void test_event_hook(uint8_t rhport, uint32_t eventid, bool in_isr)
+{
+    (void) rhport;
+    (void) eventid;
+    (void) in_isr;
+    test_event_hook_calls++;
+}
+
+/**
+ * @brief TinyUSB Task specific testcase
+ *
+ * Scenario: Initialise with Internal task and the event hook
+ * Awaiting: Install returns ESP_OK, device is enumerated, the event hook is called without the batched event loop
+ */
+TEST_CASE("Task: Default configuration, event hook", "[task][default]")
+{
+    test_event_hook_calls = 0;
+    // TinyUSB driver default configuration
+    tinyusb_config_t tusb_cfg = TINYUSB_DEFAULT_CONFIG(test_device_event_handler);
+    tusb_cfg.task.event_hook = test_event_hook;
+    // Install TinyUSB driver
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_driver_install(&tusb_cfg));
+    test_device_wait();
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_driver_uninstall());
+    // Enumeration queues at least the bus reset and the setup packets
+    TEST_ASSERT_GREATER_THAN(0, test_event_hook_calls);
+}
+
+static volatile unsigned int test_pre_hook_calls;
+static volatile unsigned int test_post_hook_calls;
+static void *volatile test_hook_arg;
+static volatile bool test_hold_armed;
+static SemaphoreHandle_t test_hold_sem;
+static SemaphoreHandle_t test_held_sem;
+
+// Hooks run in the TinyUSB task, the results are checked by the test case
+static void test_pre_hook(void *arg)
+{
+    test_hook_arg = arg;
+    test_pre_hook_calls++;
+    if (test_hold_armed) {
+        // Hold the TinyUSB task once before it waits for events, the test queues events meanwhile
+        test_hold_armed = false;
+        xSemaphoreGive(test_held_sem);
+        xSemaphoreTake(test_hold_sem, portMAX_DELAY);
+    }
+}
+
+static void test_post_hook(void *arg)
+{
+    test_hook_arg = arg;
+    test_post_hook_calls++;
+}
+
+/**
+ * @brief TinyUSB Task specific testcase
+ *
+ * Scenario: Initialise with Internal task in batched mode
+ * Awaiting: Install returns ESP_OK, device is enumerated, tusb_mount_cb() is called, hooks are called around every batch
+ */
+TEST_CASE("Task: Batched event loop", "[task][default]")
+{
+    test_pre_hook_calls = 0;
+    test_post_hook_calls = 0;
+    test_hook_arg = NULL;
+    // TinyUSB driver default configuration
+    tinyusb_config_t tusb_cfg = TINYUSB_DEFAULT_CONFIG(test_device_event_handler);
+    tusb_cfg.task.idle_timeout_ms = 10;
+    tusb_cfg.task.drain_passes = 4;
+    tusb_cfg.task.pre_hook = test_pre_hook;
+    tusb_cfg.task.post_hook = test_post_hook;
+    tusb_cfg.task.hook_arg = &tusb_cfg;
+    // Install TinyUSB driver
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_driver_install(&tusb_cfg));
+    test_device_wait();
+    // Idle timeout wakes up the task even without events
+    const unsigned int post_hook_calls = test_post_hook_calls;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_driver_uninstall());
+    TEST_ASSERT_EQUAL_PTR(&tusb_cfg, test_hook_arg);
+    TEST_ASSERT_GREATER_THAN(post_hook_calls, test_post_hook_calls);
+    // Every batch starts with the pre hook and ends with the post hook
+    TEST_ASSERT_UINT_WITHIN(1, test_pre_hook_calls, test_post_hook_calls);
+}
+
+#define TEST_DEFERRED_QUEUED    4   // Deferred calls queued while the TinyUSB task is held
+#define TEST_DEFERRED_CHAINED   4   // Deferred calls queued one by one from the deferred calls
+
+static volatile unsigned int test_deferred_calls;
+static volatile unsigned int test_deferred_chained;
+static volatile unsigned int test_deferred_first_batch;
+static volatile unsigned int test_deferred_last_batch;
+
+// Deferred function call, only wakes up the TinyUSB task
+static void test_wake_func(void *param)
+{
+    (void) param;
+}
+
+// Deferred function call, handled by the TinyUSB task as a device event
+static void test_deferred_func(void *param)
+{
+    if (test_deferred_calls == 0) {
+        test_deferred_first_batch = test_post_hook_calls;
+    }
+    test_deferred_last_batch = test_post_hook_calls;
+    test_deferred_calls++;
+    if (param != NULL && test_deferred_chained < TEST_DEFERRED_CHAINED) {
+        // Queue the next event while the event queue is being drained
+        test_deferred_chained++;
+        usbd_defer_func(test_deferred_func, param, false);
+    }
+}
+
+/**
+ * @brief TinyUSB Task specific testcase
+ *
+ * Scenario: Events are queued while the TinyUSB task is busy in the pre hook
+ * Awaiting: All queued events and events queued while the queue is drained are handled in one batch,
+ *           between the same pre hook and post hook calls
+ */
+TEST_CASE("Task: Batched event loop, events are handled in one batch", "[task][default]")
+{
+    test_pre_hook_calls = 0;
+    test_post_hook_calls = 0;
+    test_deferred_calls = 0;
+    test_deferred_chained = 0;
+    test_hold_armed = false;
+    test_hold_sem = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(test_hold_sem);
+    test_held_sem = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(test_held_sem);
+    // TinyUSB driver default configuration
+    tinyusb_config_t tusb_cfg = TINYUSB_DEFAULT_CONFIG(test_device_event_handler);
+    tusb_cfg.task.drain_passes = 1;
+    tusb_cfg.task.pre_hook = test_pre_hook;
+    tusb_cfg.task.post_hook = test_post_hook;
+    // Install TinyUSB driver
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_driver_install(&tusb_cfg));
+    test_device_wait();
+
+    // Hold the TinyUSB task in the next pre hook. Without idle timeout it sleeps until the next event, wake it up
+    test_hold_armed = true;
+    usbd_defer_func(test_wake_func, NULL, false);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(test_held_sem, pdMS_TO_TICKS(1000)));
+    const unsigned int batch = test_post_hook_calls;
+    for (int i = 0; i < TEST_DEFERRED_QUEUED - 1; i++) {
+        usbd_defer_func(test_deferred_func, NULL, false);
+    }
+    usbd_defer_func(test_deferred_func, (void *)&test_deferred_chained, false);
+    // Release the TinyUSB task
+    xSemaphoreGive(test_hold_sem);
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    TEST_ASSERT_EQUAL(TEST_DEFERRED_QUEUED + TEST_DEFERRED_CHAINED, test_deferred_calls);
+    // One pass handled the queued events and the events queued during the pass, before the post hook
+    TEST_ASSERT_EQUAL(batch, test_deferred_first_batch);
+    TEST_ASSERT_EQUAL(batch, test_deferred_last_batch);
+    TEST_ASSERT_GREATER_THAN(batch, test_post_hook_calls);
+
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_driver_uninstall());
+    vSemaphoreDelete(test_hold_sem);
+    vSemaphoreDelete(test_held_sem);
+    test_hold_sem = NULL;
+    test_held_sem = NULL;
+}
+
 #endif // SOC_USB_OTG_SUPPORTED
@@ -23,6 +23,8 @@ const static char *TAG = "tinyusb_task";
 static portMUX_TYPE tusb_task_lock = portMUX_INITIALIZER_UNLOCKED;
 #define TINYUSB_TASK_ENTER_CRITICAL()    portENTER_CRITICAL(&tusb_task_lock)
 #define TINYUSB_TASK_EXIT_CRITICAL()     portEXIT_CRITICAL(&tusb_task_lock)
+#define TINYUSB_TASK_ENTER_CRITICAL_SAFE()    portENTER_CRITICAL_SAFE(&tusb_task_lock)
+#define TINYUSB_TASK_EXIT_CRITICAL_SAFE()     portEXIT_CRITICAL_SAFE(&tusb_task_lock)
 
 #define TINYUSB_TASK_CHECK(cond, ret_val) ({                \
     if (!(cond)) {                                          \
@@ -43,6 +45,13 @@ typedef struct {
     uint8_t rhport;                         /*!< USB Peripheral hardware port number. Available when hardware has several available peripherals. */
     tusb_rhport_init_t rhport_init;         /*!< USB Device RH port initialization configuration pointer */
     const tinyusb_desc_config_t *desc_cfg;  /*!< USB Device descriptors configuration pointer */
+    // Batched event loop
+    bool batched;                           /*!< Batched event loop is used instead of tud_task() */
+    TickType_t idle_ticks;                  /*!< Maximum time to sleep without events */
+    uint8_t drain_passes;                   /*!< Maximum number of times the event queue is drained per wake-up */
+    tinyusb_task_hook_t pre_hook;           /*!< Hook, called before the task sleeps */
+    tinyusb_task_hook_t post_hook;          /*!< Hook, called after a batch of events */
+    void *hook_arg;                         /*!< Hooks argument */
     // Task related
     TaskHandle_t handle;                    /*!< Task handle */
     volatile TaskHandle_t awaiting_handle;           /*!< Task handle, waiting to be notified after successful start of TinyUSB stack */
@@ -50,6 +59,66 @@ typedef struct {
 
 static bool _task_is_running = false;               // Locking flag for the task, access only from the critical section
 static tinyusb_task_ctx_t *p_tusb_task_ctx = NULL;  // TinyUSB task context
+static TaskHandle_t _batched_task_hdl = NULL;       // TinyUSB task to wake up on new events in batched mode, access only from the critical section
+static tinyusb_event_hook_t _event_hook = NULL;     // User callback, called on new events, access only from the critical section
+
+#ifdef CONFIG_TINYUSB_EVENT_HOOK_CALLBACK
+/**
+ * @brief TinyUSB callback, called every time an event is put to the device event queue
+ *
+ * In batched mode, the TinyUSB task sleeps on its task notification instead of the event queue.
+ * The user callback from the task configuration is called in every mode.
+ */
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr)
+{
+    BaseType_t yield = pdFALSE;
+
+    TINYUSB_TASK_ENTER_CRITICAL_SAFE();
+    if (_batched_task_hdl != NULL) {
+        vTaskNotifyGiveFromISR(_batched_task_hdl, &yield);
+    }
+    tinyusb_event_hook_t event_hook = _event_hook;
+    TINYUSB_TASK_EXIT_CRITICAL_SAFE();
+
+    if (event_hook != NULL) {
+        event_hook(rhport, eventid, in_isr);
+    }
+
+    if (yield == pdTRUE) {
+        if (in_isr) {
+            portYIELD_FROM_ISR();
+        } else {
+            portYIELD();
+        }
+    }
+}
+#endif // CONFIG_TINYUSB_EVENT_HOOK_CALLBACK
+
+/**
+ * @brief Batched event loop of the TinyUSB task
+ *
+ * The task sleeps until an event is queued or the idle timeout expires. Then the event queue is drained
+ * up to drain_passes times and the post hook is called, even if events are still pending.
+ * Every tud_task_ext() call handles events until the queue is empty, the number of events handled in one
+ * pass is not limited.
+ */
+static void tinyusb_device_task_batched(tinyusb_task_ctx_t *task_ctx)
+{
+    while (1) { // RTOS forever loop
+        if (task_ctx->pre_hook) {
+            task_ctx->pre_hook(task_ctx->hook_arg);
+        }
+        if (!tud_task_event_ready()) {
+            ulTaskNotifyTake(pdTRUE, task_ctx->idle_ticks);
+        }
+        for (uint8_t pass = 0; pass < task_ctx->drain_passes && tud_task_event_ready(); pass++) {
+            tud_task_ext(0, false); // Handle events until the queue is empty, without waiting for new ones
+        }
+        if (task_ctx->post_hook) {
+            task_ctx->post_hook(task_ctx->hook_arg);
+        }
+    }
+}
 
 /**
  * @brief This top level thread processes all usb events and invokes callbacks
@@ -80,10 +149,16 @@ static void tinyusb_device_task(void *arg)
     TINYUSB_TASK_ENTER_CRITICAL();
     task_ctx->handle = xTaskGetCurrentTaskHandle(); // Save task handle
     p_tusb_task_ctx = task_ctx;                     // Save global task context pointer
+    if (task_ctx->batched) {
+        _batched_task_hdl = task_ctx->handle;       // Wake up this task on new events
+    }
     TINYUSB_TASK_EXIT_CRITICAL();
 
     xTaskNotifyGive(task_ctx->awaiting_handle);     // Notify parent task that TinyUSB stack was started successfully
 
+    if (task_ctx->batched) {
+        tinyusb_device_task_batched(task_ctx);
+    }
     while (1) { // RTOS forever loop
         tud_task();
     }
@@ -93,6 +168,7 @@ desc_free:
 del:
     TINYUSB_TASK_ENTER_CRITICAL();
     _task_is_running = false;       // Task is not running anymore
+    _event_hook = NULL;
     TINYUSB_TASK_EXIT_CRITICAL();
     vTaskDelete(NULL);
     // No return needed here: vTaskDelete(NULL) does not return
@@ -108,6 +184,12 @@ esp_err_t tinyusb_task_check_config(const tinyusb_task_config_t *config)
 #else
     ESP_RETURN_ON_FALSE(config->xCoreID <= SOC_CPU_CORES_NUM, ESP_ERR_INVALID_ARG, TAG, "Task affinity should be less or equal to CPU amount");
 #endif //
+#ifndef CONFIG_TINYUSB_EVENT_HOOK_CALLBACK
+    // Without tud_event_hook_cb(), the task can't be woken up on new events and the event hook can't be called
+    ESP_RETURN_ON_FALSE(config->idle_timeout_ms == 0 && config->drain_passes == 0 &&
+                        config->pre_hook == NULL && config->post_hook == NULL && config->event_hook == NULL,
+                        ESP_ERR_NOT_SUPPORTED, TAG, "Batched event loop and event hook require CONFIG_TINYUSB_EVENT_HOOK_CALLBACK");
+#endif // CONFIG_TINYUSB_EVENT_HOOK_CALLBACK
     return ESP_OK;
 }
 
@@ -119,6 +201,7 @@ esp_err_t tinyusb_task_start(tinyusb_port_t port, const tinyusb_task_config_t *c
     TINYUSB_TASK_CHECK_FROM_CRIT(p_tusb_task_ctx == NULL, ESP_ERR_INVALID_STATE);     // Task shouldn't started
     TINYUSB_TASK_CHECK_FROM_CRIT(!_task_is_running, ESP_ERR_INVALID_STATE);           // Task shouldn't be running
     _task_is_running = true;                                                          // Task is running flag, will be cleared in task in case of the error
+    _event_hook = config->event_hook;                                                 // Called on events queued since the stack init
     TINYUSB_TASK_EXIT_CRITICAL();
 
     esp_err_t ret;
@@ -138,6 +221,13 @@ esp_err_t tinyusb_task_start(tinyusb_port_t port, const tinyusb_task_config_t *c
     task_ctx->rhport_init.speed = (port == TINYUSB_PORT_FULL_SPEED_0) ? TUSB_SPEED_FULL : TUSB_SPEED_HIGH;
 #endif
     task_ctx->desc_cfg = desc_cfg;
+    task_ctx->batched = (config->idle_timeout_ms != 0) || (config->drain_passes != 0) ||
+                        (config->pre_hook != NULL) || (config->post_hook != NULL);
+    task_ctx->idle_ticks = (config->idle_timeout_ms != 0) ? pdMS_TO_TICKS(config->idle_timeout_ms) : portMAX_DELAY;
+    task_ctx->drain_passes = (config->drain_passes != 0) ? config->drain_passes : 1;
+    task_ctx->pre_hook = config->pre_hook;
+    task_ctx->post_hook = config->post_hook;
+    task_ctx->hook_arg = config->hook_arg;
 
     TaskHandle_t task_hdl = NULL;
     ESP_LOGD(TAG, "Creating TinyUSB main task on CPU%d", config->xCoreID);
@@ -175,6 +265,8 @@ esp_err_t tinyusb_task_stop(void)
     TINYUSB_TASK_CHECK_FROM_CRIT(p_tusb_task_ctx != NULL, ESP_ERR_INVALID_STATE);
     tinyusb_task_ctx_t *task_ctx = p_tusb_task_ctx;
     p_tusb_task_ctx = NULL;
+    _batched_task_hdl = NULL;
+    _event_hook = NULL;
     _task_is_running = false;
     TINYUSB_TASK_EXIT_CRITICAL();
 
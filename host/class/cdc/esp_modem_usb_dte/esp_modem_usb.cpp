@@ -4,8 +4,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <atomic>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
 #include "esp_log.h"
 #include "esp_modem_config.h"
 #include "esp_modem_usb_config.h"
@@ -19,6 +23,10 @@
 
 static const char *TAG = "usb_terminal";
 
+#define TX_TASK_STACK_SIZE      (3072)
+#define TX_TASK_POLL_MS         (100)  // Period of checking for TX task stop request
+#define TX_BUFFER_WAIT_MS       (1000) // Maximum time write() waits for free space in the TX buffer
+
 /**
  * @brief USB Host task
  *
@@ -50,6 +58,9 @@ public:
     explicit UsbTerminal(const esp_modem_dte_config *config, int term_idx)
     {
         const struct esp_modem_usb_term_config *usb_config = (struct esp_modem_usb_term_config *)(config->extension_config);
+        ESP_MODEM_THROW_IF_ERROR(
+            (usb_config->rx_transfer_count >= 0 && usb_config->rx_transfer_count <= CDC_ACM_IN_XFER_COUNT_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG,
+            "Invalid RX transfer count");
 
         // Install USB Host driver (if not already installed)
         if (usb_config->install_usb_host && !usb_host_lib_task) {
@@ -83,19 +94,29 @@ public:
             .dev_addr = CDC_HOST_ANY_DEV_ADDR,
             .connection_timeout_ms = usb_config->timeout_ms,
             .out_buffer_size = config->dte_buffer_size,
-            .in_buffer_size = config->dte_buffer_size,
+            // With RX flow control, unconsumed data stays in the IN buffer: leave room for the next transfer
+            .in_buffer_size = usb_config->rx_flow_control ? 2 * config->dte_buffer_size : config->dte_buffer_size,
+            .in_transfer_count = static_cast<uint8_t>(usb_config->rx_transfer_count),
             .event_cb = handle_notif,
             .data_cb = handle_rx,
             .user_arg = this,
         };
 
+        rx_flow_control = usb_config->rx_flow_control;
         ESP_MODEM_THROW_IF_ERROR(
             this->CdcAcmDevice::open(&esp_modem_cdc_acm_open_config),
             "USB Device open failed");
+
+        if (usb_config->tx_buffer_size > 0) {
+            ESP_MODEM_THROW_IF_FALSE(
+                tx_pipeline_start(usb_config->tx_buffer_size, config->dte_buffer_size, config->task_priority, usb_config->xCoreID),
+                "TX pipeline start failed");
+        }
     };
 
     ~UsbTerminal()
     {
+        tx_pipeline_stop();
         this->CdcAcmDevice::close();
     };
 
@@ -112,6 +133,9 @@ public:
     int write(uint8_t *data, size_t len) override
     {
         ESP_LOG_BUFFER_HEXDUMP(TAG, data, len, ESP_LOG_DEBUG);
+        if (tx.ringbuf) {
+            return tx_pipeline_write(data, len);
+        }
         if (this->CdcAcmDevice::tx_blocking(data, len) != ESP_OK) {
             return -1;
         }
@@ -133,16 +157,145 @@ private:
     bool operator!= (const UsbTerminal &param) const = delete;
     static TaskHandle_t usb_host_lib_task; // Reused by multiple devices or between reconnections
 
+    struct {
+        RingbufHandle_t ringbuf = nullptr;     // Data written by DTE, waiting for USB OUT transfer
+        SemaphoreHandle_t task_done = nullptr; // Given by TX task just before it exits
+        size_t transfer_size = 0;              // Maximum size of one USB OUT transfer
+        std::atomic<bool> stop{false};         // Request for TX task to exit
+        bool error_reported = false;           // TX error was reported to DTE, cleared after successful transfer
+    } tx;
+
+    bool rx_flow_control = false;              // Unconsumed RX data is kept and delivered again
+    struct {
+        const uint8_t *start = nullptr;        // Start of RX data not consumed by DTE
+        size_t len = 0;                        // Length of RX data not consumed by DTE
+    } rx_pending;
+
+    std::atomic<bool> device_gone{false};      // Device was disconnected, remaining TX data is dropped
+
+    /**
+     * @brief Create TX buffer and TX task
+     *
+     * write() only copies data to the TX buffer. The TX task sends everything that was written while
+     * the previous USB transfer was in flight in one transfer, so the DTE does not wait for USB round-trips.
+     *
+     * @return true on success
+     */
+    bool tx_pipeline_start(size_t buffer_size, size_t transfer_size, unsigned task_priority, int core_id)
+    {
+        tx.transfer_size = transfer_size;
+        tx.ringbuf = xRingbufferCreate(buffer_size, RINGBUF_TYPE_BYTEBUF);
+        tx.task_done = xSemaphoreCreateBinary();
+        if (tx.ringbuf && tx.task_done &&
+                pdTRUE == xTaskCreatePinnedToCore(tx_task, "usb_term_tx", TX_TASK_STACK_SIZE, this, task_priority, NULL, core_id)) {
+            return true;
+        }
+
+        if (tx.ringbuf) {
+            vRingbufferDelete(tx.ringbuf);
+            tx.ringbuf = nullptr;
+        }
+        if (tx.task_done) {
+            vSemaphoreDelete(tx.task_done);
+            tx.task_done = nullptr;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Stop TX task and free TX buffer. Data that was not sent yet is dropped.
+     */
+    void tx_pipeline_stop()
+    {
+        if (!tx.ringbuf) {
+            return;
+        }
+        tx.stop = true;
+        xSemaphoreTake(tx.task_done, portMAX_DELAY);
+        vSemaphoreDelete(tx.task_done);
+        vRingbufferDelete(tx.ringbuf);
+        tx.task_done = nullptr;
+        tx.ringbuf = nullptr;
+    }
+
+    int tx_pipeline_write(const uint8_t *data, size_t len)
+    {
+        // Writes larger than the TX buffer are split. Each part waits for free space, which throttles the DTE
+        const size_t max_chunk = xRingbufferGetMaxItemSize(tx.ringbuf);
+        size_t written = 0;
+        while (written < len) {
+            const size_t chunk = std::min(len - written, max_chunk);
+            if (xRingbufferSend(tx.ringbuf, &data[written], chunk, pdMS_TO_TICKS(TX_BUFFER_WAIT_MS)) != pdTRUE) {
+                ESP_LOGW(TAG, "TX buffer full");
+                break;
+            }
+            written += chunk;
+        }
+        return written > 0 ? (int)written : -1;
+    }
+
+    static void tx_task(void *arg)
+    {
+        auto *this_terminal = static_cast<UsbTerminal *>(arg);
+        auto &tx = this_terminal->tx;
+
+        while (!tx.stop) {
+            size_t len = 0;
+            uint8_t *data = (uint8_t *)xRingbufferReceiveUpTo(tx.ringbuf, &len, pdMS_TO_TICKS(TX_TASK_POLL_MS), tx.transfer_size);
+            if (data == nullptr) {
+                continue;
+            }
+            esp_err_t ret = ESP_ERR_INVALID_STATE;
+            if (!this_terminal->device_gone) {
+                ret = this_terminal->CdcAcmDevice::tx_blocking(data, len);
+            }
+            vRingbufferReturnItem(tx.ringbuf, data);
+
+            if (ret == ESP_OK) {
+                tx.error_reported = false;
+            } else if (!this_terminal->device_gone && !tx.error_reported) {
+                // Report only first error of a sequence, the DTE has already returned from write()
+                ESP_LOGW(TAG, "Pipelined TX failed: %s", esp_err_to_name(ret));
+                tx.error_reported = true;
+                if (this_terminal->on_error) {
+                    this_terminal->on_error(terminal_error::UNEXPECTED_CONTROL_FLOW);
+                }
+            }
+        }
+        xSemaphoreGive(tx.task_done);
+        vTaskDelete(NULL);
+    }
+
     static bool handle_rx(const uint8_t *data, size_t data_len, void *user_arg)
     {
         ESP_LOG_BUFFER_HEXDUMP(TAG, data, data_len, ESP_LOG_DEBUG);
         auto *this_terminal = static_cast<UsbTerminal *>(user_arg);
-        if (data_len > 0 && this_terminal->on_read) {
-            this_terminal->on_read((uint8_t *)data, data_len);
-        } else {
-            ESP_LOGD(TAG, "Unhandled RX data");
+        if (!this_terminal->rx_flow_control) {
+            if (data_len > 0 && this_terminal->on_read) {
+                this_terminal->on_read((uint8_t *)data, data_len);
+            } else {
+                ESP_LOGD(TAG, "Unhandled RX data");
+            }
+            return true;
+        }
+
+        // CDC-ACM driver appends new data right behind data that was not consumed,
+        // so the DTE gets all pending data in one span. Otherwise the IN buffer was reset on overflow.
+        auto &pending = this_terminal->rx_pending;
+        const uint8_t *span = data;
+        size_t span_len = data_len;
+        if (pending.len > 0 && data == pending.start + pending.len) {
+            span = pending.start;
+            span_len += pending.len;
+        }
+
+        bool consumed = true;
+        if (span_len > 0 && this_terminal->on_read) {
+            consumed = this_terminal->on_read((uint8_t *)span, span_len);
         }
-        return true;
+        pending.start = span;
+        pending.len = consumed ? 0 : span_len;
+        return consumed;
     }
 
     static void handle_notif(const cdc_acm_host_dev_event_data_t *event, void *user_ctx)
@@ -152,6 +305,7 @@ private:
         switch (event->type) {
         case CDC_ACM_HOST_DEVICE_DISCONNECTED:
             ESP_LOGW(TAG, "USB terminal disconnected");
+            this_terminal->device_gone = true;
             if (this_terminal->on_error) {
                 this_terminal->on_error(terminal_error::DEVICE_GONE);
             }
@@ -163,10 +317,19 @@ private:
                 this_terminal->on_error(terminal_error::UNEXPECTED_CONTROL_FLOW);
             }
             break;
+        case CDC_ACM_HOST_SERIAL_STATE:
+            // CDC-ACM driver sets bOverRun when the IN buffer cannot accept more data and discards it
+            if (event->data.serial_state.bOverRun && this_terminal->rx_flow_control) {
+                ESP_LOGW(TAG, "RX data not consumed, IN buffer overflow");
+                this_terminal->rx_pending.len = 0;
+                if (this_terminal->on_error) {
+                    this_terminal->on_error(terminal_error::BUFFER_OVERFLOW);
+                }
+            }
+            break;
         // Notifications like Ring, Rx Carrier indication or Network connection indication are not relevant for USB terminal
         // Suspend/resume events also ignored
         case CDC_ACM_HOST_NETWORK_CONNECTION:
-        case CDC_ACM_HOST_SERIAL_STATE:
         default:
             ESP_LOGD(TAG, "Ignored USB event %d", event->type);
             break;
@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @brief USB modem terminal configuration.
@@ -26,6 +27,15 @@ struct esp_modem_usb_term_config {
                                       optional USB Host task. */
     bool cdc_compliant __attribute__((deprecated("Deprecated: CDC compliance is auto-detected"))); /*!< Deprecated. */
     bool install_usb_host;       /*!< Set to true to install the USB Host driver automatically. */
+    size_t tx_buffer_size;       /*!< Size of the pipelined TX buffer in bytes. If non-zero, write() copies data to this
+                                      buffer and returns without waiting for USB transfer completion; a dedicated task
+                                      sends the buffered data to the modem. Set to 0 for blocking writes. */
+    bool rx_flow_control;        /*!< Set to true to keep RX data that was not consumed by the DTE (on_read returned
+                                      false) and deliver it again together with the next received data.
+                                      On ESP32-P4, requires USB_HOST_TRANSFER_UNALIGNED_DATA_BUFFER_SUPPORTED. */
+    int rx_transfer_count;       /*!< Number of USB IN transfers kept in flight, so the modem can send data while
+                                      the DTE processes received data. Set to 0 for one transfer.
+                                      Maximum is CDC_ACM_IN_XFER_COUNT_MAX (16). */
 };
 
 /**
@@ -64,7 +74,10 @@ struct esp_modem_usb_term_config {
         .timeout_ms = 0,                                             \
         .xCoreID = 0,                                                \
         .cdc_compliant = false,                                      \
-        .install_usb_host = true                                     \
+        .install_usb_host = true,                                    \
+        .tx_buffer_size = 0,                                         \
+        .rx_flow_control = false,                                    \
+        .rx_transfer_count = 0                                       \
     }
 
 /**
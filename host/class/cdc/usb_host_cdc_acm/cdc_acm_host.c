@@ -207,6 +207,27 @@ static esp_err_t cdc_acm_submit_poll(usb_transfer_t *xfer, bool *polling_active,
     return err;
 }
 
+/**
+ * @brief Submit all BULK IN transfers for polling
+ *
+ * Transfer held back because of unprocessed data is skipped; it is resubmitted once the user processes the data.
+ *
+ * @param[in] cdc_dev Pointer to CDC device
+ * @return
+ *    - ESP_OK: All IN transfers are polling
+ *    - Other errors passed from cdc_acm_submit_poll()
+ */
+static esp_err_t cdc_acm_submit_in_polls(cdc_dev_t *cdc_dev)
+{
+    for (int i = 0; i < cdc_dev->data.in_xfer_count; i++) {
+        if (cdc_dev->data.in_xfers[i] == cdc_dev->data.in_hold.xfer) {
+            continue;
+        }
+        ESP_RETURN_ON_ERROR(cdc_acm_submit_poll(cdc_dev->data.in_xfers[i], &cdc_dev->data.in_polling[i], "BULK IN"), TAG,);
+    }
+    return ESP_OK;
+}
+
 /**
  * @brief Start CDC device
  *
@@ -239,7 +260,7 @@ static esp_err_t cdc_acm_start(cdc_dev_t *cdc_dev, cdc_acm_host_dev_callback_t e
         err, TAG, "Could not claim interface");
     if (cdc_dev->data.in_xfer) {
         ESP_LOGD(TAG, "Submitting poll for BULK IN transfer");
-        ESP_ERROR_CHECK(cdc_acm_submit_poll(cdc_dev->data.in_xfer, &cdc_dev->data.in_polling, "BULK IN"));
+        ESP_ERROR_CHECK(cdc_acm_submit_in_polls(cdc_dev));
     }
 
     // If notification are supported, claim its interface and start polling its IN endpoint
@@ -512,8 +533,21 @@ static void cdc_acm_transfers_free(cdc_dev_t *cdc_dev)
     }
     if (cdc_dev->data.in_xfer != NULL) {
         cdc_acm_reset_in_transfer(cdc_dev);
-        usb_host_transfer_free(cdc_dev->data.in_xfer);
+    }
+    if (cdc_dev->data.in_xfers != NULL) {
+        for (int i = 0; i < cdc_dev->data.in_xfer_count; i++) {
+            if (cdc_dev->data.in_xfers[i] != NULL) {
+                usb_host_transfer_free(cdc_dev->data.in_xfers[i]);
+            }
+        }
+        free(cdc_dev->data.in_xfers);
+        free(cdc_dev->data.in_polling);
+        cdc_dev->data.in_xfers = NULL;
+        cdc_dev->data.in_polling = NULL;
         cdc_dev->data.in_xfer = NULL;
+        cdc_dev->data.in_xfer_count = 0;
+        cdc_dev->data.in_hold.xfer = NULL;
+        cdc_dev->data.in_hold.len = 0;
     }
     if (cdc_dev->data.out_xfer != NULL) {
         if (cdc_dev->data.out_xfer->context != NULL) {
@@ -548,6 +582,7 @@ static void cdc_acm_transfers_free(cdc_dev_t *cdc_dev)
  * @param[in] notif_ep_desc Pointer to notification EP descriptor
  * @param[in] in_ep_desc-   Pointer to data IN EP descriptor
  * @param[in] in_buf_len    Length of data IN buffer
+ * @param[in] in_xfer_count Number of data IN transfers
  * @param[in] out_ep_desc   Pointer to data OUT EP descriptor
  * @param[in] out_buf_len   Length of data OUT buffer
  * @return
@@ -555,7 +590,7 @@ static void cdc_acm_transfers_free(cdc_dev_t *cdc_dev)
  *     - ESP_ERR_NO_MEM:    Not enough memory for transfers and semaphores allocation
  *     - ESP_ERR_NOT_FOUND: IN or OUT endpoints were not found in the selected interface
  */
-static esp_err_t cdc_acm_transfers_allocate(cdc_dev_t *cdc_dev, const usb_ep_desc_t *notif_ep_desc, const usb_ep_desc_t *in_ep_desc, size_t in_buf_len, const usb_ep_desc_t *out_ep_desc, size_t out_buf_len)
+static esp_err_t cdc_acm_transfers_allocate(cdc_dev_t *cdc_dev, const usb_ep_desc_t *notif_ep_desc, const usb_ep_desc_t *in_ep_desc, size_t in_buf_len, uint8_t in_xfer_count, const usb_ep_desc_t *out_ep_desc, size_t out_buf_len)
 {
     assert(in_ep_desc);
     assert(out_ep_desc);
@@ -586,18 +621,27 @@ static esp_err_t cdc_acm_transfers_allocate(cdc_dev_t *cdc_dev, const usb_ep_des
     cdc_dev->ctrl_mux = xSemaphoreCreateMutex();
     ESP_GOTO_ON_FALSE(cdc_dev->ctrl_mux, ESP_ERR_NO_MEM, err, TAG,);
 
-    // 3. Setup IN data transfer (if it is required (in_buf_len > 0))
+    // 3. Setup IN data transfers (if it is required (in_buf_len > 0))
     if (in_buf_len != 0) {
-        ESP_GOTO_ON_ERROR(
-            usb_host_transfer_alloc(in_buf_len, 0, &cdc_dev->data.in_xfer),
-            err, TAG,
-        );
-        assert(cdc_dev->data.in_xfer);
-        cdc_dev->data.in_xfer->callback = in_xfer_cb;
-        cdc_dev->data.in_xfer->num_bytes = in_buf_len;
-        cdc_dev->data.in_xfer->bEndpointAddress = in_ep_desc->bEndpointAddress;
-        cdc_dev->data.in_xfer->device_handle = cdc_dev->dev_hdl;
-        cdc_dev->data.in_xfer->context = cdc_dev;
+        assert(in_xfer_count > 0);
+        cdc_dev->data.in_xfers = calloc(in_xfer_count, sizeof(usb_transfer_t *));
+        cdc_dev->data.in_polling = calloc(in_xfer_count, sizeof(bool));
+        ESP_GOTO_ON_FALSE(cdc_dev->data.in_xfers && cdc_dev->data.in_polling, ESP_ERR_NO_MEM, err, TAG,);
+        cdc_dev->data.in_xfer_count = in_xfer_count;
+        for (int i = 0; i < in_xfer_count; i++) {
+            ESP_GOTO_ON_ERROR(
+                usb_host_transfer_alloc(in_buf_len, 0, &cdc_dev->data.in_xfers[i]),
+                err, TAG,
+            );
+            usb_transfer_t *in_xfer = cdc_dev->data.in_xfers[i];
+            assert(in_xfer);
+            in_xfer->callback = in_xfer_cb;
+            in_xfer->num_bytes = in_buf_len;
+            in_xfer->bEndpointAddress = in_ep_desc->bEndpointAddress;
+            in_xfer->device_handle = cdc_dev->dev_hdl;
+            in_xfer->context = cdc_dev;
+        }
+        cdc_dev->data.in_xfer = cdc_dev->data.in_xfers[0];
         cdc_dev->data.in_mps = USB_EP_DESC_GET_MPS(in_ep_desc);
         cdc_dev->data.in_data_buffer_base = cdc_dev->data.in_xfer->data_buffer;
     }
@@ -638,6 +682,7 @@ esp_err_t cdc_acm_host_open_v1_dispatch(uint16_t vid, uint16_t pid, uint8_t inte
         .connection_timeout_ms = dev_config->connection_timeout_ms,
         .out_buffer_size = dev_config->out_buffer_size,
         .in_buffer_size = dev_config->in_buffer_size,
+        .in_transfer_count = dev_config->in_transfer_count,
         .event_cb = dev_config->event_cb,
         .data_cb = dev_config->data_cb,
         .user_arg = dev_config->user_arg,
@@ -651,6 +696,7 @@ esp_err_t cdc_acm_host_open_v2(const cdc_acm_host_open_config_t *open_config, cd
     CDC_ACM_CHECK(p_cdc_acm_obj, ESP_ERR_INVALID_STATE);
     CDC_ACM_CHECK(open_config, ESP_ERR_INVALID_ARG);
     CDC_ACM_CHECK(cdc_hdl_ret, ESP_ERR_INVALID_ARG);
+    CDC_ACM_CHECK(open_config->in_transfer_count <= CDC_ACM_IN_XFER_COUNT_MAX, ESP_ERR_INVALID_ARG);
 
     xSemaphoreTake(p_cdc_acm_obj->open_close_mutex, portMAX_DELAY);
     // Find underlying USB device
@@ -694,10 +740,11 @@ esp_err_t cdc_acm_host_open_v2(const cdc_acm_host_open_config_t *open_config, cd
     // The following line is here for backward compatibility with v1.0.*
     // where fixed size of IN buffer (equal to IN Maximum Packet Size) was used
     const size_t in_buf_size = (open_config->data_cb && (open_config->in_buffer_size == 0)) ? USB_EP_DESC_GET_MPS(cdc_info.in_ep) : open_config->in_buffer_size;
+    const uint8_t in_xfer_count = (open_config->in_transfer_count == 0) ? 1 : open_config->in_transfer_count;
 
     // Allocate USB transfers, claim CDC interfaces and return CDC-ACM handle
     ESP_GOTO_ON_ERROR(
-        cdc_acm_transfers_allocate(cdc_dev, cdc_info.notif_ep, cdc_info.in_ep, in_buf_size, cdc_info.out_ep, open_config->out_buffer_size),
+        cdc_acm_transfers_allocate(cdc_dev, cdc_info.notif_ep, cdc_info.in_ep, in_buf_size, in_xfer_count, cdc_info.out_ep, open_config->out_buffer_size),
         err, TAG,);
     ESP_GOTO_ON_ERROR(cdc_acm_start(cdc_dev, open_config->event_cb, open_config->data_cb, open_config->user_arg), err, TAG,);
     *cdc_hdl_ret = (cdc_acm_dev_hdl_t)cdc_dev;
@@ -743,7 +790,9 @@ esp_err_t cdc_acm_host_close(cdc_acm_dev_hdl_t cdc_hdl)
     CDC_ACM_EXIT_CRITICAL();
 
     // Cancel polling of BULK IN and INTERRUPT IN
-    cdc_dev->data.in_polling = false;
+    for (int i = 0; i < cdc_dev->data.in_xfer_count; i++) {
+        cdc_dev->data.in_polling[i] = false;
+    }
     cdc_dev->notif.xfer_polling = false;
     if (cdc_dev->data.in_xfer) {
         ESP_ERROR_CHECK(cdc_acm_reset_transfer_endpoint(cdc_dev->dev_hdl, cdc_dev->data.in_xfer));
@@ -820,16 +869,110 @@ static bool cdc_acm_is_transfer_completed(usb_transfer_t *transfer)
     return completed;
 }
 
+/**
+ * @brief Inform user about IN buffer overflow
+ *
+ * @param[in] cdc_dev Pointer to CDC device
+ */
+static void cdc_acm_in_overflow_notify(cdc_dev_t *cdc_dev)
+{
+    ESP_LOGW(TAG, "IN buffer overflow");
+    cdc_dev->serial_state.bOverRun = true;
+    if (cdc_dev->notif.cb) {
+        const cdc_acm_host_dev_event_data_t serial_state_event = {
+            .type = CDC_ACM_HOST_SERIAL_STATE,
+            .data.serial_state = cdc_dev->serial_state
+        };
+        cdc_dev->notif.cb(&serial_state_event, cdc_dev->cb_arg);
+    }
+    cdc_dev->serial_state.bOverRun = false;
+}
+
+/**
+ * @brief Get index of IN transfer in in_xfers array
+ *
+ * @param[in] cdc_dev  Pointer to CDC device
+ * @param[in] transfer IN transfer
+ * @return Index of the transfer
+ */
+static int cdc_acm_in_xfer_index(const cdc_dev_t *cdc_dev, const usb_transfer_t *transfer)
+{
+    for (int i = 0; i < cdc_dev->data.in_xfer_count; i++) {
+        if (cdc_dev->data.in_xfers[i] == transfer) {
+            return i;
+        }
+    }
+    assert(false);
+    return 0;
+}
+
+/**
+ * @brief Deliver data of one of multiple in-flight IN transfers to the user
+ *
+ * Transfers of one endpoint complete in the order they were submitted, so resubmitting each transfer
+ * after its data was delivered keeps the data in order, while the other transfers keep the endpoint polled.
+ *
+ * If the user does not process the data, the transfer is held back from polling. Data of following transfers
+ * is copied behind the unprocessed data, so the user sees the same contiguous buffer as with one IN transfer.
+ *
+ * @param[in] cdc_dev  Pointer to CDC device
+ * @param[in] transfer Completed IN transfer
+ */
+static void cdc_acm_in_ring_deliver(cdc_dev_t *cdc_dev, usb_transfer_t *transfer)
+{
+    usb_transfer_t *hold = cdc_dev->data.in_hold.xfer;
+    const uint8_t *data = transfer->data_buffer;
+
+    if (hold) {
+        if (transfer->actual_num_bytes > hold->data_buffer_size - cdc_dev->data.in_hold.len) {
+            // The held buffer cannot accept more data, inform the user and release the buffer
+            cdc_acm_in_overflow_notify(cdc_dev);
+            cdc_dev->data.in_hold.xfer = NULL;
+            cdc_acm_submit_poll(hold, &cdc_dev->data.in_polling[cdc_acm_in_xfer_index(cdc_dev, hold)], "BULK IN");
+            hold = NULL;
+        } else {
+            uint8_t *dst = hold->data_buffer + cdc_dev->data.in_hold.len;
+            memcpy(dst, transfer->data_buffer, transfer->actual_num_bytes);
+            cdc_dev->data.in_hold.len += transfer->actual_num_bytes;
+            data = dst;
+        }
+    }
+
+    const bool data_processed = cdc_dev->data.in_cb(data, transfer->actual_num_bytes, cdc_dev->cb_arg);
+
+    if (hold) {
+        // Data of this transfer was copied to the held buffer, it can be polled again right away
+        if (data_processed) {
+            cdc_dev->data.in_hold.xfer = NULL;
+            cdc_dev->data.in_hold.len = 0;
+            cdc_acm_submit_poll(hold, &cdc_dev->data.in_polling[cdc_acm_in_xfer_index(cdc_dev, hold)], "BULK IN");
+        }
+    } else if (!data_processed) {
+        cdc_dev->data.in_hold.xfer = transfer;
+        cdc_dev->data.in_hold.len = transfer->actual_num_bytes;
+        return;
+    }
+
+    ESP_LOGD(TAG, "Submitting poll for BULK IN transfer");
+    cdc_acm_submit_poll(transfer, &cdc_dev->data.in_polling[cdc_acm_in_xfer_index(cdc_dev, transfer)], "BULK IN");
+}
+
 static void in_xfer_cb(usb_transfer_t *transfer)
 {
     ESP_LOGD(TAG, "in xfer cb");
     cdc_dev_t *cdc_dev = (cdc_dev_t *)transfer->context;
-    cdc_dev->data.in_polling = false;
+    bool *polling = &cdc_dev->data.in_polling[cdc_acm_in_xfer_index(cdc_dev, transfer)];
+    *polling = false;
 
     if (!cdc_acm_is_transfer_completed(transfer)) {
         return;
     }
 
+    if (cdc_dev->data.in_xfer_count > 1 && cdc_dev->data.in_cb) {
+        cdc_acm_in_ring_deliver(cdc_dev, transfer);
+        return;
+    }
+
     if (cdc_dev->data.in_cb) {
         const bool data_processed = cdc_dev->data.in_cb(transfer->data_buffer, transfer->actual_num_bytes, cdc_dev->cb_arg);
 
@@ -838,7 +981,7 @@ static void in_xfer_cb(usb_transfer_t *transfer)
         // In this case, the next received data must be appended to the existing buffer.
         // Since the data_buffer in usb_transfer_t is a constant pointer, we must cast away to const qualifier.
         if (!data_processed) {
-#if !SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+#if !SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE || defined(USB_HOST_TRANSFER_UNALIGNED_DATA_BUFFER_SUPPORTED)
             // In case the received data was not processed, the next RX data must be appended to current buffer
             uint8_t **ptr = (uint8_t **)(&(transfer->data_buffer));
             *ptr += transfer->actual_num_bytes;
@@ -850,22 +993,12 @@ static void in_xfer_cb(usb_transfer_t *transfer)
 
             if (transfer->num_bytes == 0) {
                 // The IN buffer cannot accept more data, inform the user and reset the buffer
-                ESP_LOGW(TAG, "IN buffer overflow");
-                cdc_dev->serial_state.bOverRun = true;
-                if (cdc_dev->notif.cb) {
-                    const cdc_acm_host_dev_event_data_t serial_state_event = {
-                        .type = CDC_ACM_HOST_SERIAL_STATE,
-                        .data.serial_state = cdc_dev->serial_state
-                    };
-                    cdc_dev->notif.cb(&serial_state_event, cdc_dev->cb_arg);
-                }
-
+                cdc_acm_in_overflow_notify(cdc_dev);
                 cdc_acm_reset_in_transfer(cdc_dev);
-                cdc_dev->serial_state.bOverRun = false;
             }
 #else
-            // For targets that must sync internal memory through L1CACHE, we cannot change the data_buffer
-            // because it would lead to unaligned cache sync, which is not allowed
+            // For targets that must sync internal memory through L1CACHE, older USB Host Libraries cannot handle
+            // a data_buffer that is not cache line aligned
             ESP_LOGW(TAG, "RX buffer append is not supported on this target!");
 #endif
         } else {
@@ -874,7 +1007,7 @@ static void in_xfer_cb(usb_transfer_t *transfer)
     }
 
     ESP_LOGD(TAG, "Submitting poll for BULK IN transfer");
-    cdc_acm_submit_poll(cdc_dev->data.in_xfer, &cdc_dev->data.in_polling, "BULK IN");
+    cdc_acm_submit_poll(transfer, polling, "BULK IN");
 }
 
 static void notif_xfer_cb(usb_transfer_t *transfer)
@@ -942,7 +1075,7 @@ static void cdc_acm_resume(cdc_dev_t *cdc_dev)
 
     if (cdc_dev->data.in_xfer) {
         ESP_LOGD(TAG, "Submitting poll for BULK IN transfer");
-        ESP_ERROR_CHECK(cdc_acm_submit_poll(cdc_dev->data.in_xfer, &cdc_dev->data.in_polling, "BULK IN"));
+        ESP_ERROR_CHECK(cdc_acm_submit_in_polls(cdc_dev));
     }
 
     if (cdc_dev->notif.xfer) {
@@ -963,8 +1096,8 @@ static void cdc_acm_suspend_polling(cdc_dev_t *cdc_dev)
 {
     assert(cdc_dev);
 
-    if (cdc_dev->data.in_xfer) {
-        cdc_dev->data.in_polling = false;
+    for (int i = 0; i < cdc_dev->data.in_xfer_count; i++) {
+        cdc_dev->data.in_polling[i] = false;
     }
 
     if (cdc_dev->notif.xfer) {
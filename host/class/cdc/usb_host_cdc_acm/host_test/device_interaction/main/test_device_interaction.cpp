@@ -5,6 +5,8 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 
 #include "descriptors/cdc_descriptors.hpp"
@@ -514,3 +516,142 @@ SCENARIO("TinyUSB serial")
         REQUIRE(ESP_OK == test_cdc_acm_host_uninstall());
     }
 }
+
+/**
+ * @brief Record of data delivered to data callback
+ */
+typedef struct {
+    std::vector<const uint8_t *> data;  // Pointers passed to data callback
+    std::vector<size_t> len;            // Lengths passed to data callback
+    int not_processed_cnt;              // Number of following callbacks that return 'data not processed'
+    int overflow_cnt;                   // Number of serial state events with overrun
+} rx_record_t;
+
+static std::vector<usb_transfer_t *> s_submitted_in_xfers;
+
+static esp_err_t usb_host_transfer_submit_capture_callback(usb_transfer_t *transfer, int call_count)
+{
+    s_submitted_in_xfers.push_back(transfer);
+    return ESP_OK;
+}
+
+static bool rx_record_data_cb(const uint8_t *data, size_t data_len, void *user_arg)
+{
+    rx_record_t *record = static_cast<rx_record_t *>(user_arg);
+    record->data.push_back(data);
+    record->len.push_back(data_len);
+    if (record->not_processed_cnt > 0) {
+        record->not_processed_cnt--;
+        return false;
+    }
+    return true;
+}
+
+static void rx_record_event_cb(const cdc_acm_host_dev_event_data_t *event, void *user_ctx)
+{
+    rx_record_t *record = static_cast<rx_record_t *>(user_ctx);
+    if (event->type == CDC_ACM_HOST_SERIAL_STATE && event->data.serial_state.bOverRun) {
+        record->overflow_cnt++;
+    }
+}
+
+/**
+ * @brief Simulate completion of a submitted IN transfer
+ */
+static void complete_in_transfer(usb_transfer_t *transfer, uint8_t fill, size_t len)
+{
+    memset(transfer->data_buffer, fill, len);
+    transfer->actual_num_bytes = len;
+    transfer->status = USB_TRANSFER_STATUS_COMPLETED;
+    transfer->callback(transfer);
+}
+
+SCENARIO("Multiple in-flight IN transfers")
+{
+    Mockusb_host_Init();
+    GIVEN("CDC driver installed") {
+        _add_mocked_devices();
+        REQUIRE(ESP_OK == test_cdc_acm_host_install(nullptr));
+        AND_GIVEN("CP210x opened with 3 IN transfers") {
+            rx_record_t record = {};
+            const cdc_acm_host_device_config_t dev_config = {
+                .connection_timeout_ms = 1000,
+                .out_buffer_size = 64,
+                .in_buffer_size = 64,
+                .in_transfer_count = 3,
+                .event_cb = rx_record_event_cb,
+                .data_cb = rx_record_data_cb,
+                .user_arg = &record,
+            };
+
+            usb_host_device_open_Stub(usb_host_device_open_mock_callback);
+            usb_host_get_device_descriptor_Stub(usb_host_get_device_descriptor_mock_callback);
+            usb_host_device_close_Stub(usb_host_device_close_mock_callback);
+            usb_host_get_active_config_descriptor_Stub(usb_host_get_active_config_descriptor_mock_callback);
+            usb_host_device_addr_list_fill_Stub(usb_host_device_addr_list_fill_mock_callback);
+            usb_host_device_info_Stub(usb_host_device_info_mock_callback);
+            usb_host_transfer_alloc_Stub(usb_host_transfer_alloc_mock_callback);
+            usb_host_transfer_submit_Stub(usb_host_transfer_submit_capture_callback);
+            usb_host_interface_claim_ExpectAnyArgsAndReturn(ESP_OK);
+            s_submitted_in_xfers.clear();
+
+            cdc_acm_dev_hdl_t dev = nullptr;
+            REQUIRE(ESP_OK == cdc_acm_host_open(0x10C4, 0xEA60, 0, &dev_config, &dev));
+
+            // All IN transfers are polling
+            REQUIRE(s_submitted_in_xfers.size() == 3);
+            usb_transfer_t *xfers[3] = {s_submitted_in_xfers[0], s_submitted_in_xfers[1], s_submitted_in_xfers[2]};
+            REQUIRE(xfers[0] != xfers[1]);
+            REQUIRE(xfers[1] != xfers[2]);
+
+            THEN("Processed transfers are resubmitted in order of completion") {
+                complete_in_transfer(xfers[0], 0xA0, 10);
+                complete_in_transfer(xfers[1], 0xA1, 20);
+                REQUIRE(record.len == std::vector<size_t> {10, 20});
+                REQUIRE(record.data[0] == xfers[0]->data_buffer);
+                REQUIRE(record.data[1] == xfers[1]->data_buffer);
+                REQUIRE(s_submitted_in_xfers.size() == 5);
+                REQUIRE(s_submitted_in_xfers[3] == xfers[0]);
+                REQUIRE(s_submitted_in_xfers[4] == xfers[1]);
+            }
+
+            THEN("Data that was not processed is followed by data of next transfer") {
+                record.not_processed_cnt = 1;
+                complete_in_transfer(xfers[0], 0xB0, 8);
+                REQUIRE(s_submitted_in_xfers.size() == 3); // Held back from polling
+
+                complete_in_transfer(xfers[1], 0xB1, 6);
+                REQUIRE(record.data[1] == record.data[0] + 8);
+                for (int i = 0; i < 14; i++) {
+                    REQUIRE(record.data[0][i] == (i < 8 ? 0xB0 : 0xB1));
+                }
+
+                // Held transfer and the current transfer are polling again
+                REQUIRE(s_submitted_in_xfers.size() == 5);
+                REQUIRE(s_submitted_in_xfers[3] == xfers[0]);
+                REQUIRE(s_submitted_in_xfers[4] == xfers[1]);
+            }
+
+            THEN("Overflow of the held buffer is reported") {
+                record.not_processed_cnt = 3;
+                complete_in_transfer(xfers[0], 0xC0, 40);
+                complete_in_transfer(xfers[1], 0xC1, 40);
+                REQUIRE(record.overflow_cnt == 1);
+                REQUIRE(record.data[1] == xfers[1]->data_buffer);
+                REQUIRE(s_submitted_in_xfers.size() == 4);
+                REQUIRE(s_submitted_in_xfers[3] == xfers[0]);
+            }
+
+            usb_host_endpoint_halt_ExpectAnyArgsAndReturn(ESP_OK);
+            usb_host_endpoint_flush_ExpectAnyArgsAndReturn(ESP_OK);
+            usb_host_endpoint_clear_ExpectAnyArgsAndReturn(ESP_OK);
+            usb_host_interface_release_ExpectAnyArgsAndReturn(ESP_OK);
+            usb_host_transfer_free_Stub(usb_host_transfer_free_mock_callback); // Free all transfers
+            usb_host_device_close_ExpectAnyArgsAndReturn(ESP_OK);      // Close the device
+            REQUIRE(ESP_OK == cdc_acm_host_close(dev));
+        }
+
+        // Uninstall CDC-ACM driver
+        REQUIRE(ESP_OK == test_cdc_acm_host_uninstall());
+    }
+}
@@ -38,13 +38,19 @@ struct cdc_dev_s {
     void *cb_arg;                         // Common argument for user's callbacks (data IN and Notification)
     struct {
         usb_transfer_t *out_xfer;         // OUT data transfer
-        usb_transfer_t *in_xfer;          // IN data transfer
+        usb_transfer_t *in_xfer;          // IN data transfer, equal to in_xfers[0]
+        usb_transfer_t **in_xfers;        // IN data transfers kept in flight, in_xfer_count entries
+        bool *in_polling;                 // For each IN data transfer: BULK IN poll transfer is submitted
+        uint8_t in_xfer_count;            // Number of IN data transfers
+        struct {
+            usb_transfer_t *xfer;         // IN transfer held back from polling, because user did not process its data
+            size_t len;                   // Length of data not processed by user
+        } in_hold;                        // Only used with more than one IN data transfer
         cdc_acm_data_callback_t in_cb;    // User's callback for async (non-blocking) data IN
         uint16_t in_mps;                  // IN endpoint Maximum Packet Size
         uint8_t *in_data_buffer_base;     // Pointer to IN data buffer in usb_transfer_t
         const usb_intf_desc_t *intf_desc; // Pointer to data interface descriptor
         SemaphoreHandle_t out_mux;        // OUT mutex
-        bool in_polling;                  // BULK IN poll transfer is submitted
     } data;
 
     struct {
@@ -27,6 +27,11 @@
 #define CDC_HOST_REMOTE_WAKE_SUPPORTED
 #endif
 
+/**
+ * @brief Maximum number of bulk IN transfers kept in flight, see in_transfer_count
+ */
+#define CDC_ACM_IN_XFER_COUNT_MAX  (16)
+
 /**
  * @brief Opaque handle to an opened CDC-ACM device.
  */
@@ -89,6 +94,10 @@ typedef struct {
                                                Larger writes are split into multiple transfers. */
     size_t in_buffer_size;                /*!< Maximum USB bulk IN transfer size. If set to 0, the IN endpoint MPS
                                                is used. */
+    uint8_t in_transfer_count;            /*!< Number of bulk IN transfers kept in flight, each of in_buffer_size.
+                                               The device can send data while data_cb is running. Data is delivered
+                                               in order of reception. Set to 0 for one transfer.
+                                               Maximum is CDC_ACM_IN_XFER_COUNT_MAX. */
     cdc_acm_host_dev_callback_t event_cb; /*!< Device event callback. Can be NULL. */
     cdc_acm_data_callback_t data_cb;      /*!< Data RX callback. Can be NULL for write-only devices. */
     void *user_arg;                       /*!< User argument passed to both callbacks. */
@@ -108,6 +117,10 @@ typedef struct {
                                                Larger writes are split into multiple transfers. */
     size_t in_buffer_size;                /*!< Maximum USB bulk IN transfer size. If set to 0, the IN endpoint MPS
                                                is used. */
+    uint8_t in_transfer_count;            /*!< Number of bulk IN transfers kept in flight, each of in_buffer_size.
+                                               The device can send data while data_cb is running. Data is delivered
+                                               in order of reception. Set to 0 for one transfer.
+                                               Maximum is CDC_ACM_IN_XFER_COUNT_MAX. */
     cdc_acm_host_dev_callback_t event_cb; /*!< Device event callback. Can be NULL. */
     cdc_acm_data_callback_t data_cb;      /*!< Data RX callback. Can be NULL for write-only devices. */
     void *user_arg;                       /*!< User argument passed to both callbacks. */
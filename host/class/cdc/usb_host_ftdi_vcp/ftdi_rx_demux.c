@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <assert.h>
+#include "ftdi_rx_demux.h"
+
+size_t ftdi_rx_demux(ftdi_rx_demux_t *demux, uint8_t *data, size_t data_len, ftdi_rx_status_cb_t status_cb, void *arg)
+{
+    assert(demux && demux->mps > FTDI_STATUS_LEN);
+    const size_t mps = demux->mps;
+    size_t payload_len = 0;
+
+    // Only the last packet of a transfer can be shorter than MPS
+    for (size_t offset = 0; offset < data_len; offset += mps) {
+        const size_t packet_len = (data_len - offset < mps) ? (data_len - offset) : mps;
+        const uint8_t *packet = &data[offset];
+        if (packet_len < FTDI_STATUS_LEN) {
+            break; // Malformed packet without complete status header
+        }
+
+        const uint16_t status = (uint16_t)(packet[0] | (packet[1] << 8)) & FTDI_STATUS_MASK;
+        if (status != demux->status) {
+            demux->status = status;
+            if (status_cb) {
+                status_cb(status, arg);
+            }
+        }
+
+        const size_t chunk_len = packet_len - FTDI_STATUS_LEN;
+        if (chunk_len) {
+            // Source is always ahead of destination, the regions can overlap
+            memmove(&data[payload_len], &packet[FTDI_STATUS_LEN], chunk_len);
+            payload_len += chunk_len;
+        }
+    }
+    return payload_len;
+}
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "ftdi_rx_demux.h"
+
+#define TEST_STATUS_IDLE       (0x6001)  // THRE | TEMT, plus reserved bit 0 in byte 0
+#define TEST_STATUS_CTS        (0x6011)
+#define BENCHMARK_BYTES        (64 * 1024 * 1024)
+
+/**
+ * @brief Build an FTDI IN transfer: 'payload' split into packets of 'mps' bytes, each with a status header
+ */
+static std::vector<uint8_t> build_transfer(const std::vector<uint8_t> &payload, uint16_t mps, const std::vector<uint16_t> &status)
+{
+    std::vector<uint8_t> raw;
+    const size_t chunk = mps - FTDI_STATUS_LEN;
+    size_t offset = 0;
+    size_t packet = 0;
+    do {
+        const uint16_t st = status.empty() ? TEST_STATUS_IDLE : status[packet % status.size()];
+        raw.push_back(st & 0xFF);
+        raw.push_back(st >> 8);
+        const size_t len = std::min(chunk, payload.size() - offset);
+        raw.insert(raw.end(), payload.begin() + offset, payload.begin() + offset + len);
+        offset += len;
+        packet++;
+    } while (offset < payload.size());
+    return raw;
+}
+
+static std::vector<uint8_t> make_payload(size_t len)
+{
+    std::vector<uint8_t> payload(len);
+    for (size_t i = 0; i < len; i++) {
+        payload[i] = (uint8_t)(i * 7 + 3);
+    }
+    return payload;
+}
+
+static void count_status(uint16_t status, void *arg)
+{
+    std::vector<uint16_t> *changes = static_cast<std::vector<uint16_t> *>(arg);
+    changes->push_back(status);
+}
+
+SCENARIO("FTDI RX demultiplexer", "[ftdi][rx]")
+{
+    GIVEN("Full-speed MPS") {
+        ftdi_rx_demux_t demux = {};
+        demux.mps = FTDI_FS_MPS;
+
+        SECTION("Status only packet") {
+            std::vector<uint8_t> raw = build_transfer({}, FTDI_FS_MPS, {TEST_STATUS_CTS});
+            std::vector<uint16_t> changes;
+            REQUIRE(0 == ftdi_rx_demux(&demux, raw.data(), raw.size(), count_status, &changes));
+            REQUIRE(changes.size() == 1);
+            REQUIRE(changes[0] == (TEST_STATUS_CTS & FTDI_STATUS_MASK));
+        }
+
+        SECTION("Multi-packet transfer with short last packet") {
+            const std::vector<uint8_t> payload = make_payload(5 * (FTDI_FS_MPS - FTDI_STATUS_LEN) + 17);
+            std::vector<uint8_t> raw = build_transfer(payload, FTDI_FS_MPS, {});
+            REQUIRE(raw.size() == 6 * FTDI_STATUS_LEN + payload.size());
+
+            std::vector<uint16_t> changes;
+            const size_t len = ftdi_rx_demux(&demux, raw.data(), raw.size(), count_status, &changes);
+            REQUIRE(len == payload.size());
+            REQUIRE(0 == memcmp(raw.data(), payload.data(), len));
+            REQUIRE(changes.empty()); // Transmitter flags and reserved bits are masked out
+        }
+
+        SECTION("Status change in the middle of transfer") {
+            const std::vector<uint8_t> payload = make_payload(4 * (FTDI_FS_MPS - FTDI_STATUS_LEN));
+            std::vector<uint8_t> raw = build_transfer(payload, FTDI_FS_MPS, {TEST_STATUS_IDLE, TEST_STATUS_CTS, TEST_STATUS_CTS, TEST_STATUS_IDLE});
+
+            std::vector<uint16_t> changes;
+            const size_t len = ftdi_rx_demux(&demux, raw.data(), raw.size(), count_status, &changes);
+            REQUIRE(len == payload.size());
+            REQUIRE(0 == memcmp(raw.data(), payload.data(), len));
+            REQUIRE(changes.size() == 2);
+            REQUIRE(changes[0] == (TEST_STATUS_CTS & FTDI_STATUS_MASK));
+            REQUIRE(changes[1] == (TEST_STATUS_IDLE & FTDI_STATUS_MASK));
+        }
+
+        SECTION("Truncated status header is ignored") {
+            const std::vector<uint8_t> payload = make_payload(FTDI_FS_MPS - FTDI_STATUS_LEN);
+            std::vector<uint8_t> raw = build_transfer(payload, FTDI_FS_MPS, {});
+            raw.push_back(0x01);
+            REQUIRE(payload.size() == ftdi_rx_demux(&demux, raw.data(), raw.size(), nullptr, nullptr));
+        }
+    }
+}
+
+SCENARIO("FTDI RX demultiplexer throughput", "[ftdi][rx][benchmark]")
+{
+    for (const uint16_t mps : {(uint16_t)64, (uint16_t)512}) {
+        for (const size_t transfer_size : {(size_t)mps, (size_t)1024, (size_t)4096, (size_t)16384}) {
+            const size_t packets = transfer_size / mps;
+            const std::vector<uint8_t> payload = make_payload(packets * (mps - FTDI_STATUS_LEN));
+            const std::vector<uint8_t> raw = build_transfer(payload, mps, {});
+            REQUIRE(raw.size() == transfer_size);
+
+            ftdi_rx_demux_t demux = {};
+            demux.mps = mps;
+            std::vector<uint8_t> buf(raw.size());
+            const size_t iterations = BENCHMARK_BYTES / transfer_size;
+            std::chrono::nanoseconds elapsed{0};
+            size_t total_payload = 0;
+
+            for (size_t i = 0; i < iterations; i++) {
+                memcpy(buf.data(), raw.data(), raw.size()); // Demultiplexing is destructive
+                const auto t0 = std::chrono::steady_clock::now();
+                total_payload += ftdi_rx_demux(&demux, buf.data(), buf.size(), nullptr, nullptr);
+                elapsed += std::chrono::steady_clock::now() - t0;
+            }
+            REQUIRE(0 == memcmp(buf.data(), payload.data(), payload.size()));
+            REQUIRE(total_payload == iterations * payload.size());
+
+            const double seconds = std::chrono::duration<double>(elapsed).count();
+            printf("MPS %-4u transfer %-6zu packets/cb %-4zu payload %.1f MB/s, %.0f ns/transfer\n",
+                   (unsigned)mps, transfer_size, packets, (double)total_payload / seconds / 1e6,
+                   seconds * 1e9 / (double)iterations);
+        }
+    }
+}
@@ -60,6 +60,10 @@ extern "C" {
  * Pass `FTDI_PID_AUTO` or `VCP_FTDI_PID_AUTO` to probe all supported product
  * IDs for this driver.
  *
+ * `dev_config->in_buffer_size` can be a multiple of the IN endpoint MPS to receive several USB packets
+ * per transfer. The modem status bytes FTDI inserts at the start of every packet are removed and
+ * `dev_config->data_cb` receives the payload as one contiguous span.
+ *
  * @param[in] pid Product ID to open, or an auto-detect selector.
  * @param[in] interface_idx Interface index to open.
  * @param[in] dev_config CDC device configuration.
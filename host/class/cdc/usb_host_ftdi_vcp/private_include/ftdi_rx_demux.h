@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FTDI_STATUS_LEN  (2)     // Every FTDI IN packet starts with 2 modem status bytes
+#define FTDI_FS_MPS      (64)    // Bulk IN MPS of Full-speed FTDI chips
+#define FTDI_STATUS_MASK (0x1EF0u) // Status bits reported to the user (CTS, DSR, RI, DCD, OE, PE, FE, BI)
+
+/**
+ * @brief Modem status change callback
+ *
+ * @param[in] status New modem status: byte 0 in bits 0..7, byte 1 in bits 8..15, masked with FTDI_STATUS_MASK
+ * @param[in] arg    User's argument
+ */
+typedef void (*ftdi_rx_status_cb_t)(uint16_t status, void *arg);
+
+/**
+ * @brief FTDI RX demultiplexer state
+ */
+typedef struct {
+    uint16_t mps;    // IN endpoint Maximum Packet Size, the stride of status headers in received data
+    uint16_t status; // Last seen modem status, masked with FTDI_STATUS_MASK
+} ftdi_rx_demux_t;
+
+/**
+ * @brief Strip modem status headers from a multi-packet IN transfer
+ *
+ * FTDI chips insert 2 status bytes at the start of every USB packet, so a transfer spanning several
+ * packets contains a status header every 'mps' bytes. This function walks the buffer in 'mps' strides,
+ * reports status changes and moves the payload of all packets to the start of the buffer.
+ *
+ * @note The buffer is modified in place
+ *
+ * @param[inout] demux     Demultiplexer state
+ * @param[inout] data      Received data, contains contiguous payload on return
+ * @param[in]    data_len  Received data length
+ * @param[in]    status_cb Called for every status change. Can be NULL.
+ * @param[in]    arg       Argument passed to status_cb
+ * @return Payload length
+ */
+size_t ftdi_rx_demux(ftdi_rx_demux_t *demux, uint8_t *data, size_t data_len, ftdi_rx_status_cb_t status_cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
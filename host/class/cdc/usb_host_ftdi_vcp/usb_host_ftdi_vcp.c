@@ -13,6 +13,7 @@
 #include "esp_check.h"
 #include "usb/cdc_acm_host.h"
 #include "esp_private/cdc_host_common.h"
+#include "ftdi_rx_demux.h"
 
 #define FTDI_READ_REQ  (USB_BM_REQUEST_TYPE_TYPE_VENDOR | USB_BM_REQUEST_TYPE_DIR_IN)
 #define FTDI_WRITE_REQ (USB_BM_REQUEST_TYPE_TYPE_VENDOR | USB_BM_REQUEST_TYPE_DIR_OUT)
@@ -37,12 +38,17 @@ typedef struct {
     cdc_acm_host_dev_callback_t user_event_cb;       // User's event callback
     void *user_arg;                                  // User's argument
     uint16_t uart_state;                             // UART state tracking
+    ftdi_rx_demux_t demux;                           // Modem status demultiplexer
+    struct {
+        uint8_t *start;                              // Start of payload not consumed by the user
+        size_t len;                                  // Length of payload not consumed by the user
+        const uint8_t *raw_end;                      // End of last received raw data, next data is appended here
+    } pending;
 } ftdi_ctx_t;
 
 /**
- * @brief FT23x's RX data handler
+ * @brief Convert FTDI modem status to CDC-ACM UART state and dispatch it if it has changed
  *
- * First two bytes are status bytes, the RX data start at data[2].
  * Coding of status bytes:
  * Byte 0:
  *      Bit 0: Full Speed packet
@@ -59,6 +65,46 @@ typedef struct {
  *      Bit 5: Transmitter holding register empty
  *      Bit 6: Transmitter empty
  *
+ * @param[in] status   Modem status, byte 0 in bits 0..7, byte 1 in bits 8..15
+ * @param[in] user_arg Pointer to FTDI context
+ */
+static void ftdi_status(uint16_t status, void *user_arg)
+{
+    ftdi_ctx_t *ctx = (ftdi_ctx_t *)user_arg;
+    const uint8_t status0 = status & 0xFFu;
+    const uint8_t status1 = status >> 8;
+
+    cdc_acm_uart_state_t new_state;
+    new_state.val = 0;
+    new_state.bRxCarrier =   (status0 & 0x80u) != 0; // DCD
+    new_state.bTxCarrier =   (status0 & 0x20u) != 0; // DSR
+    new_state.bBreak =       (status1 & 0x10u) != 0;
+    new_state.bRingSignal =  (status0 & 0x40u) != 0;
+    new_state.bFraming =     (status1 & 0x08u) != 0;
+    new_state.bParity =      (status1 & 0x04u) != 0;
+    new_state.bOverRun =     (status1 & 0x02u) != 0;
+    new_state.bClearToSend = (status0 & 0x10u) != 0; // CTS
+
+    if (ctx->uart_state != new_state.val) {
+        cdc_acm_host_dev_event_data_t serial_event;
+        serial_event.type = CDC_ACM_HOST_SERIAL_STATE;
+        serial_event.data.serial_state = new_state;
+        ctx->user_event_cb(&serial_event, ctx->user_arg);
+        ctx->uart_state = new_state.val;
+    }
+}
+
+/**
+ * @brief FT23x's RX data handler
+ *
+ * Every USB packet starts with two modem status bytes, so an IN transfer larger than MPS contains
+ * a status header every MPS bytes. The headers are stripped in place and the user receives
+ * one contiguous span of payload per transfer.
+ *
+ * If the user did not consume the data, the CDC-ACM driver appends the next transfer right after
+ * the raw data of this one. The new payload is then moved behind the pending payload, so the user
+ * always sees all unconsumed data in one span.
+ *
  * @param[in] data     Received data
  * @param[in] data_len Received data length
  * @param[in] user_arg Pointer to FTDI context
@@ -68,33 +114,37 @@ static bool ftdi_rx(const uint8_t *data, size_t data_len, void *user_arg)
 {
     ftdi_ctx_t *ctx = (ftdi_ctx_t *)user_arg;
 
-    // Dispatch serial state if it has changed
-    if (ctx->user_event_cb && data_len >= 2) {
-        cdc_acm_uart_state_t new_state;
-        new_state.val = 0;
-        new_state.bRxCarrier =   (data[0] & 0x80u) != 0; // DCD
-        new_state.bTxCarrier =   (data[0] & 0x20u) != 0; // DSR
-        new_state.bBreak =       (data[1] & 0x10u) != 0;
-        new_state.bRingSignal =  (data[0] & 0x40u) != 0;
-        new_state.bFraming =     (data[1] & 0x08u) != 0;
-        new_state.bParity =      (data[1] & 0x04u) != 0;
-        new_state.bOverRun =     (data[1] & 0x02u) != 0;
-        new_state.bClearToSend = (data[0] & 0x10u) != 0; // CTS
-
-        if (ctx->uart_state != new_state.val) {
-            cdc_acm_host_dev_event_data_t serial_event;
-            serial_event.type = CDC_ACM_HOST_SERIAL_STATE;
-            serial_event.data.serial_state = new_state;
-            ctx->user_event_cb(&serial_event, ctx->user_arg);
-            ctx->uart_state = new_state.val;
-        }
+    // IN polling starts before ftdi_vcp_open() knows the IN endpoint MPS. Data received until then
+    // precedes the FTDI reset, which purges the RX buffer of the chip anyway, so it is dropped
+    if (ctx->demux.mps == 0) {
+        return true;
+    }
+
+    // The IN transfer buffer is owned by the CDC-ACM driver and is writable, we must cast away the const qualifier
+    uint8_t *rx_data = (uint8_t *)data;
+    size_t payload_len = ftdi_rx_demux(&ctx->demux, rx_data, data_len, ctx->user_event_cb ? ftdi_status : NULL, ctx);
+
+    // Pending payload is valid only if this data was appended to it, otherwise the IN buffer was reset
+    if (ctx->pending.len > 0 && data == ctx->pending.raw_end) {
+        memmove(ctx->pending.start + ctx->pending.len, rx_data, payload_len);
+        rx_data = ctx->pending.start;
+        payload_len += ctx->pending.len;
     }
 
     // Dispatch data if any
-    if (ctx->user_data_cb && data_len > 2) {
-        return ctx->user_data_cb(&data[2], data_len - 2, ctx->user_arg);
+    bool processed = true;
+    if (ctx->user_data_cb && payload_len > 0) {
+        processed = ctx->user_data_cb(rx_data, payload_len, ctx->user_arg);
     }
-    return true;
+
+    if (processed) {
+        ctx->pending.len = 0;
+    } else {
+        ctx->pending.start = rx_data;
+        ctx->pending.len = payload_len;
+        ctx->pending.raw_end = data + data_len;
+    }
+    return processed;
 }
 
 /**
@@ -241,6 +291,7 @@ esp_err_t ftdi_vcp_open(uint16_t pid, uint8_t interface_idx, const cdc_acm_host_
     ctx->user_event_cb = dev_config->event_cb;
     ctx->user_arg = dev_config->user_arg;
     ctx->uart_state = 0;
+    ctx->demux.mps = 0; // RX data is dropped until the MPS is known from the opened device
 
     // FTDI chips report modem status in first two bytes of RX data
     // so we need to override the RX handler with our own.
@@ -253,11 +304,6 @@ esp_err_t ftdi_vcp_open(uint16_t pid, uint8_t interface_idx, const cdc_acm_host_
         ftdi_config.event_cb = ftdi_event;
     }
 
-    if (ftdi_config.in_buffer_size > 0) {
-        ESP_LOGW(TAG, "RX FIFO size %d is not supported, setting to 0", ftdi_config.in_buffer_size);
-        ftdi_config.in_buffer_size = 0;
-    }
-
     if (pid == FTDI_PID_AUTO) {
         static const uint16_t supported_pids[] = {FT232_PID, FT231_PID};
         static const size_t num_pids = sizeof(supported_pids) / sizeof(supported_pids[0]);
@@ -278,6 +324,9 @@ esp_err_t ftdi_vcp_open(uint16_t pid, uint8_t interface_idx, const cdc_acm_host_
         return ret;
     }
 
+    // Status headers are inserted every MPS bytes of IN data. From now on, RX data is passed to the user
+    ctx->demux.mps = cdc_hdl->data.in_mps;
+
     // Set custom interface functions
     cdc_hdl->intf_func.user_data = ctx;
     cdc_hdl->intf_func.line_coding_set = ftdi_line_coding_set;
@@ -0,0 +1,460 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "usb/msc_host.h"
+#include "mock_add_usb_device.h"
+#include "msc_common.h"
+#include "msc_uas.h"
+#include "msc_scsi_bot.h"
+
+extern "C" {
+#include "Mockusb_host.h"
+}
+
+// Endpoints of the mocked UAS device, see uas_config_desc
+#define BOT_IN_EP       0x81
+#define BOT_OUT_EP      0x02
+#define UAS_CMD_EP      0x04
+#define UAS_STATUS_EP   0x83
+#define UAS_DATA_IN_EP  0x85
+#define UAS_DATA_OUT_EP 0x06
+#define UAS_MPS         512
+#define BLOCK_SIZE      512
+
+#define IU_COMMAND      0x01
+#define IU_SENSE        0x03
+#define IU_READ_READY   0x06
+#define IU_WRITE_READY  0x07
+#define IU_SENSE_SIZE   16      // Sense IU without sense data
+
+// -------------------------------------------- Simulated device -------------------------------------------------------
+
+static QueueHandle_t s_submitted;   // Transfers submitted by the driver, completed by the test
+
+static esp_err_t uas_submit_mock_callback(usb_transfer_t *transfer, int call_count)
+{
+    xQueueSend(s_submitted, &transfer, 0);
+    return ESP_OK;
+}
+
+static usb_transfer_t *expect_submitted(uint8_t ep)
+{
+    usb_transfer_t *transfer = nullptr;
+    REQUIRE(xQueueReceive(s_submitted, &transfer, pdMS_TO_TICKS(1000)) == pdTRUE);
+    REQUIRE(transfer->bEndpointAddress == ep);
+    return transfer;
+}
+
+static void expect_none_submitted(void)
+{
+    usb_transfer_t *transfer = nullptr;
+    REQUIRE(xQueueReceive(s_submitted, &transfer, pdMS_TO_TICKS(50)) == pdFALSE);
+}
+
+static void complete(usb_transfer_t *transfer, const void *data, size_t len)
+{
+    if (data) {
+        memcpy(transfer->data_buffer, data, len);
+    }
+    transfer->actual_num_bytes = len;
+    transfer->status = USB_TRANSFER_STATUS_COMPLETED;
+    transfer->callback(transfer);
+}
+
+static uint16_t iu_tag(const usb_transfer_t *transfer)
+{
+    return (transfer->data_buffer[2] << 8) | transfer->data_buffer[3];
+}
+
+static void send_iu(uint8_t iu_id, uint16_t tag)
+{
+    const uint8_t iu[4] = {iu_id, 0, (uint8_t)(tag >> 8), (uint8_t)tag};
+    complete(expect_submitted(UAS_STATUS_EP), iu, sizeof(iu));
+}
+
+static void send_sense_iu(usb_transfer_t *status_xfer, uint16_t tag, uint8_t status, const uint8_t *sense = nullptr, uint8_t sense_len = 0)
+{
+    uint8_t iu[IU_SENSE_SIZE + MSC_UAS_SENSE_SIZE] = {IU_SENSE, 0, (uint8_t)(tag >> 8), (uint8_t)tag};
+    iu[6] = status;
+    iu[15] = sense_len;
+    if (sense) {
+        memcpy(&iu[IU_SENSE_SIZE], sense, sense_len);
+    }
+    complete(status_xfer, iu, IU_SENSE_SIZE + sense_len);
+}
+
+static void send_sense_iu(uint16_t tag, uint8_t status, const uint8_t *sense = nullptr, uint8_t sense_len = 0)
+{
+    send_sense_iu(expect_submitted(UAS_STATUS_EP), tag, status, sense, sense_len);
+}
+
+// ------------------------------------------------- Fixtures ----------------------------------------------------------
+
+struct uas_test_cmd {
+    msc_device_t *device;
+    uint8_t cdb[16];
+    uint8_t cdb_len;
+    uint8_t *data;
+    size_t size;
+    bool data_in;
+    esp_err_t ret;
+    SemaphoreHandle_t done;
+};
+
+static void uas_execute_task(void *arg)
+{
+    uas_test_cmd *cmd = (uas_test_cmd *)arg;
+    cmd->ret = msc_uas_execute_command(cmd->device, cmd->cdb, cmd->cdb_len, cmd->data, cmd->size, cmd->data_in);
+    xSemaphoreGive(cmd->done);
+    vTaskDelete(NULL);
+}
+
+static void uas_execute_start(uas_test_cmd *cmd, msc_device_t *device, uint8_t opcode, uint8_t *data = nullptr, size_t size = 0, bool data_in = true)
+{
+    memset(cmd, 0, sizeof(uas_test_cmd));
+    cmd->device = device;
+    cmd->cdb[0] = opcode;
+    cmd->cdb_len = 10;
+    cmd->data = data;
+    cmd->size = size;
+    cmd->data_in = data_in;
+    cmd->done = xSemaphoreCreateBinary();
+    REQUIRE(cmd->done != nullptr);
+    REQUIRE(xTaskCreate(uas_execute_task, "uas_cmd", 4096, cmd, 5, NULL) == pdTRUE);
+}
+
+static esp_err_t uas_execute_wait(uas_test_cmd *cmd)
+{
+    REQUIRE(xSemaphoreTake(cmd->done, pdMS_TO_TICKS(1000)) == pdTRUE);
+    vSemaphoreDelete(cmd->done);
+    return cmd->ret;
+}
+
+static msc_device_t *uas_device_create(void)
+{
+    s_submitted = xQueueCreate(16, sizeof(usb_transfer_t *));
+    REQUIRE(s_submitted != nullptr);
+    usb_host_transfer_alloc_Stub(usb_host_transfer_alloc_mock_callback);
+    usb_host_transfer_free_Stub(usb_host_transfer_free_mock_callback);
+    usb_host_transfer_submit_Stub(uas_submit_mock_callback);
+
+    msc_bot_t *bot = (msc_bot_t *)calloc(1, sizeof(msc_bot_t));
+    msc_device_t *device = (msc_device_t *)calloc(1, sizeof(msc_device_t));
+    REQUIRE((bot && device));
+    bot->handle = (usb_device_handle_t)bot;  // Only passed to the mocked USB Host Library
+    bot->config.uas = true;
+    bot->config.uas_cmd_ep = UAS_CMD_EP;
+    bot->config.uas_status_ep = UAS_STATUS_EP;
+    bot->config.uas_status_mps = UAS_MPS;
+    bot->config.uas_data_in_ep = UAS_DATA_IN_EP;
+    bot->config.uas_data_in_mps = UAS_MPS;
+    bot->config.uas_data_out_ep = UAS_DATA_OUT_EP;
+    bot->luns[0] = device;
+    device->bot = bot;
+    device->handle = bot->handle;
+    REQUIRE(msc_uas_init(bot) == ESP_OK);
+    return device;
+}
+
+static void uas_device_destroy(msc_device_t *device)
+{
+    expect_none_submitted();
+    msc_uas_deinit(device->bot);
+    REQUIRE(device->bot->uas == nullptr);
+    free(device->bot);
+    free(device);
+    vQueueDelete(s_submitted);
+    usb_host_transfer_alloc_Stub(NULL);
+    usb_host_transfer_free_Stub(NULL);
+    usb_host_transfer_submit_Stub(NULL);
+}
+
+// --------------------------------------------------- Tests -----------------------------------------------------------
+
+SCENARIO("MSC UAS: Information Units")
+{
+    msc_device_t *device = uas_device_create();
+    uint8_t data[BLOCK_SIZE];
+    uint8_t pattern[BLOCK_SIZE];
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        pattern[i] = i;
+    }
+
+    GIVEN("READ command") {
+        memset(data, 0, sizeof(data));
+        uas_test_cmd cmd;
+        uas_execute_start(&cmd, device, 0x28, data, sizeof(data), true);
+
+        // The status transfer is submitted before the first command
+        usb_transfer_t *status = expect_submitted(UAS_STATUS_EP);
+        usb_transfer_t *command = expect_submitted(UAS_CMD_EP);
+        REQUIRE(command->num_bytes == 32);
+        REQUIRE(command->data_buffer[0] == IU_COMMAND);
+        REQUIRE(iu_tag(command) == 1);
+        REQUIRE(command->data_buffer[16] == 0x28);  // CDB follows the 16 byte header
+        complete(command, nullptr, command->num_bytes);
+
+        // Data stage starts by READ READY IU
+        const uint8_t read_ready[4] = {IU_READ_READY, 0, 0, 1};
+        complete(status, read_ready, sizeof(read_ready));
+        usb_transfer_t *data_xfer = expect_submitted(UAS_DATA_IN_EP);
+        REQUIRE(data_xfer->num_bytes == BLOCK_SIZE);
+        complete(data_xfer, pattern, sizeof(pattern));
+
+        // Status is resubmitted while the command waits for its Sense IU
+        send_sense_iu(1, 0x00);
+        REQUIRE(uas_execute_wait(&cmd) == ESP_OK);
+        REQUIRE(memcmp(data, pattern, sizeof(pattern)) == 0);
+    }
+
+    GIVEN("WRITE command") {
+        uas_test_cmd cmd;
+        uas_execute_start(&cmd, device, 0x2A, pattern, sizeof(pattern), false);
+
+        expect_submitted(UAS_STATUS_EP);
+        usb_transfer_t *command = expect_submitted(UAS_CMD_EP);
+        REQUIRE(command->data_buffer[16] == 0x2A);
+        const uint16_t tag = iu_tag(command);
+        complete(command, nullptr, command->num_bytes);
+
+        // Data stage starts by WRITE READY IU, with the data of the command
+        send_iu(IU_WRITE_READY, tag);
+        usb_transfer_t *data_xfer = expect_submitted(UAS_DATA_OUT_EP);
+        REQUIRE(data_xfer->num_bytes == sizeof(pattern));
+        REQUIRE(memcmp(data_xfer->data_buffer, pattern, sizeof(pattern)) == 0);
+        complete(data_xfer, nullptr, data_xfer->num_bytes);
+
+        send_sense_iu(tag, 0x00);
+        REQUIRE(uas_execute_wait(&cmd) == ESP_OK);
+    }
+
+    uas_device_destroy(device);
+}
+
+SCENARIO("MSC UAS: Tag allocation")
+{
+    msc_device_t *device = uas_device_create();
+
+    GIVEN("More commands than free tags") {
+        uas_test_cmd cmds[MSC_UAS_MAX_COMMANDS + 1];
+        std::vector<usb_transfer_t *> commands;
+        for (int i = 0; i < MSC_UAS_MAX_COMMANDS + 1; i++) {
+            uas_execute_start(&cmds[i], device, 0x00);  // TEST UNIT READY, no data
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+
+        // One status transfer is shared by all commands, the last command waits for a free tag
+        expect_submitted(UAS_STATUS_EP);
+        for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+            usb_transfer_t *command = expect_submitted(UAS_CMD_EP);
+            REQUIRE(iu_tag(command) == i + 1);
+            commands.push_back(command);
+            complete(command, nullptr, command->num_bytes);
+        }
+        expect_none_submitted();
+
+        // Commands complete out of order, the freed tag is used by the waiting command
+        send_sense_iu(3, 0x00);
+        REQUIRE(uas_execute_wait(&cmds[2]) == ESP_OK);
+        usb_transfer_t *status = expect_submitted(UAS_STATUS_EP);   // Resubmitted for the pending commands
+        usb_transfer_t *command = expect_submitted(UAS_CMD_EP);
+        REQUIRE(iu_tag(command) == 3);
+        complete(command, nullptr, command->num_bytes);
+
+        const uint16_t tags[] = {1, 4, 2, 3};
+        const int waiting[] = {0, 3, 1, 4};
+        for (int i = 0; i < 4; i++) {
+            send_sense_iu(status, tags[i], 0x00);
+            REQUIRE(uas_execute_wait(&cmds[waiting[i]]) == ESP_OK);
+            if (i < 3) {
+                status = expect_submitted(UAS_STATUS_EP);
+            }
+        }
+    }
+
+    uas_device_destroy(device);
+}
+
+SCENARIO("MSC UAS: Sense IU")
+{
+    msc_device_t *device = uas_device_create();
+
+    GIVEN("Command failed with CHECK CONDITION") {
+        uas_test_cmd cmd;
+        uas_execute_start(&cmd, device, 0x00);
+        expect_submitted(UAS_STATUS_EP);
+        usb_transfer_t *command = expect_submitted(UAS_CMD_EP);
+        complete(command, nullptr, command->num_bytes);
+
+        // NOT READY, MEDIUM NOT PRESENT
+        uint8_t sense[MSC_UAS_SENSE_SIZE] = {0x70, 0, 0x02};
+        sense[7] = 10;
+        sense[12] = 0x3A;
+        send_sense_iu(iu_tag(command), 0x02, sense, sizeof(sense));
+        REQUIRE(uas_execute_wait(&cmd) == ESP_FAIL);
+
+        SECTION("REQUEST SENSE returns the sense data of the Sense IU") {
+            scsi_sense_data_t sense_data;
+            REQUIRE(scsi_cmd_sense(device, &sense_data) == ESP_OK);
+            REQUIRE(sense_data.key == 0x02);
+            REQUIRE(sense_data.code == 0x3A);
+            REQUIRE(sense_data.code_q == 0x00);
+            // No command was sent to the device
+            expect_none_submitted();
+        }
+
+        SECTION("Sense data are returned once") {
+            uint8_t taken[MSC_UAS_SENSE_SIZE];
+            REQUIRE(msc_uas_take_sense(device, taken) == ESP_OK);
+            REQUIRE(memcmp(taken, sense, sizeof(sense)) == 0);
+            REQUIRE(msc_uas_take_sense(device, taken) == ESP_ERR_NOT_FOUND);
+        }
+    }
+
+    uas_device_destroy(device);
+}
+
+// ------------------------------------------ Alternate setting selection ----------------------------------------------
+
+// Bulk-Only interface with UAS alternate setting
+static const uint8_t uas_config_desc[] = {
+    0x09, 0x02, 0x55, 0x00, 0x01, 0x01, 0x00, 0x80, 0x32,
+    // Alternate setting 0: Bulk-Only Transport
+    0x09, 0x04, 0x00, 0x00, 0x02, 0x08, 0x06, 0x50, 0x00,
+    0x07, 0x05, BOT_IN_EP, 0x02, 0x00, 0x02, 0x00,
+    0x07, 0x05, BOT_OUT_EP, 0x02, 0x00, 0x02, 0x00,
+    // Alternate setting 1: USB Attached SCSI, every endpoint is followed by its Pipe Usage descriptor
+    0x09, 0x04, 0x00, 0x01, 0x04, 0x08, 0x06, 0x62, 0x00,
+    0x07, 0x05, UAS_CMD_EP, 0x02, 0x00, 0x02, 0x00, 0x04, 0x24, 0x01, 0x00,
+    0x07, 0x05, UAS_STATUS_EP, 0x02, 0x00, 0x02, 0x00, 0x04, 0x24, 0x02, 0x00,
+    0x07, 0x05, UAS_DATA_IN_EP, 0x02, 0x00, 0x02, 0x00, 0x04, 0x24, 0x03, 0x00,
+    0x07, 0x05, UAS_DATA_OUT_EP, 0x02, 0x00, 0x02, 0x00, 0x04, 0x24, 0x04, 0x00,
+};
+
+static const uint8_t uas_device_desc[] = {
+    0x12, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x40, 0x3A, 0x30, 0x02, 0x40, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+};
+
+static bool s_set_interface_accepted;
+static std::vector<int> s_set_interface_alts;
+static std::vector<int> s_claimed_alts;
+static int s_released;
+static uint8_t s_first_bulk_ep;
+
+static esp_err_t submit_control_mock_callback(usb_host_client_handle_t client_hdl, usb_transfer_t *transfer, int call_count)
+{
+    const usb_setup_packet_t *setup = (const usb_setup_packet_t *)transfer->data_buffer;
+    transfer->status = USB_TRANSFER_STATUS_COMPLETED;
+    transfer->actual_num_bytes = transfer->num_bytes;
+    if (setup->bRequest == USB_B_REQUEST_SET_INTERFACE) {
+        s_set_interface_alts.push_back(setup->wValue);
+        if (!s_set_interface_accepted) {
+            transfer->status = USB_TRANSFER_STATUS_STALL;
+        }
+    } else {
+        transfer->data_buffer[USB_SETUP_PACKET_SIZE] = 0; // Get Max LUN
+    }
+    transfer->callback(transfer);
+    return ESP_OK;
+}
+
+static esp_err_t interface_claim_mock_callback(usb_host_client_handle_t client_hdl, usb_device_handle_t dev_hdl, uint8_t bInterfaceNumber, uint8_t bAlternateSetting, int call_count)
+{
+    s_claimed_alts.push_back(bAlternateSetting);
+    return ESP_OK;
+}
+
+static esp_err_t interface_release_mock_callback(usb_host_client_handle_t client_hdl, usb_device_handle_t dev_hdl, uint8_t bInterfaceNumber, int call_count)
+{
+    s_released++;
+    return ESP_OK;
+}
+
+static esp_err_t submit_fail_mock_callback(usb_transfer_t *transfer, int call_count)
+{
+    if (s_first_bulk_ep == 0) {
+        s_first_bulk_ep = transfer->bEndpointAddress;
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+SCENARIO("MSC UAS: Alternate setting selection")
+{
+    const msc_host_driver_config_t msc_host_driver_config = {
+        .create_backround_task = false,
+        .task_priority = 5,
+        .stack_size = 4096,
+        .core_id = 0,
+        .callback = (reinterpret_cast<msc_host_event_cb_t>(0xdeadbeef)),
+        .callback_arg = nullptr,
+    };
+    const uint8_t dev_addr = 1;
+
+    usb_host_mock_dev_list_init();
+    REQUIRE(usb_host_mock_add_device(dev_addr, (const usb_device_desc_t *)uas_device_desc, (const usb_config_desc_t *)uas_config_desc) == ESP_OK);
+    usb_host_client_register_Stub(usb_host_client_register_mock_callback);
+    usb_host_client_deregister_Stub(usb_host_client_deregister_mock_callback);
+    usb_host_device_open_Stub(usb_host_device_open_mock_callback);
+    usb_host_device_close_Stub(usb_host_device_close_mock_callback);
+    usb_host_get_active_config_descriptor_Stub(usb_host_get_active_config_descriptor_mock_callback);
+    usb_host_transfer_alloc_Stub(usb_host_transfer_alloc_mock_callback);
+    usb_host_transfer_free_Stub(usb_host_transfer_free_mock_callback);
+    usb_host_transfer_submit_control_Stub(submit_control_mock_callback);
+    usb_host_interface_claim_Stub(interface_claim_mock_callback);
+    usb_host_interface_release_Stub(interface_release_mock_callback);
+    // The first SCSI command fails, so the installation stops after the transport was selected
+    usb_host_transfer_submit_Stub(submit_fail_mock_callback);
+    s_set_interface_alts.clear();
+    s_claimed_alts.clear();
+    s_released = 0;
+    s_first_bulk_ep = 0;
+    REQUIRE(msc_host_install(&msc_host_driver_config) == ESP_OK);
+
+    msc_host_device_handle_t device;
+
+    GIVEN("Device accepts the UAS alternate setting") {
+        s_set_interface_accepted = true;
+        REQUIRE(msc_host_install_device(dev_addr, &device) != ESP_OK);
+
+        REQUIRE((s_set_interface_alts == std::vector<int> {1}));
+        REQUIRE((s_claimed_alts == std::vector<int> {1}));
+        REQUIRE(s_first_bulk_ep == UAS_STATUS_EP);
+    }
+
+    GIVEN("Device rejects the UAS alternate setting") {
+        s_set_interface_accepted = false;
+        REQUIRE(msc_host_install_device(dev_addr, &device) != ESP_OK);
+
+        // The interface is claimed again with the Bulk-Only alternate setting, which is used for the commands
+        REQUIRE((s_set_interface_alts == std::vector<int> {1}));
+        REQUIRE((s_claimed_alts == std::vector<int> {1, 0}));
+        REQUIRE(s_released == 2);   // Fallback and installation failure
+        REQUIRE(s_first_bulk_ep == BOT_OUT_EP);
+    }
+
+    REQUIRE(msc_host_uninstall() == ESP_OK);
+    usb_host_client_register_Stub(NULL);
+    usb_host_client_deregister_Stub(NULL);
+    usb_host_device_open_Stub(NULL);
+    usb_host_device_close_Stub(NULL);
+    usb_host_get_active_config_descriptor_Stub(NULL);
+    usb_host_transfer_alloc_Stub(NULL);
+    usb_host_transfer_free_Stub(NULL);
+    usb_host_transfer_submit_control_Stub(NULL);
+    usb_host_interface_claim_Stub(NULL);
+    usb_host_interface_release_Stub(NULL);
+    usb_host_transfer_submit_Stub(NULL);
+}
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -33,16 +33,34 @@ esp_err_t scsi_cmd_write10(msc_host_device_handle_t device,
                            uint32_t num_sectors,
                            uint32_t sector_size);
 
+esp_err_t scsi_cmd_read16(msc_host_device_handle_t device,
+                          uint8_t *data,
+                          uint64_t sector_address,
+                          uint32_t num_sectors,
+                          uint32_t sector_size);
+
+esp_err_t scsi_cmd_write16(msc_host_device_handle_t device,
+                           const uint8_t *data,
+                           uint64_t sector_address,
+                           uint32_t num_sectors,
+                           uint32_t sector_size);
+
 esp_err_t scsi_cmd_read_capacity(msc_host_device_handle_t device,
                                  uint32_t *block_size,
                                  uint32_t *block_count);
 
+esp_err_t scsi_cmd_read_capacity16(msc_host_device_handle_t device,
+                                   uint32_t *block_size,
+                                   uint64_t *block_count);
+
 esp_err_t scsi_cmd_sense(msc_host_device_handle_t device, scsi_sense_data_t *sense);
 
 esp_err_t scsi_cmd_unit_ready(msc_host_device_handle_t device);
 
 esp_err_t scsi_cmd_inquiry(msc_host_device_handle_t device);
 
+esp_err_t scsi_cmd_block_limits(msc_host_device_handle_t device, uint32_t *max_transfer_length);
+
 esp_err_t scsi_cmd_prevent_removal(msc_host_device_handle_t device, bool prevent);
 
 esp_err_t scsi_cmd_mode_sense(msc_host_device_handle_t device);
@@ -70,21 +70,50 @@ typedef struct {
     BaseType_t core_id;             /*!< Core affinity of the created background task, or tskNO_AFFINITY. */
     msc_host_event_cb_t callback;   /*!< Callback invoked when MSC event occurs. Must not be NULL. */
     void *callback_arg;             /*!< User-provided argument passed to callback. */
+    uint8_t identify_cache_size;    /*!< Number of LUNs whose SCSI identification (INQUIRY data, capacity, transfer limits) is remembered
+                                         by USB serial number, to speed up their next installation. 0 to disable. */
 } msc_host_driver_config_t;
 
 /**
  * @brief MSC device info.
  */
 typedef struct {
-    uint32_t sector_count;                     /*!< Number of addressable sectors on the device. */
+    uint32_t sector_count;                     /*!< Number of addressable sectors on the device, limited to UINT32_MAX. */
     uint32_t sector_size;                      /*!< Sector size in bytes. */
     uint16_t idProduct;                        /*!< USB product ID. */
     uint16_t idVendor;                         /*!< USB vendor ID. */
     wchar_t iManufacturer[MSC_STR_DESC_SIZE];  /*!< Manufacturer string. */
     wchar_t iProduct[MSC_STR_DESC_SIZE];       /*!< Product string. */
     wchar_t iSerialNumber[MSC_STR_DESC_SIZE];  /*!< Serial number string. */
+    uint8_t lun;                               /*!< Logical Unit Number accessed through the device handle. */
+    uint64_t sector_count_64;                  /*!< Number of addressable sectors on the device, not limited to 32 bits. */
 } msc_host_device_info_t;
 
+/**
+ * @brief Write-back sector cache configuration.
+ */
+typedef struct {
+    size_t sector_count;        /*!< Number of cached sectors. Must be a multiple of ways. */
+    uint8_t ways;               /*!< Associativity, i.e. number of sectors that can be cached for one set of addresses. */
+    uint32_t idle_flush_ms;     /*!< Dirty sectors are written to the device after this time without writes. 0 to flush only on sync. */
+    uint32_t heap_caps;         /*!< Heap capabilities of the cache memory, e.g. MALLOC_CAP_SPIRAM. 0 for MALLOC_CAP_DEFAULT. */
+} msc_host_disk_cache_config_t;
+
+/**
+ * @brief Write-back sector cache statistics.
+ */
+typedef struct {
+    uint32_t read_hits;         /*!< Sectors read from the cache. */
+    uint32_t read_misses;       /*!< Sectors read from the device. */
+    uint32_t write_hits;        /*!< Sector writes that updated a cached sector. */
+    uint32_t write_misses;      /*!< Sector writes that allocated a new cache line or went directly to the device. */
+    uint32_t evictions;         /*!< Valid sectors replaced by other sectors. */
+    uint32_t flushes;           /*!< Flushes that found dirty sectors. */
+    uint32_t flush_commands;    /*!< WRITE commands issued by flushes. */
+    uint32_t flushed_sectors;   /*!< Dirty sectors written to the device by flushes. */
+    uint32_t discarded_sectors; /*!< Dirty sectors lost because the device was disconnected. */
+} msc_host_disk_cache_stats_t;
+
 /**
  * @brief Install the USB Host Mass Storage Class driver.
  *
@@ -111,6 +140,9 @@ esp_err_t msc_host_uninstall(void);
 /**
  * @brief Initialize an MSC device after connection.
  *
+ * The returned handle accesses LUN 0 of the device. Other LUNs (e.g. slots of a card reader)
+ * are installed with msc_host_install_lun().
+ *
  * @param[in] device_address Device address obtained from the MSC connection callback.
  * @param[out] device Mass storage device handle to use for subsequent API calls. Must not be NULL.
  *
@@ -123,9 +155,45 @@ esp_err_t msc_host_uninstall(void);
 esp_err_t msc_host_install_device(uint8_t device_address, msc_host_device_handle_t *device);
 
 /**
- * @brief Deinitialize an MSC device.
+ * @brief Get number of Logical Units of an MSC device.
+ *
+ * Devices that do not support the Get Max LUN request report one LUN.
  *
  * @param[in] device Device handle obtained from msc_host_install_device().
+ * @param[out] lun_count Number of LUNs of the device.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if device or lun_count is NULL
+ */
+esp_err_t msc_host_get_lun_count(msc_host_device_handle_t device, uint8_t *lun_count);
+
+/**
+ * @brief Initialize another Logical Unit of an installed MSC device.
+ *
+ * The new handle can be used in the same way as the handle returned by msc_host_install_device(),
+ * e.g. to mount the LUN with msc_host_vfs_register(). All LUNs of one device share its bulk endpoints.
+ * Commands issued to different LUNs from several tasks are executed in round-robin order.
+ *
+ * Each LUN handle must be uninstalled with msc_host_uninstall_device(). The USB device is released with the last one.
+ *
+ * @param[in] device Handle of any installed LUN of the device.
+ * @param[in] lun Logical Unit Number, lower than the count reported by msc_host_get_lun_count().
+ * @param[out] lun_device Mass storage device handle of the LUN.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if device or lun_device is NULL or the LUN does not exist
+ *      - ESP_ERR_INVALID_STATE if the LUN is already installed
+ *      - ESP_ERR_NO_MEM if memory allocation fails
+ *      - Other error codes from the MSC transport layer, e.g. if no medium is present in the LUN
+ */
+esp_err_t msc_host_install_lun(msc_host_device_handle_t device, uint8_t lun, msc_host_device_handle_t *lun_device);
+
+/**
+ * @brief Deinitialize an MSC device.
+ *
+ * @param[in] device Device handle obtained from msc_host_install_device() or msc_host_install_lun().
  *
  * @return
  *      - ESP_OK on success
@@ -219,9 +287,72 @@ esp_err_t msc_host_get_device_info(msc_host_device_handle_t device, msc_host_dev
  */
 esp_err_t msc_host_print_descriptors(msc_host_device_handle_t device);
 
+/**
+ * @brief Enable write-back sector cache of an MSC device.
+ *
+ * Without the cache, each sector written by the file system (e.g. FAT and directory updates) is sent to the device
+ * by its own WRITE command. With the cache, short writes are kept in memory and adjacent dirty sectors are written
+ * together, when the file system syncs (e.g. fclose(), fsync()), when the cache line is needed for another sector,
+ * after idle_flush_ms without writes and when the device is uninstalled.
+ *
+ * Writes that are not flushed yet are lost if the device is disconnected.
+ *
+ * @note The cache is used by the file system only. msc_host_read_sector() and msc_host_write_sector() bypass it.
+ *
+ * @param[in] device Device handle.
+ * @param[in] config Cache configuration.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if device or config is NULL or config is invalid
+ *      - ESP_ERR_INVALID_STATE if the cache is already enabled
+ *      - ESP_ERR_NO_MEM if memory allocation fails
+ */
+esp_err_t msc_host_disk_cache_enable(msc_host_device_handle_t device, const msc_host_disk_cache_config_t *config);
+
+/**
+ * @brief Flush and disable write-back sector cache of an MSC device.
+ *
+ * @param[in] device Device handle.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if device is NULL
+ *      - ESP_ERR_INVALID_STATE if the cache is not enabled
+ */
+esp_err_t msc_host_disk_cache_disable(msc_host_device_handle_t device);
+
+/**
+ * @brief Write all dirty sectors of the write-back cache to the device.
+ *
+ * @param[in] device Device handle.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if device is NULL
+ *      - ESP_ERR_INVALID_STATE if the cache is not enabled or the device is gone
+ *      - Other error codes from the MSC transport layer
+ */
+esp_err_t msc_host_disk_cache_flush(msc_host_device_handle_t device);
+
+/**
+ * @brief Get statistics of the write-back sector cache.
+ *
+ * @param[in] device Device handle.
+ * @param[out] stats Cache statistics.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if device or stats is NULL
+ *      - ESP_ERR_INVALID_STATE if the cache is not enabled
+ */
+esp_err_t msc_host_disk_cache_get_stats(msc_host_device_handle_t device, msc_host_disk_cache_stats_t *stats);
+
 /**
  * @brief Perform MSC Bulk-Only Transport reset recovery.
  *
+ * The reset applies to all LUNs of the device.
+ *
  * @see USB Mass Storage Class – Bulk Only Transport, Chapter 5.3.4
  *
  * @param[in] device Handle of the MSC device.
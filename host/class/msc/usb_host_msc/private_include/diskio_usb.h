@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2021 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -15,7 +15,7 @@ extern "C" {
  */
 typedef struct {
     uint32_t block_size;    /**< Block size */
-    uint32_t block_count;   /**< Block count */
+    uint64_t block_count;   /**< Block count */
 } usb_disk_t;
 
 /**
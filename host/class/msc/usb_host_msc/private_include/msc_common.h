@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -13,6 +13,8 @@
 #include "diskio_usb.h"
 #include "usb/usb_host.h"
 #include "usb/usb_types_stack.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "freertos/semphr.h"
 
 #ifdef __cplusplus
@@ -30,21 +32,128 @@ typedef struct {
     uint8_t bulk_in_ep;
     uint8_t bulk_out_ep;
     uint8_t iface_num;
+    uint8_t alt_setting;
+    bool uas;                   // USB Attached SCSI is used instead of Bulk-Only Transport
+    uint8_t uas_cmd_ep;
+    uint8_t uas_status_ep;
+    uint8_t uas_data_in_ep;
+    uint8_t uas_data_out_ep;
+    uint16_t uas_status_mps;
+    uint16_t uas_data_in_mps;
 } msc_config_t;
 
-typedef struct msc_host_device {
-    STAILQ_ENTRY(msc_host_device) tailq_entry;
-    SemaphoreHandle_t transfer_done;
+#define MSC_MAX_LUN_NUM     16  // Bulk-Only Transport supports up to 16 logical units
+#define MSC_MAX_TRANSFER_SIZE   (64 * 1024) // Maximum data size of one SCSI READ/WRITE command, bounds the transfer buffer
+
+typedef struct msc_host_device msc_device_t;
+typedef struct msc_uas msc_uas_t;
+typedef struct msc_disk_cache msc_disk_cache_t;
+
+/**
+ * @brief Transport shared by all logical units of one USB device
+ *
+ * With Bulk-Only Transport, only one command can be in progress on the bulk pipes. Commands of different LUNs are scheduled round-robin
+ * by msc_bot_lock() and msc_bot_unlock(), so that a busy LUN cannot starve the others.
+ */
+typedef struct {
     usb_device_handle_t handle;
     usb_transfer_t *xfer;
+    SemaphoreHandle_t transfer_done;
     msc_config_t config;
+    msc_uas_t *uas;                         // USB Attached SCSI transport, NULL for Bulk-Only Transport
+    uint8_t max_lun;                        // Maximum LUN reported by the device
+    uint32_t cbw_tag;                       // Unique number based on which MSC protocol pairs request and response
+    // Scheduling, protected by MSC driver spin lock
+    bool busy;                              // A task owns the bulk pipes
+    TaskHandle_t owner;                     // Task owning the bulk pipes, NULL while ownership is being handed over
+    uint32_t owner_depth;                   // Number of nested msc_bot_lock() calls of the owner
+    uint8_t last_lun;                       // LUN served last, the next LUN is served in round-robin order
+    msc_device_t *luns[MSC_MAX_LUN_NUM];    // Installed logical units
+} msc_bot_t;
+
+struct msc_host_device {
+    STAILQ_ENTRY(msc_host_device) tailq_entry;
+    usb_device_handle_t handle;
+    msc_bot_t *bot;
+    uint8_t lun;
+    uint8_t scsi_version;                   // VERSION field of the standard INQUIRY data
+    bool removable;                         // RMB bit of the standard INQUIRY data
+    bool lba64;                             // Capacity requires READ/WRITE(16) commands
+    bool ident_cached;                      // Identification was taken from the identification cache
+    uint32_t max_transfer_blocks;           // Maximum number of blocks of one READ/WRITE command
+    uint32_t cmd_waiting;                   // Number of tasks waiting for the bulk pipes with a command to this LUN
+    SemaphoreHandle_t cmd_slot;             // Given when the bulk pipes are handed over to a task waiting on this LUN
+    msc_disk_cache_t *cache;                // Optional write-back cache used by the diskio layer
     usb_disk_t disk;
-} msc_device_t;
+};
+
+/**
+ * @brief Get exclusive access to the Bulk-Only Transport of a device
+ *
+ * Tasks waiting for the transport are served round-robin by LUN, and in FIFO order within one LUN.
+ * The lock is recursive, so a task owning the transport can call it again (e.g. during error recovery).
+ *
+ * @param[in] device MSC device handle
+ */
+void msc_bot_lock(msc_device_t *device);
+
+/**
+ * @brief Release the Bulk-Only Transport of a device
+ *
+ * Hands the transport over to a task waiting on the next LUN in round-robin order.
+ *
+ * @param[in] device MSC device handle
+ */
+void msc_bot_unlock(msc_device_t *device);
+
+/**
+ * @brief Read blocks from a logical unit
+ *
+ * Requests larger than max_transfer_blocks are split into several commands. READ(16) is used for devices
+ * with more than 2^32 blocks.
+ *
+ * @param[in]  device MSC device handle
+ * @param[out] data   Data buffer
+ * @param[in]  lba    First block to read
+ * @param[in]  count  Number of blocks to read
+ * @return esp_err_t
+ */
+esp_err_t msc_disk_read(msc_device_t *device, uint8_t *data, uint64_t lba, uint32_t count);
+
+/**
+ * @brief Write blocks to a logical unit
+ *
+ * Requests larger than max_transfer_blocks are split into several commands. WRITE(16) is used for devices
+ * with more than 2^32 blocks.
+ *
+ * @param[in] device MSC device handle
+ * @param[in] data   Data buffer
+ * @param[in] lba    First block to write
+ * @param[in] count  Number of blocks to write
+ * @return esp_err_t
+ */
+esp_err_t msc_disk_write(msc_device_t *device, const uint8_t *data, uint64_t lba, uint32_t count);
+
+/**
+ * @brief Make sure the transfer buffer is large enough for a BULK transfer
+ *
+ * The current buffer is kept if a larger one cannot be allocated.
+ * The caller must own the transport, see msc_bot_lock()
+ *
+ * @param[in] device_handle MSC device handle
+ * @param[in] size          Size of the transfer in bytes
+ * @param[in] ep            Direction of the transfer
+ * @return
+ *      - ESP_OK if the buffer is large enough
+ *      - ESP_ERR_NO_MEM if a larger buffer cannot be allocated
+ */
+esp_err_t msc_bulk_buffer_reserve(msc_device_t *device_handle, size_t size, msc_endpoint_t ep);
 
 /**
  * @brief Trigger a BULK transfer to device
  *
  * Data buffer ownership is transferred to the MSC driver and the application cannot access it before the transfer finishes.
+ * The caller must own the transport, see msc_bot_lock()
  *
  * @param[in]    device_handle MSC device handle
  * @param[inout] data          Data buffer. Direction depends on 'ep'.
@@ -57,7 +166,8 @@ esp_err_t msc_bulk_transfer(msc_device_t *device_handle, uint8_t *data, size_t s
 /**
  * @brief Trigger a CTRL transfer to device
  *
- * The request and data must be filled by accessing private device_handle->xfer before calling this function
+ * The request and data must be filled by accessing private device_handle->bot->xfer before calling this function.
+ * The caller must own the transport, see msc_bot_lock()
  *
  * @param[in] device_handle MSC device handle
  * @param[in] len           Length of the transfer
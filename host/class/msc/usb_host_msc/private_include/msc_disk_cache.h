@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "msc_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Read blocks through the write-back cache of a device
+ *
+ * Cached blocks are served from memory, the others are read from the device.
+ *
+ * @param[in]  cache  Cache of the device
+ * @param[out] data   Buffer for count blocks
+ * @param[in]  lba    First block
+ * @param[in]  count  Number of blocks
+ * @return esp_err_t
+ */
+esp_err_t msc_disk_cache_read(msc_disk_cache_t *cache, uint8_t *data, uint64_t lba, uint32_t count);
+
+/**
+ * @brief Write blocks through the write-back cache of a device
+ *
+ * Short writes are kept in the cache until it is flushed. Long writes go to the device immediately.
+ *
+ * @param[in] cache  Cache of the device
+ * @param[in] data   count blocks to write
+ * @param[in] lba    First block
+ * @param[in] count  Number of blocks
+ * @return esp_err_t
+ */
+esp_err_t msc_disk_cache_write(msc_disk_cache_t *cache, const uint8_t *data, uint64_t lba, uint32_t count);
+
+/**
+ * @brief Write all dirty blocks to the device
+ *
+ * Dirty blocks with consecutive addresses are written by one command.
+ *
+ * @param[in] cache  Cache of the device
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the device is gone, its dirty blocks are discarded
+ *      - Other error codes from the MSC transport layer, the blocks stay dirty
+ */
+esp_err_t msc_disk_cache_flush(msc_disk_cache_t *cache);
+
+/**
+ * @brief Mark the device of a cache as gone
+ *
+ * Called from the USB event context when the device is disconnected. Dirty blocks are discarded
+ * the next time the cache is used, because no transfers can be done anymore.
+ *
+ * @param[in] cache  Cache of the device, can be NULL
+ */
+void msc_disk_cache_device_gone(msc_disk_cache_t *cache);
+
+/**
+ * @brief Flush and free the cache of a device
+ *
+ * @param[in] device  Device, its cache can be NULL
+ */
+void msc_disk_cache_destroy(msc_device_t *device);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "msc_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MSC_UAS_MAX_COMMANDS    4   // Maximum number of outstanding UAS commands per device
+#define MSC_UAS_SENSE_SIZE      18  // Fixed format sense data kept from a Sense IU
+
+/**
+ * @brief Initialize USB Attached SCSI transport of a device
+ *
+ * The UAS alternate setting of the interface must be claimed.
+ *
+ * @param[in] bot Transport of the device, with UAS endpoints in its configuration
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NO_MEM if memory allocation fails
+ */
+esp_err_t msc_uas_init(msc_bot_t *bot);
+
+/**
+ * @brief Deinitialize USB Attached SCSI transport of a device
+ *
+ * Pending transfers are canceled. No command may be in progress.
+ *
+ * @param[in] bot Transport of the device
+ */
+void msc_uas_deinit(msc_bot_t *bot);
+
+/**
+ * @brief Execute SCSI command over USB Attached SCSI
+ *
+ * Several tasks can execute commands at the same time. Up to MSC_UAS_MAX_COMMANDS commands are
+ * outstanding on the device, each identified by its tag.
+ *
+ * @param[in]    device  MSC device handle
+ * @param[in]    cdb     Command Descriptor Block
+ * @param[in]    cdb_len Length of CDB, at most 16 bytes
+ * @param[inout] data    Data (optional)
+ * @param[in]    size    Size of data in bytes
+ * @param[in]    data_in Data are transferred from the device
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL if the command finished with other than GOOD status
+ *      - ESP_ERR_NO_MEM if the transfer buffer cannot be allocated, nothing was sent to the device
+ *      - ESP_ERR_MSC_STALL if the data stage stalled
+ *      - ESP_ERR_MSC_INTERNAL on transport errors and timeouts
+ */
+esp_err_t msc_uas_execute_command(msc_device_t *device, const uint8_t *cdb, uint8_t cdb_len, void *data, size_t size, bool data_in);
+
+/**
+ * @brief Recover UAS endpoints after an error
+ *
+ * Clears halt of all four UAS pipes.
+ *
+ * @param[in] device MSC device handle
+ * @return esp_err_t
+ */
+esp_err_t msc_uas_reset_recovery(msc_device_t *device);
+
+/**
+ * @brief Take sense data of the last failed command
+ *
+ * The device returns the sense data of a failed command in its Sense IU and then clears it,
+ * so a following REQUEST SENSE would not report the error. The stored sense data is returned instead.
+ *
+ * @param[in]  device MSC device handle
+ * @param[out] sense  Buffer for MSC_UAS_SENSE_SIZE bytes of fixed format sense data
+ * @return
+ *      - ESP_OK if sense data were stored, they are consumed
+ *      - ESP_ERR_NOT_FOUND if no sense data are stored
+ */
+esp_err_t msc_uas_take_sense(msc_device_t *device, uint8_t *sense);
+
+#ifdef __cplusplus
+}
+#endif
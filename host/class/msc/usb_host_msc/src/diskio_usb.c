@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -8,9 +8,11 @@
 #include "ffconf.h"
 #include "ff.h"
 #include "esp_log.h"
+#include <sys/param.h>
 #include "diskio_usb.h"
 #include "msc_scsi_bot.h"
 #include "msc_common.h"
+#include "msc_disk_cache.h"
 #include "usb/usb_types_stack.h"
 
 static usb_disk_t *s_disks[FF_VOLUMES] = { NULL };
@@ -33,12 +35,12 @@ static DRESULT usb_disk_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
     assert(s_disks[pdrv]);
 
     usb_disk_t *disk = s_disks[pdrv];
-    size_t sector_size = disk->block_size;
     msc_device_t *dev = __containerof(disk, msc_device_t, disk);
 
-    esp_err_t err = scsi_cmd_read10(dev, buff, sector, count, sector_size);
+    esp_err_t err = dev->cache ? msc_disk_cache_read(dev->cache, buff, sector, count)
+                    : msc_disk_read(dev, buff, sector, count);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "scsi_cmd_read10 failed (%d)", err);
+        ESP_LOGE(TAG, "msc_disk_read failed (%d)", err);
         return RES_ERROR;
     }
 
@@ -51,12 +53,12 @@ static DRESULT usb_disk_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT c
     assert(s_disks[pdrv]);
 
     usb_disk_t *disk = s_disks[pdrv];
-    size_t sector_size = disk->block_size;
     msc_device_t *dev = __containerof(disk, msc_device_t, disk);
 
-    esp_err_t err = scsi_cmd_write10(dev, buff, sector, count, sector_size);
+    esp_err_t err = dev->cache ? msc_disk_cache_write(dev->cache, buff, sector, count)
+                    : msc_disk_write(dev, buff, sector, count);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "scsi_cmd_write10 failed (%d)", err);
+        ESP_LOGE(TAG, "msc_disk_write failed (%d)", err);
         return RES_ERROR;
     }
     return RES_OK;
@@ -68,12 +70,21 @@ static DRESULT usb_disk_ioctl (BYTE pdrv, BYTE cmd, void *buff)
     assert(s_disks[pdrv]);
 
     usb_disk_t *disk = s_disks[pdrv];
+    msc_device_t *dev = __containerof(disk, msc_device_t, disk);
 
     switch (cmd) {
     case CTRL_SYNC:
+        if (dev->cache) {
+            esp_err_t err = msc_disk_cache_flush(dev->cache);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "msc_disk_cache_flush failed (%d)", err);
+                return RES_ERROR;
+            }
+        }
         return RES_OK;
     case GET_SECTOR_COUNT:
-        *((DWORD *) buff) = disk->block_count;
+        // FatFs addresses at most 2^32 sectors, larger disks are used up to this limit
+        *((DWORD *) buff) = (DWORD)MIN(disk->block_count, UINT32_MAX);
         return RES_OK;
     case GET_SECTOR_SIZE:
         *((WORD *) buff) = disk->block_size;
@@ -0,0 +1,442 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "usb/msc_host.h"
+#include "msc_common.h"
+#include "msc_disk_cache.h"
+
+static const char *TAG = "USB_MSC_CACHE";
+
+#define MSC_DISK_CACHE_FLUSH_BLOCKS     16                      // Maximum number of blocks written by one flush command
+#define MSC_DISK_CACHE_TASK_STACK       3072
+#define MSC_DISK_CACHE_TASK_PRIORITY    (tskIDLE_PRIORITY + 1)
+
+typedef struct {
+    uint64_t lba;           // Block held by this line
+    uint32_t last_use;      // Value of use_counter at the last access, for LRU replacement
+    bool valid;
+    bool dirty;             // Block was written to the cache but not to the device
+} cache_line_t;
+
+/**
+ * @brief Set-associative write-back block cache
+ *
+ * Block with address lba can only be held by one of the 'ways' lines of set (lba % num_sets).
+ * Consecutive blocks belong to different sets, so a run of up to num_sets blocks never evicts itself.
+ */
+struct msc_disk_cache {
+    msc_device_t *device;
+    SemaphoreHandle_t mutex;            // Protects all members below, except device_gone
+    TaskHandle_t flush_task;            // Idle flush task, NULL if disabled
+    uint32_t idle_flush_ms;
+    volatile bool device_gone;          // Set from USB event context, dirty blocks cannot be written anymore
+    uint32_t block_size;
+    uint32_t num_sets;
+    uint8_t ways;
+    uint32_t use_counter;
+    uint32_t num_dirty;
+    cache_line_t *lines;                // num_sets * ways lines, lines of one set are adjacent
+    uint8_t *data;                      // One block per line
+    uint32_t *flush_order;              // Indexes of dirty lines, sorted by address during flush
+    uint8_t *staging;                   // Dirty blocks with consecutive addresses are gathered here
+    uint32_t staging_blocks;
+    msc_host_disk_cache_stats_t stats;
+};
+
+static inline uint8_t *line_data(const msc_disk_cache_t *cache, uint32_t line)
+{
+    return cache->data + (size_t)line * cache->block_size;
+}
+
+static inline void line_touch(msc_disk_cache_t *cache, uint32_t line)
+{
+    cache->lines[line].last_use = ++cache->use_counter;
+}
+
+/**
+ * @brief Find the line holding a block
+ *
+ * @return Line index, or -1 if the block is not cached
+ */
+static int cache_find(const msc_disk_cache_t *cache, uint64_t lba)
+{
+    const uint32_t first = (uint32_t)(lba % cache->num_sets) * cache->ways;
+    for (uint32_t line = first; line < first + cache->ways; line++) {
+        if (cache->lines[line].valid && cache->lines[line].lba == lba) {
+            return line;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Drop all dirty blocks of a disconnected device
+ */
+static void cache_discard(msc_disk_cache_t *cache)
+{
+    if (cache->num_dirty == 0) {
+        return;
+    }
+    ESP_LOGW(TAG, "Device gone, %"PRIu32" unwritten blocks discarded", cache->num_dirty);
+    for (uint32_t line = 0; line < cache->num_sets * cache->ways; line++) {
+        if (cache->lines[line].dirty) {
+            cache->lines[line].dirty = false;
+            cache->lines[line].valid = false;
+        }
+    }
+    cache->stats.discarded_sectors += cache->num_dirty;
+    cache->num_dirty = 0;
+}
+
+/**
+ * @brief Write all dirty blocks to the device, cache mutex must be taken
+ */
+static esp_err_t cache_flush_locked(msc_disk_cache_t *cache)
+{
+    if (cache->device_gone) {
+        cache_discard(cache);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cache->num_dirty == 0) {
+        return ESP_OK;
+    }
+
+    // Insertion sort of the dirty lines by address, there are few of them and they are mostly in order already
+    uint32_t num = 0;
+    for (uint32_t line = 0; line < cache->num_sets * cache->ways; line++) {
+        if (!cache->lines[line].dirty) {
+            continue;
+        }
+        uint32_t pos = num++;
+        while (pos > 0 && cache->lines[cache->flush_order[pos - 1]].lba > cache->lines[line].lba) {
+            cache->flush_order[pos] = cache->flush_order[pos - 1];
+            pos--;
+        }
+        cache->flush_order[pos] = line;
+    }
+
+    cache->stats.flushes++;
+    for (uint32_t i = 0; i < num;) {
+        const uint64_t lba = cache->lines[cache->flush_order[i]].lba;
+        uint32_t run = 0;
+        while (i + run < num && run < cache->staging_blocks &&
+                cache->lines[cache->flush_order[i + run]].lba == lba + run) {
+            memcpy(cache->staging + (size_t)run * cache->block_size,
+                   line_data(cache, cache->flush_order[i + run]), cache->block_size);
+            run++;
+        }
+
+        MSC_RETURN_ON_ERROR( msc_disk_write(cache->device, cache->staging, lba, run) );
+
+        for (uint32_t j = 0; j < run; j++) {
+            cache->lines[cache->flush_order[i + j]].dirty = false;
+        }
+        cache->num_dirty -= run;
+        cache->stats.flush_commands++;
+        cache->stats.flushed_sectors += run;
+        i += run;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Get a line for a block that is not cached
+ *
+ * An invalid line of the set is used, or the least recently used one is replaced.
+ * If the replaced line is dirty, the whole cache is flushed, so that it is written together with its neighbors.
+ */
+static esp_err_t cache_alloc(msc_disk_cache_t *cache, uint64_t lba, uint32_t *line_out)
+{
+    const uint32_t first = (uint32_t)(lba % cache->num_sets) * cache->ways;
+    uint32_t victim = first;
+
+    for (uint32_t line = first; line < first + cache->ways; line++) {
+        if (!cache->lines[line].valid) {
+            victim = line;
+            break;
+        }
+        if (cache->lines[line].last_use < cache->lines[victim].last_use) {
+            victim = line;
+        }
+    }
+
+    if (cache->lines[victim].valid) {
+        if (cache->lines[victim].dirty) {
+            MSC_RETURN_ON_ERROR( cache_flush_locked(cache) );
+        }
+        cache->stats.evictions++;
+    }
+
+    cache->lines[victim].lba = lba;
+    cache->lines[victim].valid = true;
+    cache->lines[victim].dirty = false;
+    line_touch(cache, victim);
+    *line_out = victim;
+    return ESP_OK;
+}
+
+esp_err_t msc_disk_cache_read(msc_disk_cache_t *cache, uint8_t *data, uint64_t lba, uint32_t count)
+{
+    const uint32_t block_size = cache->block_size;
+    // Long reads (file data) are not cached, they would only evict file system metadata
+    const bool allocate = count < cache->num_sets;
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(cache->mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < count;) {
+        int line = cache_find(cache, lba + i);
+        if (line >= 0) {
+            memcpy(data + (size_t)i * block_size, line_data(cache, line), block_size);
+            line_touch(cache, line);
+            cache->stats.read_hits++;
+            i++;
+            continue;
+        }
+
+        // Read all consecutive blocks that are not cached by one command
+        uint32_t run = 1;
+        while (i + run < count && cache_find(cache, lba + i + run) < 0) {
+            run++;
+        }
+        ret = msc_disk_read(cache->device, data + (size_t)i * block_size, lba + i, run);
+        if (ret != ESP_OK) {
+            break;
+        }
+        cache->stats.read_misses += run;
+
+        for (uint32_t j = 0; allocate && j < run; j++) {
+            uint32_t new_line;
+            if (cache_alloc(cache, lba + i + j, &new_line) != ESP_OK) {
+                break; // The blocks were read, only caching them failed
+            }
+            memcpy(line_data(cache, new_line), data + (size_t)(i + j) * block_size, block_size);
+        }
+        i += run;
+    }
+    xSemaphoreGive(cache->mutex);
+    return ret;
+}
+
+esp_err_t msc_disk_cache_write(msc_disk_cache_t *cache, const uint8_t *data, uint64_t lba, uint32_t count)
+{
+    const uint32_t block_size = cache->block_size;
+    const bool write_back = count < cache->num_sets;
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(cache->mutex, portMAX_DELAY);
+    if (cache->device_gone) {
+        cache_discard(cache);
+        xSemaphoreGive(cache->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (write_back) {
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t line;
+            int found = cache_find(cache, lba + i);
+            if (found >= 0) {
+                line = found;
+                line_touch(cache, line);
+                cache->stats.write_hits++;
+            } else {
+                ret = cache_alloc(cache, lba + i, &line);
+                if (ret != ESP_OK) {
+                    break;
+                }
+                cache->stats.write_misses++;
+            }
+            memcpy(line_data(cache, line), data + (size_t)i * block_size, block_size);
+            if (!cache->lines[line].dirty) {
+                cache->lines[line].dirty = true;
+                cache->num_dirty++;
+            }
+        }
+    } else {
+        // Long writes (file data) go to the device, cached copies of the blocks are updated
+        ret = msc_disk_write(cache->device, data, lba, count);
+        if (ret == ESP_OK) {
+            cache->stats.write_misses += count;
+            for (uint32_t i = 0; i < count; i++) {
+                int line = cache_find(cache, lba + i);
+                if (line < 0) {
+                    continue;
+                }
+                memcpy(line_data(cache, line), data + (size_t)i * block_size, block_size);
+                if (cache->lines[line].dirty) {
+                    cache->lines[line].dirty = false;
+                    cache->num_dirty--;
+                }
+            }
+        }
+    }
+    xSemaphoreGive(cache->mutex);
+
+    // Restart the idle period of the flush task
+    if (write_back && cache->flush_task) {
+        xTaskNotifyGive(cache->flush_task);
+    }
+    return ret;
+}
+
+esp_err_t msc_disk_cache_flush(msc_disk_cache_t *cache)
+{
+    xSemaphoreTake(cache->mutex, portMAX_DELAY);
+    esp_err_t ret = cache_flush_locked(cache);
+    xSemaphoreGive(cache->mutex);
+    return ret;
+}
+
+void msc_disk_cache_device_gone(msc_disk_cache_t *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+    // Transfers of the gone device are completed from the USB event context, so the mutex must not be taken here
+    cache->device_gone = true;
+    if (cache->flush_task) {
+        xTaskNotifyGive(cache->flush_task);
+    }
+}
+
+/**
+ * @brief Idle flush task
+ *
+ * Each write-back notifies the task. Dirty blocks are flushed when no notification comes for idle_flush_ms.
+ */
+static void cache_flush_task(void *arg)
+{
+    msc_disk_cache_t *cache = (msc_disk_cache_t *)arg;
+
+    while (1) {
+        const TickType_t timeout = cache->num_dirty ? pdMS_TO_TICKS(cache->idle_flush_ms) : portMAX_DELAY;
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0 || cache->device_gone) {
+            if (msc_disk_cache_flush(cache) == ESP_ERR_INVALID_STATE) {
+                // Device gone, wait until the cache is destroyed
+                vTaskSuspend(NULL);
+            }
+        }
+    }
+}
+
+static void cache_free(msc_disk_cache_t *cache)
+{
+    if (cache->mutex) {
+        vSemaphoreDelete(cache->mutex);
+    }
+    free(cache->lines);
+    free(cache->flush_order);
+    heap_caps_free(cache->data);
+    heap_caps_free(cache->staging);
+    free(cache);
+}
+
+void msc_disk_cache_destroy(msc_device_t *device)
+{
+    msc_disk_cache_t *cache = device->cache;
+    if (cache == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(cache->mutex, portMAX_DELAY);
+    // The task does not hold the mutex now, so it can be deleted safely
+    if (cache->flush_task) {
+        vTaskDelete(cache->flush_task);
+    }
+    esp_err_t err = cache_flush_locked(cache);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Failed to flush cache (%s), %"PRIu32" blocks lost", esp_err_to_name(err), cache->num_dirty);
+    }
+    device->cache = NULL;
+    xSemaphoreGive(cache->mutex);
+
+    cache_free(cache);
+}
+
+esp_err_t msc_host_disk_cache_enable(msc_host_device_handle_t device, const msc_host_disk_cache_config_t *config)
+{
+    MSC_RETURN_ON_INVALID_ARG(device);
+    MSC_RETURN_ON_INVALID_ARG(config);
+    MSC_RETURN_ON_FALSE(config->ways > 0 && config->sector_count >= config->ways &&
+                        config->sector_count % config->ways == 0, ESP_ERR_INVALID_ARG);
+
+    msc_device_t *dev = (msc_device_t *)device;
+    MSC_RETURN_ON_FALSE(dev->cache == NULL, ESP_ERR_INVALID_STATE);
+
+    esp_err_t ret;
+    const uint32_t caps = config->heap_caps ? config->heap_caps : MALLOC_CAP_DEFAULT;
+    msc_disk_cache_t *cache = calloc(1, sizeof(msc_disk_cache_t));
+    MSC_RETURN_ON_FALSE(cache, ESP_ERR_NO_MEM);
+
+    cache->device = dev;
+    cache->idle_flush_ms = config->idle_flush_ms;
+    cache->block_size = dev->disk.block_size;
+    cache->ways = config->ways;
+    cache->num_sets = config->sector_count / config->ways;
+    cache->staging_blocks = MIN(config->sector_count, MSC_DISK_CACHE_FLUSH_BLOCKS);
+
+    MSC_GOTO_ON_FALSE( cache->mutex = xSemaphoreCreateMutex(), ESP_ERR_NO_MEM );
+    MSC_GOTO_ON_FALSE( cache->lines = calloc(config->sector_count, sizeof(cache_line_t)), ESP_ERR_NO_MEM );
+    MSC_GOTO_ON_FALSE( cache->flush_order = malloc(config->sector_count * sizeof(uint32_t)), ESP_ERR_NO_MEM );
+    MSC_GOTO_ON_FALSE( cache->data = heap_caps_malloc(config->sector_count * cache->block_size, caps), ESP_ERR_NO_MEM );
+    MSC_GOTO_ON_FALSE( cache->staging = heap_caps_malloc(cache->staging_blocks * cache->block_size, caps), ESP_ERR_NO_MEM );
+
+    if (config->idle_flush_ms) {
+        BaseType_t task_created = xTaskCreate(cache_flush_task, "MSC cache", MSC_DISK_CACHE_TASK_STACK,
+                                              cache, MSC_DISK_CACHE_TASK_PRIORITY, &cache->flush_task);
+        MSC_GOTO_ON_FALSE(task_created == pdPASS, ESP_ERR_NO_MEM);
+    }
+
+    dev->cache = cache;
+    return ESP_OK;
+
+fail:
+    cache_free(cache);
+    return ret;
+}
+
+esp_err_t msc_host_disk_cache_disable(msc_host_device_handle_t device)
+{
+    MSC_RETURN_ON_INVALID_ARG(device);
+    msc_device_t *dev = (msc_device_t *)device;
+    MSC_RETURN_ON_FALSE(dev->cache, ESP_ERR_INVALID_STATE);
+
+    msc_disk_cache_destroy(dev);
+    return ESP_OK;
+}
+
+esp_err_t msc_host_disk_cache_flush(msc_host_device_handle_t device)
+{
+    MSC_RETURN_ON_INVALID_ARG(device);
+    msc_device_t *dev = (msc_device_t *)device;
+    MSC_RETURN_ON_FALSE(dev->cache, ESP_ERR_INVALID_STATE);
+
+    return msc_disk_cache_flush(dev->cache);
+}
+
+esp_err_t msc_host_disk_cache_get_stats(msc_host_device_handle_t device, msc_host_disk_cache_stats_t *stats)
+{
+    MSC_RETURN_ON_INVALID_ARG(device);
+    MSC_RETURN_ON_INVALID_ARG(stats);
+    msc_device_t *dev = (msc_device_t *)device;
+    MSC_RETURN_ON_FALSE(dev->cache, ESP_ERR_INVALID_STATE);
+
+    xSemaphoreTake(dev->cache->mutex, portMAX_DELAY);
+    *stats = dev->cache->stats;
+    xSemaphoreGive(dev->cache->mutex);
+    return ESP_OK;
+}
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <sys/queue.h>
 #include <sys/param.h>
 #include "esp_log.h"
@@ -19,6 +20,8 @@
 #include "usb/usb_host.h"
 #include "diskio_usb.h"
 #include "msc_common.h"
+#include "msc_uas.h"
+#include "msc_disk_cache.h"
 #include "usb/msc_host.h"
 #include "msc_scsi_bot.h"
 #include "usb/usb_types_ch9.h"
@@ -84,13 +87,40 @@ static portMUX_TYPE msc_lock = portMUX_INITIALIZER_UNLOCKED;
 
 #define DEFAULT_XFER_SIZE   (64) // Transfer size used for all transfers apart from SCSI read/write
 #define WAIT_FOR_READY_TIMEOUT_MS 5000
+#define READY_POLL_MIN_DELAY_MS     5   // First delay between TEST UNIT READY trials, doubled after each trial
+#define READY_POLL_MAX_DELAY_MS     100
+#define READY_POLL_IMMEDIATE_MAX    4   // Maximum number of trials without delay, bounds polling of a LUN repeating UNIT ATTENTION
 #define SCSI_COMMAND_SET    0x06
 #define BULK_ONLY_TRANSFER  0x50
+#define USB_ATTACHED_SCSI   0x62
+#define UAS_PIPE_USAGE_DESC_TYPE    0x24
+#define UAS_PIPE_ID_COMMAND         0x01
+#define UAS_PIPE_ID_STATUS          0x02
+#define UAS_PIPE_ID_DATA_IN         0x03
+#define UAS_PIPE_ID_DATA_OUT        0x04
 #define MSC_NO_SENSE        0x00
 #define MSC_NOT_READY       0x02
 #define MSC_UNIT_ATTENTION  0x06
+#define SCSI_VERSION_SPC3   0x05 // First SCSI version with the Block Limits VPD page
 
 static const char *TAG = "USB_MSC";
+/**
+ * @brief Identification of a logical unit, remembered by USB serial number
+ */
+typedef struct {
+    uint16_t vid;
+    uint16_t pid;
+    uint8_t lun;
+    uint8_t serial_len;                     // Number of UTF-16 characters of the serial number, 0 for unused entry
+    uint16_t serial[MSC_STR_DESC_SIZE];
+    uint8_t scsi_version;
+    bool removable;
+    bool lba64;
+    uint32_t block_size;
+    uint64_t block_count;
+    uint32_t max_transfer_length;           // From Block Limits VPD page, 0 if not reported
+} msc_ident_t;
+
 typedef struct {
     usb_host_client_handle_t client_handle;
     msc_host_event_cb_t user_cb;
@@ -99,6 +129,9 @@ typedef struct {
     volatile bool end_client_event_handling;
     bool event_handling_started;
     STAILQ_HEAD(devices, msc_host_device) devices_tailq;
+    msc_ident_t *ident_cache;               // Identification of recently attached LUNs, NULL if disabled
+    uint8_t ident_cache_size;
+    uint8_t ident_cache_next;               // Entry replaced by the next new LUN
 } msc_driver_t;
 
 static msc_driver_t *s_msc_driver;
@@ -119,7 +152,20 @@ static inline bool is_in_endpoint(uint8_t endpoint)
     return endpoint & USB_B_ENDPOINT_ADDRESS_EP_DIR_MASK ? true : false;
 }
 
-static const usb_intf_desc_t *find_msc_interface(const usb_config_desc_t *config_desc, size_t *offset)
+static inline bool is_supported_protocol(uint8_t protocol)
+{
+    return protocol == BULK_ONLY_TRANSFER || protocol == USB_ATTACHED_SCSI;
+}
+
+/**
+ * @brief Find interface implementing the SCSI command set
+ *
+ * @param[in]    config_desc Configuration descriptor
+ * @param[inout] offset      Offset from which the search starts, updated to the offset of the found interface
+ * @param[in]    protocol    Requested protocol, or 0 for any protocol supported by this driver
+ * @return Interface descriptor or NULL if not found
+ */
+static const usb_intf_desc_t *find_msc_interface(const usb_config_desc_t *config_desc, size_t *offset, uint8_t protocol)
 {
     size_t total_length = config_desc->wTotalLength;
     const usb_standard_desc_t *next_desc = (const usb_standard_desc_t *)config_desc;
@@ -132,7 +178,7 @@ static const usb_intf_desc_t *find_msc_interface(const usb_config_desc_t *config
 
         if ( ifc_desc->bInterfaceClass == USB_CLASS_MASS_STORAGE &&
                 ifc_desc->bInterfaceSubClass == SCSI_COMMAND_SET &&
-                ifc_desc->bInterfaceProtocol == BULK_ONLY_TRANSFER ) {
+                (protocol ? ifc_desc->bInterfaceProtocol == protocol : is_supported_protocol(ifc_desc->bInterfaceProtocol)) ) {
             return ifc_desc;
         }
 
@@ -144,7 +190,7 @@ static const usb_intf_desc_t *find_msc_interface(const usb_config_desc_t *config
 esp_err_t clear_feature(msc_device_t *device, uint8_t endpoint)
 {
     usb_device_handle_t dev = device->handle;
-    usb_transfer_t *xfer = device->xfer;
+    usb_transfer_t *xfer = device->bot->xfer;
 
     MSC_RETURN_ON_ERROR( usb_host_endpoint_halt(dev, endpoint) );
 
@@ -176,9 +222,9 @@ esp_err_t clear_feature(msc_device_t *device, uint8_t endpoint)
 static esp_err_t msc_mass_reset(msc_host_device_handle_t dev)
 {
     msc_device_t *device = (msc_device_t *)dev;
-    usb_transfer_t *xfer = device->xfer;
+    usb_transfer_t *xfer = device->bot->xfer;
 
-    USB_MASS_REQ_INIT_RESET((usb_setup_packet_t *)xfer->data_buffer, device->config.iface_num);
+    USB_MASS_REQ_INIT_RESET((usb_setup_packet_t *)xfer->data_buffer, device->bot->config.iface_num);
     MSC_RETURN_ON_ERROR( msc_control_transfer(device, USB_SETUP_PACKET_SIZE) );
 
     return ESP_OK;
@@ -189,7 +235,7 @@ static esp_err_t msc_mass_reset(msc_host_device_handle_t dev)
  *
  * If the device implements 3 LUNs, the returned value is 2. (LUN0, LUN1, LUN2).
  *
- * This driver does not support multiple LUNs yet.
+ * Devices that do not support multiple LUNs may STALL this request.
  *
  * @see USB Mass Storage Class – Bulk Only Transport, Chapter 3.2
  *
@@ -197,40 +243,127 @@ static esp_err_t msc_mass_reset(msc_host_device_handle_t dev)
  * @param[out] lun Maximum Logical Unit Number
  * @return esp_err_t
  */
-__attribute__((unused)) static esp_err_t msc_get_max_lun(msc_host_device_handle_t dev, uint8_t *lun)
+static esp_err_t msc_get_max_lun(msc_host_device_handle_t dev, uint8_t *lun)
 {
     msc_device_t *device = (msc_device_t *)dev;
-    usb_transfer_t *xfer = device->xfer;
 
-    USB_MASS_REQ_INIT_GET_MAX_LUN((usb_setup_packet_t *)xfer->data_buffer, device->config.iface_num);
-    MSC_RETURN_ON_ERROR( msc_control_transfer(device, USB_SETUP_PACKET_SIZE + 1) );
+    msc_bot_lock(device);
+    usb_transfer_t *xfer = device->bot->xfer;
+    USB_MASS_REQ_INIT_GET_MAX_LUN((usb_setup_packet_t *)xfer->data_buffer, device->bot->config.iface_num);
+    esp_err_t ret = msc_control_transfer(device, USB_SETUP_PACKET_SIZE + 1);
+    if (ret == ESP_OK) {
+        *lun = xfer->data_buffer[USB_SETUP_PACKET_SIZE];
+    }
+    msc_bot_unlock(device);
+
+    return ret;
+}
+
+/**
+ * @brief Select alternate setting of the MSC interface
+ *
+ * usb_host_interface_claim() only opens the endpoints of the alternate setting, the device is switched to it by SET_INTERFACE.
+ *
+ * @see USB 2.0 specification, Chapter 9.4.10
+ *
+ * @param[in] dev         MSC device handle
+ * @param[in] alt_setting Alternate setting of the claimed interface
+ * @return esp_err_t
+ */
+static esp_err_t msc_set_interface(msc_host_device_handle_t dev, uint8_t alt_setting)
+{
+    msc_device_t *device = (msc_device_t *)dev;
+
+    msc_bot_lock(device);
+    usb_transfer_t *xfer = device->bot->xfer;
+    USB_SETUP_PACKET_INIT_SET_INTERFACE((usb_setup_packet_t *)xfer->data_buffer, device->bot->config.iface_num, alt_setting);
+    esp_err_t ret = msc_control_transfer(device, USB_SETUP_PACKET_SIZE);
+    msc_bot_unlock(device);
+
+    return ret;
+}
+
+/**
+ * @brief Extracts USB Attached SCSI configuration from interface descriptor
+ *
+ * Each of the four UAS endpoints is followed by a Pipe Usage descriptor, which identifies its function.
+ *
+ * @see USB Attached SCSI, Chapter 5.3.3
+ *
+ * @param[in]  cfg_desc  Configuration descriptor
+ * @param[in]  ifc_desc  UAS interface descriptor
+ * @param[in]  offset    Offset of the interface descriptor
+ * @param[out] cfg       Obtained configuration
+ * @return esp_err_t
+ */
+static esp_err_t extract_uas_config(const usb_config_desc_t *cfg_desc, const usb_intf_desc_t *ifc_desc, size_t offset, msc_config_t *cfg)
+{
+    size_t total_len = cfg_desc->wTotalLength;
+    const usb_standard_desc_t *next_desc = (const usb_standard_desc_t *)ifc_desc;
+    const usb_ep_desc_t *ep_desc = NULL;
+    uint32_t pipes_found = 0;
+    int desc_offset = offset;
 
-    *lun = xfer->data_buffer[USB_SETUP_PACKET_SIZE];
+    while ((next_desc = usb_parse_next_descriptor(next_desc, total_len, &desc_offset)) != NULL) {
+        if (next_desc->bDescriptorType == USB_W_VALUE_DT_INTERFACE) {
+            break;
+        }
+        if (next_desc->bDescriptorType == USB_B_DESCRIPTOR_TYPE_ENDPOINT) {
+            ep_desc = (const usb_ep_desc_t *)next_desc;
+        } else if (next_desc->bDescriptorType == UAS_PIPE_USAGE_DESC_TYPE && ep_desc) {
+            const uint8_t pipe_id = ((const uint8_t *)next_desc)[USB_STANDARD_DESC_SIZE]; // bPipeID
+            switch (pipe_id) {
+            case UAS_PIPE_ID_COMMAND:
+                cfg->uas_cmd_ep = ep_desc->bEndpointAddress;
+                break;
+            case UAS_PIPE_ID_STATUS:
+                cfg->uas_status_ep = ep_desc->bEndpointAddress;
+                cfg->uas_status_mps = USB_EP_DESC_GET_MPS(ep_desc);
+                break;
+            case UAS_PIPE_ID_DATA_IN:
+                cfg->uas_data_in_ep = ep_desc->bEndpointAddress;
+                cfg->uas_data_in_mps = USB_EP_DESC_GET_MPS(ep_desc);
+                break;
+            case UAS_PIPE_ID_DATA_OUT:
+                cfg->uas_data_out_ep = ep_desc->bEndpointAddress;
+                break;
+            default:
+                continue;
+            }
+            pipes_found |= 1 << pipe_id;
+        }
+    }
+    MSC_RETURN_ON_FALSE(pipes_found == ((1 << UAS_PIPE_ID_COMMAND) | (1 << UAS_PIPE_ID_STATUS) |
+                                        (1 << UAS_PIPE_ID_DATA_IN) | (1 << UAS_PIPE_ID_DATA_OUT)), ESP_ERR_NOT_SUPPORTED);
 
+    cfg->iface_num = ifc_desc->bInterfaceNumber;
+    cfg->alt_setting = ifc_desc->bAlternateSetting;
+    cfg->uas = true;
     return ESP_OK;
 }
 
 /**
- * @brief Extracts configuration from configuration descriptor.
+ * @brief Extracts Bulk-Only Transport configuration from configuration descriptor
  *
  * @note  Passes interface and endpoint descriptors to obtain:
-
  *        - interface number, IN endpoint, OUT endpoint, max. packet size
  *
  * @param[in]  cfg_desc  Configuration descriptor
  * @param[out] cfg       Obtained configuration
  * @return esp_err_t
  */
-static esp_err_t extract_config_from_descriptor(const usb_config_desc_t *cfg_desc, msc_config_t *cfg)
+static esp_err_t extract_bot_config(const usb_config_desc_t *cfg_desc, msc_config_t *cfg)
 {
     size_t offset = 0;
     size_t total_len = cfg_desc->wTotalLength;
-    const usb_intf_desc_t *ifc_desc = find_msc_interface(cfg_desc, &offset);
-    assert(ifc_desc);
+    const usb_intf_desc_t *ifc_desc = find_msc_interface(cfg_desc, &offset, BULK_ONLY_TRANSFER);
+    MSC_RETURN_ON_FALSE(ifc_desc, ESP_ERR_NOT_SUPPORTED);
     const usb_standard_desc_t *next_desc = (const usb_standard_desc_t *)ifc_desc;
     const usb_ep_desc_t *ep_desc = NULL;
 
     cfg->iface_num = ifc_desc->bInterfaceNumber;
+    cfg->alt_setting = ifc_desc->bAlternateSetting;
+    cfg->uas = false;
 
     next_desc = next_endpoint_desc(next_desc, total_len, &offset);
     MSC_RETURN_ON_FALSE(next_desc, ESP_ERR_NOT_SUPPORTED);
@@ -257,55 +390,128 @@ static esp_err_t extract_config_from_descriptor(const usb_config_desc_t *cfg_des
     return ESP_OK;
 }
 
+/**
+ * @brief Extracts configuration from configuration descriptor
+ *
+ * USB Attached SCSI is preferred, it is usually provided as an alternate setting of the Bulk-Only interface.
+ *
+ * @param[in]  cfg_desc  Configuration descriptor
+ * @param[out] cfg       Obtained configuration
+ * @return esp_err_t
+ */
+static esp_err_t extract_config_from_descriptor(const usb_config_desc_t *cfg_desc, msc_config_t *cfg)
+{
+    size_t offset = 0;
+    const usb_intf_desc_t *ifc_desc = find_msc_interface(cfg_desc, &offset, USB_ATTACHED_SCSI);
+    if (ifc_desc && extract_uas_config(cfg_desc, ifc_desc, offset, cfg) == ESP_OK) {
+        return ESP_OK;
+    }
+    return extract_bot_config(cfg_desc, cfg);
+}
+
+static esp_err_t msc_deinit_bot(msc_bot_t *bot, bool install_failed)
+{
+    msc_uas_deinit(bot);
+    if (bot->transfer_done) {
+        vSemaphoreDelete(bot->transfer_done);
+    }
+    if (install_failed) {
+        // Error code is unchecked, as it's unknown at what point installation failed.
+        usb_host_interface_release(s_msc_driver->client_handle, bot->handle, bot->config.iface_num);
+        usb_host_device_close(s_msc_driver->client_handle, bot->handle);
+        usb_host_transfer_free(bot->xfer);
+    } else {
+        MSC_RETURN_ON_ERROR( usb_host_interface_release(s_msc_driver->client_handle, bot->handle, bot->config.iface_num) );
+        MSC_RETURN_ON_ERROR( usb_host_device_close(s_msc_driver->client_handle, bot->handle) );
+        MSC_RETURN_ON_ERROR( usb_host_transfer_free(bot->xfer) );
+    }
+
+    free(bot);
+    return ESP_OK;
+}
+
 static esp_err_t msc_deinit_device(msc_device_t *dev, bool install_failed)
 {
+    bool last_lun = true;
+
+    if (dev) {
+        // Dirty blocks are written back while the transport is still available
+        msc_disk_cache_destroy(dev);
+    }
+
     MSC_ENTER_CRITICAL();
     MSC_RETURN_ON_FALSE_CRITICAL( dev, ESP_ERR_INVALID_STATE );
     STAILQ_REMOVE(&s_msc_driver->devices_tailq, dev, msc_host_device, tailq_entry);
+    msc_bot_t *bot = dev->bot;
+    if (bot) {
+        if (bot->luns[dev->lun] == dev) {
+            bot->luns[dev->lun] = NULL;
+        }
+        for (int i = 0; i < MSC_MAX_LUN_NUM; i++) {
+            if (bot->luns[i]) {
+                last_lun = false;
+                break;
+            }
+        }
+    }
     MSC_EXIT_CRITICAL();
 
-    if (dev->transfer_done) {
-        vSemaphoreDelete(dev->transfer_done);
+    if (dev->cmd_slot) {
+        vSemaphoreDelete(dev->cmd_slot);
     }
-    if (install_failed) {
-        // Error code is unchecked, as it's unknown at what point installation failed.
-        usb_host_interface_release(s_msc_driver->client_handle, dev->handle, dev->config.iface_num);
-        usb_host_device_close(s_msc_driver->client_handle, dev->handle);
-        usb_host_transfer_free(dev->xfer);
-    } else {
-        MSC_RETURN_ON_ERROR( usb_host_interface_release(s_msc_driver->client_handle, dev->handle, dev->config.iface_num) );
-        MSC_RETURN_ON_ERROR( usb_host_device_close(s_msc_driver->client_handle, dev->handle) );
-        MSC_RETURN_ON_ERROR( usb_host_transfer_free(dev->xfer) );
+    // The USB device is released together with its last installed LUN
+    if (bot && last_lun) {
+        MSC_RETURN_ON_ERROR( msc_deinit_bot(bot, install_failed) );
     }
 
     free(dev);
     return ESP_OK;
 }
 
-// Some MSC devices requires to change its internal state from non-ready to ready
+/**
+ * @brief Wait until a logical unit is ready
+ *
+ * Some MSC devices require time to change their internal state from non-ready to ready.
+ * The first failed trial and trials failed with UNIT ATTENTION, which is cleared by REQUEST SENSE, are repeated
+ * immediately. Otherwise the delay between trials grows exponentially, so that a LUN that becomes ready quickly
+ * is not delayed by a fixed polling period.
+ *
+ * @param[in] dev        MSC device handle
+ * @param[in] timeout_ms Timeout
+ * @return esp_err_t
+ */
 static esp_err_t msc_wait_for_ready_state(msc_device_t *dev, size_t timeout_ms)
 {
     esp_err_t err;
     scsi_sense_data_t sense;
-    uint32_t trials = MAX(1, timeout_ms / 100);
+    uint32_t delay_ms = READY_POLL_MIN_DELAY_MS;
+    uint32_t immediate_trials = 0;
+    const TickType_t start = xTaskGetTickCount();
 
-    do {
+    while (true) {
         err = scsi_cmd_unit_ready(dev);
         if (err == ESP_OK) {
             return ESP_OK;
-        } else {
-            // Some MSC devices report 'NOT READY TO READY TRANSITION - MEDIA CHANGED', which isn't cleared until a REQUEST SENSE is performed.
-            MSC_RETURN_ON_ERROR( scsi_cmd_sense(dev, &sense) );
-            if (sense.key != MSC_NOT_READY &&
-                    sense.key != MSC_UNIT_ATTENTION &&
-                    sense.key != MSC_NO_SENSE) {
-                return ESP_ERR_MSC_INTERNAL;
-            }
         }
-        vTaskDelay( pdMS_TO_TICKS(100) );
-    } while (trials-- && err);
+        // Some MSC devices report 'NOT READY TO READY TRANSITION - MEDIA CHANGED', which isn't cleared until a REQUEST SENSE is performed.
+        MSC_RETURN_ON_ERROR( scsi_cmd_sense(dev, &sense) );
+        if (sense.key != MSC_NOT_READY &&
+                sense.key != MSC_UNIT_ATTENTION &&
+                sense.key != MSC_NO_SENSE) {
+            return ESP_ERR_MSC_INTERNAL;
+        }
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms)) {
+            return err;
+        }
 
-    return err;
+        const bool retry_now = (immediate_trials == 0 || sense.key == MSC_UNIT_ATTENTION);
+        if (retry_now && immediate_trials < READY_POLL_IMMEDIATE_MAX) {
+            immediate_trials++;
+            continue;
+        }
+        vTaskDelay(MAX(1, pdMS_TO_TICKS(delay_ms)));
+        delay_ms = MIN(delay_ms * 2, READY_POLL_MAX_DELAY_MS);
+    }
 }
 
 static bool is_mass_storage_device(uint8_t dev_addr)
@@ -317,7 +523,7 @@ static bool is_mass_storage_device(uint8_t dev_addr)
 
     if ( usb_host_device_open(s_msc_driver->client_handle, dev_addr, &device) == ESP_OK) {
         if ( usb_host_get_active_config_descriptor(device, &config_desc) == ESP_OK ) {
-            if ( find_msc_interface(config_desc, &dummy) ) {
+            if ( find_msc_interface(config_desc, &dummy, 0) ) {
                 is_msc_device = true;
             } else {
                 ESP_LOGD(TAG, "Connected USB device is not MSC");
@@ -359,21 +565,33 @@ static void event_handler_task(void *arg)
     vTaskDelete(NULL);
 }
 
-static msc_device_t *find_msc_device(usb_device_handle_t device_handle)
+/**
+ * @brief Deliver an MSC event to all installed LUNs of a USB device
+ *
+ * @param[in]    device_handle USB device handle
+ * @param[inout] msc_event     Event to deliver, device handle is filled for each LUN
+ */
+static void notify_msc_devices(usb_device_handle_t device_handle, msc_host_event_t *msc_event)
 {
     msc_device_t *iter;
-    msc_device_t *device_found = NULL;
+    msc_device_t *devices_found[MSC_MAX_LUN_NUM];
+    int num_devices = 0;
 
     MSC_ENTER_CRITICAL();
     STAILQ_FOREACH(iter, &s_msc_driver->devices_tailq, tailq_entry) {
-        if (device_handle == iter->handle) {
-            device_found = iter;
-            break;
+        if (device_handle == iter->handle && num_devices < MSC_MAX_LUN_NUM) {
+            devices_found[num_devices++] = iter;
         }
     }
     MSC_EXIT_CRITICAL();
 
-    return device_found;
+    for (int i = 0; i < num_devices; i++) {
+        if (msc_event->event == MSC_DEVICE_DISCONNECTED) {
+            msc_disk_cache_device_gone(devices_found[i]->cache);
+        }
+        msc_event->device.handle = devices_found[i];
+        s_msc_driver->user_cb(msc_event, s_msc_driver->user_arg);
+    }
 }
 
 static void client_event_cb(const usb_host_client_event_msg_t *event, void *arg)
@@ -391,38 +609,26 @@ static void client_event_cb(const usb_host_client_event_msg_t *event, void *arg)
         break;
     case USB_HOST_CLIENT_EVENT_DEV_GONE:
         ESP_LOGD(TAG, "Device suddenly disconnected");
-        msc_device_t *msc_device_gone = find_msc_device(event->dev_gone.dev_hdl);
-        if (msc_device_gone) {
-            const msc_host_event_t msc_event = {
-                .event = MSC_DEVICE_DISCONNECTED,
-                .device.handle = msc_device_gone,
-            };
-            s_msc_driver->user_cb(&msc_event, s_msc_driver->user_arg);
-        }
+        msc_host_event_t msc_event_gone = {
+            .event = MSC_DEVICE_DISCONNECTED,
+        };
+        notify_msc_devices(event->dev_gone.dev_hdl, &msc_event_gone);
         break;
 
 #ifdef MSC_HOST_SUSPEND_RESUME_API_SUPPORTED
     case USB_HOST_CLIENT_EVENT_DEV_SUSPENDED:
         ESP_LOGD(TAG, "Device suspended");
-        msc_device_t *msc_device_susp = find_msc_device(event->dev_suspend_resume.dev_hdl);
-        if (msc_device_susp) {
-            const msc_host_event_t msc_event = {
-                .event = MSC_DEVICE_SUSPENDED,
-                .device.handle = msc_device_susp,
-            };
-            s_msc_driver->user_cb(&msc_event, s_msc_driver->user_arg);
-        }
+        msc_host_event_t msc_event_susp = {
+            .event = MSC_DEVICE_SUSPENDED,
+        };
+        notify_msc_devices(event->dev_suspend_resume.dev_hdl, &msc_event_susp);
         break;
     case USB_HOST_CLIENT_EVENT_DEV_RESUMED:
         ESP_LOGD(TAG, "Device resumed");
-        msc_device_t *msc_device_res = find_msc_device(event->dev_suspend_resume.dev_hdl);
-        if (msc_device_res) {
-            const msc_host_event_t msc_event = {
-                .event = MSC_DEVICE_RESUMED,
-                .device.handle = msc_device_res,
-            };
-            s_msc_driver->user_cb(&msc_event, s_msc_driver->user_arg);
-        }
+        msc_host_event_t msc_event_res = {
+            .event = MSC_DEVICE_RESUMED,
+        };
+        notify_msc_devices(event->dev_suspend_resume.dev_hdl, &msc_event_res);
         break;
 #endif // MSC_HOST_SUSPEND_RESUME_API_SUPPORTED
 
@@ -448,6 +654,10 @@ esp_err_t msc_host_install(const msc_host_driver_config_t *config)
     MSC_RETURN_ON_FALSE(driver, ESP_ERR_NO_MEM);
     driver->user_cb = config->callback;
     driver->user_arg = config->callback_arg;
+    if (config->identify_cache_size) {
+        MSC_GOTO_ON_FALSE( driver->ident_cache = calloc(config->identify_cache_size, sizeof(msc_ident_t)), ESP_ERR_NO_MEM );
+        driver->ident_cache_size = config->identify_cache_size;
+    }
 
     usb_host_client_config_t client_config = {
         .async.client_event_callback = client_event_cb,
@@ -487,6 +697,7 @@ fail:
     if (driver->all_events_handled) {
         vSemaphoreDelete(driver->all_events_handled);
     }
+    free(driver->ident_cache);
     free(driver);
     return ret;
 }
@@ -510,17 +721,188 @@ esp_err_t msc_host_uninstall(void)
     }
     vSemaphoreDelete(s_msc_driver->all_events_handled);
     ESP_ERROR_CHECK( usb_host_client_deregister(s_msc_driver->client_handle) );
+    free(s_msc_driver->ident_cache);
     free(s_msc_driver);
     s_msc_driver = NULL;
     return ESP_OK;
 }
 
+/**
+ * @brief Get the key of a logical unit in the identification cache
+ *
+ * @param[in]  device MSC device handle
+ * @param[out] ident  Entry with VID, PID, serial number and LUN filled in
+ * @return true if the device has a serial number, so that it can be cached
+ */
+static bool ident_cache_key(const msc_device_t *device, msc_ident_t *ident)
+{
+    usb_device_info_t dev_info;
+    const usb_device_desc_t *desc;
+
+    if (usb_host_device_info(device->handle, &dev_info) != ESP_OK ||
+            usb_host_get_device_descriptor(device->handle, &desc) != ESP_OK) {
+        return false;
+    }
+    const usb_str_desc_t *serial = dev_info.str_desc_serial_num;
+    if (serial == NULL || serial->bLength <= USB_STANDARD_DESC_SIZE) {
+        return false;
+    }
+
+    memset(ident, 0, sizeof(msc_ident_t));
+    ident->vid = desc->idVendor;
+    ident->pid = desc->idProduct;
+    ident->lun = device->lun;
+    ident->serial_len = MIN((serial->bLength - USB_STANDARD_DESC_SIZE) / 2, MSC_STR_DESC_SIZE);
+    memcpy(ident->serial, serial->wData, ident->serial_len * sizeof(uint16_t));
+    return true;
+}
+
+static inline bool ident_cache_match(const msc_ident_t *a, const msc_ident_t *b)
+{
+    return a->vid == b->vid && a->pid == b->pid && a->lun == b->lun && a->serial_len == b->serial_len &&
+           memcmp(a->serial, b->serial, a->serial_len * sizeof(uint16_t)) == 0;
+}
+
+/**
+ * @brief Find a logical unit in the identification cache
+ *
+ * @param[inout] ident Key obtained from ident_cache_key(), filled with the cached identification if found
+ * @return true if found
+ */
+static bool ident_cache_lookup(msc_ident_t *ident)
+{
+    bool found = false;
+
+    MSC_ENTER_CRITICAL();
+    for (int i = 0; i < s_msc_driver->ident_cache_size; i++) {
+        if (ident_cache_match(&s_msc_driver->ident_cache[i], ident)) {
+            *ident = s_msc_driver->ident_cache[i];
+            found = true;
+            break;
+        }
+    }
+    MSC_EXIT_CRITICAL();
+    return found;
+}
+
+static void ident_cache_store(const msc_ident_t *ident)
+{
+    MSC_ENTER_CRITICAL();
+    int slot = -1;
+    for (int i = 0; i < s_msc_driver->ident_cache_size; i++) {
+        if (ident_cache_match(&s_msc_driver->ident_cache[i], ident)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        slot = s_msc_driver->ident_cache_next;
+        s_msc_driver->ident_cache_next = (slot + 1) % s_msc_driver->ident_cache_size;
+    }
+    s_msc_driver->ident_cache[slot] = *ident;
+    MSC_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Read capacity of a logical unit
+ *
+ * @param[in] device MSC device handle
+ * @return esp_err_t
+ */
+static esp_err_t msc_read_capacity(msc_device_t *device)
+{
+    uint32_t block_size, block_count;
+
+    MSC_RETURN_ON_ERROR( scsi_cmd_read_capacity(device, &block_size, &block_count) );
+
+    device->disk.block_size = block_size;
+    device->disk.block_count = block_count;
+    device->lba64 = false;
+    if (block_count == UINT32_MAX) {
+        // The capacity does not fit into READ CAPACITY(10), the LUN must be accessed with 16 byte commands
+        uint64_t block_count_64;
+        MSC_RETURN_ON_ERROR( scsi_cmd_read_capacity16(device, &block_size, &block_count_64) );
+        device->disk.block_size = block_size;
+        device->disk.block_count = block_count_64;
+        device->lba64 = true;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Initialize a logical unit and read its capacity
+ *
+ * If the identification cache is enabled and the LUN was attached before, INQUIRY and the Block Limits VPD page
+ * are not requested again. The capacity is taken from the cache only for non-removable media.
+ *
+ * @param[in] device MSC device handle
+ * @return esp_err_t
+ */
+static esp_err_t msc_lun_init(msc_device_t *device)
+{
+    uint32_t max_transfer_length = 0;
+    msc_ident_t ident;
+    const bool cacheable = s_msc_driver->ident_cache_size > 0 && ident_cache_key(device, &ident);
+    const bool cached = cacheable && ident_cache_lookup(&ident);
+
+    device->ident_cached = cached;
+    if (cached) {
+        device->scsi_version = ident.scsi_version;
+        device->removable = ident.removable;
+    } else {
+        MSC_RETURN_ON_ERROR( scsi_cmd_inquiry(device) );
+    }
+    MSC_RETURN_ON_ERROR( msc_wait_for_ready_state(device, WAIT_FOR_READY_TIMEOUT_MS) );
+
+    if (cached && !ident.removable) {
+        device->disk.block_size = ident.block_size;
+        device->disk.block_count = ident.block_count;
+        device->lba64 = ident.lba64;
+    } else {
+        MSC_RETURN_ON_ERROR( msc_read_capacity(device) );
+    }
+    MSC_RETURN_ON_FALSE(device->disk.block_size > 0, ESP_ERR_NOT_SUPPORTED);
+
+    if (cached) {
+        max_transfer_length = ident.max_transfer_length;
+    } else if (device->scsi_version >= SCSI_VERSION_SPC3 &&
+               scsi_cmd_block_limits(device, &max_transfer_length) != ESP_OK) {
+        // Block Limits VPD page is optional, many devices do not implement it
+        ESP_LOGD(TAG, "Block Limits VPD page not supported");
+        max_transfer_length = 0;
+    }
+
+    // Split large requests by the transfer buffer size, the command's transfer length field and the device limit
+    uint32_t max_blocks = MAX(1, MSC_MAX_TRANSFER_SIZE / device->disk.block_size);
+    if (!device->lba64) {
+        max_blocks = MIN(max_blocks, UINT16_MAX);
+    }
+    if (max_transfer_length != 0) {
+        max_blocks = MIN(max_blocks, max_transfer_length);
+    }
+    device->max_transfer_blocks = max_blocks;
+    ESP_LOGD(TAG, "LUN %d: %"PRIu64" blocks of %"PRIu32" bytes, up to %"PRIu32" blocks per command%s%s",
+             device->lun, device->disk.block_count, device->disk.block_size, max_blocks,
+             device->lba64 ? ", 16 byte commands" : "", cached ? ", identification cached" : "");
+
+    if (cacheable) {
+        ident.scsi_version = device->scsi_version;
+        ident.removable = device->removable;
+        ident.lba64 = device->lba64;
+        ident.block_size = device->disk.block_size;
+        ident.block_count = device->disk.block_count;
+        ident.max_transfer_length = max_transfer_length;
+        ident_cache_store(&ident);
+    }
+    return ESP_OK;
+}
+
 esp_err_t msc_host_install_device(uint8_t device_address, msc_host_device_handle_t *msc_device_handle)
 {
     esp_err_t ret;
-    uint32_t block_size, block_count;
     const usb_config_desc_t *config_desc;
     msc_device_t *msc_device;
+    msc_bot_t *bot;
 
     MSC_GOTO_ON_FALSE( msc_device = calloc(1, sizeof(msc_device_t)), ESP_ERR_NO_MEM );
 
@@ -530,22 +912,45 @@ esp_err_t msc_host_install_device(uint8_t device_address, msc_host_device_handle
     STAILQ_INSERT_TAIL(&s_msc_driver->devices_tailq, msc_device, tailq_entry);
     MSC_EXIT_CRITICAL();
 
-    MSC_GOTO_ON_FALSE( msc_device->transfer_done = xSemaphoreCreateBinary(), ESP_ERR_NO_MEM);
-    MSC_GOTO_ON_ERROR( usb_host_device_open(s_msc_driver->client_handle, device_address, &msc_device->handle) );
-    MSC_GOTO_ON_ERROR( usb_host_get_active_config_descriptor(msc_device->handle, &config_desc) );
-    MSC_GOTO_ON_ERROR( extract_config_from_descriptor(config_desc, &msc_device->config) );
-    MSC_GOTO_ON_ERROR( usb_host_transfer_alloc(DEFAULT_XFER_SIZE, 0, &msc_device->xfer) );
+    // Transport shared by all LUNs of the device, LUN 0 is installed together with it
+    MSC_GOTO_ON_FALSE( bot = calloc(1, sizeof(msc_bot_t)), ESP_ERR_NO_MEM );
+    msc_device->bot = bot;
+    bot->luns[0] = msc_device;
+    MSC_GOTO_ON_FALSE( bot->transfer_done = xSemaphoreCreateBinary(), ESP_ERR_NO_MEM);
+    MSC_GOTO_ON_FALSE( msc_device->cmd_slot = xSemaphoreCreateBinary(), ESP_ERR_NO_MEM);
+    MSC_GOTO_ON_ERROR( usb_host_device_open(s_msc_driver->client_handle, device_address, &bot->handle) );
+    msc_device->handle = bot->handle;
+    MSC_GOTO_ON_ERROR( usb_host_get_active_config_descriptor(bot->handle, &config_desc) );
+    MSC_GOTO_ON_ERROR( extract_config_from_descriptor(config_desc, &bot->config) );
+    MSC_GOTO_ON_ERROR( usb_host_transfer_alloc(DEFAULT_XFER_SIZE, 0, &bot->xfer) );
     MSC_GOTO_ON_ERROR( usb_host_interface_claim(
                            s_msc_driver->client_handle,
-                           msc_device->handle,
-                           msc_device->config.iface_num, 0) );
+                           bot->handle,
+                           bot->config.iface_num,
+                           bot->config.alt_setting) );
+
+    if (bot->config.uas && msc_set_interface(msc_device, bot->config.alt_setting) != ESP_OK) {
+        // The device stays in the default alternate setting, use its Bulk-Only Transport
+        ESP_LOGW(TAG, "UAS alternate setting not selected, using Bulk-Only Transport");
+        MSC_GOTO_ON_ERROR( usb_host_interface_release(s_msc_driver->client_handle, bot->handle, bot->config.iface_num) );
+        MSC_GOTO_ON_ERROR( extract_bot_config(config_desc, &bot->config) );
+        MSC_GOTO_ON_ERROR( usb_host_interface_claim(
+                               s_msc_driver->client_handle,
+                               bot->handle,
+                               bot->config.iface_num,
+                               bot->config.alt_setting) );
+    }
 
-    MSC_GOTO_ON_ERROR( scsi_cmd_inquiry(msc_device) );
-    MSC_GOTO_ON_ERROR( msc_wait_for_ready_state(msc_device, WAIT_FOR_READY_TIMEOUT_MS) );
-    MSC_GOTO_ON_ERROR( scsi_cmd_read_capacity(msc_device, &block_size, &block_count) );
+    if (bot->config.uas) {
+        // Get Max LUN is a Bulk-Only request, UAS devices are used with LUN 0
+        MSC_GOTO_ON_ERROR( msc_uas_init(bot) );
+        bot->max_lun = 0;
+    } else if (msc_get_max_lun(msc_device, &bot->max_lun) != ESP_OK || bot->max_lun >= MSC_MAX_LUN_NUM) {
+        ESP_LOGD(TAG, "Get Max LUN not supported, using LUN 0 only");
+        bot->max_lun = 0;
+    }
 
-    msc_device->disk.block_size = block_size;
-    msc_device->disk.block_count = block_count;
+    MSC_GOTO_ON_ERROR( msc_lun_init(msc_device) );
     *msc_device_handle = msc_device;
 
     return ESP_OK;
@@ -555,6 +960,55 @@ fail:
     return ret;
 }
 
+esp_err_t msc_host_get_lun_count(msc_host_device_handle_t device, uint8_t *lun_count)
+{
+    MSC_RETURN_ON_INVALID_ARG(device);
+    MSC_RETURN_ON_INVALID_ARG(lun_count);
+
+    *lun_count = ((msc_device_t *)device)->bot->max_lun + 1;
+    return ESP_OK;
+}
+
+esp_err_t msc_host_install_lun(msc_host_device_handle_t device, uint8_t lun, msc_host_device_handle_t *lun_device)
+{
+    esp_err_t ret;
+    MSC_RETURN_ON_INVALID_ARG(device);
+    MSC_RETURN_ON_INVALID_ARG(lun_device);
+    msc_bot_t *bot = ((msc_device_t *)device)->bot;
+    MSC_RETURN_ON_FALSE(lun <= bot->max_lun, ESP_ERR_INVALID_ARG);
+
+    msc_device_t *msc_device = calloc(1, sizeof(msc_device_t));
+    MSC_RETURN_ON_FALSE(msc_device, ESP_ERR_NO_MEM);
+    msc_device->handle = bot->handle;
+    msc_device->bot = bot;
+    msc_device->lun = lun;
+    msc_device->cmd_slot = xSemaphoreCreateBinary();
+    if (msc_device->cmd_slot == NULL) {
+        free(msc_device);
+        return ESP_ERR_NO_MEM;
+    }
+
+    MSC_ENTER_CRITICAL();
+    if (bot->luns[lun] != NULL) {
+        MSC_EXIT_CRITICAL();
+        vSemaphoreDelete(msc_device->cmd_slot);
+        free(msc_device);
+        return ESP_ERR_INVALID_STATE;
+    }
+    bot->luns[lun] = msc_device;
+    STAILQ_INSERT_TAIL(&s_msc_driver->devices_tailq, msc_device, tailq_entry);
+    MSC_EXIT_CRITICAL();
+
+    MSC_GOTO_ON_ERROR( msc_lun_init(msc_device) );
+    *lun_device = msc_device;
+
+    return ESP_OK;
+
+fail:
+    msc_deinit_device(msc_device, true);
+    return ret;
+}
+
 esp_err_t msc_host_uninstall_device(msc_host_device_handle_t device)
 {
     MSC_RETURN_ON_INVALID_ARG(device);
@@ -566,7 +1020,7 @@ esp_err_t msc_host_read_sector(msc_host_device_handle_t device, size_t sector, v
     MSC_RETURN_ON_INVALID_ARG(device);
     msc_device_t *dev = (msc_device_t *)device;
 
-    return scsi_cmd_read10(dev, data, sector, 1, dev->disk.block_size);
+    return msc_disk_read(dev, data, sector, 1);
 }
 
 esp_err_t msc_host_write_sector(msc_host_device_handle_t device, size_t sector, const void *data, size_t size)
@@ -574,7 +1028,50 @@ esp_err_t msc_host_write_sector(msc_host_device_handle_t device, size_t sector,
     MSC_RETURN_ON_INVALID_ARG(device);
     msc_device_t *dev = (msc_device_t *)device;
 
-    return scsi_cmd_write10(dev, data, sector, 1, dev->disk.block_size);
+    return msc_disk_write(dev, data, sector, 1);
+}
+
+/**
+ * @brief Read or write blocks, split into commands of at most max_transfer_blocks
+ *
+ * If the transfer buffer for a command cannot be allocated, the command is retried with half of the blocks.
+ */
+static esp_err_t msc_disk_transfer(msc_device_t *device, uint8_t *data, uint64_t lba, uint32_t count, bool write)
+{
+    const uint32_t block_size = device->disk.block_size;
+    uint32_t max_blocks = device->max_transfer_blocks;
+
+    while (count > 0) {
+        const uint32_t blocks = MIN(count, max_blocks);
+        esp_err_t ret;
+        if (device->lba64) {
+            ret = write ? scsi_cmd_write16(device, data, lba, blocks, block_size)
+                  : scsi_cmd_read16(device, data, lba, blocks, block_size);
+        } else {
+            ret = write ? scsi_cmd_write10(device, data, (uint32_t)lba, blocks, block_size)
+                  : scsi_cmd_read10(device, data, (uint32_t)lba, blocks, block_size);
+        }
+        if (ret == ESP_ERR_NO_MEM && blocks > 1) {
+            max_blocks = blocks / 2;
+            continue;
+        }
+        MSC_RETURN_ON_ERROR(ret);
+
+        data += (size_t)blocks * block_size;
+        lba += blocks;
+        count -= blocks;
+    }
+    return ESP_OK;
+}
+
+esp_err_t msc_disk_read(msc_device_t *device, uint8_t *data, uint64_t lba, uint32_t count)
+{
+    return msc_disk_transfer(device, data, lba, count, false);
+}
+
+esp_err_t msc_disk_write(msc_device_t *device, const uint8_t *data, uint64_t lba, uint32_t count)
+{
+    return msc_disk_transfer(device, (uint8_t *)data, lba, count, true);
 }
 
 static void copy_string_desc(wchar_t *dest, const usb_str_desc_t *src)
@@ -610,7 +1107,9 @@ esp_err_t msc_host_get_device_info(msc_host_device_handle_t device, msc_host_dev
     info->idProduct = desc->idProduct;
     info->idVendor = desc->idVendor;
     info->sector_size = dev->disk.block_size;
-    info->sector_count = dev->disk.block_count;
+    info->sector_count = (uint32_t)MIN(dev->disk.block_count, UINT32_MAX);
+    info->lun = dev->lun;
+    info->sector_count_64 = dev->disk.block_count;
 
     copy_string_desc(info->iManufacturer, dev_info.str_desc_manufacturer);
     copy_string_desc(info->iProduct, dev_info.str_desc_product);
@@ -631,51 +1130,127 @@ esp_err_t msc_host_print_descriptors(msc_host_device_handle_t device)
     return ESP_OK;
 }
 
+void msc_bot_lock(msc_device_t *device)
+{
+    msc_bot_t *bot = device->bot;
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    MSC_ENTER_CRITICAL();
+    if (!bot->busy) {
+        bot->busy = true;
+        bot->owner = task;
+        bot->owner_depth = 1;
+        MSC_EXIT_CRITICAL();
+        return;
+    }
+    if (bot->owner == task) {
+        bot->owner_depth++;
+        MSC_EXIT_CRITICAL();
+        return;
+    }
+    device->cmd_waiting++;
+    MSC_EXIT_CRITICAL();
+
+    // The transport is handed over to us by msc_bot_unlock(), it stays busy in the meantime
+    xSemaphoreTake(device->cmd_slot, portMAX_DELAY);
+    MSC_ENTER_CRITICAL();
+    bot->owner = task;
+    bot->owner_depth = 1;
+    MSC_EXIT_CRITICAL();
+}
+
+void msc_bot_unlock(msc_device_t *device)
+{
+    msc_bot_t *bot = device->bot;
+    msc_device_t *next = NULL;
+
+    MSC_ENTER_CRITICAL();
+    assert(bot->owner == xTaskGetCurrentTaskHandle());
+    if (--bot->owner_depth > 0) {
+        MSC_EXIT_CRITICAL();
+        return;
+    }
+    bot->owner = NULL;
+    bot->last_lun = device->lun;
+    // Serve the waiting LUNs round-robin, starting after the LUN that was just served
+    for (int i = 1; i <= MSC_MAX_LUN_NUM; i++) {
+        msc_device_t *lun_device = bot->luns[(bot->last_lun + i) % MSC_MAX_LUN_NUM];
+        if (lun_device && lun_device->cmd_waiting > 0) {
+            lun_device->cmd_waiting--;
+            next = lun_device;
+            break;
+        }
+    }
+    if (next == NULL) {
+        bot->busy = false;
+    }
+    MSC_EXIT_CRITICAL();
+
+    if (next) {
+        xSemaphoreGive(next->cmd_slot);
+    }
+}
+
 static void transfer_callback(usb_transfer_t *transfer)
 {
-    msc_device_t *device = (msc_device_t *)transfer->context;
+    msc_bot_t *bot = (msc_bot_t *)transfer->context;
 
     if (transfer->status != USB_TRANSFER_STATUS_COMPLETED) {
         ESP_LOGE("Transfer failed", "Status %d", transfer->status);
     }
 
-    xSemaphoreGive(device->transfer_done);
+    xSemaphoreGive(bot->transfer_done);
 }
 
 static usb_transfer_status_t wait_for_transfer_done(usb_transfer_t *xfer)
 {
-    msc_device_t *device = (msc_device_t *)xfer->context;
-    BaseType_t received = xSemaphoreTake(device->transfer_done, pdMS_TO_TICKS(xfer->timeout_ms));
+    msc_bot_t *bot = (msc_bot_t *)xfer->context;
+    BaseType_t received = xSemaphoreTake(bot->transfer_done, pdMS_TO_TICKS(xfer->timeout_ms));
     usb_transfer_status_t status = xfer->status;
 
     if (received != pdTRUE) {
         usb_host_endpoint_halt(xfer->device_handle, xfer->bEndpointAddress);
         usb_host_endpoint_flush(xfer->device_handle, xfer->bEndpointAddress);
         usb_host_endpoint_clear(xfer->device_handle, xfer->bEndpointAddress);
-        xSemaphoreTake(device->transfer_done, portMAX_DELAY); // Since we flushed the EP, this should return immediately
+        xSemaphoreTake(bot->transfer_done, portMAX_DELAY); // Since we flushed the EP, this should return immediately
         status = USB_TRANSFER_STATUS_TIMED_OUT;
     }
 
     return status;
 }
 
-esp_err_t msc_bulk_transfer(msc_device_t *device, uint8_t *data, size_t size, msc_endpoint_t ep)
+esp_err_t msc_bulk_buffer_reserve(msc_device_t *device, size_t size, msc_endpoint_t ep)
 {
-    esp_err_t ret = ESP_OK;
-    usb_transfer_t *xfer = device->xfer;
-    size_t transfer_size = (ep == MSC_EP_IN) ? usb_round_up_to_mps(size, device->config.bulk_in_mps) : size;
+    msc_bot_t *bot = device->bot;
+    size_t transfer_size = (ep == MSC_EP_IN) ? usb_round_up_to_mps(size, bot->config.bulk_in_mps) : size;
 
-    if (xfer->data_buffer_size < transfer_size) {
+    if (bot->xfer->data_buffer_size < transfer_size) {
         // The allocated buffer is not large enough -> realloc
-        MSC_RETURN_ON_ERROR( usb_host_transfer_free(xfer) );
-        MSC_RETURN_ON_ERROR( usb_host_transfer_alloc(transfer_size, 0, &device->xfer) );
-        xfer = device->xfer;
+        // Allocate first, so that the current buffer is kept if there is not enough memory
+        usb_transfer_t *xfer;
+        esp_err_t ret = usb_host_transfer_alloc(transfer_size, 0, &xfer);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        MSC_RETURN_ON_ERROR( usb_host_transfer_free(bot->xfer) );
+        bot->xfer = xfer;
     }
+    return ESP_OK;
+}
+
+esp_err_t msc_bulk_transfer(msc_device_t *device, uint8_t *data, size_t size, msc_endpoint_t ep)
+{
+    esp_err_t ret = ESP_OK;
+    msc_bot_t *bot = device->bot;
+    size_t transfer_size = (ep == MSC_EP_IN) ? usb_round_up_to_mps(size, bot->config.bulk_in_mps) : size;
+
+    MSC_RETURN_ON_ERROR( msc_bulk_buffer_reserve(device, size, ep) );
+    usb_transfer_t *xfer = bot->xfer;
 
     if (ep == MSC_EP_IN) {
-        xfer->bEndpointAddress = device->config.bulk_in_ep;
+        xfer->bEndpointAddress = bot->config.bulk_in_ep;
     } else {
-        xfer->bEndpointAddress = device->config.bulk_out_ep;
+        xfer->bEndpointAddress = bot->config.bulk_out_ep;
         memcpy(xfer->data_buffer, data, size);
     }
 
@@ -683,7 +1258,7 @@ esp_err_t msc_bulk_transfer(msc_device_t *device, uint8_t *data, size_t size, ms
     xfer->device_handle = device->handle;
     xfer->callback = transfer_callback;
     xfer->timeout_ms = 5000;
-    xfer->context = device;
+    xfer->context = bot;
 
     MSC_RETURN_ON_ERROR( usb_host_transfer_submit(xfer) );
     const usb_transfer_status_t status = wait_for_transfer_done(xfer);
@@ -709,13 +1284,13 @@ esp_err_t msc_bulk_transfer(msc_device_t *device, uint8_t *data, size_t size, ms
 
 esp_err_t msc_control_transfer(msc_device_t *device, size_t len)
 {
-    usb_transfer_t *xfer = device->xfer;
+    usb_transfer_t *xfer = device->bot->xfer;
     xfer->device_handle = device->handle;
     xfer->bEndpointAddress = 0;
     xfer->callback = transfer_callback;
     xfer->timeout_ms = 5000;
     xfer->num_bytes = len;
-    xfer->context = device;
+    xfer->context = device->bot;
 
     MSC_RETURN_ON_ERROR( usb_host_transfer_submit_control(s_msc_driver->client_handle, xfer));
     return wait_for_transfer_done(xfer) == USB_TRANSFER_STATUS_COMPLETED ? ESP_OK : ESP_ERR_MSC_INTERNAL;
@@ -730,10 +1305,22 @@ esp_err_t msc_host_reset_recovery(msc_host_device_handle_t device)
     // (b) a Clear Feature HALT to the Bulk-In endpoint
     // (c) a Clear Feature HALT to the Bulk-Out endpoint
 
-    ESP_RETURN_ON_ERROR( msc_mass_reset(device), TAG, "Mass reset failed" );
-    // Clear feature will fail if there is not STALL on the endpoint, so we don't check the errors here
-    clear_feature(device, device->config.bulk_in_ep);
-    clear_feature(device, device->config.bulk_out_ep);
+    if (device->bot->uas) {
+        MSC_RETURN_ON_ERROR( msc_uas_reset_recovery(device) );
+        MSC_RETURN_ON_ERROR( msc_wait_for_ready_state(device, WAIT_FOR_READY_TIMEOUT_MS) );
+        return ESP_OK;
+    }
+
+    // The reset applies to the whole interface, i.e. to all LUNs sharing the transport
+    msc_bot_lock(device);
+    esp_err_t ret = msc_mass_reset(device);
+    if (ret == ESP_OK) {
+        // Clear feature will fail if there is not STALL on the endpoint, so we don't check the errors here
+        clear_feature(device, device->bot->config.bulk_in_ep);
+        clear_feature(device, device->bot->config.bulk_out_ep);
+    }
+    msc_bot_unlock(device);
+    ESP_RETURN_ON_ERROR( ret, TAG, "Mass reset failed" );
     MSC_RETURN_ON_ERROR( msc_wait_for_ready_state(device, WAIT_FOR_READY_TIMEOUT_MS) );
     return ESP_OK;
 }
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <sys/param.h>
 #include "msc_common.h"
+#include "msc_disk_cache.h"
 #include "usb/msc_host_vfs.h"
 #include "diskio_impl.h"
 #include "ffconf.h"
@@ -21,6 +22,7 @@ typedef struct msc_host_vfs {
     char drive[DRIVE_STR_LEN];
     char *base_path;
     uint8_t pdrv;
+    msc_device_t *device;
 } msc_host_vfs_t;
 
 static const char *TAG = "MSC VFS";
@@ -100,6 +102,7 @@ esp_err_t msc_host_vfs_register(msc_host_device_handle_t device,
     strncpy(vfs->drive, drive, DRIVE_STR_LEN);
     MSC_GOTO_ON_FALSE( vfs->base_path = strdup(base_path), ESP_ERR_NO_MEM );
     vfs->pdrv = pdrv;
+    vfs->device = dev;
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
     esp_vfs_fat_conf_t conf = {
@@ -144,6 +147,10 @@ esp_err_t msc_host_vfs_unregister(msc_host_vfs_handle_t vfs_handle)
     MSC_RETURN_ON_INVALID_ARG(vfs_handle);
     msc_host_vfs_t *vfs = (msc_host_vfs_t *)vfs_handle;
 
+    // FatFs does not sync the disk on unmount, write back the cached blocks here
+    if (vfs->device->cache) {
+        msc_disk_cache_flush(vfs->device->cache);
+    }
     f_mount(NULL, vfs->drive, 0);
     ff_diskio_unregister(vfs->pdrv);
     esp_vfs_fat_unregister_path(vfs->base_path);
@@ -16,6 +16,7 @@
 #include "esp_log.h"
 #include "msc_common.h"
 #include "msc_scsi_bot.h"
+#include "msc_uas.h"
 #include "usb/msc_host.h"
 
 static const char *TAG = "USB_MSC_SCSI";
@@ -32,7 +33,9 @@ static const char *TAG = "USB_MSC_SCSI";
 #define SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL 0x1E
 #define SCSI_CMD_READ10 0x28
 #define SCSI_CMD_READ12 0xA8
+#define SCSI_CMD_READ16 0x88
 #define SCSI_CMD_READ_CAPACITY 0x25
+#define SCSI_CMD_SERVICE_ACTION_IN_16 0x9E
 #define SCSI_CMD_READ_FORMAT_CAPACITIES 0x23
 #define SCSI_CMD_REQUEST_SENSE 0x03
 #define SCSI_CMD_REZERO 0x01
@@ -43,25 +46,31 @@ static const char *TAG = "USB_MSC_SCSI";
 #define SCSI_CMD_VERIFY 0x2F
 #define SCSI_CMD_WRITE10 0x2A
 #define SCSI_CMD_WRITE12 0xAA
+#define SCSI_CMD_WRITE16 0x8A
 #define SCSI_CMD_WRITE_AND_VERIFY 0x2E
 
 #define IN_DIR   CWB_FLAG_DIRECTION_IN
 #define OUT_DIR  0
 
+#define SCSI_SA_READ_CAPACITY_16    0x10
+#define INQUIRY_FLAG_EVPD           (1 << 0)
+#define INQUIRY_VPD_BLOCK_LIMITS    0xB0
+#define INQUIRY_RMB                 (1 << 7)    // Removable medium bit of the standard INQUIRY data
+
 #define INQUIRY_VID_SIZE    8
 #define INQUIRY_PID_SIZE    16
 #define INQUIRY_REV_SIZE    4
 
 #define CBW_CMD_SIZE(cmd) (sizeof(cmd) - sizeof(msc_cbw_t))
 
-#define CBW_BASE_INIT(dir, cbw_len, data_len)   \
-    .base = {                                   \
-        .signature = 0x43425355,                \
-        .tag = ++cbw_tag,                       \
-        .flags = dir,                           \
-        .lun = 0,                               \
-        .data_length = data_len,                \
-        .cbw_length = cbw_len,                  \
+// The tag is assigned by bot_execute_command()
+#define CBW_BASE_INIT(dev, dir, cbw_len, data_len) \
+    .base = {                                      \
+        .signature = 0x43425355,                   \
+        .flags = dir,                              \
+        .lun = (dev)->lun,                         \
+        .data_length = data_len,                   \
+        .cbw_length = cbw_len,                     \
     }
 
 #define CSW_SIGNATURE   0x53425355
@@ -142,6 +151,28 @@ typedef struct __attribute__((packed))
     uint8_t reserved2[1];
 } cbw_write10_t;
 
+typedef struct __attribute__((packed))
+{
+    msc_cbw_t base;
+    uint8_t opcode;
+    uint8_t flags;
+    uint64_t address;
+    uint32_t length;
+    uint8_t group;
+    uint8_t control;
+} cbw_read16_t;
+
+typedef struct __attribute__((packed))
+{
+    msc_cbw_t base;
+    uint8_t opcode;
+    uint8_t flags;
+    uint64_t address;
+    uint32_t length;
+    uint8_t group;
+    uint8_t control;
+} cbw_write16_t;
+
 typedef struct __attribute__((packed))
 {
     msc_cbw_t base;
@@ -151,6 +182,24 @@ typedef struct __attribute__((packed))
     uint8_t reserved[6];
 } cbw_read_capacity_t;
 
+typedef struct __attribute__((packed))
+{
+    msc_cbw_t base;
+    uint8_t opcode;
+    uint8_t service_action;
+    uint64_t address;
+    uint32_t allocation_length;
+    uint8_t pmi;
+    uint8_t control;
+} cbw_read_capacity16_t;
+
+typedef struct __attribute__((packed))
+{
+    uint64_t block_count;
+    uint32_t block_size;
+    uint8_t reserved[20];
+} cbw_read_capacity16_response_t;
+
 typedef struct __attribute__((packed))
 {
     uint32_t block_count;
@@ -230,8 +279,20 @@ typedef struct __attribute__((packed))
     uint8_t data[36];
 } cbw_inquiry_response_t;
 
-// Unique number based on which MSC protocol pairs request and response
-static uint32_t cbw_tag;
+/**
+ * @brief Block Limits VPD page
+ *
+ * @see SCSI Block Commands - 3 (SBC-3), Table 181
+ */
+typedef struct __attribute__((packed))
+{
+    uint8_t peripheral;
+    uint8_t page_code;
+    uint16_t page_length;
+    uint8_t reserved_0[4];
+    uint32_t max_transfer_length;
+    uint8_t reserved_1[52];
+} cbw_block_limits_response_t;
 
 static esp_err_t check_csw(msc_csw_t *csw, uint32_t tag)
 {
@@ -248,16 +309,15 @@ static esp_err_t check_csw(msc_csw_t *csw, uint32_t tag)
 }
 
 /**
- * @brief Execute BOT command
+ * @brief Transport BOT command
  *
  * There are multiple stages in BOT command:
+ * 0. Allocation of the transfer buffer for the data transport. ESP_ERR_NO_MEM is returned before anything is sent
  * 1. Command transport
  * 2. Data transport (optional)
  * 3. Status transport
  * 3.1. Error recovery (in case of error)
  *
- * This function is not 'static' so it could be called from unit test
- *
  * @see USB Mass Storage Class – Bulk Only Transport, Chapter 5.3
  *
  * @param[in] device MSC device handle
@@ -266,11 +326,19 @@ static esp_err_t check_csw(msc_csw_t *csw, uint32_t tag)
  * @param[in] size   Size of data in bytes
  * @return esp_err_t
  */
-esp_err_t bot_execute_command(msc_device_t *device, msc_cbw_t *cbw, void *data, size_t size)
+static esp_err_t bot_transport_command(msc_device_t *device, msc_cbw_t *cbw, void *data, size_t size)
 {
     msc_csw_t csw;
     msc_endpoint_t ep = (cbw->flags & CWB_FLAG_DIRECTION_IN) ? MSC_EP_IN : MSC_EP_OUT;
 
+    // 0. Make sure the data stage can be transported before sending the command
+    if (data) {
+        esp_err_t ret = msc_bulk_buffer_reserve(device, size, ep);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
     // 1. Command transport
     MSC_RETURN_ON_ERROR( msc_bulk_transfer(device, (uint8_t *)cbw, CBW_SIZE, MSC_EP_OUT) );
 
@@ -285,7 +353,7 @@ esp_err_t bot_execute_command(msc_device_t *device, msc_cbw_t *cbw, void *data,
     // 3.1 Error recovery
     if (err == ESP_ERR_MSC_STALL) {
         // In case of the status transport failure, we can try reading the status again after clearing feature
-        ESP_RETURN_ON_ERROR( clear_feature(device, device->config.bulk_in_ep), TAG, "Clear feature failed" );
+        ESP_RETURN_ON_ERROR( clear_feature(device, device->bot->config.bulk_in_ep), TAG, "Clear feature failed" );
         err = msc_bulk_transfer(device, (uint8_t *)&csw, sizeof(msc_csw_t), MSC_EP_IN);
         if (ESP_OK != err) {
             // In case the repeated status transport failed we do reset recovery
@@ -299,6 +367,36 @@ esp_err_t bot_execute_command(msc_device_t *device, msc_cbw_t *cbw, void *data,
     return check_csw(&csw, cbw->tag);
 }
 
+/**
+ * @brief Execute BOT command
+ *
+ * All LUNs of a device share its bulk endpoints, so the whole command is executed with the transport locked.
+ * Commands to different LUNs are interleaved command by command.
+ * Devices using USB Attached SCSI get the command's CDB in a Command IU instead.
+ *
+ * This function is not 'static' so it could be called from unit test
+ *
+ * @param[in] device MSC device handle
+ * @param[in] cbw    Command Block Wrapper
+ * @param[in] data   Data (optional)
+ * @param[in] size   Size of data in bytes
+ * @return esp_err_t
+ */
+esp_err_t bot_execute_command(msc_device_t *device, msc_cbw_t *cbw, void *data, size_t size)
+{
+    if (device->bot->uas) {
+        // UAS transports the CDB in a Command IU, commands of all tasks are outstanding at the same time
+        const bool data_in = cbw->flags & CWB_FLAG_DIRECTION_IN;
+        return msc_uas_execute_command(device, (const uint8_t *)(cbw + 1), cbw->cbw_length, data, size, data_in);
+    }
+
+    msc_bot_lock(device);
+    cbw->tag = ++device->bot->cbw_tag;
+    esp_err_t ret = bot_transport_command(device, cbw, data, size);
+    msc_bot_unlock(device);
+    return ret;
+}
+
 static const char *decode_sense_keys(cbw_sense_response_t *sense_response)
 {
     // Only decode WRITE_PROTECTED_MEDIA sense key, other keys are not implemented
@@ -326,7 +424,7 @@ esp_err_t scsi_cmd_read10(msc_host_device_handle_t dev,
 
     msc_device_t *device = (msc_device_t *)dev;
     cbw_read10_t cbw = {
-        CBW_BASE_INIT(IN_DIR, CBW_CMD_SIZE(cbw_read10_t), num_sectors * sector_size),
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_read10_t), num_sectors * sector_size),
         .opcode = SCSI_CMD_READ10,
         .flags = 0, // lun
         .address = __builtin_bswap32(sector_address),
@@ -335,8 +433,8 @@ esp_err_t scsi_cmd_read10(msc_host_device_handle_t dev,
 
     esp_err_t ret = bot_execute_command(device, &cbw.base, data, num_sectors * sector_size);
 
-    // In case of an error, get an error code
-    if (unlikely(ret != ESP_OK)) {
+    // In case of an error, get an error code. Nothing was sent to the device if there was not enough memory
+    if (unlikely(ret != ESP_OK && ret != ESP_ERR_NO_MEM)) {
         MSC_RETURN_ON_ERROR( scsi_cmd_sense(device, NULL));
     }
     return ret;
@@ -354,7 +452,7 @@ esp_err_t scsi_cmd_write10(msc_host_device_handle_t dev,
 
     msc_device_t *device = (msc_device_t *)dev;
     cbw_write10_t cbw = {
-        CBW_BASE_INIT(OUT_DIR, CBW_CMD_SIZE(cbw_write10_t), num_sectors * sector_size),
+        CBW_BASE_INIT(device, OUT_DIR, CBW_CMD_SIZE(cbw_write10_t), num_sectors * sector_size),
         .opcode = SCSI_CMD_WRITE10,
         .address = __builtin_bswap32(sector_address),
         .length = __builtin_bswap16(num_sectors),
@@ -362,8 +460,62 @@ esp_err_t scsi_cmd_write10(msc_host_device_handle_t dev,
 
     esp_err_t ret = bot_execute_command(device, &cbw.base, (void *)data, num_sectors * sector_size);
 
-    // In case of an error, get an error code
-    if (unlikely(ret != ESP_OK)) {
+    // In case of an error, get an error code. Nothing was sent to the device if there was not enough memory
+    if (unlikely(ret != ESP_OK && ret != ESP_ERR_NO_MEM)) {
+        MSC_RETURN_ON_ERROR( scsi_cmd_sense(device, NULL));
+    }
+    return ret;
+}
+
+esp_err_t scsi_cmd_read16(msc_host_device_handle_t dev,
+                          uint8_t *data,
+                          uint64_t sector_address,
+                          uint32_t num_sectors,
+                          uint32_t sector_size)
+{
+    if (num_sectors != 0 && sector_size > UINT32_MAX / num_sectors) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    msc_device_t *device = (msc_device_t *)dev;
+    cbw_read16_t cbw = {
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_read16_t), num_sectors * sector_size),
+        .opcode = SCSI_CMD_READ16,
+        .address = __builtin_bswap64(sector_address),
+        .length = __builtin_bswap32(num_sectors),
+    };
+
+    esp_err_t ret = bot_execute_command(device, &cbw.base, data, num_sectors * sector_size);
+
+    // In case of an error, get an error code. Nothing was sent to the device if there was not enough memory
+    if (unlikely(ret != ESP_OK && ret != ESP_ERR_NO_MEM)) {
+        MSC_RETURN_ON_ERROR( scsi_cmd_sense(device, NULL));
+    }
+    return ret;
+}
+
+esp_err_t scsi_cmd_write16(msc_host_device_handle_t dev,
+                           const uint8_t *data,
+                           uint64_t sector_address,
+                           uint32_t num_sectors,
+                           uint32_t sector_size)
+{
+    if (num_sectors != 0 && sector_size > UINT32_MAX / num_sectors) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    msc_device_t *device = (msc_device_t *)dev;
+    cbw_write16_t cbw = {
+        CBW_BASE_INIT(device, OUT_DIR, CBW_CMD_SIZE(cbw_write16_t), num_sectors * sector_size),
+        .opcode = SCSI_CMD_WRITE16,
+        .address = __builtin_bswap64(sector_address),
+        .length = __builtin_bswap32(num_sectors),
+    };
+
+    esp_err_t ret = bot_execute_command(device, &cbw.base, (void *)data, num_sectors * sector_size);
+
+    // In case of an error, get an error code. Nothing was sent to the device if there was not enough memory
+    if (unlikely(ret != ESP_OK && ret != ESP_ERR_NO_MEM)) {
         MSC_RETURN_ON_ERROR( scsi_cmd_sense(device, NULL));
     }
     return ret;
@@ -375,7 +527,7 @@ esp_err_t scsi_cmd_read_capacity(msc_host_device_handle_t dev, uint32_t *block_s
     cbw_read_capacity_response_t response;
 
     cbw_read_capacity_t cbw = {
-        CBW_BASE_INIT(IN_DIR, CBW_CMD_SIZE(cbw_read_capacity_t), sizeof(response)),
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_read_capacity_t), sizeof(response)),
         .opcode = SCSI_CMD_READ_CAPACITY,
     };
 
@@ -392,11 +544,37 @@ esp_err_t scsi_cmd_read_capacity(msc_host_device_handle_t dev, uint32_t *block_s
     return ret;
 }
 
+esp_err_t scsi_cmd_read_capacity16(msc_host_device_handle_t dev, uint32_t *block_size, uint64_t *block_count)
+{
+    msc_device_t *device = (msc_device_t *)dev;
+    cbw_read_capacity16_response_t response;
+
+    cbw_read_capacity16_t cbw = {
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_read_capacity16_t), sizeof(response)),
+        .opcode = SCSI_CMD_SERVICE_ACTION_IN_16,
+        .service_action = SCSI_SA_READ_CAPACITY_16,
+        .allocation_length = __builtin_bswap32(sizeof(response)),
+    };
+
+    esp_err_t ret = bot_execute_command(device, &cbw.base, &response, sizeof(response));
+
+    // In case of an error, get an error code
+    if (unlikely(ret != ESP_OK)) {
+        MSC_RETURN_ON_ERROR( scsi_cmd_sense(device, NULL));
+        return ret;
+    }
+
+    *block_count = __builtin_bswap64(response.block_count);
+    *block_size = __builtin_bswap32(response.block_size);
+
+    return ret;
+}
+
 esp_err_t scsi_cmd_unit_ready(msc_host_device_handle_t dev)
 {
     msc_device_t *device = (msc_device_t *)dev;
     cbw_unit_ready_t cbw = {
-        CBW_BASE_INIT(IN_DIR, CBW_CMD_SIZE(cbw_unit_ready_t), 0),
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_unit_ready_t), 0),
         .opcode = SCSI_CMD_TEST_UNIT_READY,
     };
 
@@ -415,12 +593,15 @@ esp_err_t scsi_cmd_sense(msc_host_device_handle_t dev, scsi_sense_data_t *sense)
     cbw_sense_response_t response;
 
     cbw_sense_t cbw = {
-        CBW_BASE_INIT(IN_DIR, CBW_CMD_SIZE(cbw_sense_t), sizeof(response)),
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_sense_t), sizeof(response)),
         .opcode = SCSI_CMD_REQUEST_SENSE,
         .allocation_length = sizeof(response),
     };
 
-    MSC_RETURN_ON_ERROR( bot_execute_command(device, &cbw.base, &response, sizeof(response)) );
+    // UAS devices return the sense data with the failed command, REQUEST SENSE would find them cleared
+    if (!device->bot->uas || msc_uas_take_sense(device, (uint8_t *)&response) != ESP_OK) {
+        MSC_RETURN_ON_ERROR( bot_execute_command(device, &cbw.base, &response, sizeof(response)) );
+    }
 
     if (sense == NULL) {
         ESP_LOGE(TAG, "Sense error codes: Sense Key 0x%02"PRIx8", ASC: 0x%02"PRIx8", ASCQ: 0x%02"PRIx8"",
@@ -443,7 +624,7 @@ esp_err_t scsi_cmd_inquiry(msc_host_device_handle_t dev)
     cbw_inquiry_response_t response = { 0 };
 
     cbw_inquiry_t cbw = {
-        CBW_BASE_INIT(IN_DIR, CBW_CMD_SIZE(cbw_inquiry_t), sizeof(response)),
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_inquiry_t), sizeof(response)),
         .opcode = SCSI_CMD_INQUIRY,
         .allocation_length = sizeof(response),
     };
@@ -453,17 +634,53 @@ esp_err_t scsi_cmd_inquiry(msc_host_device_handle_t dev)
     // In case of an error, get an error code
     if (unlikely(ret != ESP_OK)) {
         MSC_RETURN_ON_ERROR( scsi_cmd_sense(device, NULL));
+        return ret;
     }
+
+    device->removable = response.data[1] & INQUIRY_RMB;
+    device->scsi_version = response.data[2];
     return ret;
 }
 
+esp_err_t scsi_cmd_block_limits(msc_host_device_handle_t dev, uint32_t *max_transfer_length)
+{
+    msc_device_t *device = (msc_device_t *)dev;
+    cbw_block_limits_response_t response = { 0 };
+
+    cbw_inquiry_t cbw = {
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(cbw_inquiry_t), sizeof(response)),
+        .opcode = SCSI_CMD_INQUIRY,
+        .flags = INQUIRY_FLAG_EVPD,
+        .page_code = INQUIRY_VPD_BLOCK_LIMITS,
+        .allocation_length = sizeof(response),
+    };
+
+    esp_err_t ret = bot_execute_command(device, &cbw.base, &response, sizeof(response) );
+
+    // The page is optional, so errors are handled silently
+    if (unlikely(ret == ESP_FAIL)) {
+        // The command failed in CSW, clear the sense data
+        scsi_sense_data_t sense;
+        scsi_cmd_sense(device, &sense);
+        return ret;
+    } else if (unlikely(ret != ESP_OK)) {
+        // The device might have stalled the data stage
+        msc_host_reset_recovery(device);
+        return ret;
+    }
+    MSC_RETURN_ON_FALSE(response.page_code == INQUIRY_VPD_BLOCK_LIMITS, ESP_ERR_INVALID_RESPONSE);
+
+    *max_transfer_length = __builtin_bswap32(response.max_transfer_length);
+    return ESP_OK;
+}
+
 esp_err_t scsi_cmd_mode_sense(msc_host_device_handle_t dev)
 {
     msc_device_t *device = (msc_device_t *)dev;
     mode_sense_response_t response = { 0 };
 
     mode_sense_t cbw = {
-        CBW_BASE_INIT(IN_DIR, CBW_CMD_SIZE(mode_sense_t), sizeof(response)),
+        CBW_BASE_INIT(device, IN_DIR, CBW_CMD_SIZE(mode_sense_t), sizeof(response)),
         .opcode = SCSI_CMD_MODE_SENSE,
         .pc_page_code = 0x3F,
         .parameter_list_length = sizeof(response),
@@ -482,7 +699,7 @@ esp_err_t scsi_cmd_prevent_removal(msc_host_device_handle_t dev, bool prevent)
 {
     msc_device_t *device = (msc_device_t *)dev;
     prevent_allow_medium_removal_t cbw = {
-        CBW_BASE_INIT(OUT_DIR, CBW_CMD_SIZE(prevent_allow_medium_removal_t), 0),
+        CBW_BASE_INIT(device, OUT_DIR, CBW_CMD_SIZE(prevent_allow_medium_removal_t), 0),
         .opcode = SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL,
         .prevent = (uint8_t) prevent,
     };
@@ -0,0 +1,605 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "usb/usb_host.h"
+#include "usb/usb_helpers.h"
+#include "usb/msc_host.h"
+#include "msc_common.h"
+#include "msc_uas.h"
+
+static const char *TAG = "USB_MSC_UAS";
+
+// UAS spin lock
+static portMUX_TYPE uas_lock = portMUX_INITIALIZER_UNLOCKED;
+#define UAS_ENTER_CRITICAL()    portENTER_CRITICAL(&uas_lock)
+#define UAS_EXIT_CRITICAL()     portEXIT_CRITICAL(&uas_lock)
+
+/* ---------------------------- UAS Definitions ----------------------------- */
+#define UAS_IU_COMMAND          0x01
+#define UAS_IU_SENSE            0x03
+#define UAS_IU_RESPONSE         0x04
+#define UAS_IU_READ_READY       0x06
+#define UAS_IU_WRITE_READY      0x07
+
+#define UAS_TASK_ATTR_SIMPLE    0x00
+#define UAS_CDB_MAX_SIZE        16
+#define UAS_TIMEOUT_MS          5000    // Timeout of one command, transfers are canceled when it expires
+#define UAS_FLUSH_TIMEOUT_MS    1000
+#define SCSI_STATUS_GOOD        0x00
+
+/**
+ * @brief Command IU
+ *
+ * @see USB Attached SCSI, Chapter 6.2.2
+ */
+typedef struct __attribute__((packed))
+{
+    uint8_t iu_id;
+    uint8_t reserved_0;
+    uint16_t tag;
+    uint8_t task_attribute;
+    uint8_t reserved_1;
+    uint8_t additional_cdb_length;
+    uint8_t reserved_2;
+    uint8_t lun[8];
+    uint8_t cdb[UAS_CDB_MAX_SIZE];
+} uas_command_iu_t;
+
+/**
+ * @brief Common header of all IUs
+ */
+typedef struct __attribute__((packed))
+{
+    uint8_t iu_id;
+    uint8_t reserved;
+    uint16_t tag;
+} uas_iu_header_t;
+
+/**
+ * @brief Sense IU with fixed format sense data
+ *
+ * @see USB Attached SCSI, Chapter 6.2.5
+ */
+typedef struct __attribute__((packed))
+{
+    uas_iu_header_t header;
+    uint16_t status_qualifier;
+    uint8_t status;
+    uint8_t reserved[7];
+    uint16_t sense_length;
+    uint8_t sense_data[MSC_UAS_SENSE_SIZE];
+} uas_sense_iu_t;
+
+/**
+ * @brief Response IU
+ *
+ * @see USB Attached SCSI, Chapter 6.2.6
+ */
+typedef struct __attribute__((packed))
+{
+    uas_iu_header_t header;
+    uint8_t additional_info[3];
+    uint8_t response_code;
+} uas_response_iu_t;
+
+/**
+ * @brief Outstanding UAS command
+ *
+ * A command finishes when its Sense or Response IU was received and none of its transfers is in flight.
+ * Transfers of all pipes are completed in the MSC client task; this structure is protected by the UAS spin lock.
+ */
+typedef struct {
+    msc_uas_t *uas;
+    uint16_t tag;
+    bool in_use;
+    bool data_in;
+    bool cmd_busy;              // Command IU transfer in flight
+    bool data_busy;             // Data transfer in flight
+    bool status_done;           // Sense or Response IU received, or the status pipe failed
+    bool signaled;              // The waiting task was signaled
+    uint8_t *data;
+    size_t size;
+    esp_err_t result;
+    uint8_t sense_len;          // Length of sense data received in the Sense IU
+    uint8_t sense[MSC_UAS_SENSE_SIZE];
+    usb_transfer_t *cmd_xfer;
+    usb_transfer_t *data_xfer;
+    SemaphoreHandle_t done;
+} uas_cmd_t;
+
+struct msc_uas {
+    msc_bot_t *bot;
+    usb_transfer_t *status_xfer;
+    bool status_busy;           // Status transfer is submitted
+    uint32_t num_pending;       // Commands waiting for their Sense or Response IU
+    uint8_t sense_len;          // Sense data of the last failed command, UAS devices are used with LUN 0 only
+    uint8_t sense[MSC_UAS_SENSE_SIZE];
+    SemaphoreHandle_t free_slots;
+    uas_cmd_t cmds[MSC_UAS_MAX_COMMANDS];
+};
+
+/**
+ * @brief Signal the tasks of all finished commands
+ *
+ * Must be called outside of critical section
+ */
+static void uas_signal_finished(msc_uas_t *uas)
+{
+    SemaphoreHandle_t to_signal[MSC_UAS_MAX_COMMANDS];
+    int num_signal = 0;
+
+    UAS_ENTER_CRITICAL();
+    for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+        uas_cmd_t *cmd = &uas->cmds[i];
+        if (cmd->in_use && !cmd->signaled && cmd->status_done && !cmd->cmd_busy && !cmd->data_busy) {
+            cmd->signaled = true;
+            to_signal[num_signal++] = cmd->done;
+        }
+    }
+    UAS_EXIT_CRITICAL();
+
+    for (int i = 0; i < num_signal; i++) {
+        xSemaphoreGive(to_signal[i]);
+    }
+}
+
+/**
+ * @brief Fail all commands that wait for their status
+ *
+ * Must be called from critical section
+ */
+static void uas_fail_pending(msc_uas_t *uas)
+{
+    for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+        uas_cmd_t *cmd = &uas->cmds[i];
+        if (cmd->in_use && !cmd->status_done) {
+            cmd->status_done = true;
+            cmd->result = ESP_ERR_MSC_INTERNAL;
+            uas->num_pending--;
+        }
+    }
+}
+
+static esp_err_t uas_submit_status(msc_uas_t *uas)
+{
+    usb_transfer_t *xfer = uas->status_xfer;
+    xfer->num_bytes = xfer->data_buffer_size;
+    return usb_host_transfer_submit(xfer);
+}
+
+static void uas_cmd_callback(usb_transfer_t *transfer)
+{
+    uas_cmd_t *cmd = (uas_cmd_t *)transfer->context;
+
+    UAS_ENTER_CRITICAL();
+    cmd->cmd_busy = false;
+    if (transfer->status != USB_TRANSFER_STATUS_COMPLETED) {
+        // The device did not get the command, so it will never send its status
+        cmd->result = ESP_ERR_MSC_INTERNAL;
+        if (!cmd->status_done) {
+            cmd->status_done = true;
+            cmd->uas->num_pending--;
+        }
+    }
+    UAS_EXIT_CRITICAL();
+
+    uas_signal_finished(cmd->uas);
+}
+
+static void uas_data_callback(usb_transfer_t *transfer)
+{
+    uas_cmd_t *cmd = (uas_cmd_t *)transfer->context;
+    esp_err_t result = ESP_OK;
+
+    switch (transfer->status) {
+    case USB_TRANSFER_STATUS_COMPLETED:
+        if (cmd->data_in) {
+            if (transfer->actual_num_bytes > cmd->size) {
+                result = ESP_ERR_INVALID_SIZE;
+            } else {
+                memcpy(cmd->data, transfer->data_buffer, transfer->actual_num_bytes);
+            }
+        }
+        break;
+    case USB_TRANSFER_STATUS_STALL:
+        result = ESP_ERR_MSC_STALL;
+        break;
+    default:
+        result = ESP_ERR_MSC_INTERNAL;
+        break;
+    }
+
+    UAS_ENTER_CRITICAL();
+    cmd->data_busy = false;
+    if (result != ESP_OK) {
+        cmd->result = result;
+    }
+    UAS_EXIT_CRITICAL();
+
+    uas_signal_finished(cmd->uas);
+}
+
+/**
+ * @brief Start the data stage of a command, requested by READ READY or WRITE READY IU
+ */
+static void uas_start_data(msc_uas_t *uas, uas_cmd_t *cmd, bool data_in)
+{
+    const msc_config_t *config = &uas->bot->config;
+    usb_transfer_t *xfer = cmd->data_xfer;
+
+    if (cmd->data == NULL || data_in != cmd->data_in) {
+        ESP_LOGW(TAG, "Unexpected data stage of tag %d", cmd->tag);
+        return;
+    }
+    xfer->bEndpointAddress = data_in ? config->uas_data_in_ep : config->uas_data_out_ep;
+    xfer->num_bytes = data_in ? usb_round_up_to_mps(cmd->size, config->uas_data_in_mps) : cmd->size;
+
+    UAS_ENTER_CRITICAL();
+    cmd->data_busy = true;
+    UAS_EXIT_CRITICAL();
+    if (usb_host_transfer_submit(xfer) != ESP_OK) {
+        UAS_ENTER_CRITICAL();
+        cmd->data_busy = false;
+        cmd->result = ESP_ERR_MSC_INTERNAL;
+        UAS_EXIT_CRITICAL();
+    }
+}
+
+static uas_cmd_t *uas_find_cmd(msc_uas_t *uas, uint16_t tag)
+{
+    for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+        if (uas->cmds[i].in_use && uas->cmds[i].tag == tag) {
+            return &uas->cmds[i];
+        }
+    }
+    return NULL;
+}
+
+static void uas_status_callback(usb_transfer_t *transfer)
+{
+    msc_uas_t *uas = (msc_uas_t *)transfer->context;
+    const uas_iu_header_t *header = (const uas_iu_header_t *)transfer->data_buffer;
+
+    if (transfer->status == USB_TRANSFER_STATUS_COMPLETED && transfer->actual_num_bytes >= sizeof(uas_iu_header_t)) {
+        uas_cmd_t *cmd = uas_find_cmd(uas, __builtin_bswap16(header->tag));
+        if (cmd == NULL) {
+            ESP_LOGW(TAG, "IU 0x%02x with unknown tag %d", header->iu_id, __builtin_bswap16(header->tag));
+        } else {
+            switch (header->iu_id) {
+            case UAS_IU_READ_READY:
+                uas_start_data(uas, cmd, true);
+                break;
+            case UAS_IU_WRITE_READY:
+                uas_start_data(uas, cmd, false);
+                break;
+            case UAS_IU_SENSE: {
+                const uas_sense_iu_t *sense = (const uas_sense_iu_t *)transfer->data_buffer;
+                const size_t header_len = offsetof(uas_sense_iu_t, sense_data);
+                size_t sense_len = 0;
+                if (transfer->actual_num_bytes > header_len) {
+                    sense_len = MIN(__builtin_bswap16(sense->sense_length), transfer->actual_num_bytes - header_len);
+                    sense_len = MIN(sense_len, MSC_UAS_SENSE_SIZE);
+                }
+                UAS_ENTER_CRITICAL();
+                if (sense->status != SCSI_STATUS_GOOD) {
+                    cmd->result = ESP_FAIL;
+                    // The device clears its sense data once it sent them, keep them for scsi_cmd_sense()
+                    memcpy(cmd->sense, sense->sense_data, sense_len);
+                    cmd->sense_len = sense_len;
+                }
+                if (!cmd->status_done) {
+                    cmd->status_done = true;
+                    uas->num_pending--;
+                }
+                UAS_EXIT_CRITICAL();
+                if (sense->status != SCSI_STATUS_GOOD) {
+                    ESP_LOGD(TAG, "Tag %d status 0x%02x, Sense Key 0x%02x", cmd->tag, sense->status, sense->sense_data[2] & 0x0F);
+                }
+                break;
+            }
+            case UAS_IU_RESPONSE: {
+                const uas_response_iu_t *response = (const uas_response_iu_t *)transfer->data_buffer;
+                ESP_LOGD(TAG, "Tag %d response code 0x%02x", cmd->tag, response->response_code);
+                UAS_ENTER_CRITICAL();
+                cmd->result = ESP_ERR_MSC_INTERNAL;
+                if (!cmd->status_done) {
+                    cmd->status_done = true;
+                    uas->num_pending--;
+                }
+                UAS_EXIT_CRITICAL();
+                break;
+            }
+            default:
+                ESP_LOGW(TAG, "Unexpected IU 0x%02x", header->iu_id);
+                break;
+            }
+        }
+    } else if (transfer->status != USB_TRANSFER_STATUS_COMPLETED) {
+        // The status pipe failed (e.g. the device is gone or the pipe was flushed)
+        UAS_ENTER_CRITICAL();
+        uas_fail_pending(uas);
+        UAS_EXIT_CRITICAL();
+    }
+
+    // Keep the status transfer submitted while there are commands waiting for an IU
+    UAS_ENTER_CRITICAL();
+    const bool resubmit = uas->num_pending > 0;
+    if (!resubmit) {
+        uas->status_busy = false;
+    }
+    UAS_EXIT_CRITICAL();
+    if (resubmit && uas_submit_status(uas) != ESP_OK) {
+        UAS_ENTER_CRITICAL();
+        uas_fail_pending(uas);
+        uas->status_busy = false;
+        UAS_EXIT_CRITICAL();
+    }
+
+    uas_signal_finished(uas);
+}
+
+/**
+ * @brief Halt, flush and clear all UAS pipes
+ *
+ * All transfers in flight are completed, so all outstanding commands finish.
+ */
+static void uas_flush_pipes(msc_uas_t *uas)
+{
+    const msc_config_t *config = &uas->bot->config;
+    const uint8_t endpoints[] = {config->uas_cmd_ep, config->uas_status_ep, config->uas_data_in_ep, config->uas_data_out_ep};
+
+    for (int i = 0; i < sizeof(endpoints); i++) {
+        usb_host_endpoint_halt(uas->bot->handle, endpoints[i]);
+        usb_host_endpoint_flush(uas->bot->handle, endpoints[i]);
+        usb_host_endpoint_clear(uas->bot->handle, endpoints[i]);
+    }
+}
+
+/**
+ * @brief Make sure the data transfer of a command is large enough
+ *
+ * The current transfer is kept if a larger one cannot be allocated.
+ */
+static esp_err_t uas_data_reserve(uas_cmd_t *cmd, size_t size, bool data_in)
+{
+    const msc_config_t *config = &cmd->uas->bot->config;
+    const size_t transfer_size = data_in ? usb_round_up_to_mps(size, config->uas_data_in_mps) : size;
+
+    if (cmd->data_xfer == NULL || cmd->data_xfer->data_buffer_size < transfer_size) {
+        usb_transfer_t *xfer;
+        esp_err_t ret = usb_host_transfer_alloc(transfer_size, 0, &xfer);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (cmd->data_xfer) {
+            usb_host_transfer_free(cmd->data_xfer);
+        }
+        xfer->device_handle = cmd->uas->bot->handle;
+        xfer->callback = uas_data_callback;
+        xfer->context = cmd;
+        cmd->data_xfer = xfer;
+    }
+    return ESP_OK;
+}
+
+esp_err_t msc_uas_execute_command(msc_device_t *device, const uint8_t *cdb, uint8_t cdb_len, void *data, size_t size, bool data_in)
+{
+    MSC_RETURN_ON_FALSE(cdb_len <= UAS_CDB_MAX_SIZE, ESP_ERR_INVALID_ARG);
+    msc_uas_t *uas = device->bot->uas;
+    uas_cmd_t *cmd = NULL;
+    esp_err_t ret;
+
+    // Get a free tag
+    xSemaphoreTake(uas->free_slots, portMAX_DELAY);
+    UAS_ENTER_CRITICAL();
+    for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+        if (!uas->cmds[i].in_use) {
+            cmd = &uas->cmds[i];
+            cmd->in_use = true;
+            break;
+        }
+    }
+    UAS_EXIT_CRITICAL();
+    assert(cmd);
+
+    const bool has_data = (data != NULL && size > 0);
+    if (has_data) {
+        ret = uas_data_reserve(cmd, size, data_in);
+        if (ret != ESP_OK) {
+            goto release;
+        }
+        if (!data_in) {
+            memcpy(cmd->data_xfer->data_buffer, data, size);
+        }
+    }
+    cmd->data = has_data ? data : NULL;
+    cmd->size = has_data ? size : 0;
+    cmd->data_in = data_in;
+    cmd->result = ESP_OK;
+    cmd->sense_len = 0;
+    cmd->signaled = false;
+
+    uas_command_iu_t *iu = (uas_command_iu_t *)cmd->cmd_xfer->data_buffer;
+    memset(iu, 0, sizeof(uas_command_iu_t));
+    iu->iu_id = UAS_IU_COMMAND;
+    iu->tag = __builtin_bswap16(cmd->tag);
+    iu->task_attribute = UAS_TASK_ATTR_SIMPLE;
+    iu->lun[1] = device->lun; // Single level LUN structure, peripheral device addressing
+    memcpy(iu->cdb, cdb, cdb_len);
+    cmd->cmd_xfer->num_bytes = sizeof(uas_command_iu_t);
+
+    UAS_ENTER_CRITICAL();
+    cmd->status_done = false;
+    cmd->cmd_busy = true;
+    uas->num_pending++;
+    const bool submit_status = !uas->status_busy;
+    uas->status_busy = true;
+    UAS_EXIT_CRITICAL();
+
+    // Without streams, the status transfer is shared by all commands and every IU carries the tag
+    if (submit_status && uas_submit_status(uas) != ESP_OK) {
+        // No IU can be received, fail this command and the commands that were waiting for the status transfer
+        UAS_ENTER_CRITICAL();
+        uas->status_busy = false;
+        cmd->cmd_busy = false;
+        uas_fail_pending(uas);
+        UAS_EXIT_CRITICAL();
+        uas_signal_finished(uas);
+    } else if (usb_host_transfer_submit(cmd->cmd_xfer) != ESP_OK) {
+        UAS_ENTER_CRITICAL();
+        cmd->cmd_busy = false;
+        cmd->status_done = true;
+        cmd->result = ESP_ERR_MSC_INTERNAL;
+        uas->num_pending--;
+        UAS_EXIT_CRITICAL();
+        uas_signal_finished(uas);
+    }
+
+    if (xSemaphoreTake(cmd->done, pdMS_TO_TICKS(UAS_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Tag %d timed out", cmd->tag);
+        // Cancel all transfers, all outstanding commands are failed
+        uas_flush_pipes(uas);
+        xSemaphoreTake(cmd->done, portMAX_DELAY); // Since we flushed the pipes, this should return immediately
+        cmd->result = ESP_ERR_MSC_INTERNAL;
+    }
+    ret = cmd->result;
+
+    if (ret == ESP_FAIL) {
+        UAS_ENTER_CRITICAL();
+        memcpy(uas->sense, cmd->sense, cmd->sense_len);
+        uas->sense_len = cmd->sense_len;
+        UAS_EXIT_CRITICAL();
+    }
+
+release:
+    UAS_ENTER_CRITICAL();
+    cmd->in_use = false;
+    UAS_EXIT_CRITICAL();
+    xSemaphoreGive(uas->free_slots);
+    return ret;
+}
+
+esp_err_t msc_uas_reset_recovery(msc_device_t *device)
+{
+    const msc_config_t *config = &device->bot->config;
+
+    msc_bot_lock(device);
+    // Clear feature will fail if there is not STALL on the endpoint, so we don't check the errors here
+    clear_feature(device, config->uas_status_ep);
+    clear_feature(device, config->uas_data_in_ep);
+    clear_feature(device, config->uas_data_out_ep);
+    clear_feature(device, config->uas_cmd_ep);
+    msc_bot_unlock(device);
+    return ESP_OK;
+}
+
+esp_err_t msc_uas_take_sense(msc_device_t *device, uint8_t *sense)
+{
+    msc_uas_t *uas = device->bot->uas;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    UAS_ENTER_CRITICAL();
+    if (uas->sense_len > 0) {
+        memset(sense, 0, MSC_UAS_SENSE_SIZE);
+        memcpy(sense, uas->sense, uas->sense_len);
+        uas->sense_len = 0;
+        ret = ESP_OK;
+    }
+    UAS_EXIT_CRITICAL();
+    return ret;
+}
+
+esp_err_t msc_uas_init(msc_bot_t *bot)
+{
+    esp_err_t ret;
+    msc_uas_t *uas = calloc(1, sizeof(msc_uas_t));
+    MSC_RETURN_ON_FALSE(uas, ESP_ERR_NO_MEM);
+    uas->bot = bot;
+    bot->uas = uas;
+
+    MSC_GOTO_ON_FALSE( uas->free_slots = xSemaphoreCreateCounting(MSC_UAS_MAX_COMMANDS, MSC_UAS_MAX_COMMANDS), ESP_ERR_NO_MEM );
+    MSC_GOTO_ON_ERROR( usb_host_transfer_alloc(usb_round_up_to_mps(sizeof(uas_sense_iu_t), bot->config.uas_status_mps), 0, &uas->status_xfer) );
+    uas->status_xfer->device_handle = bot->handle;
+    uas->status_xfer->bEndpointAddress = bot->config.uas_status_ep;
+    uas->status_xfer->callback = uas_status_callback;
+    uas->status_xfer->context = uas;
+
+    for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+        uas_cmd_t *cmd = &uas->cmds[i];
+        cmd->uas = uas;
+        cmd->tag = i + 1;
+        MSC_GOTO_ON_FALSE( cmd->done = xSemaphoreCreateBinary(), ESP_ERR_NO_MEM );
+        MSC_GOTO_ON_ERROR( usb_host_transfer_alloc(sizeof(uas_command_iu_t), 0, &cmd->cmd_xfer) );
+        cmd->cmd_xfer->device_handle = bot->handle;
+        cmd->cmd_xfer->bEndpointAddress = bot->config.uas_cmd_ep;
+        cmd->cmd_xfer->callback = uas_cmd_callback;
+        cmd->cmd_xfer->context = cmd;
+    }
+    return ESP_OK;
+
+fail:
+    msc_uas_deinit(bot);
+    return ret;
+}
+
+void msc_uas_deinit(msc_bot_t *bot)
+{
+    msc_uas_t *uas = bot->uas;
+    if (uas == NULL) {
+        return;
+    }
+
+    // The status transfer can stay submitted after its command failed, cancel it.
+    // It is completed by the MSC client task, it must not be freed before its callback ran.
+    UAS_ENTER_CRITICAL();
+    bool status_busy = uas->status_busy;
+    UAS_EXIT_CRITICAL();
+    if (status_busy) {
+        uas_flush_pipes(uas);
+    }
+    for (int i = 0; status_busy; i++) {
+        if (i == UAS_FLUSH_TIMEOUT_MS) {
+            ESP_LOGW(TAG, "Waiting for the status transfer, is the MSC client task running?");
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+        UAS_ENTER_CRITICAL();
+        status_busy = uas->status_busy;
+        UAS_EXIT_CRITICAL();
+    }
+
+    for (int i = 0; i < MSC_UAS_MAX_COMMANDS; i++) {
+        uas_cmd_t *cmd = &uas->cmds[i];
+        if (cmd->done) {
+            vSemaphoreDelete(cmd->done);
+        }
+        if (cmd->cmd_xfer) {
+            usb_host_transfer_free(cmd->cmd_xfer);
+        }
+        if (cmd->data_xfer) {
+            usb_host_transfer_free(cmd->data_xfer);
+        }
+    }
+    if (uas->status_xfer) {
+        usb_host_transfer_free(uas->status_xfer);
+    }
+    if (uas->free_slots) {
+        vSemaphoreDelete(uas->free_slots);
+    }
+    free(uas);
+    bot->uas = NULL;
+}
@@ -98,6 +98,14 @@ static char const *string_desc_arr[] = {
     //"Test MSC",                  // 4. MSC
 };
 
+// Serial String descriptor is provided only in the serial_number test mode, the host caches the identification by it
+static char const *string_desc_arr_serial[] = {
+    (const char[]) { 0x09, 0x04 },  // 0: is supported language is English (0x0409)
+    "TinyUSB",                      // 1: Manufacturer
+    "TinyUSB Device",               // 2: Product
+    "123456",                       // 3: Serials
+};
+
 /**
  * @brief TinyUSB device events handler
  *
@@ -126,7 +134,7 @@ static void device_event_handler(tinyusb_event_t *event, void *arg)
     xQueueSend(dev_evt_queue, event, 0);
 }
 
-static void usb_device_init(void)
+static void usb_device_init(bool serial_number)
 {
     // Create static app message queue
     dev_evt_queue = xQueueCreateStatic(DEV_EVT_QUEUE_LENGTH, sizeof(tinyusb_event_t), &(ucQueueStorage[0]), &s_queue_buf);
@@ -141,18 +149,23 @@ static void usb_device_init(void)
     tusb_cfg.descriptor.high_speed_config = msc_hs_desc_configuration;
     tusb_cfg.descriptor.qualifier = &device_qualifier;
 #endif // TUD_OPT_HIGH_SPEED
-    tusb_cfg.descriptor.string = string_desc_arr;
-    tusb_cfg.descriptor.string_count = sizeof(string_desc_arr) / sizeof(string_desc_arr[0]);
+    if (serial_number) {
+        tusb_cfg.descriptor.string = string_desc_arr_serial;
+        tusb_cfg.descriptor.string_count = sizeof(string_desc_arr_serial) / sizeof(string_desc_arr_serial[0]);
+    } else {
+        tusb_cfg.descriptor.string = string_desc_arr;
+        tusb_cfg.descriptor.string_count = sizeof(string_desc_arr) / sizeof(string_desc_arr[0]);
+    }
 
     ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
     ESP_LOGI(TAG, "USB initialization DONE");
 }
 
-static esp_err_t storage_init_spiflash(wl_handle_t *wl_handle)
+static esp_err_t storage_init_spiflash(const char *label, wl_handle_t *wl_handle)
 {
-    ESP_LOGI(TAG, "Initializing wear levelling");
+    ESP_LOGI(TAG, "Initializing wear levelling on %s", label);
 
-    const esp_partition_t *data_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, NULL);
+    const esp_partition_t *data_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, label);
     if (data_partition == NULL) {
         ESP_LOGE(TAG, "Failed to find FATFS partition. Check the partition table.");
         return ESP_ERR_NOT_FOUND;
@@ -161,19 +174,36 @@ static esp_err_t storage_init_spiflash(wl_handle_t *wl_handle)
     return wl_mount(data_partition, wl_handle);
 }
 
-static void msc_mock_device_run(void)
+/**
+ * @brief Run MSC Device with SPI flash storage
+ *
+ * @param[in] serial_number Provide the Serial String descriptor
+ * @param[in] two_luns      Expose a second partition as LUN 1
+ */
+static void msc_mock_device_run(bool serial_number, bool two_luns)
 {
     ESP_LOGI(TAG, "Initialization");
 
     static wl_handle_t wl_handle = WL_INVALID_HANDLE;
-    ESP_ERROR_CHECK(storage_init_spiflash(&wl_handle));
+    ESP_ERROR_CHECK(storage_init_spiflash("storage", &wl_handle));
 
     const tinyusb_msc_storage_config_t config = {
         .medium.wl_handle = wl_handle,  // Set the medium of the storage to the wear leveling
     };
     ESP_ERROR_CHECK(tinyusb_msc_new_storage_spiflash(&config, NULL));
 
-    usb_device_init();
+    if (two_luns) {
+        static wl_handle_t wl_handle_lun1 = WL_INVALID_HANDLE;
+        ESP_ERROR_CHECK(storage_init_spiflash("storage2", &wl_handle_lun1));
+
+        const tinyusb_msc_storage_config_t config_lun1 = {
+            .medium.wl_handle = wl_handle_lun1,
+            .fat_fs.base_path = "/lun1",    // Each storage needs its own base path
+        };
+        ESP_ERROR_CHECK(tinyusb_msc_new_storage_spiflash(&config_lun1, NULL));
+    }
+
+    usb_device_init(serial_number);
 }
 
 /**
@@ -242,7 +272,7 @@ static void device_suspend_common(size_t dconn_delay_ms, size_t conn_delay_ms)
  */
 TEST_CASE("mock_device_app", "[usb_msc_device][spiflash][default][ignore]")
 {
-    msc_mock_device_run();
+    msc_mock_device_run(false, false);
 
     while (1) {
         vTaskDelay(10);
@@ -251,11 +281,39 @@ TEST_CASE("mock_device_app", "[usb_msc_device][spiflash][default][ignore]")
 
 TEST_CASE("mock_device_sudden_dconn", "[usb_msc_device][spiflash][suspend_sudden_dconn][ignore]")
 {
-    msc_mock_device_run();
+    msc_mock_device_run(false, false);
 
     device_suspend_common(0, 1000);
 }
 
+/**
+ * @brief USB MSC Device Mock with a serial number
+ *
+ * Used to test the identification cache of the MSC host driver, which requires a serial number
+ */
+TEST_CASE("mock_device_serial_number", "[usb_msc_device][spiflash][serial_number][ignore]")
+{
+    msc_mock_device_run(true, false);
+
+    while (1) {
+        vTaskDelay(10);
+    }
+}
+
+/**
+ * @brief USB MSC Device Mock with two LUNs
+ *
+ * Used to test the Logical Unit API and commands issued to several LUNs of the MSC host driver
+ */
+TEST_CASE("mock_device_two_luns", "[usb_msc_device][spiflash][two_luns][ignore]")
+{
+    msc_mock_device_run(false, true);
+
+    while (1) {
+        vTaskDelay(10);
+    }
+}
+
 #if SOC_SDMMC_HOST_SUPPORTED
 static esp_err_t storage_init_sdmmc(sdmmc_card_t **card)
 {
@@ -340,7 +398,7 @@ void device_app_sdmmc(void)
     };
     ESP_ERROR_CHECK(tinyusb_msc_new_storage_sdmmc(&config, NULL));
 
-    usb_device_init();
+    usb_device_init(false);
 }
 
 TEST_CASE("mock_device_app", "[usb_msc_device][sdmmc][default][ignore]")
@@ -9,6 +9,7 @@
 #if SOC_USB_OTG_SUPPORTED
 
 #include "unity.h"
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <inttypes.h>
@@ -21,6 +22,7 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "../private_include/msc_common.h"
+#include "../private_include/msc_disk_cache.h"
 
 static const char *TAG = "APP";
 
@@ -578,7 +580,7 @@ TEST_CASE("can_be_formated_by_api", "[usb_msc]")
 static void print_device_info(msc_host_device_info_t *info)
 {
     const size_t megabyte = 1024 * 1024;
-    uint64_t capacity = ((uint64_t)info->sector_size * info->sector_count) / megabyte;
+    uint64_t capacity = ((uint64_t)info->sector_size * info->sector_count_64) / megabyte;
 
     printf("Device info:\n");
     printf("\t Capacity: %llu MB\n", capacity);
@@ -607,6 +609,296 @@ TEST_CASE("device_info", "[usb_msc]")
     print_device_info(&info);
 }
 
+#define SPLIT_BLOCKS            10
+#define SPLIT_MAX_BLOCKS        4
+
+/**
+ * @brief Large transfer splitting
+ *
+ * Purpose:
+ *     - Test that a multi-sector request is split into several commands and the data are not corrupted
+ *
+ * Procedure:
+ *     - Install USB Host lib, Install MSC driver, open a device
+ *     - Lower the maximum number of blocks per command
+ *     - Write and read a request that needs several commands, with an uneven last command
+ *     - Teardown
+ */
+TEST_CASE("large_transfer_split", "[usb_msc]")
+{
+    msc_setup();
+    uint8_t *write_data = malloc(SPLIT_BLOCKS * DISK_BLOCK_SIZE);
+    uint8_t *read_data = calloc(SPLIT_BLOCKS, DISK_BLOCK_SIZE);
+    TEST_ASSERT_NOT_NULL(write_data);
+    TEST_ASSERT_NOT_NULL(read_data);
+    for (int i = 0; i < SPLIT_BLOCKS * DISK_BLOCK_SIZE; i++) {
+        write_data[i] = (uint8_t)(i / DISK_BLOCK_SIZE + i);
+    }
+
+    msc_device_t *dev = (msc_device_t *)device;
+    TEST_ASSERT_GREATER_OR_EQUAL(1, dev->max_transfer_blocks);
+    const uint32_t max_transfer_blocks = dev->max_transfer_blocks;
+    dev->max_transfer_blocks = SPLIT_MAX_BLOCKS;
+    ESP_OK_ASSERT( msc_disk_write(dev, write_data, 30, SPLIT_BLOCKS) );
+    ESP_OK_ASSERT( msc_disk_read(dev, read_data, 30, SPLIT_BLOCKS) );
+    dev->max_transfer_blocks = max_transfer_blocks;
+    TEST_ASSERT_EQUAL_MEMORY(write_data, read_data, SPLIT_BLOCKS * DISK_BLOCK_SIZE);
+
+    free(write_data);
+    free(read_data);
+    msc_teardown();
+}
+
+/**
+ * @brief Write-back cache
+ *
+ * Procedure:
+ *     - Install USB Host lib, Install MSC driver, open a device, mount the file system
+ *     - Check invalid cache configurations
+ *     - Enable the cache, write and read a file. Closing the file syncs the file system, which flushes the cache
+ *     - Check the file with the cache disabled
+ *     - Teardown
+ */
+TEST_CASE("write_back_cache", "[usb_msc]")
+{
+    msc_host_disk_cache_stats_t stats;
+    msc_host_disk_cache_config_t cache_config = {
+        .sector_count = 18,
+        .ways = 4,
+        .idle_flush_ms = 100,
+    };
+
+    msc_setup();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, msc_host_disk_cache_enable(device, &cache_config));
+    cache_config.sector_count = 16;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, msc_host_disk_cache_get_stats(device, &stats));
+    ESP_OK_ASSERT( msc_host_disk_cache_enable(device, &cache_config) );
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, msc_host_disk_cache_enable(device, &cache_config));
+
+    write_read_file(FILE_NAME);
+    ESP_OK_ASSERT( msc_host_disk_cache_get_stats(device, &stats) );
+    ESP_LOGI(TAG, "Cache: read hits %"PRIu32", misses %"PRIu32", write hits %"PRIu32", misses %"PRIu32", flushed %"PRIu32" sectors by %"PRIu32" commands",
+             stats.read_hits, stats.read_misses, stats.write_hits, stats.write_misses, stats.flushed_sectors, stats.flush_commands);
+    TEST_ASSERT_GREATER_THAN(0, stats.flushes);
+    TEST_ASSERT_GREATER_THAN(0, stats.flushed_sectors);
+    TEST_ASSERT_LESS_OR_EQUAL(stats.flushed_sectors, stats.flush_commands);
+    TEST_ASSERT_EQUAL(0, stats.discarded_sectors);
+
+    // Dirty sectors are written after the idle time. The sector is rewritten with its own content not to break the file system
+    uint8_t data[DISK_BLOCK_SIZE];
+    msc_device_t *dev = (msc_device_t *)device;
+    const uint32_t flushed_sectors = stats.flushed_sectors;
+    ESP_OK_ASSERT( msc_disk_cache_read(dev->cache, data, 40, 1) );
+    ESP_OK_ASSERT( msc_disk_cache_write(dev->cache, data, 40, 1) );
+    vTaskDelay(pdMS_TO_TICKS(cache_config.idle_flush_ms * 3));
+    ESP_OK_ASSERT( msc_host_disk_cache_get_stats(device, &stats) );
+    TEST_ASSERT_EQUAL(flushed_sectors + 1, stats.flushed_sectors);
+
+    ESP_OK_ASSERT( msc_host_disk_cache_disable(device) );
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, msc_host_disk_cache_flush(device));
+    write_read_file(FILE_NAME);
+    msc_teardown();
+}
+
+#define CONCURRENT_TASKS        2
+#define CONCURRENT_ITERATIONS   50
+
+static SemaphoreHandle_t concurrent_done;
+
+static void concurrent_sectors_task(void *arg)
+{
+    const uint32_t sector = 20 + (uint32_t)arg;
+    uint8_t write_data[DISK_BLOCK_SIZE];
+    uint8_t read_data[DISK_BLOCK_SIZE];
+
+    memset(write_data, 0x55 + (uint32_t)arg, DISK_BLOCK_SIZE);
+    for (int i = 0; i < CONCURRENT_ITERATIONS; i++) {
+        memset(read_data, 0, DISK_BLOCK_SIZE);
+        TEST_ASSERT_EQUAL(ESP_OK, scsi_cmd_write10(device, write_data, sector, 1, DISK_BLOCK_SIZE));
+        TEST_ASSERT_EQUAL(ESP_OK, scsi_cmd_read10(device, read_data, sector, 1, DISK_BLOCK_SIZE));
+        TEST_ASSERT_EQUAL_MEMORY(write_data, read_data, DISK_BLOCK_SIZE);
+    }
+    xSemaphoreGive(concurrent_done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Logical units and concurrent commands
+ *
+ * Purpose:
+ *     - Test LUN discovery and installation API
+ *     - Test that commands issued from several tasks do not interfere on the shared Bulk-Only Transport
+ *
+ * Procedure:
+ *     - Install USB Host lib, Install MSC driver, open a device
+ *     - Check the LUN count and that LUN 0 cannot be installed twice
+ *     - Write and read sectors from several tasks at once
+ *     - Teardown
+ */
+TEST_CASE("luns_and_concurrent_commands", "[usb_msc]")
+{
+    msc_setup();
+
+    uint8_t lun_count = 0;
+    msc_host_device_handle_t lun_device;
+    msc_host_device_info_t info;
+    ESP_OK_ASSERT( msc_host_get_lun_count(device, &lun_count) );
+    TEST_ASSERT_GREATER_OR_EQUAL(1, lun_count);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, msc_host_install_lun(device, 0, &lun_device));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, msc_host_install_lun(device, lun_count, &lun_device));
+    ESP_OK_ASSERT( msc_host_get_device_info(device, &info) );
+    TEST_ASSERT_EQUAL(0, info.lun);
+
+    concurrent_done = xSemaphoreCreateCounting(CONCURRENT_TASKS, 0);
+    TEST_ASSERT_NOT_NULL(concurrent_done);
+    for (uint32_t i = 0; i < CONCURRENT_TASKS; i++) {
+        TEST_ASSERT(xTaskCreate(concurrent_sectors_task, "msc_concurrent", 4096, (void *)i, 3, NULL));
+    }
+    for (int i = 0; i < CONCURRENT_TASKS; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(concurrent_done, pdMS_TO_TICKS(10000)));
+    }
+    vSemaphoreDelete(concurrent_done);
+
+    msc_teardown();
+}
+
+#define LUN_SECTOR              20
+
+static msc_host_device_handle_t lun_devices[CONCURRENT_TASKS];
+static volatile uint32_t lun_iterations[CONCURRENT_TASKS];
+static uint32_t lun_other_iterations[CONCURRENT_TASKS];   // Iterations of the other LUN when the task finished
+
+static void concurrent_luns_task(void *arg)
+{
+    const uint32_t lun = (uint32_t)arg;
+    uint8_t write_data[DISK_BLOCK_SIZE];
+    uint8_t read_data[DISK_BLOCK_SIZE];
+
+    // Both LUNs use the same sector with different data
+    memset(write_data, 0xA0 + lun, DISK_BLOCK_SIZE);
+    for (int i = 0; i < CONCURRENT_ITERATIONS; i++) {
+        memset(read_data, 0, DISK_BLOCK_SIZE);
+        TEST_ASSERT_EQUAL(ESP_OK, scsi_cmd_write10(lun_devices[lun], write_data, LUN_SECTOR, 1, DISK_BLOCK_SIZE));
+        TEST_ASSERT_EQUAL(ESP_OK, scsi_cmd_read10(lun_devices[lun], read_data, LUN_SECTOR, 1, DISK_BLOCK_SIZE));
+        TEST_ASSERT_EQUAL_MEMORY(write_data, read_data, DISK_BLOCK_SIZE);
+        lun_iterations[lun]++;
+    }
+    lun_other_iterations[lun] = lun_iterations[(lun + 1) % CONCURRENT_TASKS];
+    xSemaphoreGive(concurrent_done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Commands to two logical units
+ *
+ * Purpose:
+ *     - Test installation of a second LUN
+ *     - Test that commands to several LUNs are served in turns and each LUN keeps its own data
+ *
+ * Procedure:
+ *     - Install USB Host lib, Install MSC driver, open a device and install its LUN 1
+ *     - Write and read the same sector of both LUNs, one task per LUN
+ *     - Check that no task was starved and that the sector of each LUN holds its own data
+ *     - Teardown
+ *
+ * The mock device must provide two LUNs (two_luns device test mode)
+ */
+TEST_CASE("commands_to_two_luns", "[usb_msc_luns]")
+{
+    msc_setup();
+
+    uint8_t lun_count = 0;
+    msc_host_device_handle_t lun_device;
+    msc_host_device_info_t info_lun0, info_lun1;
+    ESP_OK_ASSERT( msc_host_get_lun_count(device, &lun_count) );
+    TEST_ASSERT_EQUAL(CONCURRENT_TASKS, lun_count);
+    lun_devices[0] = device;
+    ESP_OK_ASSERT( msc_host_install_lun(device, 1, &lun_devices[1]) );
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, msc_host_install_lun(lun_devices[1], 1, &lun_device));
+    ESP_OK_ASSERT( msc_host_get_device_info(lun_devices[0], &info_lun0) );
+    ESP_OK_ASSERT( msc_host_get_device_info(lun_devices[1], &info_lun1) );
+    TEST_ASSERT_EQUAL(0, info_lun0.lun);
+    TEST_ASSERT_EQUAL(1, info_lun1.lun);
+    // The partition of LUN 1 is smaller
+    TEST_ASSERT(info_lun1.sector_count_64 < info_lun0.sector_count_64);
+
+    concurrent_done = xSemaphoreCreateCounting(CONCURRENT_TASKS, 0);
+    TEST_ASSERT_NOT_NULL(concurrent_done);
+    for (uint32_t lun = 0; lun < CONCURRENT_TASKS; lun++) {
+        lun_iterations[lun] = 0;
+        lun_other_iterations[lun] = 0;
+    }
+    for (uint32_t lun = 0; lun < CONCURRENT_TASKS; lun++) {
+        TEST_ASSERT(xTaskCreate(concurrent_luns_task, "msc_lun", 4096, (void *)lun, 3, NULL));
+    }
+    for (int i = 0; i < CONCURRENT_TASKS; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(concurrent_done, pdMS_TO_TICKS(10000)));
+    }
+    vSemaphoreDelete(concurrent_done);
+
+    // Commands are served in turns, the other LUN made progress while each task ran
+    for (uint32_t lun = 0; lun < CONCURRENT_TASKS; lun++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(CONCURRENT_ITERATIONS / 2, lun_other_iterations[lun]);
+    }
+
+    // Each LUN keeps its own data in the same sector
+    uint8_t expected_data[DISK_BLOCK_SIZE];
+    uint8_t read_data[DISK_BLOCK_SIZE];
+    for (uint32_t lun = 0; lun < CONCURRENT_TASKS; lun++) {
+        memset(expected_data, 0xA0 + lun, DISK_BLOCK_SIZE);
+        ESP_OK_ASSERT( scsi_cmd_read10(lun_devices[lun], read_data, LUN_SECTOR, 1, DISK_BLOCK_SIZE) );
+        TEST_ASSERT_EQUAL_MEMORY(expected_data, read_data, DISK_BLOCK_SIZE);
+    }
+
+    ESP_OK_ASSERT( msc_host_uninstall_device(lun_devices[1]) );
+    msc_teardown();
+}
+
+/**
+ * @brief Identification cache
+ *
+ * Procedure:
+ *     - Install USB Host lib, Install MSC driver with identification cache
+ *     - Install and uninstall the device, its identification is not cached yet
+ *     - Install the device again, its identification is taken from the cache
+ *     - Check that the device is identified in the same way and can be used
+ *     - Teardown
+ *
+ * The mock device must provide a serial number (serial_number device test mode), the cache is keyed by it
+ */
+TEST_CASE("identification_cache", "[usb_msc_serial]")
+{
+    msc_host_device_info_t info_first, info_cached;
+
+    msc_test_init();
+    const msc_host_driver_config_t msc_config = {
+        .create_backround_task = true,
+        .callback = msc_event_cb,
+        .stack_size = 4096,
+        .task_priority = 5,
+        .identify_cache_size = 2,
+    };
+    ESP_OK_ASSERT( msc_host_install(&msc_config) );
+    const uint8_t device_addr = wait_for_app_event(&new_dev_event, pdMS_TO_TICKS(5000));
+
+    ESP_OK_ASSERT( msc_host_install_device(device_addr, &device) );
+    ESP_OK_ASSERT( msc_host_get_device_info(device, &info_first) );
+    TEST_ASSERT_FALSE(((msc_device_t *)device)->ident_cached);
+    const uint32_t max_transfer_blocks = ((msc_device_t *)device)->max_transfer_blocks;
+    ESP_OK_ASSERT( msc_host_uninstall_device(device) );
+
+    ESP_OK_ASSERT( msc_host_install_device(device_addr, &device) );
+    ESP_OK_ASSERT( msc_host_get_device_info(device, &info_cached) );
+    TEST_ASSERT_TRUE(((msc_device_t *)device)->ident_cached);
+    TEST_ASSERT_EQUAL(info_first.sector_size, info_cached.sector_size);
+    TEST_ASSERT(info_first.sector_count_64 == info_cached.sector_count_64);
+    TEST_ASSERT_EQUAL(max_transfer_blocks, ((msc_device_t *)device)->max_transfer_blocks);
+
+    ESP_OK_ASSERT( msc_host_vfs_register(device, BASE_PATH, &mount_config, &vfs_handle) );
+    write_read_file(FILE_NAME);
+    msc_teardown();
+}
+
 /**
  * @brief USB MSC driver with no background task
  *
@@ -26,6 +26,8 @@ def test_usb_host_msc(dut: Tuple[IdfDut, IdfDut]) -> None:
         # Device test mode          Host test case group
         ("default",                 "usb_msc"),
         ("suspend_sudden_dconn",    "host_suspend_sudden_dconn"),
+        ("serial_number",           "usb_msc_serial"),
+        ("two_luns",                "usb_msc_luns"),
     ]
 
     for dev_test_mode, host_test_case_group in tests:
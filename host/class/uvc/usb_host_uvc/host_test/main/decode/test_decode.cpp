@@ -0,0 +1,227 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <catch2/catch_test_macros.hpp>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "usb/uvc_host.h"
+#include "usb/uvc_host_decode.h"
+#include "uvc_types_priv.h"
+#include "uvc_frame_priv.h"
+
+// Fake backend: copies the encoded frame to the output buffer.
+// If 'gate' is set, decoding blocks until the test gives it, 'started' is given when decoding starts.
+struct fake_decoder_t {
+    uvc_host_decoder_t base;
+    SemaphoreHandle_t gate;
+    SemaphoreHandle_t started;
+    bool fail;
+    bool deleted;
+};
+
+static esp_err_t fake_decode(uvc_host_decoder_t *decoder, const uvc_host_frame_t *in, uvc_host_decoded_frame_t *out)
+{
+    fake_decoder_t *fake = (fake_decoder_t *)decoder;
+    if (fake->started) {
+        xSemaphoreGive(fake->started);
+    }
+    if (fake->gate) {
+        xSemaphoreTake(fake->gate, portMAX_DELAY);
+    }
+    if (fake->fail || in->data_len > out->data_buffer_len) {
+        return ESP_FAIL;
+    }
+    memcpy(out->data, in->data, in->data_len);
+    out->data_len = in->data_len;
+    out->width = 16;
+    out->height = 8;
+    return ESP_OK;
+}
+
+static void fake_del(uvc_host_decoder_t *decoder)
+{
+    ((fake_decoder_t *)decoder)->deleted = true;
+}
+
+static bool submit_frame(uvc_stream_t *stream, uvc_host_decode_hdl_t decode, uint8_t value)
+{
+    uvc_host_frame_t *frame = uvc_frame_get_empty(stream);
+    REQUIRE(frame != nullptr);
+    const uint8_t data[4] = {value, value, value, value};
+    REQUIRE(uvc_frame_add_data(stream, frame, data, sizeof(data)) == ESP_OK);
+    return uvc_host_decode_submit(decode, frame);
+}
+
+static void wait_for_decoded(uvc_host_decode_hdl_t decode, uint32_t count)
+{
+    uvc_host_decode_stats_t stats = {};
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(uvc_host_decode_stats_get(decode, &stats) == ESP_OK);
+        if (stats.frames_decoded + stats.decode_errors >= count) {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    FAIL("Frames were not decoded in time");
+}
+
+SCENARIO("Decode pipeline", "[decode]")
+{
+    uvc_stream_t stream = {}; // Define mock stream
+    REQUIRE(uvc_frame_allocate(&stream, 4, 1024, 0, NULL) == ESP_OK);
+
+    fake_decoder_t fake = {};
+    fake.base.decode = fake_decode;
+    fake.base.del = fake_del;
+
+    uvc_host_decode_config_t config = {
+        .stream_hdl = (uvc_host_stream_hdl_t)&stream,
+        .decoder = &fake.base,
+        .input_queue_depth = 1,
+        .output_buffer_count = 2,
+        .output_buffer_size = 64,
+        .output_heap_caps = 0,
+        .task = {
+            .stack_size = 4096,
+            .priority = 5,
+            .xCoreID = 0,
+        },
+    };
+
+    GIVEN("Invalid configuration") {
+        config.output_buffer_count = 0;
+        uvc_host_decode_hdl_t decode = nullptr;
+        REQUIRE(uvc_host_decode_create(&config, &decode) == ESP_ERR_INVALID_ARG);
+        REQUIRE_FALSE(fake.deleted);
+    }
+
+    GIVEN("Pipeline is created") {
+        uvc_host_decode_hdl_t decode = nullptr;
+        uvc_host_decoded_frame_t *out = nullptr;
+        uvc_host_decode_stats_t stats = {};
+
+        WHEN("Frames are submitted one by one") {
+            REQUIRE(uvc_host_decode_create(&config, &decode) == ESP_OK);
+            for (uint8_t i = 0; i < 3; i++) {
+                REQUIRE_FALSE(submit_frame(&stream, decode, i));
+                REQUIRE(uvc_host_decode_get(decode, &out, pdMS_TO_TICKS(100)) == ESP_OK);
+                // The frame is decoded and the encoded frame is returned to the stream
+                REQUIRE(out->data_len == 4);
+                REQUIRE(out->data[0] == i);
+                REQUIRE(out->width == 16);
+                REQUIRE(out->height == 8);
+                REQUIRE(out->sequence == i);
+                REQUIRE(uvc_frame_are_all_returned(&stream));
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+            }
+            REQUIRE(uvc_host_decode_get(decode, &out, 0) == ESP_ERR_TIMEOUT);
+            REQUIRE(uvc_host_decode_stats_get(decode, &stats) == ESP_OK);
+            REQUIRE(stats.frames_submitted == 3);
+            REQUIRE(stats.frames_decoded == 3);
+            REQUIRE(stats.input_dropped == 0);
+            REQUIRE(stats.output_dropped == 0);
+        }
+
+        WHEN("The decoder is slower than the camera") {
+            fake.gate = xSemaphoreCreateCounting(10, 0);
+            fake.started = xSemaphoreCreateCounting(10, 0);
+            REQUIRE(uvc_host_decode_create(&config, &decode) == ESP_OK);
+
+            // Frame 0 is being decoded, frame 1 waits in the input queue and is replaced by frame 2
+            REQUIRE_FALSE(submit_frame(&stream, decode, 0));
+            REQUIRE(xSemaphoreTake(fake.started, pdMS_TO_TICKS(100)) == pdTRUE);
+            REQUIRE_FALSE(submit_frame(&stream, decode, 1));
+            REQUIRE_FALSE(submit_frame(&stream, decode, 2));
+            xSemaphoreGive(fake.gate);
+            xSemaphoreGive(fake.gate);
+            wait_for_decoded(decode, 2);
+
+            THEN("The oldest waiting frame is dropped") {
+                REQUIRE(uvc_host_decode_stats_get(decode, &stats) == ESP_OK);
+                REQUIRE(stats.frames_submitted == 3);
+                REQUIRE(stats.frames_decoded == 2);
+                REQUIRE(stats.input_dropped == 1);
+                REQUIRE(uvc_frame_are_all_returned(&stream));
+
+                REQUIRE(uvc_host_decode_get(decode, &out, pdMS_TO_TICKS(100)) == ESP_OK);
+                REQUIRE(out->sequence == 0);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+                REQUIRE(uvc_host_decode_get(decode, &out, pdMS_TO_TICKS(100)) == ESP_OK);
+                REQUIRE(out->sequence == 2);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+            }
+        }
+
+        WHEN("The consumer is slower than the decoder") {
+            REQUIRE(uvc_host_decode_create(&config, &decode) == ESP_OK);
+            for (uint8_t i = 0; i < 3; i++) {
+                REQUIRE_FALSE(submit_frame(&stream, decode, i));
+                wait_for_decoded(decode, i + 1);
+            }
+
+            THEN("The oldest decoded frame is overwritten") {
+                REQUIRE(uvc_host_decode_stats_get(decode, &stats) == ESP_OK);
+                REQUIRE(stats.frames_decoded == 3);
+                REQUIRE(stats.output_dropped == 1);
+
+                REQUIRE(uvc_host_decode_get(decode, &out, pdMS_TO_TICKS(100)) == ESP_OK);
+                REQUIRE(out->sequence == 1);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+                REQUIRE(uvc_host_decode_get(decode, &out, pdMS_TO_TICKS(100)) == ESP_OK);
+                REQUIRE(out->sequence == 2);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+            }
+        }
+
+        WHEN("The backend fails to decode a frame") {
+            fake.fail = true;
+            REQUIRE(uvc_host_decode_create(&config, &decode) == ESP_OK);
+            REQUIRE_FALSE(submit_frame(&stream, decode, 0));
+            wait_for_decoded(decode, 1);
+
+            THEN("The frame is dropped and counted as an error") {
+                REQUIRE(uvc_host_decode_get(decode, &out, 0) == ESP_ERR_TIMEOUT);
+                REQUIRE(uvc_host_decode_stats_get(decode, &stats) == ESP_OK);
+                REQUIRE(stats.decode_errors == 1);
+                REQUIRE(stats.frames_decoded == 0);
+                REQUIRE(uvc_frame_are_all_returned(&stream));
+            }
+        }
+
+        WHEN("The consumer holds a decoded frame") {
+            REQUIRE(uvc_host_decode_create(&config, &decode) == ESP_OK);
+            REQUIRE_FALSE(submit_frame(&stream, decode, 0));
+            REQUIRE(uvc_host_decode_get(decode, &out, pdMS_TO_TICKS(100)) == ESP_OK);
+
+            THEN("The pipeline cannot be deleted until the frame is returned") {
+                REQUIRE(uvc_host_decode_delete(decode) == ESP_ERR_INVALID_STATE);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+            }
+
+            THEN("Only the held frame of this pipeline can be returned, once") {
+                uvc_host_decoded_frame_t foreign = {};
+                REQUIRE(uvc_host_decode_return(decode, &foreign) == ESP_ERR_INVALID_ARG);
+                REQUIRE(uvc_host_decode_return(decode, (uvc_host_decoded_frame_t *)((uint8_t *)out + 1)) == ESP_ERR_INVALID_ARG);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_OK);
+                REQUIRE(uvc_host_decode_return(decode, out) == ESP_ERR_INVALID_STATE);
+            }
+        }
+
+        // Teardown
+        REQUIRE(uvc_host_decode_delete(decode) == ESP_OK);
+        REQUIRE(fake.deleted);
+        REQUIRE(uvc_frame_are_all_returned(&stream));
+        if (fake.gate) {
+            vSemaphoreDelete(fake.gate);
+            vSemaphoreDelete(fake.started);
+        }
+    }
+
+    uvc_frame_free(&stream);
+}
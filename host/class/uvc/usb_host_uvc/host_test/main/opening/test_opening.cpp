@@ -136,6 +136,8 @@ SCENARIO("Test mocked device opening and closing", "[opening]")
         THEN("Multiple streams can be opened") {
             uvc_host_stream_hdl_t stream[10];
 
+            // Largest alternate settings of C270 and ELP do not fit together in the periodic bandwidth budget
+            test_uvc_set_negotiated_payload(1024);
             // All these cameras support 1280x720@15 MJPEG format
             stream_config.usb.dev_addr = 1; // Same as = 0
             REQUIRE(ESP_OK == test_uvc_host_stream_open(&stream_config, 0, &stream[0], true));
@@ -147,6 +149,7 @@ SCENARIO("Test mocked device opening and closing", "[opening]")
             REQUIRE(ESP_OK == test_uvc_host_stream_close(stream[0]));
             REQUIRE(ESP_OK == test_uvc_host_stream_close(stream[1]));
             REQUIRE(ESP_OK == test_uvc_host_stream_close(stream[2]));
+            test_uvc_set_negotiated_payload(0);
         }
 
         THEN("Multiple streams from the same device can be opened") {
@@ -187,6 +190,7 @@ SCENARIO("Test mocked device opening and closing", "[opening]")
             uvc_host_stream_hdl_t stream2 = nullptr;
             stream_config.usb.vid = 0x046D;
             stream_config.usb.pid = 0x0825;
+            test_uvc_set_negotiated_payload(1024); // Both streams must fit in the periodic bandwidth budget
             REQUIRE(ESP_OK == test_uvc_host_stream_open(&stream_config, 0, &stream, true));
 
             // Second call to claim the same interface will fail in usb_host_lib
@@ -194,6 +198,7 @@ SCENARIO("Test mocked device opening and closing", "[opening]")
             REQUIRE_FALSE(ESP_OK == uvc_host_stream_open(&stream_config, 0, &stream2));
 
             REQUIRE(ESP_OK == test_uvc_host_stream_close(stream));
+            test_uvc_set_negotiated_payload(0);
         }
 
         REQUIRE(ESP_OK == test_uvc_host_uninstall());
@@ -371,3 +376,83 @@ SCENARIO("Test mocked device URB allocation", "[opening]")
         REQUIRE(ESP_OK == test_uvc_host_uninstall());
     }
 }
+
+SCENARIO("Test mocked device alternate setting selection", "[opening]")
+{
+    // We will put device adding to the SECTION, to run it just once, not repeatedly for all the following SECTIONs
+    // (if multiple sections are present)
+    SECTION("Add mocked devices") {
+        _add_mocked_devices();
+    }
+
+    SECTION("Install the UVC driver") {
+        const uvc_host_driver_config_t uvc_driver_config = {
+            .driver_task_stack_size = 4 * 1024,
+            .driver_task_priority = 10,
+            .xCoreID = tskNO_AFFINITY,
+            .create_background_task = true,
+            .event_cb = nullptr,
+            .user_ctx = nullptr,
+        };
+        REQUIRE(ESP_OK == test_uvc_host_install(&uvc_driver_config));
+
+        uvc_host_stream_config_t stream_config = {
+            .event_cb = nullptr,
+            .frame_cb = nullptr,
+            .user_ctx = nullptr,
+            .usb = {
+                .dev_addr = 1, // Logitech C270
+                .vid = UVC_HOST_ANY_VID,
+                .pid = UVC_HOST_ANY_PID,
+                .uvc_stream_index = 0,
+            },
+            .vs_format = {
+                .h_res = 1280,
+                .v_res = 720,
+                .fps = 15,
+                .format = UVC_VS_FORMAT_MJPEG,
+            },
+            .advanced = {
+                .number_of_frame_buffers = 3,
+                .frame_size = 0,
+                .frame_heap_caps = 0,
+                .number_of_urbs = NUMBER_OF_URBS,
+                .urb_size = 0,
+                .user_frame_buffers = NULL,
+            },
+        };
+
+        THEN("Smallest alternate setting that covers the payload is selected") {
+            uvc_host_stream_hdl_t stream = nullptr;
+            test_uvc_set_negotiated_payload(1000);
+            REQUIRE(ESP_OK == test_uvc_host_stream_open(&stream_config, 0, &stream, true));
+            // Alternate interface 7 offers MPS = 1280
+            REQUIRE(stream->constant.bAlternateSetting == 7);
+            REQUIRE(stream->constant.xfers[0]->data_buffer_size == 4 * 1280);
+            REQUIRE(ESP_OK == test_uvc_host_stream_close(stream));
+            test_uvc_set_negotiated_payload(0);
+        }
+
+        THEN("Stream that does not fit in the periodic bandwidth budget is rejected") {
+            uvc_host_stream_hdl_t stream[2] = {nullptr, nullptr};
+            // Payload size is unknown: C270 reserves 3 x 1020 bytes per microframe
+            REQUIRE(ESP_OK == test_uvc_host_stream_open(&stream_config, 0, &stream[0], true));
+
+            // ELP H265 needs 3 x 1024 bytes per microframe; both together exceed 80 % of the bus
+            stream_config.usb.dev_addr = 3;
+            usb_host_transfer_submit_control_ExpectAnyArgsAndReturn(ESP_OK); // Set interface 0
+            usb_host_transfer_submit_control_ExpectAnyArgsAndReturn(ESP_OK); // Get current
+            usb_host_transfer_submit_control_ExpectAnyArgsAndReturn(ESP_OK); // Set current
+            usb_host_transfer_submit_control_ExpectAnyArgsAndReturn(ESP_OK); // Get current
+            REQUIRE(ESP_ERR_INVALID_SIZE == uvc_host_stream_open(&stream_config, 0, &stream[1]));
+            REQUIRE(stream[1] == nullptr);
+
+            // The bandwidth is returned on close
+            REQUIRE(ESP_OK == test_uvc_host_stream_close(stream[0]));
+            REQUIRE(ESP_OK == test_uvc_host_stream_open(&stream_config, 0, &stream[1], true));
+            REQUIRE(ESP_OK == test_uvc_host_stream_close(stream[1]));
+        }
+
+        REQUIRE(ESP_OK == test_uvc_host_uninstall());
+    }
+}
@@ -167,3 +167,17 @@
         REQUIRE(intf_desc->bAlternateSetting == (expected_alt_setting));                                                   \
         REQUIRE(USB_EP_DESC_GET_MPS(ep_desc) * (USB_EP_DESC_GET_MULT(ep_desc) + 1) == (expected_effective_mps));           \
     } while (0)
+
+/**
+ * @brief Helper that requires streaming interface and EP for negotiated payload size and checks alternate setting and effective MPS.
+ */
+#define REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, intf_num, payload, max_mps, expected_alt_setting, expected_effective_mps) \
+    do {                                                                                                                   \
+        const usb_intf_desc_t *intf_desc = nullptr;                                                                        \
+        const usb_ep_desc_t *ep_desc = nullptr;                                                                            \
+        REQUIRE(ESP_OK == uvc_desc_get_streaming_intf_and_ep_for_payload(cfg, intf_num, payload, max_mps, &intf_desc, &ep_desc)); \
+        REQUIRE(intf_desc != nullptr);                                                                                     \
+        REQUIRE(ep_desc != nullptr);                                                                                       \
+        REQUIRE(intf_desc->bAlternateSetting == (expected_alt_setting));                                                   \
+        REQUIRE(USB_EP_DESC_GET_MPS(ep_desc) * (USB_EP_DESC_GET_MULT(ep_desc) + 1) == (expected_effective_mps));           \
+    } while (0)
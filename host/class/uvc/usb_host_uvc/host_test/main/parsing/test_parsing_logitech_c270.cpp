@@ -145,4 +145,44 @@ SCENARIO("Camera descriptor parsing: Logitech C270", "[logitech][c270]")
         // 2. Requested MPS is too small, we should get not found error.
         REQUIRE(ESP_ERR_NOT_FOUND == uvc_desc_get_streaming_intf_and_ep(cfg, 1, 128, &intf_desc, &ep_desc));
     }
+
+    GIVEN("Payload size is negotiated") {
+        // This test checks if the smallest alternate interface that covers the negotiated payload is selected
+        const usb_intf_desc_t *intf_desc = nullptr;
+        const usb_ep_desc_t *ep_desc = nullptr;
+
+        // Exact match
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 192, MAX_MPS_IN, 1, 192);
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 944, MAX_MPS_IN, 6, 944);
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 3060, 4096, 11, 3060);
+        // Payload between two alternate settings: the larger one is needed
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 100, MAX_MPS_IN, 1, 192);
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 400, MAX_MPS_IN, 3, 512);
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 1000, 4096, 7, 1280);
+
+        // Payload is not covered by any alternate setting: the largest one that fits in the FIFO is used
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 5000, 4096, 11, 3060);
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 1000, 596, 3, 512);
+
+        // Payload is unknown: the largest alternate setting is used
+        REQUIRE_STREAMING_INTF_AND_EP_FOR_PAYLOAD(cfg, 1, 0, 4096, 11, 3060);
+
+        // No alternate setting fits in the FIFO
+        REQUIRE(ESP_ERR_NOT_FOUND == uvc_desc_get_streaming_intf_and_ep_for_payload(cfg, 1, 100, 128, &intf_desc, &ep_desc));
+    }
+
+    GIVEN("Periodic bus time is calculated") {
+        const usb_intf_desc_t *intf_desc = nullptr;
+        const usb_ep_desc_t *ep_desc = nullptr;
+
+        // Alternate interface 1: 192 bytes in every microframe = 1536 bytes per 1 ms frame
+        REQUIRE(ESP_OK == uvc_desc_get_streaming_intf_and_ep(cfg, 1, 192, &intf_desc, &ep_desc));
+        REQUIRE(uvc_desc_get_periodic_bus_time_ns(ep_desc, true) == 25600);
+
+        // Alternate interface 11: 3 x 1020 bytes in every microframe, 40.8% of the bus
+        // Two such streams do not fit in the default 80% budget
+        REQUIRE(ESP_OK == uvc_desc_get_streaming_intf_and_ep(cfg, 1, 3060, &intf_desc, &ep_desc));
+        REQUIRE(uvc_desc_get_periodic_bus_time_ns(ep_desc, true) == 408000);
+        REQUIRE(2 * uvc_desc_get_periodic_bus_time_ns(ep_desc, true) > 80 * 10000);
+    }
 }
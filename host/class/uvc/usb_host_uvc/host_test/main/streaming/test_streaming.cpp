@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <functional>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 
 #include "usb/usb_types_stack.h"
@@ -139,6 +140,155 @@ void run_streaming_frame_reconstruction_scenario(void)
             uvc_frame_free(&stream);
         }
 
+        AND_GIVEN("Chunk callback is registered") {
+            struct chunk_ctx {
+                std::vector<uvc_host_frame_chunk_t> chunks;
+                std::vector<uint8_t> data;
+                int frames;
+            } ctx = {};
+            stream.constant.cb_arg = (void *)&ctx;
+            stream.constant.frame_cb = [](const uvc_host_frame_t *frame, void *user_ctx) -> bool {
+                static_cast<chunk_ctx *>(user_ctx)->frames++;
+                return true;
+            };
+            stream.constant.chunk_cb = [](const uvc_host_frame_chunk_t *chunk, void *user_ctx) {
+                chunk_ctx *ctx = static_cast<chunk_ctx *>(user_ctx);
+                REQUIRE(chunk->offset == ctx->data.size());
+                ctx->data.insert(ctx->data.end(), chunk->data, chunk->data + chunk->data_len);
+                ctx->chunks.push_back(*chunk);
+            };
+            REQUIRE(uvc_frame_allocate(&stream, 1, 100 * 1024, 0, NULL) == ESP_OK);
+            uvc_frame_format_update(&stream, &logo_jpg_format);
+
+            WHEN("The frame data contain no errors") {
+                send_function_wrapper(1024, &stream, std::span(logo_jpg));
+
+                THEN("The frame is delivered in several contiguous chunks before the frame callback") {
+                    REQUIRE(ctx.frames == 1);
+                    REQUIRE(ctx.chunks.size() > 1);
+                    REQUIRE(ctx.chunks.front().flags == UVC_HOST_CHUNK_FLAG_SOF);
+                    REQUIRE(ctx.chunks.back().flags & UVC_HOST_CHUNK_FLAG_EOF);
+                    for (const auto &chunk : ctx.chunks) {
+                        REQUIRE(chunk.frame_id == ctx.chunks.front().frame_id);
+                        REQUIRE_FALSE(chunk.flags & UVC_HOST_CHUNK_FLAG_ERROR);
+                    }
+                    REQUIRE(ctx.data == std::vector<uint8_t>(logo_jpg.begin(), logo_jpg.end()));
+                }
+
+                AND_WHEN("Next frame is send") {
+                    const uint32_t first_frame_id = ctx.chunks.front().frame_id;
+                    ctx.chunks.clear();
+                    ctx.data.clear();
+                    send_function_wrapper(1024, &stream, std::span(logo_jpg), 1);
+
+                    THEN("Chunks of the next frame carry a new frame ID") {
+                        REQUIRE(ctx.frames == 2);
+                        REQUIRE(ctx.chunks.front().offset == 0);
+                        REQUIRE(ctx.chunks.front().frame_id != first_frame_id);
+                        REQUIRE(ctx.data.size() == logo_jpg.size());
+                    }
+                }
+            }
+
+            WHEN("The frame contains error in EoF") {
+                send_function_wrapper(1024, &stream, std::span(logo_jpg), 0, false, true);
+
+                THEN("The partially delivered frame is aborted") {
+                    REQUIRE(ctx.frames == 0);
+                    REQUIRE(ctx.chunks.size() > 1);
+                    REQUIRE(ctx.chunks.back().data_len == 0);
+                    REQUIRE(ctx.chunks.back().flags == (UVC_HOST_CHUNK_FLAG_EOF | UVC_HOST_CHUNK_FLAG_ERROR));
+                }
+            }
+
+            WHEN("The frame contains error in SoF") {
+                send_function_wrapper(1024, &stream, std::span(logo_jpg), 0, true);
+
+                THEN("No chunk is delivered") {
+                    REQUIRE(ctx.frames == 0);
+                    REQUIRE(ctx.chunks.empty());
+                }
+            }
+            REQUIRE(uvc_frame_are_all_returned(&stream));
+            uvc_frame_free(&stream);
+        }
+
+        AND_GIVEN("Frame buffers grow from a shared pool") {
+            int frame_callback_called = 0;
+            stream.constant.cb_arg = (void *)&frame_callback_called;
+            stream.constant.frame_cb = [](const uvc_host_frame_t *frame, void *user_ctx) -> bool {
+                (*static_cast<int *>(user_ctx))++;
+                REQUIRE(frame->data_buffer_len < 100 * 1024);
+                std::vector<uint8_t> frame_data(frame->data, frame->data + frame->data_len);
+                REQUIRE(frame_data == std::vector<uint8_t>(logo_jpg.begin(), logo_jpg.end()));
+                return true;
+            };
+
+            const uvc_host_frame_pool_config_t pool_config = {
+                .pool_size = 2 * 8192,
+                .initial_frame_size = 2048,
+                .grow_step = 1024,
+                .heap_caps = 0,
+            };
+            uvc_host_frame_pool_hdl_t pool = nullptr;
+            REQUIRE(uvc_host_frame_pool_create(&pool_config, &pool) == ESP_OK);
+            stream.constant.frame_pool = pool;
+            REQUIRE(uvc_frame_allocate(&stream, 2, 100 * 1024, 0, NULL) == ESP_OK);
+            uvc_frame_format_update(&stream, &logo_jpg_format);
+
+            size_t used, peak;
+            REQUIRE(uvc_host_frame_pool_usage_get(pool, &used, &peak) == ESP_OK);
+            REQUIRE(used == 0);
+
+            WHEN("Two frames are received") {
+                send_function_wrapper(1024, &stream, std::span(logo_jpg));
+                send_function_wrapper(1024, &stream, std::span(logo_jpg), 1);
+
+                THEN("Frame buffers take only as much memory from the pool as needed") {
+                    REQUIRE(frame_callback_called == 2);
+                    REQUIRE(uvc_host_frame_pool_usage_get(pool, &used, &peak) == ESP_OK);
+                    REQUIRE(used == peak);
+                    REQUIRE(used <= 2 * (logo_jpg.size() + pool_config.grow_step));
+                    REQUIRE(uvc_host_frame_pool_delete(pool) == ESP_ERR_INVALID_STATE);
+                }
+            }
+
+            REQUIRE(uvc_frame_are_all_returned(&stream));
+            uvc_frame_free(&stream);
+            REQUIRE(uvc_host_frame_pool_usage_get(pool, &used, nullptr) == ESP_OK);
+            REQUIRE(used == 0);
+            REQUIRE(uvc_host_frame_pool_delete(pool) == ESP_OK);
+        }
+
+        AND_GIVEN("Frame buffer pool is too small") {
+            enum uvc_host_dev_event event_type = static_cast<enum uvc_host_dev_event>(-1); // Explicitly set to invalid value
+            stream.constant.cb_arg = (void *)&event_type;
+            stream.constant.stream_cb = [](const uvc_host_stream_event_data_t *event, void *user_ctx) {
+                *static_cast<enum uvc_host_dev_event *>(user_ctx) = event->type;
+            };
+            const uvc_host_frame_pool_config_t pool_config = {
+                .pool_size = logo_jpg.size() / 2,
+                .initial_frame_size = 0,
+                .grow_step = 1024,
+                .heap_caps = 0,
+            };
+            uvc_host_frame_pool_hdl_t pool = nullptr;
+            REQUIRE(uvc_host_frame_pool_create(&pool_config, &pool) == ESP_OK);
+            stream.constant.frame_pool = pool;
+            REQUIRE(uvc_frame_allocate(&stream, 1, 100 * 1024, 0, NULL) == ESP_OK);
+
+            WHEN("The frame does not fit in the pool") {
+                send_function_wrapper(1024, &stream, std::span(logo_jpg));
+                THEN("Buffer overflow event is generated") {
+                    REQUIRE(event_type == UVC_HOST_FRAME_BUFFER_OVERFLOW);
+                }
+            }
+
+            REQUIRE(uvc_frame_are_all_returned(&stream));
+            uvc_frame_free(&stream);
+            REQUIRE(uvc_host_frame_pool_delete(pool) == ESP_OK);
+        }
+
         AND_GIVEN("Frame buffer is too small") {
             // We expect overflow stream event
             enum uvc_host_dev_event event_type = static_cast<enum uvc_host_dev_event>(-1); // Explicitly set to invalid value
@@ -264,3 +414,84 @@ SCENARIO("Isochronous stream frame reconstruction", "[streaming][isoc]")
     - Unaligned USB transfer sizes
     */
 }
+
+SCENARIO("Payload timing and stream statistics", "[streaming][stats]")
+{
+    uvc_stream_t stream = {}; // Define mock stream
+
+    GIVEN("Payload header with PTS and SCR") {
+        const uint8_t header[HEADER_LEN] = {
+            HEADER_LEN, 0x8C,                   // EOH | SCR | PTS
+            0x44, 0x33, 0x22, 0x11,             // PTS
+            0xDD, 0xCC, 0xBB, 0xAA, 0x23, 0xF1, // SCR: STC, SOF counter with reserved bits set
+        };
+        const uvc_payload_header_t *hdr = reinterpret_cast<const uvc_payload_header_t *>(header);
+        REQUIRE(uvc_frame_payload_header_validate(hdr, sizeof(header)));
+
+        uvc_frame_payload_time_update(&stream, hdr, 1000, true);
+        THEN("Device and host timestamps are saved for the first and last payload") {
+            const uvc_host_payload_time_t &first = stream.single_thread.first_payload;
+            REQUIRE(first.has_pts);
+            REQUIRE(first.has_scr);
+            REQUIRE(first.pts == 0x11223344);
+            REQUIRE(first.scr_stc == 0xAABBCCDD);
+            REQUIRE(first.scr_sof == 0x123);
+            REQUIRE(first.host_time_us == 1000);
+            REQUIRE(stream.single_thread.last_payload.pts == first.pts);
+        }
+
+        AND_WHEN("Next payload contains only SCR") {
+            const uint8_t header_scr[8] = {8, 0x88, 0x04, 0x03, 0x02, 0x01, 0x05, 0x00};
+            uvc_frame_payload_time_update(&stream, reinterpret_cast<const uvc_payload_header_t *>(header_scr), 2000, false);
+            THEN("Only the last payload timing is updated") {
+                REQUIRE(stream.single_thread.first_payload.host_time_us == 1000);
+                REQUIRE_FALSE(stream.single_thread.last_payload.has_pts);
+                REQUIRE(stream.single_thread.last_payload.scr_stc == 0x01020304);
+                REQUIRE(stream.single_thread.last_payload.scr_sof == 5);
+                REQUIRE(stream.single_thread.last_payload.host_time_us == 2000);
+            }
+        }
+    }
+
+    GIVEN("Streaming enabled and frame allocated") {
+        stream.constant.frame_cb = [](const uvc_host_frame_t *frame, void *user_ctx) -> bool {
+            REQUIRE(frame->first_payload.host_time_us != 0);
+            REQUIRE(frame->last_payload.host_time_us >= frame->first_payload.host_time_us);
+            return true;
+        };
+        REQUIRE(uvc_host_stream_unpause(&stream) == ESP_OK);
+        REQUIRE(uvc_frame_allocate(&stream, 1, 100 * 1024, 0, NULL) == ESP_OK);
+        uvc_frame_format_update(&stream, &logo_jpg_format);
+
+        WHEN("Three frames and one corrupted frame are received") {
+            test_streaming_bulk_send_frame(1024, &stream, std::span(logo_jpg), 0);
+            test_streaming_bulk_send_frame(1024, &stream, std::span(logo_jpg), 1);
+            test_streaming_bulk_send_frame(1024, &stream, std::span(logo_jpg), 0);
+            test_streaming_bulk_send_frame(1024, &stream, std::span(logo_jpg), 1, false, true);
+
+            THEN("Statistics count delivered and dropped frames") {
+                uvc_host_stream_stats_t stats;
+                REQUIRE(uvc_host_stream_stats_get(&stream, &stats) == ESP_OK);
+                REQUIRE(stats.frames_delivered == 3);
+                REQUIRE(stats.frames_dropped == 1);
+                REQUIRE(stats.underflow_count == 0);
+                REQUIRE(stats.overflow_count == 0);
+                REQUIRE(stats.frame_interval_max_us >= stats.frame_interval_avg_us);
+                REQUIRE(stats.assembly_time_max_us >= stats.assembly_time_avg_us);
+            }
+
+            AND_WHEN("Statistics are reset") {
+                REQUIRE(uvc_host_stream_stats_reset(&stream) == ESP_OK);
+                THEN("All counters are zero") {
+                    uvc_host_stream_stats_t stats;
+                    REQUIRE(uvc_host_stream_stats_get(&stream, &stats) == ESP_OK);
+                    REQUIRE(stats.frames_delivered == 0);
+                    REQUIRE(stats.frames_dropped == 0);
+                    REQUIRE(stats.frame_interval_avg_us == 0);
+                }
+            }
+        }
+        REQUIRE(uvc_frame_are_all_returned(&stream));
+        uvc_frame_free(&stream);
+    }
+}
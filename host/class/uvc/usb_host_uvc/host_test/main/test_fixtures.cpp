@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2025-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -9,11 +9,32 @@
 #include <catch2/catch_test_macros.hpp>
 #include "mock_add_usb_device.h"
 #include "test_fixtures.hpp"
+#include "usb_types_uvc.h"
 
 extern "C" {
 #include "Mockusb_host.h"
 }
 
+static uint32_t negotiated_payload = 0;
+
+void test_uvc_set_negotiated_payload(uint32_t payload)
+{
+    negotiated_payload = payload;
+}
+
+/**
+ * @brief Successful CTRL transfer that also answers VS_PROBE_CONTROL GET_CUR with the configured payload size
+ */
+static esp_err_t usb_host_transfer_submit_control_probe_mock_callback(usb_host_client_handle_t client_hdl, usb_transfer_t *transfer, int call_count)
+{
+    const usb_setup_packet_t *setup = (const usb_setup_packet_t *)transfer->data_buffer;
+    if (negotiated_payload != 0 && setup->bRequest == UVC_GET_CUR && (setup->wValue >> 8) == UVC_VS_PROBE_CONTROL) {
+        uvc_vs_ctrl_t *vs_ctrl = (uvc_vs_ctrl_t *)(transfer->data_buffer + sizeof(usb_setup_packet_t));
+        vs_ctrl->dwMaxPayloadTransferSize = negotiated_payload;
+    }
+    return usb_host_transfer_submit_control_success_mock_callback(client_hdl, transfer, call_count);
+}
+
 esp_err_t test_uvc_host_install(const uvc_host_driver_config_t *driver_config)
 {
     // Allocation of CTRL transfer (common for all devices)
@@ -64,7 +85,7 @@ esp_err_t test_uvc_host_stream_open(const uvc_host_stream_config_t *stream_confi
 
     /* **Testing starts here** */
 
-    usb_host_transfer_submit_control_AddCallback(usb_host_transfer_submit_control_success_mock_callback);
+    usb_host_transfer_submit_control_AddCallback(usb_host_transfer_submit_control_probe_mock_callback);
     usb_host_interface_claim_ExpectAnyArgsAndReturn(ESP_OK);         // Claim interface
     if (is_isoc) {                                                   // Set interface only for ISOC cameras)
         usb_host_transfer_submit_control_ExpectAnyArgsAndReturn(ESP_OK);
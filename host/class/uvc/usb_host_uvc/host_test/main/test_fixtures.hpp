@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2025-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -13,3 +13,10 @@ esp_err_t test_uvc_host_install(const uvc_host_driver_config_t *driver_config);
 esp_err_t test_uvc_host_uninstall(void);
 esp_err_t test_uvc_host_stream_open(const uvc_host_stream_config_t *stream_config, int timeout, uvc_host_stream_hdl_t *stream_hdl_ret, bool is_isoc);
 esp_err_t test_uvc_host_stream_close(uvc_host_stream_hdl_t stream_hdl);
+
+/**
+ * @brief Set dwMaxPayloadTransferSize returned by mocked VS_PROBE_CONTROL GET_CUR requests
+ *
+ * @param[in] payload Payload size. 0 returns the data set by the driver (payload size unknown)
+ */
+void test_uvc_set_negotiated_payload(uint32_t payload);
@@ -28,6 +28,7 @@ extern "C" {
 #endif
 
 typedef struct uvc_host_stream_s *uvc_host_stream_hdl_t; /*!< UVC stream handle. */
+typedef struct uvc_host_frame_pool_s *uvc_host_frame_pool_hdl_t; /*!< Shared frame buffer pool handle. */
 
 /**
  * @brief UVC host driver event types.
@@ -150,6 +151,21 @@ typedef struct {
     enum uvc_host_stream_format format; /*!< Frame coding format. */
 } uvc_host_stream_format_t;
 
+/**
+ * @brief Timing information of one UVC payload.
+ *
+ * Device clock values are copied from the UVC payload header. Their frequency is given by
+ * dwClockFrequency of the Video Control interface.
+ */
+typedef struct {
+    uint32_t pts;                             /*!< Presentation time stamp in device clock units. Valid if has_pts is set. */
+    uint32_t scr_stc;                         /*!< Source time clock of the SCR in device clock units. Valid if has_scr is set. */
+    uint16_t scr_sof;                         /*!< 11-bit USB SOF counter of the SCR. Valid if has_scr is set. */
+    bool has_pts;                             /*!< Payload header contained PTS. */
+    bool has_scr;                             /*!< Payload header contained SCR. */
+    int64_t host_time_us;                     /*!< Completion time of the USB transfer that carried this payload, from esp_timer_get_time(). */
+} uvc_host_payload_time_t;
+
 /**
  * @brief Video stream frame.
  *
@@ -160,8 +176,28 @@ typedef struct {
     size_t data_buffer_len;                   /*!< Maximum data length supported by this frame buffer. */
     size_t data_len;                          /*!< Data length of the currently stored frame. */
     uint8_t *data;                            /*!< Frame data. */
+    uvc_host_payload_time_t first_payload;    /*!< Timing of the first payload of this frame. */
+    uvc_host_payload_time_t last_payload;     /*!< Timing of the last payload of this frame. */
 } uvc_host_frame_t;
 
+/**
+ * @brief Stream statistics.
+ *
+ * Frame interval is measured between host arrival times of the first payloads of consecutive delivered frames.
+ * Intervals spanning a dropped frame are not counted.
+ */
+typedef struct {
+    uint32_t frames_delivered;                /*!< Complete frames passed to the frame callback. */
+    uint32_t frames_dropped;                  /*!< Frames discarded because of payload errors, missing frame buffer or overflow. */
+    uint32_t underflow_count;                 /*!< Number of UVC_HOST_FRAME_BUFFER_UNDERFLOW events. */
+    uint32_t overflow_count;                  /*!< Number of UVC_HOST_FRAME_BUFFER_OVERFLOW events. */
+    uint32_t frame_interval_avg_us;           /*!< Average frame interval. */
+    uint32_t frame_interval_max_us;           /*!< Maximum frame interval. */
+    uint32_t frame_interval_jitter_us;        /*!< Smoothed frame interval jitter, computed as interarrival jitter in RFC 3550. */
+    uint32_t assembly_time_avg_us;            /*!< Average time between the first and the last payload of a frame. */
+    uint32_t assembly_time_max_us;            /*!< Maximum time between the first and the last payload of a frame. */
+} uvc_host_stream_stats_t;
+
 /**
  * @brief Stream event callback type.
  *
@@ -181,12 +217,51 @@ typedef void (*uvc_host_stream_callback_t)(const uvc_host_stream_event_data_t *e
  */
 typedef bool (*uvc_host_frame_callback_t)(const uvc_host_frame_t *frame, void *user_ctx);
 
+#define UVC_HOST_CHUNK_FLAG_SOF   (1 << 0) /*!< First chunk of a frame. Offset is 0. */
+#define UVC_HOST_CHUNK_FLAG_EOF   (1 << 1) /*!< Last chunk of a frame. The frame is complete. */
+#define UVC_HOST_CHUNK_FLAG_ERROR (1 << 2) /*!< Frame was aborted. Always set together with EOF; data of this frame must be discarded. */
+
+/**
+ * @brief Part of a frame that is still being received.
+ *
+ * Chunks of one frame are delivered in order and without gaps: offset of each chunk equals
+ * the sum of data_len of all previous chunks with the same frame_id.
+ */
+typedef struct {
+    const uint8_t *data;                  /*!< Chunk data. Valid only during the chunk callback. */
+    size_t data_len;                      /*!< Chunk length in bytes. Can be 0 for the last chunk. */
+    size_t offset;                        /*!< Offset of this chunk from the start of the frame. */
+    uint32_t frame_id;                    /*!< Frame sequence number. Incremented on every start of frame. */
+    uint8_t flags;                        /*!< Combination of UVC_HOST_CHUNK_FLAG_* */
+} uvc_host_frame_chunk_t;
+
+/**
+ * @brief Frame chunk callback type.
+ *
+ * Called from the same context as the frame callback, after each USB transfer that carried data of the current frame.
+ *
+ * @param[in] chunk Received chunk.
+ * @param[in] user_ctx User argument from uvc_host_stream_config_t.
+ */
+typedef void (*uvc_host_frame_chunk_callback_t)(const uvc_host_frame_chunk_t *chunk, void *user_ctx);
+
+/**
+ * @brief Shared frame buffer pool configuration.
+ */
+typedef struct {
+    size_t pool_size;                     /*!< Maximum memory in bytes for frame data of all streams using this pool. */
+    size_t initial_frame_size;            /*!< Memory allocated to a frame buffer when it receives its first data. Set to 0 to use grow_step. */
+    size_t grow_step;                     /*!< Frame buffers grow in multiples of this size. Set to 0 for the default of 16 kB. */
+    uint32_t heap_caps;                   /*!< Memory capabilities passed to heap_caps_realloc(), e.g. MALLOC_CAP_SPIRAM. */
+} uvc_host_frame_pool_config_t;
+
 /**
  * @brief UVC stream configuration structure.
  */
 typedef struct {
     uvc_host_stream_callback_t event_cb;  /*!< Stream event callback function. Can be NULL. */
-    uvc_host_frame_callback_t frame_cb;   /*!< Stream frame callback function. */
+    uvc_host_frame_callback_t frame_cb;   /*!< Stream frame callback function. Can be NULL if chunk_cb is used. */
+    uvc_host_frame_chunk_callback_t chunk_cb; /*!< Optional callback with partial frame data. Can be NULL. */
     void *user_ctx;                       /*!< User argument passed to the callbacks. */
     struct {
         uint8_t dev_addr;                 /*!< USB address of device. Set to 0 for any. */
@@ -202,6 +277,7 @@ typedef struct {
         int number_of_urbs;          /*!< Number of URBs used by this stream. Triple buffering is recommended. */
         size_t urb_size;             /*!< Size in bytes of one URB. Larger values trade memory for fewer interrupts. Set to 0 to use the default size, which is 4x MPS */
         uint8_t **user_frame_buffers; /*!< Optional user-provided frame buffers. NULL lets the driver allocate them. */
+        uvc_host_frame_pool_hdl_t frame_pool; /*!< Optional shared pool. Frame buffers then grow on demand up to frame_size. Cannot be combined with user_frame_buffers. */
     } advanced;                       /*!< Advanced buffering and transfer settings. */
 } uvc_host_stream_config_t;
 
@@ -253,6 +329,9 @@ esp_err_t uvc_host_handle_events(unsigned long timeout);
 /**
  * @brief Open a UVC-compliant stream.
  *
+ * For isochronous streams, the smallest alternate setting that covers the negotiated payload size is selected.
+ * The stream reserves periodic bandwidth until it is closed, see CONFIG_UVC_PERIODIC_BANDWIDTH_PERCENT.
+ *
  * @param[in] stream_config Stream configuration structure.
  * @param[in] timeout Timeout in FreeRTOS ticks.
  * @param[out] stream_hdl_ret UVC stream handle output.
@@ -263,6 +342,7 @@ esp_err_t uvc_host_handle_events(unsigned long timeout);
  *      - ESP_ERR_INVALID_ARG if stream_config or stream_hdl_ret is NULL, or the frame buffer configuration is invalid
  *      - ESP_ERR_NO_MEM if there is not enough memory for the stream
  *      - ESP_ERR_NOT_FOUND if a stream matching the requested configuration is not found
+ *      - ESP_ERR_INVALID_SIZE if there is not enough periodic bandwidth left for the stream
  *      - Other error codes from the USB Host library
  */
 esp_err_t uvc_host_stream_open(const uvc_host_stream_config_t *stream_config,
@@ -316,6 +396,31 @@ esp_err_t uvc_host_stream_format_select(uvc_host_stream_hdl_t stream_hdl, uvc_ho
  */
 esp_err_t uvc_host_stream_format_get(uvc_host_stream_hdl_t stream_hdl, uvc_host_stream_format_t *format);
 
+/**
+ * @brief Get statistics of a UVC stream.
+ *
+ * Statistics are collected since the stream was opened or since the last uvc_host_stream_stats_reset().
+ *
+ * @param[in] stream_hdl UVC handle obtained from uvc_host_stream_open().
+ * @param[out] stats Pointer to the statistics structure to fill.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if stream_hdl or stats is NULL
+ */
+esp_err_t uvc_host_stream_stats_get(uvc_host_stream_hdl_t stream_hdl, uvc_host_stream_stats_t *stats);
+
+/**
+ * @brief Reset statistics of a UVC stream.
+ *
+ * @param[in] stream_hdl UVC handle obtained from uvc_host_stream_open().
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if stream_hdl is NULL
+ */
+esp_err_t uvc_host_stream_stats_reset(uvc_host_stream_hdl_t stream_hdl);
+
 /**
  * @brief Stop a UVC stream.
  *
@@ -357,6 +462,48 @@ esp_err_t uvc_host_stream_close(uvc_host_stream_hdl_t stream_hdl);
  */
 esp_err_t uvc_host_frame_return(uvc_host_stream_hdl_t stream_hdl, uvc_host_frame_t *frame);
 
+/**
+ * @brief Create a frame buffer pool that can be shared by several UVC streams.
+ *
+ * Streams opened with this pool allocate frame data from it only as payload arrives,
+ * so each frame buffer uses about the size of the largest frame it received, not dwMaxVideoFrameSize.
+ * Memory stays with the frame buffer while it is recycled and is returned to the pool when the stream is closed.
+ *
+ * @param[in] config Pool configuration.
+ * @param[out] pool_hdl_ret Pool handle.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config or pool_hdl_ret is NULL or pool_size is 0
+ *      - ESP_ERR_NO_MEM if there is not enough memory for the pool
+ */
+esp_err_t uvc_host_frame_pool_create(const uvc_host_frame_pool_config_t *config, uvc_host_frame_pool_hdl_t *pool_hdl_ret);
+
+/**
+ * @brief Delete a frame buffer pool.
+ *
+ * @param[in] pool_hdl Pool handle obtained from uvc_host_frame_pool_create().
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if pool_hdl is NULL
+ *      - ESP_ERR_INVALID_STATE if a stream still uses the pool
+ */
+esp_err_t uvc_host_frame_pool_delete(uvc_host_frame_pool_hdl_t pool_hdl);
+
+/**
+ * @brief Get memory usage of a frame buffer pool.
+ *
+ * @param[in] pool_hdl Pool handle obtained from uvc_host_frame_pool_create().
+ * @param[out] used Bytes currently held by frame buffers. Can be NULL.
+ * @param[out] peak Maximum number of bytes held since the pool was created. Can be NULL.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if pool_hdl is NULL
+ */
+esp_err_t uvc_host_frame_pool_usage_get(uvc_host_frame_pool_hdl_t pool_hdl, size_t *used, size_t *peak);
+
 /**
  * @brief Print a device's descriptors.
  *
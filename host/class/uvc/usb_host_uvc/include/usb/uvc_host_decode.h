@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "usb/uvc_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct uvc_host_decode_s *uvc_host_decode_hdl_t; /*!< Decode pipeline handle. */
+
+/**
+ * @brief Decoded frame.
+ */
+typedef struct {
+    uint8_t *data;                        /*!< Decoded image data. */
+    size_t data_len;                      /*!< Length of decoded image data. */
+    size_t data_buffer_len;               /*!< Size of the data buffer. */
+    unsigned width;                       /*!< Image width in pixels. */
+    unsigned height;                      /*!< Image height in pixels. */
+    uint32_t sequence;                    /*!< Sequence number of the source frame. Incremented on every submitted frame, so gaps show dropped frames. */
+    int64_t capture_time_us;              /*!< Host arrival time of the first payload of the source frame. */
+} uvc_host_decoded_frame_t;
+
+typedef struct uvc_host_decoder_s uvc_host_decoder_t;
+
+/**
+ * @brief Decoder backend.
+ *
+ * Backends are created by uvc_host_decoder_new_*() functions. Custom backends can be
+ * implemented by filling this structure.
+ */
+struct uvc_host_decoder_s {
+    /**
+     * @brief Decode one frame
+     *
+     * @param[in] decoder Decoder backend
+     * @param[in] in      Encoded frame
+     * @param[in,out] out Decoded frame. data and data_buffer_len are set by the pipeline,
+     *                    the backend fills data_len, width and height
+     * @return ESP_OK on success, other values drop the frame
+     */
+    esp_err_t (*decode)(uvc_host_decoder_t *decoder, const uvc_host_frame_t *in, uvc_host_decoded_frame_t *out);
+
+    /**
+     * @brief Allocate an output buffer. Optional
+     *
+     * Set to NULL to allocate output buffers with heap_caps_malloc() and output_heap_caps.
+     * The buffer is freed with free().
+     */
+    void *(*alloc_output)(uvc_host_decoder_t *decoder, size_t size);
+
+    /**
+     * @brief Delete the backend. Optional
+     */
+    void (*del)(uvc_host_decoder_t *decoder);
+};
+
+/**
+ * @brief Output pixel format of built-in JPEG decoders.
+ */
+typedef enum {
+    UVC_HOST_JPEG_OUT_RGB565 = 0,         /*!< 16 bits per pixel. */
+    UVC_HOST_JPEG_OUT_RGB888,             /*!< 24 bits per pixel. */
+} uvc_host_jpeg_out_format_t;
+
+/**
+ * @brief Configuration of built-in JPEG decoders.
+ */
+typedef struct {
+    uvc_host_jpeg_out_format_t out_format; /*!< Output pixel format. */
+    bool swap_color_bytes;                 /*!< Swap bytes of RGB565 pixels, as needed by most SPI displays. */
+} uvc_host_jpeg_decoder_config_t;
+
+/**
+ * @brief Decode pipeline configuration.
+ */
+typedef struct {
+    uvc_host_stream_hdl_t stream_hdl;     /*!< Stream whose frames are decoded. Frames are returned to it after decoding. */
+    uvc_host_decoder_t *decoder;          /*!< Decoder backend. On success, the pipeline takes ownership and deletes it in uvc_host_decode_delete(). */
+    int input_queue_depth;                /*!< Frames waiting for decoding. The oldest frame is dropped when the queue is full. */
+    int output_buffer_count;              /*!< Number of decoded frame buffers. */
+    size_t output_buffer_size;            /*!< Size of one decoded frame buffer. */
+    uint32_t output_heap_caps;            /*!< Memory capabilities of decoded frame buffers. Used only if the backend has no alloc_output. */
+    struct {
+        size_t stack_size;                /*!< Stack size of the decode task. */
+        unsigned priority;                /*!< Priority of the decode task. */
+        int xCoreID;                      /*!< Core affinity of the decode task. */
+    } task;                               /*!< Decode task settings. */
+} uvc_host_decode_config_t;
+
+/**
+ * @brief Decode pipeline statistics.
+ *
+ * Times are measured per stage: waiting in the input queue, decoding, and waiting for the consumer.
+ */
+typedef struct {
+    uint32_t frames_submitted;            /*!< Frames passed to uvc_host_decode_submit(). */
+    uint32_t frames_decoded;              /*!< Frames decoded successfully. */
+    uint32_t decode_errors;               /*!< Frames the backend failed to decode. */
+    uint32_t input_dropped;               /*!< Encoded frames dropped because the input queue was full or no output buffer was free. */
+    uint32_t output_dropped;              /*!< Decoded frames overwritten before the consumer took them. */
+    uint32_t queue_time_avg_us;           /*!< Average time a frame waited for the decoder. */
+    uint32_t queue_time_max_us;           /*!< Maximum time a frame waited for the decoder. */
+    uint32_t decode_time_avg_us;          /*!< Average decoding time. */
+    uint32_t decode_time_max_us;          /*!< Maximum decoding time. */
+    uint32_t consumer_time_avg_us;        /*!< Average time a decoded frame waited for the consumer. */
+    uint32_t consumer_time_max_us;        /*!< Maximum time a decoded frame waited for the consumer. */
+} uvc_host_decode_stats_t;
+
+/**
+ * @brief Create a decode pipeline for a UVC stream.
+ *
+ * The pipeline owns a task that decodes frames passed to uvc_host_decode_submit().
+ * Decoded frames are taken with uvc_host_decode_get() and released with uvc_host_decode_return().
+ * If the consumer does not keep up, the oldest decoded frame is overwritten.
+ *
+ * @param[in] config Pipeline configuration.
+ * @param[out] decode_hdl_ret Pipeline handle.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL or queue depth, buffer count or buffer size is 0
+ *      - ESP_ERR_NO_MEM if there is not enough memory
+ */
+esp_err_t uvc_host_decode_create(const uvc_host_decode_config_t *config, uvc_host_decode_hdl_t *decode_hdl_ret);
+
+/**
+ * @brief Delete a decode pipeline.
+ *
+ * The stream must be stopped and all decoded frames returned before calling this function.
+ * Frames waiting for decoding are returned to the stream.
+ *
+ * @param[in] decode_hdl Pipeline handle.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if decode_hdl is NULL
+ *      - ESP_ERR_INVALID_STATE if the consumer still holds decoded frames
+ */
+esp_err_t uvc_host_decode_delete(uvc_host_decode_hdl_t decode_hdl);
+
+/**
+ * @brief Submit a received frame for decoding.
+ *
+ * Call this function from uvc_host_frame_callback_t and return its result from the callback.
+ * If the input queue is full, the oldest waiting frame is returned to the stream undecoded.
+ *
+ * @param[in] decode_hdl Pipeline handle.
+ * @param[in] frame Frame from the frame callback.
+ *
+ * @return
+ *      - false if the frame was taken by the pipeline. It is returned to the stream after decoding
+ *      - true if the frame was not taken and can be returned to the driver immediately
+ */
+bool uvc_host_decode_submit(uvc_host_decode_hdl_t decode_hdl, const uvc_host_frame_t *frame);
+
+/**
+ * @brief Get the oldest decoded frame.
+ *
+ * @param[in] decode_hdl Pipeline handle.
+ * @param[out] frame Decoded frame. Must be released with uvc_host_decode_return().
+ * @param[in] timeout Timeout in ticks.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL
+ *      - ESP_ERR_TIMEOUT if no frame was decoded within the timeout
+ */
+esp_err_t uvc_host_decode_get(uvc_host_decode_hdl_t decode_hdl, uvc_host_decoded_frame_t **frame, TickType_t timeout);
+
+/**
+ * @brief Release a decoded frame.
+ *
+ * @param[in] decode_hdl Pipeline handle.
+ * @param[in] frame Frame obtained from uvc_host_decode_get().
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL or the frame does not belong to this pipeline
+ *      - ESP_ERR_INVALID_STATE if the frame was already returned
+ */
+esp_err_t uvc_host_decode_return(uvc_host_decode_hdl_t decode_hdl, uvc_host_decoded_frame_t *frame);
+
+/**
+ * @brief Get decode pipeline statistics.
+ *
+ * @param[in] decode_hdl Pipeline handle.
+ * @param[out] stats Statistics.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL
+ */
+esp_err_t uvc_host_decode_stats_get(uvc_host_decode_hdl_t decode_hdl, uvc_host_decode_stats_t *stats);
+
+#if UVC_HOST_HW_JPEG_DECODER_SUPPORTED
+/**
+ * @brief Create a hardware JPEG decoder backend
+ *
+ * Available on targets with a JPEG codec, such as ESP32-P4.
+ *
+ * @param[in] config Decoder configuration.
+ * @param[out] decoder_ret Decoder backend.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL
+ *      - ESP_ERR_NO_MEM if there is not enough memory
+ *      - Other errors from the JPEG driver
+ */
+esp_err_t uvc_host_decoder_new_hw_jpeg(const uvc_host_jpeg_decoder_config_t *config, uvc_host_decoder_t **decoder_ret);
+#endif // UVC_HOST_HW_JPEG_DECODER_SUPPORTED
+
+#if UVC_HOST_SW_JPEG_DECODER_SUPPORTED
+/**
+ * @brief Create a software JPEG decoder backend
+ *
+ * Available if espressif/esp_jpeg component is part of the build.
+ *
+ * @param[in] config Decoder configuration.
+ * @param[out] decoder_ret Decoder backend.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL
+ *      - ESP_ERR_NO_MEM if there is not enough memory
+ */
+esp_err_t uvc_host_decoder_new_sw_jpeg(const uvc_host_jpeg_decoder_config_t *config, uvc_host_decoder_t **decoder_ret);
+#endif // UVC_HOST_SW_JPEG_DECODER_SUPPORTED
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,12 +9,16 @@
 // In this file we want to have clean interface for descriptor parsing
 // So we include only files with USB specification definitions
 // This interface is also used in host_tests
+#include <stdbool.h>
 #include "usb/usb_types_ch9.h"
 #include "usb_types_uvc.h"
 
 #define UVC_DESC_FPS_TO_DWFRAMEINTERVAL(fps) (((fps) != 0) ? 10000000.0f / (fps) : 0)
 #define UVC_DESC_DWFRAMEINTERVAL_TO_FPS(dwFrameInterval) (((dwFrameInterval) != 0) ? 10000000.0f / ((float)(dwFrameInterval)) : 0)
 
+#define UVC_DESC_HS_BYTES_PER_FRAME (60000) // 480 Mbit/s in one 1 ms frame
+#define UVC_DESC_FS_BYTES_PER_FRAME (1500)  // 12 Mbit/s in one 1 ms frame
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,6 +64,45 @@ esp_err_t uvc_desc_get_streaming_intf_and_ep(
     const usb_intf_desc_t **intf_desc_ret,
     const usb_ep_desc_t **ep_desc_ret);
 
+/**
+ * @brief Get Streaming Interface and Endpoint descriptors for negotiated payload size
+ *
+ * Picks the alternate setting with the smallest MPS x mult that is greater than or equal to dwMaxPayloadTransferSize,
+ * so the stream does not reserve more periodic bandwidth than it needs.
+ * If no alternate setting covers the payload, the one with the largest MPS x mult is returned.
+ * If dwMaxPayloadTransferSize is 0 (not reported by the device), this behaves as uvc_desc_get_streaming_intf_and_ep().
+ *
+ * @param[in] cfg_desc                 Configuration descriptor
+ * @param[in] bInterfaceNumber         Index of Streaming interface
+ * @param[in] dwMaxPayloadTransferSize Payload size negotiated with VS_PROBE_CONTROL
+ * @param[in] max_mps                  Maximum MPS x mult that fits in the IN FIFO
+ * @param[out] intf_desc_ret           Interface descriptor
+ * @param[out] ep_desc_ret             Endpoint descriptor
+ * @return
+ *     - ESP_OK: Success
+ *     - ESP_ERR_INVALID_ARG: cfg_desc, intf_desc_ret or ep_desc_ret is NULL
+ *     - ESP_ERR_NOT_FOUND: Could not find interface with MPS smaller than or equal to max_mps
+ */
+esp_err_t uvc_desc_get_streaming_intf_and_ep_for_payload(
+    const usb_config_desc_t *cfg_desc,
+    uint8_t bInterfaceNumber,
+    uint32_t dwMaxPayloadTransferSize,
+    uint16_t max_mps,
+    const usb_intf_desc_t **intf_desc_ret,
+    const usb_ep_desc_t **ep_desc_ret);
+
+/**
+ * @brief Get periodic bus time the endpoint reserves in one 1 ms frame
+ *
+ * The result is the share of the bus (480 Mbit/s for High-speed, 12 Mbit/s for Full-speed)
+ * that the endpoint needs, expressed in nanoseconds per 1 ms frame. Protocol overhead is not included.
+ *
+ * @param[in] ep_desc    Streaming endpoint descriptor
+ * @param[in] high_speed The device is connected at High-speed
+ * @return Bus time in nanoseconds per 1 ms frame. 0 for non-isochronous endpoints.
+ */
+uint32_t uvc_desc_get_periodic_bus_time_ns(const usb_ep_desc_t *ep_desc, bool high_speed);
+
 esp_err_t uvc_desc_get_frame_format_by_index(
     const usb_config_desc_t *cfg_desc,
     uint8_t bInterfaceNumber,
@@ -19,6 +19,9 @@ extern "C" {
 /**
  * @brief Allocate frame buffers for UVC stream
  *
+ * If uvc_stream->constant.frame_pool is set, frame data are not allocated here;
+ * frame buffers grow from the pool up to fb_size as data arrive.
+ *
  * @param[in] uvc_stream UVC stream handle
  * @param[in] nb_of_fb   Number of frame buffers to allocate
  * @param[in] fb_size    Size of 1 frame buffer in bytes
@@ -60,15 +63,19 @@ uvc_host_frame_t *uvc_frame_get_empty(uvc_stream_t *uvc_stream);
 /**
  * @brief Add data to the frame buffer
  *
- * @param[in] frame    Frame buffer
- * @param[in] data     Pointer to data
- * @param[in] data_len Data length in bytes
+ * If the stream uses a frame buffer pool, the frame buffer grows as needed.
+ *
+ * @param[in] uvc_stream UVC stream that owns the frame buffer
+ * @param[in] frame      Frame buffer
+ * @param[in] data       Pointer to data
+ * @param[in] data_len   Data length in bytes
  * @return
  *     - ESP_OK: Data added to the frame buffer
- *     - ESP_ERR_INVALID_ARG: frame or data is NULL
+ *     - ESP_ERR_INVALID_ARG: uvc_stream, frame or data is NULL
  *     - ESP_ERR_INVALID_SIZE: Frame buffer overflow
+ *     - ESP_ERR_NO_MEM: Frame buffer could not grow
  */
-esp_err_t uvc_frame_add_data(uvc_host_frame_t *frame, const uint8_t *data, size_t data_len);
+esp_err_t uvc_frame_add_data(uvc_stream_t *uvc_stream, uvc_host_frame_t *frame, const uint8_t *data, size_t data_len);
 
 /**
  * @brief Reset a frame buffer
@@ -83,6 +90,66 @@ static inline void uvc_frame_reset(uvc_host_frame_t *frame)
     frame->data_len = 0;
 }
 
+/**
+ * @brief Start chunk delivery of a new frame
+ *
+ * Must be called on every start of frame. If the previous frame was partially delivered and not finished,
+ * it is aborted with a zero-length chunk flagged UVC_HOST_CHUNK_FLAG_ERROR | UVC_HOST_CHUNK_FLAG_EOF.
+ *
+ * @param[in] uvc_stream UVC stream
+ */
+void uvc_frame_chunk_start(uvc_stream_t *uvc_stream);
+
+/**
+ * @brief Deliver data of current frame that was not yet passed to the chunk callback
+ *
+ * Called at the end of each USB transfer callback. Does nothing if chunk callback is not registered,
+ * there is no current frame or the current frame is being skipped.
+ *
+ * @param[in] uvc_stream UVC stream
+ */
+void uvc_frame_chunk_deliver(uvc_stream_t *uvc_stream);
+
+/**
+ * @brief Finish chunk delivery of a frame
+ *
+ * Delivers the rest of the frame with UVC_HOST_CHUNK_FLAG_EOF, or aborts the frame if it is not valid.
+ *
+ * @param[in] uvc_stream  UVC stream
+ * @param[in] frame       Completed frame. Can be NULL
+ * @param[in] frame_valid false if the frame is being skipped
+ */
+void uvc_frame_chunk_end(uvc_stream_t *uvc_stream, const uvc_host_frame_t *frame, bool frame_valid);
+
+/**
+ * @brief Save timing of a payload that belongs to the current frame
+ *
+ * @param[in] uvc_stream     UVC stream
+ * @param[in] hdr            Validated UVC payload header
+ * @param[in] host_time_us   Arrival time of the USB transfer
+ * @param[in] start_of_frame This is the first payload of a new frame
+ */
+void uvc_frame_payload_time_update(uvc_stream_t *uvc_stream, const uvc_payload_header_t *hdr, int64_t host_time_us, bool start_of_frame);
+
+/**
+ * @brief Finish a frame: save its timing and update stream statistics
+ *
+ * Must be called at end of frame, before the frame is passed to the user.
+ *
+ * @param[in] uvc_stream  UVC stream
+ * @param[in] frame       Completed frame. Can be NULL
+ * @param[in] frame_valid false if the frame is being skipped
+ */
+void uvc_frame_stats_update(uvc_stream_t *uvc_stream, uvc_host_frame_t *frame, bool frame_valid);
+
+/**
+ * @brief Count frame buffer underflow or overflow and inform the user
+ *
+ * @param[in] uvc_stream UVC stream
+ * @param[in] type       UVC_HOST_FRAME_BUFFER_UNDERFLOW or UVC_HOST_FRAME_BUFFER_OVERFLOW
+ */
+void uvc_frame_buffer_event(uvc_stream_t *uvc_stream, enum uvc_host_dev_event type);
+
 /**
  * @brief Saves format to all frame buffers
  *
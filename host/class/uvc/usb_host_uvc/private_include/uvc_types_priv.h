@@ -28,6 +28,16 @@ typedef enum {
     UVC_STREAM_BULK_PACKET_EOF,
 } uvc_stream_bulk_packet_type_t;
 
+struct uvc_host_frame_pool_s {
+    size_t size;                              // Total memory budget
+    size_t used;                              // Memory currently held by frame buffers. Protected by UVC critical section
+    size_t peak;                              // Maximum of 'used'. Protected by UVC critical section
+    size_t initial_frame_size;                // First allocation of a frame buffer
+    size_t grow_step;                         // Frame buffers grow in multiples of this size
+    uint32_t heap_caps;                       // Memory capabilities of frame buffers
+    unsigned stream_count;                    // Number of streams using this pool. Protected by UVC critical section
+};
+
 struct uvc_host_stream_s {
     SLIST_ENTRY(uvc_host_stream_s) list_entry;
 
@@ -35,15 +45,20 @@ struct uvc_host_stream_s {
         // UVC driver related members
         uvc_host_stream_callback_t stream_cb; // User's callback for stream events
         uvc_host_frame_callback_t frame_cb;   // User's frame callback
+        uvc_host_frame_chunk_callback_t chunk_cb; // User's frame chunk callback. Can be NULL
         void *cb_arg;                         // Common argument for user's callbacks
         QueueHandle_t empty_fb_queue;         // Queue of empty framebuffers
         bool user_provided_fb;                // Flag indicating if frame buffers are user-provided
+        uvc_host_frame_pool_hdl_t frame_pool; // Shared pool the frame buffers grow from. NULL if frame buffers have fixed size
+        size_t frame_size;                    // Maximum size of one frame buffer
 
         // Constant USB descriptor values
         uint16_t bcdUVC;                      // Version of UVC specs this device implements
         uint8_t  bInterfaceNumber;            // USB Video Streaming interface claimed by this stream. Needed for ISOC Stream start and CTRL transfers
         uint8_t  bAlternateSetting;           // Alternate setting for selected interface. Needed for ISOC Stream start
         uint8_t  bEndpointAddress;            // Streaming endpoint address. Needed for BULK Stream stop
+        uint16_t isoc_payload_size;           // MPS x mult of the selected ISOC alternate setting. 0 for BULK streams
+        uint32_t periodic_bus_time_ns;        // Periodic bus time reserved by this stream, in nanoseconds per 1 ms frame
 
         // USB host related members
         usb_device_handle_t dev_hdl;          // USB device handle
@@ -62,5 +77,24 @@ struct uvc_host_stream_s {
         uvc_stream_bulk_packet_type_t next_bulk_packet; // Bulk only: next expected packet
         bool skip_current_frame;                        // Flag to skip current frame. An error has occurred in the stream
         uint8_t current_frame_id;                       // Frame ID can be only 0 or 1. But we also allow setting it to invalid value = 2.
+        uint32_t chunk_frame_id;                        // Frame sequence number reported in frame chunks
+        size_t chunk_offset;                            // Frame data already delivered in chunks of current frame
+        uvc_host_payload_time_t first_payload;          // Timing of the first payload of current frame
+        uvc_host_payload_time_t last_payload;           // Timing of the last payload of current frame
     } single_thread; // Single thread members are only accessed from 1 thread, so they do not need protection
+
+    struct {
+        uint32_t frames_delivered;
+        uint32_t frames_dropped;
+        uint32_t underflow_count;
+        uint32_t overflow_count;
+        int64_t prev_frame_start_us;          // First payload arrival of previous delivered frame. 0 if the previous frame was dropped
+        uint32_t prev_interval_us;            // Previous frame interval. 0 if not known
+        uint32_t jitter_q4;                   // Frame interval jitter in 1/16 us
+        uint64_t interval_sum_us;
+        uint32_t interval_count;
+        uint32_t interval_max_us;
+        uint64_t assembly_sum_us;
+        uint32_t assembly_max_us;
+    } stats; // Stream statistics require a critical section
 };
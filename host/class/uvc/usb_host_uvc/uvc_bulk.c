@@ -8,6 +8,7 @@
 #include <string.h> // For memcpy
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "uvc_stream.h" // For uvc_host_stream_pause()
 #include "uvc_types_priv.h"
@@ -24,10 +25,15 @@ static void bulk_complete_frame(uvc_stream_t *uvc_stream)
     uvc_host_frame_t *this_frame = uvc_stream->dynamic.current_frame;
     uvc_stream->dynamic.current_frame = NULL;
 
-    const bool invoke_fb_callback = (uvc_stream->dynamic.streaming && uvc_stream->constant.frame_cb && this_frame &&
-                                     !uvc_stream->single_thread.skip_current_frame);
+    const bool frame_valid = (uvc_stream->dynamic.streaming && this_frame && !uvc_stream->single_thread.skip_current_frame);
+    const bool invoke_fb_callback = (frame_valid && uvc_stream->constant.frame_cb);
     UVC_EXIT_CRITICAL();
 
+    if (UVC_ATOMIC_LOAD(uvc_stream->dynamic.streaming)) {
+        uvc_frame_stats_update(uvc_stream, this_frame, frame_valid);
+    }
+    uvc_frame_chunk_end(uvc_stream, this_frame, frame_valid);
+
     bool return_frame = true;
     if (invoke_fb_callback) {
         return_frame = uvc_stream->constant.frame_cb(this_frame, uvc_stream->constant.cb_arg);
@@ -50,19 +56,13 @@ static void bulk_add_frame_data(uvc_stream_t *uvc_stream, const uint8_t *data, s
         return;
     }
 
-    esp_err_t ret = uvc_frame_add_data(current_frame, data, data_len);
+    esp_err_t ret = uvc_frame_add_data(uvc_stream, current_frame, data, data_len);
     if (ret != ESP_OK) {
         // Frame buffer overflow
         uvc_stream->single_thread.skip_current_frame = true;
 
         // Inform the user about the overflow
-        uvc_host_stream_callback_t stream_cb = uvc_stream->constant.stream_cb;
-        if (stream_cb) {
-            const uvc_host_stream_event_data_t event = {
-                .type = UVC_HOST_FRAME_BUFFER_OVERFLOW,
-            };
-            stream_cb(&event, uvc_stream->constant.cb_arg);
-        }
+        uvc_frame_buffer_event(uvc_stream, UVC_HOST_FRAME_BUFFER_OVERFLOW);
     }
 }
 
@@ -119,6 +119,7 @@ void bulk_transfer_callback(usb_transfer_t *transfer)
     // meaning both the pointer and the data it points to cannot be changed.
     // This contrasts with the ISOC implementation, where 'payload' is a variable
     // pointer and is increased after every ISOC packet processing
+    const int64_t arrival_us = esp_timer_get_time();
     const uint8_t *const payload = transfer->data_buffer;
     const uint8_t *payload_data  = payload;
     size_t payload_data_len      = transfer->actual_num_bytes;
@@ -143,6 +144,8 @@ label_sof:
         // We detected start of new frame. Update Frame ID and start fetching this frame
         uvc_stream->single_thread.current_frame_id   = payload_header->bmHeaderInfo.frame_id;
         uvc_stream->single_thread.skip_current_frame = payload_header->bmHeaderInfo.error; // Check for error flag
+        uvc_frame_chunk_start(uvc_stream);
+        uvc_frame_payload_time_update(uvc_stream, payload_header, arrival_us, true);
         payload_data     += payload_header->bHeaderLength; // Pointer arithmetic!
         payload_data_len -= payload_header->bHeaderLength;
 
@@ -179,13 +182,7 @@ label_sof:
                 uvc_stream->single_thread.skip_current_frame = true;
 
                 // Inform the user about the underflow
-                uvc_host_stream_callback_t stream_cb = uvc_stream->constant.stream_cb;
-                if (stream_cb) {
-                    const uvc_host_stream_event_data_t event = {
-                        .type = UVC_HOST_FRAME_BUFFER_UNDERFLOW,
-                    };
-                    stream_cb(&event, uvc_stream->constant.cb_arg);
-                }
+                uvc_frame_buffer_event(uvc_stream, UVC_HOST_FRAME_BUFFER_UNDERFLOW);
             }
         } else {
             // We received SoF but current_frame is not NULL: We missed EoF - reset the frame buffer
@@ -223,10 +220,14 @@ skip_sof:
         if (!start_of_frame && payload_header->bmHeaderInfo.end_of_frame == false && payload_data_len > 0) {
             // This is not the end of frame, we collect more data
             uvc_stream->single_thread.next_bulk_packet = UVC_STREAM_BULK_PACKET_DATA;
+            uvc_frame_payload_time_update(uvc_stream, payload_header, arrival_us, false);
             bulk_add_frame_data(uvc_stream, payload_data + payload_header->bHeaderLength, payload_data_len - payload_header->bHeaderLength);
             break;
         }
 
+        if (!start_of_frame) {
+            uvc_frame_payload_time_update(uvc_stream, payload_header, arrival_us, false);
+        }
         bulk_complete_frame(uvc_stream);
 
         if (start_of_frame && payload_header->bHeaderLength < payload_data_len) {
@@ -241,6 +242,9 @@ skip_sof:
     default: abort();
     }
 
+    // Pass data of the unfinished frame to the chunk callback
+    uvc_frame_chunk_deliver(uvc_stream);
+
     if (UVC_ATOMIC_LOAD(uvc_stream->dynamic.streaming)) {
         usb_host_transfer_submit(transfer); // Restart the transfer
     }
@@ -0,0 +1,327 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "usb/uvc_host_decode.h"
+#include "uvc_check_priv.h"
+#include "uvc_critical_priv.h"
+
+static const char *TAG = "uvc-decode";
+
+typedef struct {
+    uvc_host_frame_t *frame;                  // Encoded frame. NULL requests the decode task to exit
+    uint32_t sequence;                        // Sequence number of this frame
+    int64_t submit_time_us;                   // Time of uvc_host_decode_submit()
+} uvc_decode_job_t;
+
+typedef struct {
+    uvc_host_decoded_frame_t frame;           // Must be first: the consumer gets pointer to this member
+    int64_t ready_time_us;                    // Time the frame was decoded
+    bool held;                                // Taken by uvc_host_decode_get() and not returned yet
+} uvc_decode_buf_t;
+
+typedef struct {
+    uint64_t sum_us;
+    uint32_t count;
+    uint32_t max_us;
+} uvc_decode_time_t;
+
+struct uvc_host_decode_s {
+    struct {
+        uvc_host_stream_hdl_t stream_hdl;     // Stream the encoded frames are returned to
+        uvc_host_decoder_t *decoder;          // Decoder backend
+        QueueHandle_t input_queue;            // Queue of uvc_decode_job_t waiting for decoding
+        QueueHandle_t free_queue;             // Queue of empty uvc_decode_buf_t pointers
+        QueueHandle_t ready_queue;            // Queue of decoded uvc_decode_buf_t pointers waiting for the consumer
+        uvc_decode_buf_t *bufs;               // Array of decoded frame buffers
+        int buf_count;                        // Number of decoded frame buffers
+        SemaphoreHandle_t task_done;          // Given by the decode task before it exits
+    } constant; // Constant members do no change after creation thus do not require a critical section
+
+    struct {
+        uint32_t sequence;                    // Sequence number of the next submitted frame
+        int consumer_held;                    // Decoded frames taken by uvc_host_decode_get() and not returned yet
+        uint32_t frames_submitted;
+        uint32_t frames_decoded;
+        uint32_t decode_errors;
+        uint32_t input_dropped;
+        uint32_t output_dropped;
+        uvc_decode_time_t queue_time;
+        uvc_decode_time_t decode_time;
+        uvc_decode_time_t consumer_time;
+    } dynamic; // Dynamic members require a critical section
+};
+
+static inline void uvc_decode_time_add(uvc_decode_time_t *time, int64_t duration_us)
+{
+    const uint32_t duration = (uint32_t)duration_us;
+    time->sum_us += duration;
+    time->count++;
+    if (duration > time->max_us) {
+        time->max_us = duration;
+    }
+}
+
+static inline uint32_t uvc_decode_time_avg(const uvc_decode_time_t *time)
+{
+    return time->count ? (uint32_t)(time->sum_us / time->count) : 0;
+}
+
+static void uvc_decode_task(void *arg)
+{
+    uvc_host_decode_hdl_t decode = (uvc_host_decode_hdl_t)arg;
+    uvc_decode_job_t job;
+
+    while (xQueueReceive(decode->constant.input_queue, &job, portMAX_DELAY) == pdPASS) {
+        if (job.frame == NULL) {
+            break; // Exit request from uvc_host_decode_delete()
+        }
+
+        // Get an output buffer. If the consumer is slow, overwrite the oldest decoded frame
+        uvc_decode_buf_t *buf = NULL;
+        bool output_dropped = false;
+        if (xQueueReceive(decode->constant.free_queue, &buf, 0) != pdPASS) {
+            output_dropped = (xQueueReceive(decode->constant.ready_queue, &buf, 0) == pdPASS);
+        }
+        if (buf == NULL) {
+            // The consumer holds all output buffers
+            uvc_host_frame_return(decode->constant.stream_hdl, job.frame);
+            UVC_ENTER_CRITICAL();
+            decode->dynamic.input_dropped++;
+            UVC_EXIT_CRITICAL();
+            continue;
+        }
+
+        const int64_t start_us = esp_timer_get_time();
+        buf->frame.data_len = 0;
+        buf->frame.width = 0;
+        buf->frame.height = 0;
+        buf->frame.sequence = job.sequence;
+        buf->frame.capture_time_us = job.frame->first_payload.host_time_us;
+        const esp_err_t ret = decode->constant.decoder->decode(decode->constant.decoder, job.frame, &buf->frame);
+        const int64_t end_us = esp_timer_get_time();
+
+        // The encoded frame is not needed anymore
+        uvc_host_frame_return(decode->constant.stream_hdl, job.frame);
+
+        UVC_ENTER_CRITICAL();
+        decode->dynamic.output_dropped += output_dropped;
+        uvc_decode_time_add(&decode->dynamic.queue_time, start_us - job.submit_time_us);
+        if (ret == ESP_OK) {
+            decode->dynamic.frames_decoded++;
+            uvc_decode_time_add(&decode->dynamic.decode_time, end_us - start_us);
+        } else {
+            decode->dynamic.decode_errors++;
+        }
+        UVC_EXIT_CRITICAL();
+
+        if (ret == ESP_OK) {
+            buf->ready_time_us = end_us;
+            xQueueSend(decode->constant.ready_queue, &buf, 0);
+        } else {
+            ESP_LOGD(TAG, "Frame %"PRIu32" decoding failed: %s", job.sequence, esp_err_to_name(ret));
+            xQueueSend(decode->constant.free_queue, &buf, 0);
+        }
+    }
+
+    xSemaphoreGive(decode->constant.task_done);
+    vTaskDelete(NULL);
+}
+
+static void uvc_decode_free(uvc_host_decode_hdl_t decode)
+{
+    if (decode->constant.bufs) {
+        for (int i = 0; i < decode->constant.buf_count; i++) {
+            free(decode->constant.bufs[i].frame.data);
+        }
+        free(decode->constant.bufs);
+    }
+    if (decode->constant.input_queue) {
+        vQueueDelete(decode->constant.input_queue);
+    }
+    if (decode->constant.free_queue) {
+        vQueueDelete(decode->constant.free_queue);
+    }
+    if (decode->constant.ready_queue) {
+        vQueueDelete(decode->constant.ready_queue);
+    }
+    if (decode->constant.task_done) {
+        vSemaphoreDelete(decode->constant.task_done);
+    }
+    free(decode);
+}
+
+esp_err_t uvc_host_decode_create(const uvc_host_decode_config_t *config, uvc_host_decode_hdl_t *decode_hdl_ret)
+{
+    UVC_CHECK(config && decode_hdl_ret && config->stream_hdl && config->decoder && config->decoder->decode, ESP_ERR_INVALID_ARG);
+    UVC_CHECK(config->input_queue_depth > 0 && config->output_buffer_count > 0 && config->output_buffer_size > 0, ESP_ERR_INVALID_ARG);
+    esp_err_t ret = ESP_OK;
+
+    uvc_host_decode_hdl_t decode = calloc(1, sizeof(struct uvc_host_decode_s));
+    UVC_CHECK(decode, ESP_ERR_NO_MEM);
+    decode->constant.stream_hdl = config->stream_hdl;
+    decode->constant.buf_count = config->output_buffer_count;
+    decode->constant.input_queue = xQueueCreate(config->input_queue_depth, sizeof(uvc_decode_job_t));
+    decode->constant.free_queue = xQueueCreate(config->output_buffer_count, sizeof(uvc_decode_buf_t *));
+    decode->constant.ready_queue = xQueueCreate(config->output_buffer_count, sizeof(uvc_decode_buf_t *));
+    decode->constant.task_done = xSemaphoreCreateBinary();
+    decode->constant.bufs = calloc(config->output_buffer_count, sizeof(uvc_decode_buf_t));
+    ESP_GOTO_ON_FALSE(decode->constant.input_queue && decode->constant.free_queue && decode->constant.ready_queue &&
+                      decode->constant.task_done && decode->constant.bufs, ESP_ERR_NO_MEM, err, TAG, "Not enough memory for decode pipeline");
+
+    const uint32_t caps = config->output_heap_caps ? config->output_heap_caps : MALLOC_CAP_DEFAULT;
+    for (int i = 0; i < config->output_buffer_count; i++) {
+        uvc_decode_buf_t *buf = &decode->constant.bufs[i];
+        if (config->decoder->alloc_output) {
+            buf->frame.data = config->decoder->alloc_output(config->decoder, config->output_buffer_size);
+        } else {
+            buf->frame.data = heap_caps_malloc(config->output_buffer_size, caps);
+        }
+        ESP_GOTO_ON_FALSE(buf->frame.data, ESP_ERR_NO_MEM, err, TAG, "Not enough memory for decoded frame buffers %zu", config->output_buffer_size);
+        buf->frame.data_buffer_len = config->output_buffer_size;
+        xQueueSend(decode->constant.free_queue, &buf, 0);
+    }
+
+    // The decoder is deleted with the pipeline only if the pipeline was created, see uvc_host_decode_delete()
+    decode->constant.decoder = config->decoder;
+    TaskHandle_t task_hdl = NULL;
+    xTaskCreatePinnedToCore(uvc_decode_task, "UVC-decode", config->task.stack_size, decode,
+                            config->task.priority, &task_hdl, config->task.xCoreID);
+    ESP_GOTO_ON_FALSE(task_hdl, ESP_ERR_NO_MEM, err, TAG, "Could not create decode task");
+
+    *decode_hdl_ret = decode;
+    return ESP_OK;
+
+err:
+    uvc_decode_free(decode);
+    return ret;
+}
+
+esp_err_t uvc_host_decode_delete(uvc_host_decode_hdl_t decode_hdl)
+{
+    UVC_CHECK(decode_hdl, ESP_ERR_INVALID_ARG);
+
+    // Decoded frames held by the consumer would be freed under its hands
+    UVC_CHECK(UVC_ATOMIC_LOAD(decode_hdl->dynamic.consumer_held) == 0, ESP_ERR_INVALID_STATE);
+
+    // Stop the decode task and return frames that were not decoded
+    const uvc_decode_job_t exit_job = {0};
+    xQueueSendToFront(decode_hdl->constant.input_queue, &exit_job, portMAX_DELAY);
+    xSemaphoreTake(decode_hdl->constant.task_done, portMAX_DELAY);
+
+    uvc_decode_job_t job;
+    while (xQueueReceive(decode_hdl->constant.input_queue, &job, 0) == pdPASS) {
+        if (job.frame) {
+            uvc_host_frame_return(decode_hdl->constant.stream_hdl, job.frame);
+        }
+    }
+
+    uvc_host_decoder_t *decoder = decode_hdl->constant.decoder;
+    uvc_decode_free(decode_hdl);
+    if (decoder->del) {
+        decoder->del(decoder);
+    }
+    return ESP_OK;
+}
+
+bool uvc_host_decode_submit(uvc_host_decode_hdl_t decode_hdl, const uvc_host_frame_t *frame)
+{
+    UVC_CHECK(decode_hdl && frame, true);
+
+    UVC_ENTER_CRITICAL();
+    uvc_decode_job_t job = {
+        .frame = (uvc_host_frame_t *)frame,
+        .sequence = decode_hdl->dynamic.sequence++,
+        .submit_time_us = 0,
+    };
+    decode_hdl->dynamic.frames_submitted++;
+    UVC_EXIT_CRITICAL();
+    job.submit_time_us = esp_timer_get_time();
+
+    while (xQueueSend(decode_hdl->constant.input_queue, &job, 0) != pdPASS) {
+        // Input queue is full: drop the oldest frame. The decode task may take it first, then we just retry
+        uvc_decode_job_t oldest;
+        if (xQueueReceive(decode_hdl->constant.input_queue, &oldest, 0) == pdPASS) {
+            uvc_host_frame_return(decode_hdl->constant.stream_hdl, oldest.frame);
+            UVC_ENTER_CRITICAL();
+            decode_hdl->dynamic.input_dropped++;
+            UVC_EXIT_CRITICAL();
+        }
+    }
+    return false; // The frame is returned to the stream by the decode task
+}
+
+esp_err_t uvc_host_decode_get(uvc_host_decode_hdl_t decode_hdl, uvc_host_decoded_frame_t **frame, TickType_t timeout)
+{
+    UVC_CHECK(decode_hdl && frame, ESP_ERR_INVALID_ARG);
+
+    uvc_decode_buf_t *buf;
+    UVC_CHECK(xQueueReceive(decode_hdl->constant.ready_queue, &buf, timeout) == pdPASS, ESP_ERR_TIMEOUT);
+    const int64_t wait_us = esp_timer_get_time() - buf->ready_time_us;
+
+    UVC_ENTER_CRITICAL();
+    buf->held = true;
+    decode_hdl->dynamic.consumer_held++;
+    uvc_decode_time_add(&decode_hdl->dynamic.consumer_time, wait_us);
+    UVC_EXIT_CRITICAL();
+    *frame = &buf->frame;
+    return ESP_OK;
+}
+
+esp_err_t uvc_host_decode_return(uvc_host_decode_hdl_t decode_hdl, uvc_host_decoded_frame_t *frame)
+{
+    UVC_CHECK(decode_hdl && frame, ESP_ERR_INVALID_ARG);
+
+    // The frame must be one of this pipeline's buffers, currently held by the consumer
+    const uintptr_t first = (uintptr_t)&decode_hdl->constant.bufs[0];
+    const uintptr_t offset = (uintptr_t)frame - first;
+    UVC_CHECK((uintptr_t)frame >= first && offset % sizeof(uvc_decode_buf_t) == 0 &&
+              offset / sizeof(uvc_decode_buf_t) < (uintptr_t)decode_hdl->constant.buf_count, ESP_ERR_INVALID_ARG);
+    uvc_decode_buf_t *buf = (uvc_decode_buf_t *)frame;
+
+    UVC_ENTER_CRITICAL();
+    const bool held = buf->held;
+    buf->held = false;
+    if (held) {
+        decode_hdl->dynamic.consumer_held--;
+    }
+    UVC_EXIT_CRITICAL();
+    UVC_CHECK(held, ESP_ERR_INVALID_STATE);
+
+    // The free queue has room for all buffers, so a held buffer always fits
+    xQueueSend(decode_hdl->constant.free_queue, &buf, 0);
+    return ESP_OK;
+}
+
+esp_err_t uvc_host_decode_stats_get(uvc_host_decode_hdl_t decode_hdl, uvc_host_decode_stats_t *stats)
+{
+    UVC_CHECK(decode_hdl && stats, ESP_ERR_INVALID_ARG);
+    UVC_ENTER_CRITICAL();
+    stats->frames_submitted = decode_hdl->dynamic.frames_submitted;
+    stats->frames_decoded = decode_hdl->dynamic.frames_decoded;
+    stats->decode_errors = decode_hdl->dynamic.decode_errors;
+    stats->input_dropped = decode_hdl->dynamic.input_dropped;
+    stats->output_dropped = decode_hdl->dynamic.output_dropped;
+    stats->queue_time_avg_us = uvc_decode_time_avg(&decode_hdl->dynamic.queue_time);
+    stats->queue_time_max_us = decode_hdl->dynamic.queue_time.max_us;
+    stats->decode_time_avg_us = uvc_decode_time_avg(&decode_hdl->dynamic.decode_time);
+    stats->decode_time_max_us = decode_hdl->dynamic.decode_time.max_us;
+    stats->consumer_time_avg_us = uvc_decode_time_avg(&decode_hdl->dynamic.consumer_time);
+    stats->consumer_time_max_us = decode_hdl->dynamic.consumer_time.max_us;
+    UVC_EXIT_CRITICAL();
+    return ESP_OK;
+}
@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Built-in JPEG decoder backends for the decode pipeline
+
+#include <stdlib.h>
+
+#include "esp_check.h"
+#include "usb/uvc_host_decode.h"
+#include "uvc_check_priv.h"
+
+#if UVC_HOST_HW_JPEG_DECODER_SUPPORTED
+#include "driver/jpeg_decode.h"
+#endif
+#if UVC_HOST_SW_JPEG_DECODER_SUPPORTED
+#include "jpeg_decoder.h"
+#endif
+
+static const char *TAG = "uvc-jpeg";
+
+#if UVC_HOST_HW_JPEG_DECODER_SUPPORTED
+#define UVC_HW_JPEG_TIMEOUT_MS (100)
+
+typedef struct {
+    uvc_host_decoder_t base;                  // Must be first
+    jpeg_decoder_handle_t engine;
+    jpeg_decode_cfg_t decode_cfg;
+} uvc_hw_jpeg_decoder_t;
+
+static esp_err_t uvc_hw_jpeg_decode(uvc_host_decoder_t *decoder, const uvc_host_frame_t *in, uvc_host_decoded_frame_t *out)
+{
+    uvc_hw_jpeg_decoder_t *hw = (uvc_hw_jpeg_decoder_t *)decoder;
+    jpeg_decode_picture_info_t info;
+    ESP_RETURN_ON_ERROR(jpeg_decoder_get_info(in->data, in->data_len, &info), TAG, "Invalid JPEG header");
+
+    uint32_t out_len = 0;
+    ESP_RETURN_ON_ERROR(
+        jpeg_decoder_process(hw->engine, &hw->decode_cfg, in->data, in->data_len, out->data, out->data_buffer_len, &out_len),
+        TAG, "Decoding failed");
+    out->width = info.width;
+    out->height = info.height;
+    out->data_len = out_len;
+    return ESP_OK;
+}
+
+static void *uvc_hw_jpeg_alloc_output(uvc_host_decoder_t *decoder, size_t size)
+{
+    // The JPEG DMA needs cache-line aligned output buffers
+    const jpeg_decode_memory_alloc_cfg_t mem_cfg = {
+        .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
+    };
+    size_t allocated_size;
+    return jpeg_alloc_decoder_mem(size, &mem_cfg, &allocated_size);
+}
+
+static void uvc_hw_jpeg_del(uvc_host_decoder_t *decoder)
+{
+    uvc_hw_jpeg_decoder_t *hw = (uvc_hw_jpeg_decoder_t *)decoder;
+    jpeg_del_decoder_engine(hw->engine);
+    free(hw);
+}
+
+esp_err_t uvc_host_decoder_new_hw_jpeg(const uvc_host_jpeg_decoder_config_t *config, uvc_host_decoder_t **decoder_ret)
+{
+    UVC_CHECK(config && decoder_ret, ESP_ERR_INVALID_ARG);
+    esp_err_t ret;
+
+    uvc_hw_jpeg_decoder_t *hw = calloc(1, sizeof(uvc_hw_jpeg_decoder_t));
+    UVC_CHECK(hw, ESP_ERR_NO_MEM);
+
+    const jpeg_decode_engine_cfg_t engine_cfg = {
+        .intr_priority = 0,
+        .timeout_ms = UVC_HW_JPEG_TIMEOUT_MS,
+    };
+    ESP_GOTO_ON_ERROR(jpeg_new_decoder_engine(&engine_cfg, &hw->engine), err, TAG, "Could not create JPEG decoder engine");
+
+    hw->decode_cfg.output_format = (config->out_format == UVC_HOST_JPEG_OUT_RGB888) ? JPEG_DECODE_OUT_FORMAT_RGB888 : JPEG_DECODE_OUT_FORMAT_RGB565;
+    hw->decode_cfg.rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR;
+    hw->decode_cfg.conv_std = JPEG_YUV_RGB_CONV_STD_BT601;
+    hw->base.decode = uvc_hw_jpeg_decode;
+    hw->base.alloc_output = uvc_hw_jpeg_alloc_output;
+    hw->base.del = uvc_hw_jpeg_del;
+    *decoder_ret = &hw->base;
+    return ESP_OK;
+
+err:
+    free(hw);
+    return ret;
+}
+#endif // UVC_HOST_HW_JPEG_DECODER_SUPPORTED
+
+#if UVC_HOST_SW_JPEG_DECODER_SUPPORTED
+#define UVC_SW_JPEG_WORKING_BUFFER_SIZE (4000) // Default esp_jpeg working buffer is too small for some cameras
+
+typedef struct {
+    uvc_host_decoder_t base;                  // Must be first
+    uvc_host_jpeg_out_format_t out_format;
+    bool swap_color_bytes;
+    uint8_t working_buffer[UVC_SW_JPEG_WORKING_BUFFER_SIZE];
+} uvc_sw_jpeg_decoder_t;
+
+static esp_err_t uvc_sw_jpeg_decode(uvc_host_decoder_t *decoder, const uvc_host_frame_t *in, uvc_host_decoded_frame_t *out)
+{
+    uvc_sw_jpeg_decoder_t *sw = (uvc_sw_jpeg_decoder_t *)decoder;
+    esp_jpeg_image_cfg_t jpeg_cfg = {
+        .indata = in->data,
+        .indata_size = in->data_len,
+        .outbuf = out->data,
+        .outbuf_size = out->data_buffer_len,
+        .out_format = (sw->out_format == UVC_HOST_JPEG_OUT_RGB888) ? JPEG_IMAGE_FORMAT_RGB888 : JPEG_IMAGE_FORMAT_RGB565,
+        .out_scale = JPEG_IMAGE_SCALE_0,
+        .flags = {
+            .swap_color_bytes = sw->swap_color_bytes,
+        },
+        .advanced = {
+            .working_buffer = sw->working_buffer,
+            .working_buffer_size = sizeof(sw->working_buffer),
+        },
+    };
+    esp_jpeg_image_output_t img;
+    ESP_RETURN_ON_ERROR(esp_jpeg_decode(&jpeg_cfg, &img), TAG, "Decoding failed");
+
+    const size_t bytes_per_pixel = (sw->out_format == UVC_HOST_JPEG_OUT_RGB888) ? 3 : 2;
+    out->width = img.width;
+    out->height = img.height;
+    out->data_len = (size_t)img.width * img.height * bytes_per_pixel;
+    return ESP_OK;
+}
+
+static void uvc_sw_jpeg_del(uvc_host_decoder_t *decoder)
+{
+    free(decoder);
+}
+
+esp_err_t uvc_host_decoder_new_sw_jpeg(const uvc_host_jpeg_decoder_config_t *config, uvc_host_decoder_t **decoder_ret)
+{
+    UVC_CHECK(config && decoder_ret, ESP_ERR_INVALID_ARG);
+    uvc_sw_jpeg_decoder_t *sw = calloc(1, sizeof(uvc_sw_jpeg_decoder_t));
+    UVC_CHECK(sw, ESP_ERR_NO_MEM);
+
+    sw->out_format = config->out_format;
+    sw->swap_color_bytes = config->swap_color_bytes;
+    sw->base.decode = uvc_sw_jpeg_decode;
+    sw->base.alloc_output = NULL;
+    sw->base.del = uvc_sw_jpeg_del;
+    *decoder_ret = &sw->base;
+    return ESP_OK;
+}
+#endif // UVC_HOST_SW_JPEG_DECODER_SUPPORTED
@@ -110,6 +110,82 @@ esp_err_t uvc_desc_get_streaming_intf_and_ep(
     return ret;
 }
 
+esp_err_t uvc_desc_get_streaming_intf_and_ep_for_payload(
+    const usb_config_desc_t *cfg_desc,
+    uint8_t bInterfaceNumber,
+    uint32_t dwMaxPayloadTransferSize,
+    uint16_t max_mps,
+    const usb_intf_desc_t **intf_desc_ret,
+    const usb_ep_desc_t **ep_desc_ret)
+{
+    UVC_CHECK(cfg_desc && intf_desc_ret && ep_desc_ret, ESP_ERR_INVALID_ARG);
+
+    // Payload size is unknown: fall back to the largest alternate setting
+    if (dwMaxPayloadTransferSize == 0) {
+        return uvc_desc_get_streaming_intf_and_ep(cfg_desc, bInterfaceNumber, max_mps, intf_desc_ret, ep_desc_ret);
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    int offset = 0;
+    bool payload_covered = false;
+    uint16_t best_mps = 0;
+
+    const uint8_t num_of_alternate = usb_parse_interface_number_of_alternate(cfg_desc, bInterfaceNumber);
+    for (int i = 0; i <= num_of_alternate; i++) {
+        const usb_intf_desc_t *intf_desc = usb_parse_interface_descriptor(cfg_desc, bInterfaceNumber, i, &offset);
+        UVC_CHECK(intf_desc, ESP_ERR_NOT_FOUND);
+        UVC_CHECK(intf_desc->bInterfaceClass == USB_CLASS_VIDEO, ESP_ERR_NOT_FOUND);
+        UVC_CHECK(intf_desc->bInterfaceSubClass == UVC_SC_VIDEOSTREAMING, ESP_ERR_NOT_FOUND);
+        if (intf_desc->bNumEndpoints == 0 && i == 0) {
+            continue; // This is Alternate setting 0 for ISOC cameras.
+        }
+        UVC_CHECK(intf_desc->bNumEndpoints == 1, ESP_ERR_NOT_FOUND); // Only 1 endpoint is expected
+
+        const usb_ep_desc_t *ep_desc = usb_parse_endpoint_descriptor_by_index(intf_desc, 0, cfg_desc->wTotalLength, &offset);
+        UVC_CHECK(ep_desc, ESP_ERR_NOT_FOUND);
+
+        const uint16_t current_mps = USB_EP_DESC_GET_MPS(ep_desc) * (USB_EP_DESC_GET_MULT(ep_desc) + 1);
+        if (current_mps > max_mps) {
+            continue; // Does not fit in the IN FIFO
+        }
+
+        // Prefer the smallest MPS that covers the payload. Until one is found, keep the largest MPS seen so far.
+        const bool covers = (current_mps >= dwMaxPayloadTransferSize);
+        bool better;
+        if (covers) {
+            better = !payload_covered || current_mps < best_mps;
+        } else {
+            better = !payload_covered && current_mps >= best_mps;
+        }
+        if (better) {
+            payload_covered = covers;
+            best_mps = current_mps;
+            *ep_desc_ret = ep_desc;
+            *intf_desc_ret = intf_desc;
+            ret = ESP_OK;
+        }
+    }
+
+    return ret;
+}
+
+uint32_t uvc_desc_get_periodic_bus_time_ns(const usb_ep_desc_t *ep_desc, bool high_speed)
+{
+    UVC_CHECK(ep_desc, 0);
+    if (USB_EP_DESC_GET_XFERTYPE(ep_desc) != USB_BM_ATTRIBUTES_XFER_ISOC) {
+        return 0; // Bulk endpoints do not reserve periodic bandwidth
+    }
+
+    // Isochronous bInterval is always an exponent: the endpoint is serviced every 2^(bInterval-1) (micro)frames
+    uint8_t interval_exp = ep_desc->bInterval;
+    interval_exp = (interval_exp == 0) ? 0 : (interval_exp > 16 ? 15 : interval_exp - 1);
+
+    const uint64_t bytes_per_interval = USB_EP_DESC_GET_MPS(ep_desc) * (USB_EP_DESC_GET_MULT(ep_desc) + 1);
+    const uint64_t bytes_per_frame = (high_speed ? bytes_per_interval * 8 : bytes_per_interval) >> interval_exp;
+    const uint64_t bus_bytes_per_frame = high_speed ? UVC_DESC_HS_BYTES_PER_FRAME : UVC_DESC_FS_BYTES_PER_FRAME;
+    return (uint32_t)((bytes_per_frame * 1000000ULL + bus_bytes_per_frame - 1) / bus_bytes_per_frame);
+}
+
 /**
  * @brief Check if this descriptor is Format descriptor
  *
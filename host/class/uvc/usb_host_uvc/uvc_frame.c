@@ -15,12 +15,15 @@
 #include "uvc_frame_priv.h"
 #include "uvc_types_priv.h"
 #include "uvc_check_priv.h"
+#include "uvc_critical_priv.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 
 static const char *TAG = "uvc-frame";
 
+#define UVC_FRAME_POOL_DEFAULT_GROW_STEP (16 * 1024)
+
 esp_err_t uvc_host_frame_return(uvc_host_stream_hdl_t stream_hdl, uvc_host_frame_t *frame)
 {
     UVC_CHECK(stream_hdl && frame, ESP_ERR_INVALID_ARG);
@@ -31,6 +34,43 @@ esp_err_t uvc_host_frame_return(uvc_host_stream_hdl_t stream_hdl, uvc_host_frame
     return ESP_OK;
 }
 
+esp_err_t uvc_host_frame_pool_create(const uvc_host_frame_pool_config_t *config, uvc_host_frame_pool_hdl_t *pool_hdl_ret)
+{
+    UVC_CHECK(config && pool_hdl_ret, ESP_ERR_INVALID_ARG);
+    UVC_CHECK(config->pool_size > 0, ESP_ERR_INVALID_ARG);
+
+    uvc_host_frame_pool_hdl_t pool = calloc(1, sizeof(struct uvc_host_frame_pool_s));
+    UVC_CHECK(pool, ESP_ERR_NO_MEM);
+    pool->size = config->pool_size;
+    pool->grow_step = config->grow_step ? config->grow_step : UVC_FRAME_POOL_DEFAULT_GROW_STEP;
+    pool->initial_frame_size = config->initial_frame_size ? config->initial_frame_size : pool->grow_step;
+    pool->heap_caps = config->heap_caps ? config->heap_caps : MALLOC_CAP_DEFAULT;
+    *pool_hdl_ret = pool;
+    return ESP_OK;
+}
+
+esp_err_t uvc_host_frame_pool_delete(uvc_host_frame_pool_hdl_t pool_hdl)
+{
+    UVC_CHECK(pool_hdl, ESP_ERR_INVALID_ARG);
+    UVC_CHECK(UVC_ATOMIC_LOAD(pool_hdl->stream_count) == 0, ESP_ERR_INVALID_STATE);
+    free(pool_hdl);
+    return ESP_OK;
+}
+
+esp_err_t uvc_host_frame_pool_usage_get(uvc_host_frame_pool_hdl_t pool_hdl, size_t *used, size_t *peak)
+{
+    UVC_CHECK(pool_hdl, ESP_ERR_INVALID_ARG);
+    UVC_ENTER_CRITICAL();
+    if (used) {
+        *used = pool_hdl->used;
+    }
+    if (peak) {
+        *peak = pool_hdl->peak;
+    }
+    UVC_EXIT_CRITICAL();
+    return ESP_OK;
+}
+
 esp_err_t uvc_frame_allocate(uvc_stream_t *uvc_stream, int nb_of_fb, size_t fb_size, uint32_t fb_caps, uint8_t **user_frame_buffers)
 {
     UVC_CHECK(uvc_stream, ESP_ERR_INVALID_ARG);
@@ -39,10 +79,18 @@ esp_err_t uvc_frame_allocate(uvc_stream_t *uvc_stream, int nb_of_fb, size_t fb_s
     // Determine if we're using user-provided buffers
     const bool using_user_buffers = (user_frame_buffers != NULL);
     uvc_stream->constant.user_provided_fb = using_user_buffers;
+    uvc_stream->constant.frame_size = fb_size;
+    uvc_host_frame_pool_hdl_t pool = uvc_stream->constant.frame_pool;
+    UVC_CHECK(!(pool && using_user_buffers), ESP_ERR_INVALID_ARG);
 
     // We will be passing the frame buffers by reference
     uvc_stream->constant.empty_fb_queue = xQueueCreate(nb_of_fb, sizeof(uvc_host_frame_t *));
     UVC_CHECK(uvc_stream->constant.empty_fb_queue, ESP_ERR_NO_MEM);
+    if (pool) {
+        UVC_ENTER_CRITICAL();
+        pool->stream_count++; // Released in uvc_frame_free()
+        UVC_EXIT_CRITICAL();
+    }
 
     for (int i = 0; i < nb_of_fb; i++) {
         // Allocate the frame buffer
@@ -54,7 +102,11 @@ esp_err_t uvc_frame_allocate(uvc_stream_t *uvc_stream, int nb_of_fb, size_t fb_s
         }
 
         uint8_t *this_data = NULL;
-        if (using_user_buffers) {
+        size_t this_data_len = fb_size;
+        if (pool) {
+            // Frame data are allocated from the pool on demand, see uvc_frame_grow()
+            this_data_len = 0;
+        } else if (using_user_buffers) {
             // Use user-provided buffer (already validated in uvc_host_stream_open)
             this_data = user_frame_buffers[i];
         } else {
@@ -73,7 +125,7 @@ esp_err_t uvc_frame_allocate(uvc_stream_t *uvc_stream, int nb_of_fb, size_t fb_s
 
         // Set members to default
         this_fb->data = this_data;
-        this_fb->data_buffer_len = fb_size;
+        this_fb->data_buffer_len = this_data_len;
         this_fb->data_len = 0;
 
         // Add the frame to Queue of empty frames
@@ -94,16 +146,28 @@ void uvc_frame_free(uvc_stream_t *uvc_stream)
     }
 
     // Free all Frame Buffers and the Queue itself
+    uvc_host_frame_pool_hdl_t pool = uvc_stream->constant.frame_pool;
     uvc_host_frame_t *this_fb;
     while (xQueueReceive(uvc_stream->constant.empty_fb_queue, &this_fb, 0) == pdPASS) {
         // Only free the data buffer if it was allocated by the driver (not user-provided)
         if (!uvc_stream->constant.user_provided_fb) {
             free(this_fb->data);
         }
+        if (pool) {
+            UVC_ENTER_CRITICAL();
+            pool->used -= this_fb->data_buffer_len;
+            UVC_EXIT_CRITICAL();
+        }
         free(this_fb);
     }
     vQueueDelete(uvc_stream->constant.empty_fb_queue);
     uvc_stream->constant.empty_fb_queue = NULL;
+
+    if (pool) {
+        UVC_ENTER_CRITICAL();
+        pool->stream_count--;
+        UVC_EXIT_CRITICAL();
+    }
 }
 
 bool uvc_frame_are_all_returned(uvc_stream_t *uvc_stream)
@@ -128,19 +192,213 @@ uvc_host_frame_t *uvc_frame_get_empty(uvc_stream_t *uvc_stream)
     }
 }
 
-esp_err_t uvc_frame_add_data(uvc_host_frame_t *frame, const uint8_t *data, size_t data_len)
+/**
+ * @brief Grow pool frame buffer so it can hold at least 'required_len' bytes
+ *
+ * @param[in] uvc_stream   UVC stream
+ * @param[in] frame        Frame buffer of this stream
+ * @param[in] required_len Required frame buffer length
+ * @return
+ *     - ESP_OK: Frame buffer can hold required_len bytes
+ *     - ESP_ERR_INVALID_SIZE: Stream does not use pool, required length exceeds maximum frame size or pool is exhausted
+ *     - ESP_ERR_NO_MEM: Not enough heap memory
+ */
+static esp_err_t uvc_frame_grow(uvc_stream_t *uvc_stream, uvc_host_frame_t *frame, size_t required_len)
+{
+    uvc_host_frame_pool_hdl_t pool = uvc_stream->constant.frame_pool;
+    if (!pool || required_len > uvc_stream->constant.frame_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t new_len = (required_len + pool->grow_step - 1) / pool->grow_step * pool->grow_step;
+    if (new_len < pool->initial_frame_size) {
+        new_len = pool->initial_frame_size;
+    }
+    if (new_len > uvc_stream->constant.frame_size) {
+        new_len = uvc_stream->constant.frame_size;
+    }
+    const size_t increment = new_len - frame->data_buffer_len;
+
+    // Reserve memory from the pool budget first, so concurrent streams cannot exceed it
+    UVC_ENTER_CRITICAL();
+    if (pool->used + increment > pool->size) {
+        UVC_EXIT_CRITICAL();
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pool->used += increment;
+    if (pool->used > pool->peak) {
+        pool->peak = pool->used;
+    }
+    UVC_EXIT_CRITICAL();
+
+    uint8_t *new_data = heap_caps_realloc(frame->data, new_len, pool->heap_caps);
+    if (new_data == NULL) {
+        UVC_ENTER_CRITICAL();
+        pool->used -= increment;
+        UVC_EXIT_CRITICAL();
+        ESP_LOGW(TAG, "Not enough memory to grow frame buffer to %zu", new_len);
+        return ESP_ERR_NO_MEM;
+    }
+    frame->data = new_data;
+    frame->data_buffer_len = new_len;
+    return ESP_OK;
+}
+
+esp_err_t uvc_frame_add_data(uvc_stream_t *uvc_stream, uvc_host_frame_t *frame, const uint8_t *data, size_t data_len)
 {
     if (data_len == 0) {
         return ESP_OK; // Fast return in case of zero data
     }
-    UVC_CHECK(frame && data, ESP_ERR_INVALID_ARG);
-    UVC_CHECK(frame->data_len + data_len <= frame->data_buffer_len, ESP_ERR_INVALID_SIZE);
+    UVC_CHECK(uvc_stream && frame && data, ESP_ERR_INVALID_ARG);
+    if (frame->data_len + data_len > frame->data_buffer_len) {
+        const esp_err_t ret = uvc_frame_grow(uvc_stream, frame, frame->data_len + data_len);
+        UVC_CHECK(ret == ESP_OK, ret);
+    }
 
     memcpy(frame->data + frame->data_len, data, data_len);
     frame->data_len += data_len;
     return ESP_OK;
 }
 
+void uvc_frame_buffer_event(uvc_stream_t *uvc_stream, enum uvc_host_dev_event type)
+{
+    UVC_ENTER_CRITICAL();
+    if (type == UVC_HOST_FRAME_BUFFER_UNDERFLOW) {
+        uvc_stream->stats.underflow_count++;
+    } else {
+        uvc_stream->stats.overflow_count++;
+    }
+    UVC_EXIT_CRITICAL();
+
+    uvc_host_stream_callback_t stream_cb = uvc_stream->constant.stream_cb;
+    if (stream_cb) {
+        const uvc_host_stream_event_data_t event = {
+            .type = type,
+        };
+        stream_cb(&event, uvc_stream->constant.cb_arg);
+    }
+}
+
+void uvc_frame_payload_time_update(uvc_stream_t *uvc_stream, const uvc_payload_header_t *hdr, int64_t host_time_us, bool start_of_frame)
+{
+    // Optional header fields follow bmHeaderInfo in this order: PTS (4 bytes), SCR (4 bytes STC + 2 bytes SOF counter)
+    // They are little-endian and not aligned
+    const uint8_t *field = (const uint8_t *)hdr + sizeof(uvc_payload_header_t);
+    uvc_host_payload_time_t *time = &uvc_stream->single_thread.last_payload;
+    time->host_time_us = host_time_us;
+    time->has_pts = hdr->bmHeaderInfo.presentation_time;
+    time->has_scr = hdr->bmHeaderInfo.source_clock_reference;
+    if (time->has_pts) {
+        time->pts = field[0] | (field[1] << 8) | (field[2] << 16) | ((uint32_t)field[3] << 24);
+        field += 4;
+    }
+    if (time->has_scr) {
+        time->scr_stc = field[0] | (field[1] << 8) | (field[2] << 16) | ((uint32_t)field[3] << 24);
+        time->scr_sof = (field[4] | (field[5] << 8)) & 0x07FF;
+    }
+    if (start_of_frame) {
+        uvc_stream->single_thread.first_payload = *time;
+    }
+}
+
+void uvc_frame_stats_update(uvc_stream_t *uvc_stream, uvc_host_frame_t *frame, bool frame_valid)
+{
+    if (!frame_valid) {
+        UVC_ENTER_CRITICAL();
+        uvc_stream->stats.frames_dropped++;
+        uvc_stream->stats.prev_frame_start_us = 0;
+        UVC_EXIT_CRITICAL();
+        return;
+    }
+
+    frame->first_payload = uvc_stream->single_thread.first_payload;
+    frame->last_payload = uvc_stream->single_thread.last_payload;
+    const int64_t start_us = frame->first_payload.host_time_us;
+    const uint32_t assembly_us = (uint32_t)(frame->last_payload.host_time_us - start_us);
+
+    UVC_ENTER_CRITICAL();
+    uvc_stream->stats.frames_delivered++;
+    uvc_stream->stats.assembly_sum_us += assembly_us;
+    if (assembly_us > uvc_stream->stats.assembly_max_us) {
+        uvc_stream->stats.assembly_max_us = assembly_us;
+    }
+    if (uvc_stream->stats.prev_frame_start_us != 0) {
+        const uint32_t interval_us = (uint32_t)(start_us - uvc_stream->stats.prev_frame_start_us);
+        uvc_stream->stats.interval_sum_us += interval_us;
+        uvc_stream->stats.interval_count++;
+        if (interval_us > uvc_stream->stats.interval_max_us) {
+            uvc_stream->stats.interval_max_us = interval_us;
+        }
+        if (uvc_stream->stats.prev_interval_us != 0) {
+            // J = J + (|D| - J) / 16, kept in 1/16 us to avoid losing precision
+            const int32_t d = (int32_t)(interval_us - uvc_stream->stats.prev_interval_us);
+            const uint32_t abs_d = (d < 0) ? -d : d;
+            uvc_stream->stats.jitter_q4 += abs_d - ((uvc_stream->stats.jitter_q4 + 8) >> 4);
+        }
+        uvc_stream->stats.prev_interval_us = interval_us;
+    }
+    uvc_stream->stats.prev_frame_start_us = start_us;
+    UVC_EXIT_CRITICAL();
+}
+
+static void uvc_frame_chunk_call(uvc_stream_t *uvc_stream, const uint8_t *data, size_t data_len, uint8_t flags)
+{
+    const size_t offset = uvc_stream->single_thread.chunk_offset;
+    const uvc_host_frame_chunk_t chunk = {
+        .data = data,
+        .data_len = data_len,
+        .offset = offset,
+        .frame_id = uvc_stream->single_thread.chunk_frame_id,
+        .flags = flags | (offset == 0 ? UVC_HOST_CHUNK_FLAG_SOF : 0),
+    };
+    uvc_stream->constant.chunk_cb(&chunk, uvc_stream->constant.cb_arg);
+    uvc_stream->single_thread.chunk_offset = offset + data_len;
+}
+
+static void uvc_frame_chunk_abort(uvc_stream_t *uvc_stream)
+{
+    // Only frames that the user already received a part of must be terminated
+    if (uvc_stream->single_thread.chunk_offset > 0) {
+        uvc_frame_chunk_call(uvc_stream, NULL, 0, UVC_HOST_CHUNK_FLAG_EOF | UVC_HOST_CHUNK_FLAG_ERROR);
+    }
+    uvc_stream->single_thread.chunk_offset = 0;
+}
+
+void uvc_frame_chunk_start(uvc_stream_t *uvc_stream)
+{
+    if (uvc_stream->constant.chunk_cb) {
+        uvc_frame_chunk_abort(uvc_stream);
+    }
+    uvc_stream->single_thread.chunk_frame_id++;
+}
+
+void uvc_frame_chunk_deliver(uvc_stream_t *uvc_stream)
+{
+    if (!uvc_stream->constant.chunk_cb || uvc_stream->single_thread.skip_current_frame) {
+        return;
+    }
+    const uvc_host_frame_t *frame = UVC_ATOMIC_LOAD(uvc_stream->dynamic.current_frame);
+    if (!frame || frame->data_len <= uvc_stream->single_thread.chunk_offset) {
+        return;
+    }
+    const size_t offset = uvc_stream->single_thread.chunk_offset;
+    uvc_frame_chunk_call(uvc_stream, frame->data + offset, frame->data_len - offset, 0);
+}
+
+void uvc_frame_chunk_end(uvc_stream_t *uvc_stream, const uvc_host_frame_t *frame, bool frame_valid)
+{
+    if (!uvc_stream->constant.chunk_cb) {
+        return;
+    }
+    const size_t offset = uvc_stream->single_thread.chunk_offset;
+    if (!frame || !frame_valid || frame->data_len < offset) {
+        uvc_frame_chunk_abort(uvc_stream);
+        return;
+    }
+    uvc_frame_chunk_call(uvc_stream, frame->data + offset, frame->data_len - offset, UVC_HOST_CHUNK_FLAG_EOF);
+    uvc_stream->single_thread.chunk_offset = 0;
+}
+
 void uvc_frame_format_update(uvc_stream_t *uvc_stream, const uvc_host_stream_format_t *vs_format)
 {
     uvc_host_frame_t *this_frame = uvc_frame_get_empty(uvc_stream);
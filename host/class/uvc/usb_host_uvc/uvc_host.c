@@ -42,6 +42,9 @@ portMUX_TYPE uvc_lock = portMUX_INITIALIZER_UNLOCKED;
 #define UVC_TEARDOWN          BIT1 // UVC is being uninstalled
 #define UVC_TEARDOWN_COMPLETE BIT2 // UVC uninstall finished
 
+// Periodic bus time available to all UVC ISOC streams, in nanoseconds per 1 ms frame
+#define UVC_PERIODIC_BUS_TIME_BUDGET_NS (CONFIG_UVC_PERIODIC_BANDWIDTH_PERCENT * 10000)
+
 // Transfer callbacks
 static void ctrl_xfer_cb(usb_transfer_t *transfer);
 void isoc_transfer_callback(usb_transfer_t *transfer);
@@ -56,6 +59,7 @@ typedef struct {
     SemaphoreHandle_t ctrl_mutex;               /*!< CTRL mutex */
     uvc_host_driver_event_callback_t user_cb;   /*!< Callback function to handle events */
     void *user_ctx;
+    uint32_t periodic_bus_time_ns;              /*!< Bus time per 1 ms frame reserved by open ISOC streams. Protected by open_close_mutex */
     SLIST_HEAD(list_dev, uvc_host_stream_s) uvc_stream_list;   /*!< List of open streams */
 } uvc_host_driver_t;
 
@@ -439,6 +443,7 @@ err:
 static void uvc_device_remove(uvc_stream_t *uvc_stream)
 {
     assert(uvc_stream);
+    p_uvc_host_driver->periodic_bus_time_ns -= uvc_stream->constant.periodic_bus_time_ns;
     uvc_transfers_free(uvc_stream);
     uvc_frame_free(uvc_stream);
     // We don't check the error code of usb_host_device_close, as the close might fail, if someone else is still using the device (not all interfaces are released)
@@ -561,21 +566,22 @@ static inline esp_err_t uvc_set_interface(uvc_host_stream_hdl_t stream_hdl, bool
 }
 
 /**
- * @brief Find and claim interface for selected frame format
+ * @brief Find streaming interface for selected frame format
+ *
+ * The alternate setting is not selected here, because it depends on the result of format negotiation.
+ * bAlternateSetting is set to the largest alternate setting, so the caller can tell ISOC (non-zero) and BULK (zero) streams apart.
  *
  * @param[in]  uvc_stream  Pointer to UVC stream
  * @param[in]  uvc_index   Index of UVC function you want to use
  * @param[in]  vs_format   Desired frame format
- * @param[out] ep_desc_ret EP descriptor for this stream
  * @return
- *     - ESP_OK:              Success, interface found and claimed
+ *     - ESP_OK:              Success, interface found
  *     - ESP_ERR_INVALID_ARG: Input parameter is NULL
  *     - ESP_ERR_NOT_FOUND:   Selected format was not found
- *     - Other:               Error during interface claim
  */
-static esp_err_t uvc_claim_interface(uvc_stream_t *uvc_stream, uint8_t uvc_index, const uvc_host_stream_format_t *vs_format, const usb_ep_desc_t **ep_desc_ret)
+static esp_err_t uvc_find_interface(uvc_stream_t *uvc_stream, uint8_t uvc_index, const uvc_host_stream_format_t *vs_format)
 {
-    UVC_CHECK(uvc_stream && vs_format && ep_desc_ret, ESP_ERR_INVALID_ARG);
+    UVC_CHECK(uvc_stream && vs_format, ESP_ERR_INVALID_ARG);
 
     const usb_config_desc_t *cfg_desc;
     const usb_intf_desc_t *intf_desc;
@@ -595,11 +601,96 @@ static esp_err_t uvc_claim_interface(uvc_stream_t *uvc_stream, uint8_t uvc_index
         uvc_desc_get_streaming_intf_and_ep(cfg_desc, bInterfaceNumber, MAX_MPS_IN, &intf_desc, &ep_desc),
         TAG, "Could not find Streaming interface %d", bInterfaceNumber);
 
-    // Save all constant information about the UVC stream
     uvc_stream->constant.bInterfaceNumber  = bInterfaceNumber;
     uvc_stream->constant.bcdUVC            = bcdUVC;
     uvc_stream->constant.bAlternateSetting = intf_desc->bAlternateSetting;
+    return ESP_OK;
+}
+
+/**
+ * @brief Reserve periodic bus time for the selected alternate setting
+ *
+ * If the alternate setting does not fit in the remaining budget and CONFIG_UVC_PERIODIC_BANDWIDTH_DOWNGRADE is enabled,
+ * smaller alternate settings are tried.
+ *
+ * @param[in]    uvc_stream Pointer to UVC stream
+ * @param[in]    cfg_desc   Active configuration descriptor
+ * @param[inout] intf_desc  Selected interface descriptor. Updated on downgrade
+ * @param[inout] ep_desc    Selected endpoint descriptor. Updated on downgrade
+ * @return
+ *     - ESP_OK:                Success, bus time reserved
+ *     - ESP_ERR_INVALID_SIZE:  Not enough periodic bandwidth left for this stream
+ */
+static esp_err_t uvc_periodic_bandwidth_reserve(uvc_stream_t *uvc_stream, const usb_config_desc_t *cfg_desc,
+                                                const usb_intf_desc_t **intf_desc, const usb_ep_desc_t **ep_desc)
+{
+    usb_device_info_t dev_info;
+    ESP_RETURN_ON_ERROR(usb_host_device_info(uvc_stream->constant.dev_hdl, &dev_info), TAG, "Could not get device info");
+    const bool high_speed = (dev_info.speed == USB_SPEED_HIGH);
+    const uint32_t available = UVC_PERIODIC_BUS_TIME_BUDGET_NS - p_uvc_host_driver->periodic_bus_time_ns;
+    uint32_t bus_time = uvc_desc_get_periodic_bus_time_ns(*ep_desc, high_speed);
+
+#ifdef CONFIG_UVC_PERIODIC_BANDWIDTH_DOWNGRADE
+    while (bus_time > available) {
+        const uint16_t mps = USB_EP_DESC_GET_MPS(*ep_desc) * (USB_EP_DESC_GET_MULT(*ep_desc) + 1);
+        if (ESP_OK != uvc_desc_get_streaming_intf_and_ep(cfg_desc, uvc_stream->constant.bInterfaceNumber, mps - 1, intf_desc, ep_desc)) {
+            break; // No smaller alternate setting
+        }
+        ESP_LOGW(TAG, "Downgrading interface %d to alternate setting %d, MPS %d: not enough periodic bandwidth",
+                 (*intf_desc)->bInterfaceNumber, (*intf_desc)->bAlternateSetting,
+                 USB_EP_DESC_GET_MPS(*ep_desc) * (USB_EP_DESC_GET_MULT(*ep_desc) + 1));
+        bus_time = uvc_desc_get_periodic_bus_time_ns(*ep_desc, high_speed);
+    }
+#endif // CONFIG_UVC_PERIODIC_BANDWIDTH_DOWNGRADE
+
+    if (bus_time > available) {
+        ESP_LOGE(TAG, "Not enough periodic bandwidth: stream needs %"PRIu32" ns/frame, %"PRIu32" ns/frame left",
+                 bus_time, available);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    p_uvc_host_driver->periodic_bus_time_ns += bus_time;
+    uvc_stream->constant.periodic_bus_time_ns = bus_time;
+    ESP_LOGD(TAG, "Reserved %"PRIu32" ns/frame of periodic bandwidth, %"PRIu32" ns/frame in total",
+             bus_time, p_uvc_host_driver->periodic_bus_time_ns);
+    return ESP_OK;
+}
+
+/**
+ * @brief Select alternate setting for negotiated payload size and claim the interface
+ *
+ * @param[in]  uvc_stream               Pointer to UVC stream. The streaming interface must be found by uvc_find_interface()
+ * @param[in]  dwMaxPayloadTransferSize Payload size negotiated with the device
+ * @param[out] ep_desc_ret              EP descriptor for this stream
+ * @return
+ *     - ESP_OK:               Success, interface claimed
+ *     - ESP_ERR_INVALID_ARG:  Input parameter is NULL
+ *     - ESP_ERR_NOT_FOUND:    No alternate setting fits in the IN FIFO
+ *     - ESP_ERR_INVALID_SIZE: Not enough periodic bandwidth left for this stream
+ *     - Other:                Error during interface claim
+ */
+static esp_err_t uvc_claim_interface(uvc_stream_t *uvc_stream, uint32_t dwMaxPayloadTransferSize, const usb_ep_desc_t **ep_desc_ret)
+{
+    UVC_CHECK(uvc_stream && ep_desc_ret, ESP_ERR_INVALID_ARG);
+
+    const usb_config_desc_t *cfg_desc;
+    const usb_intf_desc_t *intf_desc;
+    const usb_ep_desc_t *ep_desc;
+    ESP_ERROR_CHECK(usb_host_get_active_config_descriptor(uvc_stream->constant.dev_hdl, &cfg_desc));
+
+    ESP_RETURN_ON_ERROR(
+        uvc_desc_get_streaming_intf_and_ep_for_payload(cfg_desc, uvc_stream->constant.bInterfaceNumber, dwMaxPayloadTransferSize, MAX_MPS_IN, &intf_desc, &ep_desc),
+        TAG, "Could not find Streaming interface %d", uvc_stream->constant.bInterfaceNumber);
+    ESP_RETURN_ON_ERROR(
+        uvc_periodic_bandwidth_reserve(uvc_stream, cfg_desc, &intf_desc, &ep_desc),
+        TAG,);
+
+    // Save all constant information about the UVC stream
+    uvc_stream->constant.bAlternateSetting = intf_desc->bAlternateSetting;
     uvc_stream->constant.bEndpointAddress  = ep_desc->bEndpointAddress;
+    if (USB_EP_DESC_GET_XFERTYPE(ep_desc) == USB_BM_ATTRIBUTES_XFER_ISOC) {
+        uvc_stream->constant.isoc_payload_size = USB_EP_DESC_GET_MPS(ep_desc) * (USB_EP_DESC_GET_MULT(ep_desc) + 1);
+    }
     *ep_desc_ret                           = ep_desc;
 
     // Claim the interface in USB Host Lib
@@ -792,6 +883,7 @@ esp_err_t uvc_host_stream_open(const uvc_host_stream_config_t *stream_config, in
 
     // Validate user-provided frame buffers configuration
     if (stream_config->advanced.user_frame_buffers != NULL) {
+        UVC_CHECK(stream_config->advanced.frame_pool == NULL, ESP_ERR_INVALID_ARG);
         UVC_CHECK(stream_config->advanced.number_of_frame_buffers > 0, ESP_ERR_INVALID_ARG);
         UVC_CHECK(stream_config->advanced.frame_size > 0, ESP_ERR_INVALID_ARG);
         // Verify that all user-provided buffers are not NULL
@@ -812,12 +904,10 @@ esp_err_t uvc_host_stream_open(const uvc_host_stream_config_t *stream_config, in
         goto not_found;
     }
 
-    // Find the streaming interface and endpoint and claim it
-    const usb_ep_desc_t *ep_desc;
+    // Find the streaming interface. The alternate setting is selected after format negotiation
     ESP_GOTO_ON_ERROR(
-        uvc_claim_interface(uvc_stream, stream_config->usb.uvc_stream_index, &stream_config->vs_format, &ep_desc),
-        claim_err, TAG, "Could not find/claim streaming interface");
-    ESP_LOGD(TAG, "Claimed interface index %d with MPS %d", uvc_stream->constant.bInterfaceNumber, USB_EP_DESC_GET_MPS(ep_desc));
+        uvc_find_interface(uvc_stream, stream_config->usb.uvc_stream_index, &stream_config->vs_format),
+        claim_err, TAG, "Could not find streaming interface");
 
     /*
     * Although not strictly required by the UVC specification, some UVC ISOC
@@ -842,13 +932,22 @@ esp_err_t uvc_host_stream_open(const uvc_host_stream_config_t *stream_config, in
     memcpy(&real_format, &stream_config->vs_format, sizeof(uvc_host_stream_format_t)); // Memcpy to avoid overwriting the original format
     ESP_GOTO_ON_ERROR(
         uvc_host_stream_control_probe(uvc_stream, &real_format, &vs_result),
-        err, TAG, "Failed to negotiate requested Video Stream format");
+        claim_err, TAG, "Failed to negotiate requested Video Stream format");
+
+    // Select the smallest alternate setting that covers the negotiated payload and claim it
+    const usb_ep_desc_t *ep_desc;
+    ESP_GOTO_ON_ERROR(
+        uvc_claim_interface(uvc_stream, vs_result.dwMaxPayloadTransferSize, &ep_desc),
+        claim_err, TAG, "Could not claim streaming interface");
+    ESP_LOGD(TAG, "Claimed interface index %d alt %d with MPS %d for payload %"PRIu32, uvc_stream->constant.bInterfaceNumber,
+             uvc_stream->constant.bAlternateSetting, USB_EP_DESC_GET_MPS(ep_desc), vs_result.dwMaxPayloadTransferSize);
 
     // Allocate USB transfers
     ESP_GOTO_ON_ERROR(
         uvc_transfers_allocate(uvc_stream, stream_config->advanced.number_of_urbs, stream_config->advanced.urb_size, ep_desc),
         err, TAG,);
     // Allocate Frame buffers
+    uvc_stream->constant.frame_pool = stream_config->advanced.frame_pool;
     ESP_GOTO_ON_ERROR(
         uvc_frame_allocate(
             uvc_stream,
@@ -862,6 +961,7 @@ esp_err_t uvc_host_stream_open(const uvc_host_stream_config_t *stream_config, in
     uvc_format_save(uvc_stream, &real_format, vs_result.dwMaxVideoFrameSize);
     uvc_stream->constant.stream_cb = stream_config->event_cb;
     uvc_stream->constant.frame_cb = stream_config->frame_cb;
+    uvc_stream->constant.chunk_cb = stream_config->chunk_cb;
     uvc_stream->constant.cb_arg = stream_config->user_ctx;
 
     // Everything OK, add the device into list
@@ -1013,6 +1113,11 @@ esp_err_t uvc_host_stream_format_select(uvc_host_stream_hdl_t stream_hdl, uvc_ho
     ESP_GOTO_ON_ERROR(
         uvc_host_stream_control_probe(stream_hdl, format, &vs_result),
         bailout, TAG, "Failed to negotiate requested Video Stream format");
+    if (stream_hdl->constant.isoc_payload_size != 0 && vs_result.dwMaxPayloadTransferSize > stream_hdl->constant.isoc_payload_size) {
+        // The alternate setting is selected when the stream is opened. Re-open the stream to select a larger one.
+        ESP_LOGW(TAG, "Payload size %"PRIu32" exceeds MPS %d of the selected alternate setting, frames may be lost",
+                 vs_result.dwMaxPayloadTransferSize, stream_hdl->constant.isoc_payload_size);
+    }
     uvc_format_save(stream_hdl, format, vs_result.dwMaxVideoFrameSize);
 
 bailout:
@@ -1031,6 +1136,32 @@ esp_err_t uvc_host_stream_format_get(uvc_host_stream_hdl_t stream_hdl, uvc_host_
     return ESP_OK;
 }
 
+esp_err_t uvc_host_stream_stats_get(uvc_host_stream_hdl_t stream_hdl, uvc_host_stream_stats_t *stats)
+{
+    UVC_CHECK(stream_hdl && stats, ESP_ERR_INVALID_ARG);
+    UVC_ENTER_CRITICAL();
+    stats->frames_delivered = stream_hdl->stats.frames_delivered;
+    stats->frames_dropped = stream_hdl->stats.frames_dropped;
+    stats->underflow_count = stream_hdl->stats.underflow_count;
+    stats->overflow_count = stream_hdl->stats.overflow_count;
+    stats->frame_interval_avg_us = stream_hdl->stats.interval_count ? (uint32_t)(stream_hdl->stats.interval_sum_us / stream_hdl->stats.interval_count) : 0;
+    stats->frame_interval_max_us = stream_hdl->stats.interval_max_us;
+    stats->frame_interval_jitter_us = stream_hdl->stats.jitter_q4 >> 4;
+    stats->assembly_time_avg_us = stream_hdl->stats.frames_delivered ? (uint32_t)(stream_hdl->stats.assembly_sum_us / stream_hdl->stats.frames_delivered) : 0;
+    stats->assembly_time_max_us = stream_hdl->stats.assembly_max_us;
+    UVC_EXIT_CRITICAL();
+    return ESP_OK;
+}
+
+esp_err_t uvc_host_stream_stats_reset(uvc_host_stream_hdl_t stream_hdl)
+{
+    UVC_CHECK(stream_hdl, ESP_ERR_INVALID_ARG);
+    UVC_ENTER_CRITICAL();
+    memset(&stream_hdl->stats, 0, sizeof(stream_hdl->stats));
+    UVC_EXIT_CRITICAL();
+    return ESP_OK;
+}
+
 esp_err_t uvc_host_buf_info_get(uvc_host_stream_hdl_t stream_hdl, uvc_host_buf_info_t *buf_info)
 {
     UVC_CHECK(stream_hdl && buf_info, ESP_ERR_INVALID_ARG);
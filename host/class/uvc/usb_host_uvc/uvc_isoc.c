@@ -8,6 +8,7 @@
 #include <string.h> // For memcpy
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "uvc_stream.h" // For uvc_host_stream_pause()
 #include "uvc_types_priv.h"
@@ -54,6 +55,7 @@ void isoc_transfer_callback(usb_transfer_t *transfer)
         return; // If the streaming was turned off, we don't have to do anything
     }
 
+    const int64_t arrival_us = esp_timer_get_time();
     const uint8_t *payload = transfer->data_buffer;
     for (int i = 0; i < transfer->num_isoc_packets; i++) {
         usb_isoc_packet_desc_t *isoc_desc = &transfer->isoc_packet_desc[i];
@@ -113,6 +115,7 @@ void isoc_transfer_callback(usb_transfer_t *transfer)
         if (start_of_frame) {
             // We detected start of new frame. Update Frame ID and start fetching this frame
             uvc_stream->single_thread.current_frame_id   = payload_header->bmHeaderInfo.frame_id;
+            uvc_frame_chunk_start(uvc_stream);
 #ifdef CONFIG_UVC_CHECK_PAYLOAD_HEADER_ERR
             uvc_stream->single_thread.skip_current_frame = payload_header->bmHeaderInfo.error;
 #else
@@ -138,13 +141,7 @@ void isoc_transfer_callback(usb_transfer_t *transfer)
                     uvc_stream->single_thread.skip_current_frame = true;
 
                     // Inform the user about the underflow
-                    uvc_host_stream_callback_t stream_cb = uvc_stream->constant.stream_cb;
-                    if (stream_cb) {
-                        const uvc_host_stream_event_data_t event = {
-                            .type = UVC_HOST_FRAME_BUFFER_UNDERFLOW,
-                        };
-                        stream_cb(&event, uvc_stream->constant.cb_arg);
-                    }
+                    uvc_frame_buffer_event(uvc_stream, UVC_HOST_FRAME_BUFFER_UNDERFLOW);
                     goto next_isoc_packet;
                 }
             } else {
@@ -158,21 +155,16 @@ void isoc_transfer_callback(usb_transfer_t *transfer)
 
         // Add received data to frame buffer
         if (!uvc_stream->single_thread.skip_current_frame) {
+            uvc_frame_payload_time_update(uvc_stream, payload_header, arrival_us, start_of_frame);
             uvc_host_frame_t *current_frame = UVC_ATOMIC_LOAD(uvc_stream->dynamic.current_frame);
 
-            esp_err_t ret = uvc_frame_add_data(current_frame, payload_data, payload_data_len);
+            esp_err_t ret = uvc_frame_add_data(uvc_stream, current_frame, payload_data, payload_data_len);
             if (ret != ESP_OK) {
                 // Frame buffer overflow, skip this frame
                 uvc_stream->single_thread.skip_current_frame = true;
 
                 // Inform the user about the overflow
-                uvc_host_stream_callback_t stream_cb = uvc_stream->constant.stream_cb;
-                if (stream_cb) {
-                    const uvc_host_stream_event_data_t event = {
-                        .type = UVC_HOST_FRAME_BUFFER_OVERFLOW,
-                    };
-                    stream_cb(&event, uvc_stream->constant.cb_arg);
-                }
+                uvc_frame_buffer_event(uvc_stream, UVC_HOST_FRAME_BUFFER_OVERFLOW);
                 goto next_isoc_packet;
             }
         }
@@ -189,9 +181,15 @@ void isoc_transfer_callback(usb_transfer_t *transfer)
             // Determine if we should invoke the frame callback:
             // Only invoke the callback if streaming is active, a frame callback exists,
             // and we have a valid frame to pass to the user.
-            const bool invoke_fb_callback = (uvc_stream->dynamic.streaming && uvc_stream->constant.frame_cb && this_frame && !uvc_stream->single_thread.skip_current_frame);
+            const bool frame_valid = (uvc_stream->dynamic.streaming && this_frame && !uvc_stream->single_thread.skip_current_frame);
+            const bool invoke_fb_callback = (frame_valid && uvc_stream->constant.frame_cb);
             UVC_EXIT_CRITICAL();
 
+            if (UVC_ATOMIC_LOAD(uvc_stream->dynamic.streaming)) {
+                uvc_frame_stats_update(uvc_stream, this_frame, frame_valid);
+            }
+            uvc_frame_chunk_end(uvc_stream, this_frame, frame_valid);
+
             if (invoke_fb_callback) {
                 return_frame = uvc_stream->constant.frame_cb(this_frame, uvc_stream->constant.cb_arg);
             }
@@ -205,6 +203,9 @@ next_isoc_packet:
         continue;
     }
 
+    // Pass data of the unfinished frame to the chunk callback
+    uvc_frame_chunk_deliver(uvc_stream);
+
     if (UVC_ATOMIC_LOAD(uvc_stream->dynamic.streaming)) {
         usb_host_transfer_submit(transfer); // Restart the transfer
     }
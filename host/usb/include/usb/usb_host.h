@@ -7,9 +7,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "esp_err.h"
 #include "esp_intr_alloc.h"
+#include "soc/soc_caps.h"
 // Include the other USB Host Library headers as well
 #include "usb/usb_helpers.h"
 #include "usb/usb_types_ch9.h"
@@ -34,6 +36,18 @@ extern "C" {
  */
 typedef struct usb_host_client_handle_s *usb_host_client_handle_t;
 
+#if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+/**
+ * @brief The data_buffer of a transfer does not need to be cache line aligned
+ *
+ * Defined on targets with L1 cache for internal memory, where the HCD syncs the data buffers.
+ * A transfer's data_buffer may be advanced inside its allocated buffer (e.g., to append newly received data to
+ * previously received data). Only the accessed part of the buffer is synced, extended to whole cache lines. The CPU
+ * must not write to memory sharing cache lines with the accessed part while the transfer is in flight.
+ */
+#define USB_HOST_TRANSFER_UNALIGNED_DATA_BUFFER_SUPPORTED
+#endif // SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+
 // ----------------------- Events --------------------------
 
 #define USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS     0x01    /**< All clients have been deregistered from the USB Host Library */
@@ -97,8 +111,19 @@ typedef struct {
     int num_devices;            /**< Current number of connected (and enumerated) devices */
     int num_clients;            /**< Current number of registered clients */
     bool root_port_suspended;   /**< Current status of the root port (suspended/resumed) */
+    usb_port_stats_t root_port_stats;   /**< Statistics of the root port */
 } usb_host_lib_info_t;
 
+/**
+ * @brief Node of the device topology obtained via usb_host_device_topology_get()
+ */
+typedef struct {
+    uint8_t dev_addr;           /**< Device's address, 0 if the device is not addressed yet */
+    uint8_t parent_dev_addr;    /**< Parent Hub's address, 0 if the device is connected to a root port */
+    uint8_t port_num;           /**< Root port index or the parent Hub's port number */
+    uint8_t depth;              /**< Device's tier in the topology, 1 for devices connected to a root port */
+} usb_host_topology_node_t;
+
 // ---------------------- Callbacks ------------------------
 
 /**
@@ -110,6 +135,20 @@ typedef struct {
  */
 typedef void (*usb_host_client_event_cb_t)(const usb_host_client_event_msg_t *event_msg, void *arg);
 
+// ---------------------- Priorities -----------------------
+
+/**
+ * @brief Completion priority of an endpoint
+ *
+ * Transfer callbacks of endpoints with a higher priority are run before those of endpoints with a lower priority.
+ * Endpoints of the same priority are served in the order their transfers completed.
+ */
+typedef enum {
+    USB_HOST_EP_PRIORITY_LOW = 0,       /**< Background endpoints, e.g. bulk mass storage */
+    USB_HOST_EP_PRIORITY_NORMAL,        /**< Default priority of all endpoints */
+    USB_HOST_EP_PRIORITY_HIGH,          /**< Latency critical endpoints, e.g. isochronous audio */
+} usb_host_ep_priority_t;
+
 // -------------------- Configurations ---------------------
 
 /**
@@ -165,6 +204,14 @@ typedef struct {
             void *callback_arg;                                 /**< Event callback function argument */
         } async;                                                /**< Async callback config */
     };
+    struct {
+        int num_tasks;              /**< Number of worker tasks that run transfer callbacks of the client's endpoints.
+                                         Set to 0 to run them from usb_host_client_handle_events() */
+        size_t stack_size;          /**< Stack size of each worker task */
+        unsigned task_priority;     /**< FreeRTOS priority of the worker tasks */
+        BaseType_t core_id;         /**< Core affinity of the worker tasks, or tskNO_AFFINITY */
+    } completion_workers;           /**< Optional completion worker pool. Control transfers and event messages are
+                                         always handled by usb_host_client_handle_events() */
 } usb_host_client_config_t;
 
 // ------------------------------------------------ Library Functions --------------------------------------------------
@@ -249,6 +296,24 @@ esp_err_t usb_host_lib_unblock(void);
  */
 esp_err_t usb_host_lib_info(usb_host_lib_info_t *info_ret);
 
+/**
+ * @brief Print the statistics of the root port and of all endpoints of all connected devices
+ *
+ * - Prints one line for the root port, then one line per endpoint: the default endpoint of each device and all
+ *   endpoints of its claimed interfaces
+ * - Refer to usb_port_stats_t and usb_ep_stats_t for the meaning of the counters
+ *
+ * @note This function can block
+ *
+ * @param[in] stream Stream to print to (e.g., stdout)
+ *
+ * @return
+ *    - ESP_OK: Statistics printed successfully
+ *    - ESP_ERR_INVALID_STATE: USB Host Library is not installed
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t usb_host_lib_dump_stats(FILE *stream);
+
 /**
  * @brief Power the root port ON or OFF
  *
@@ -306,8 +371,9 @@ esp_err_t usb_host_lib_root_port_resume(void);
  * - The timer is either one-shot or periodic
  * - The timer expires after the set period, only if there is no activity on the USB Bus
  * - The timer resets (if enabled) every time, the usb_host_client_handle_events() handles any client events,
- *   or the usb_host_lib_handle_events() handles any host lib events, thus checking any activity on all the
- *   registered clients or inside the host lib
+ *   the usb_host_lib_handle_events() handles any host lib events, or a transfer is submitted, thus checking any
+ *   activity on all the registered clients or inside the host lib
+ * - Resetting the timer only records the time of the activity, the idle time is checked when the timer expires
  * - Once the timer expires, an auto_suspend_timer_cb() is called, which delivers USB Host lib event flags
  *
  * @note set the timer interval to 0, to disable the timer (in case NO auto suspend functionality is required anymore)
@@ -359,6 +425,10 @@ esp_err_t usb_host_client_deregister(usb_host_client_handle_t client_hdl);
  *
  * - This function handles all of a client's processing and should be called repeatedly in a loop
  * - For a particular client, this function should never be called by multiple threads simultaneously
+ * - Endpoints with completed transfers are served in order of their priority, see usb_host_endpoint_set_priority().
+ *   A high priority endpoint waits at most for one transfer callback of a lower priority endpoint
+ * - If the client was registered with completion workers, transfer callbacks of non-control endpoints are run by
+ *   the workers instead
  *
  * @note This function can block
  * @param[in] client_hdl Client handle
@@ -458,6 +528,24 @@ esp_err_t usb_host_device_free_all(void);
  */
 esp_err_t usb_host_device_addr_list_fill(int list_len, uint8_t *dev_addr_list, int *num_dev_ret);
 
+/**
+ * @brief Get a snapshot of the device topology
+ *
+ * - This function fills a list with all connected devices, including external Hubs and devices being enumerated
+ * - Parents are listed before their children, so the tree can be rebuilt in one pass over the list
+ * - If there are more devices than num_nodes, this function will only fill up to num_nodes number of devices.
+ *
+ * @param[in] num_nodes Length of the empty list
+ * @param[out] nodes Empty list to be filled
+ * @param[out] num_nodes_ret Number of filled nodes
+ *
+ * @return
+ *    - ESP_OK: Topology obtained successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t usb_host_device_topology_get(int num_nodes, usb_host_topology_node_t *nodes, int *num_nodes_ret);
+
 // ------------------------------------------------- Device Requests ---------------------------------------------------
 
 // ------------------- Cached Requests ---------------------
@@ -657,6 +745,70 @@ esp_err_t usb_host_endpoint_flush(usb_device_handle_t dev_hdl, uint8_t bEndpoint
  */
 esp_err_t usb_host_endpoint_clear(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress);
 
+/**
+ * @brief Set the completion priority of a particular endpoint
+ *
+ * - The endpoint must be part of an interface claimed by a client
+ * - Completed transfers of higher priority endpoints are dispatched first, regardless of the order in which
+ *   the endpoints completed
+ * - The priority is reset to USB_HOST_EP_PRIORITY_NORMAL when the interface is released
+ *
+ * @param[in] dev_hdl Device handle
+ * @param[in] bEndpointAddress Endpoint address
+ * @param[in] priority Completion priority
+ *
+ * @return
+ *    - ESP_OK: Priority set successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NOT_FOUND: Endpoint address not found
+ */
+esp_err_t usb_host_endpoint_set_priority(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usb_host_ep_priority_t priority);
+
+/**
+ * @brief Enable or disable direct completion callbacks of a particular endpoint
+ *
+ * - The endpoint must be part of an interface claimed by a client
+ * - When enabled, transfer callbacks of successfully completed transfers are called directly from the USB Host
+ *   Library's completion context (usually the USB interrupt) instead of from usb_host_client_handle_events().
+ *   This removes the context switches between the transfer completion and its callback
+ * - Such callbacks run in ISR context: they must be short, placed in IRAM, must not block and may only use
+ *   ISR safe functions. Use usb_host_transfer_submit_from_isr() to resubmit the transfer
+ * - Transfers that complete with an endpoint error (e.g., STALL) are still dispatched from the client's context,
+ *   after the endpoint is flushed
+ * - Direct callbacks are disabled when the interface is released
+ *
+ * @param[in] dev_hdl Device handle
+ * @param[in] bEndpointAddress Endpoint address
+ * @param[in] enable Enable direct completion callbacks
+ *
+ * @return
+ *    - ESP_OK: Direct callbacks enabled or disabled successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NOT_FOUND: Endpoint address not found
+ */
+esp_err_t usb_host_endpoint_set_direct_callback(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, bool enable);
+
+/**
+ * @brief Get the transfer statistics of a particular endpoint
+ *
+ * - The counters are always enabled. They allow finding out why a stream is losing data, e.g., late isochronous
+ *   packets, transfer errors, a queue that runs dry or a slow resubmission of transfers
+ * - Use bEndpointAddress 0 for the default endpoint of the device. Its statistics include the control transfers of
+ *   all clients and of the USB Host Library itself
+ * - Other endpoints must be part of an interface claimed by a client. Their statistics are reset when the interface
+ *   is claimed
+ *
+ * @param[in] dev_hdl Device handle
+ * @param[in] bEndpointAddress Endpoint address
+ * @param[out] stats Endpoint statistics
+ *
+ * @return
+ *    - ESP_OK: Statistics obtained successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NOT_FOUND: Endpoint address not found
+ */
+esp_err_t usb_host_endpoint_get_stats(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usb_ep_stats_t *stats);
+
 // ------------------------------------------------ Asynchronous I/O ---------------------------------------------------
 
 /**
@@ -702,7 +854,8 @@ esp_err_t usb_host_transfer_free(usb_transfer_t *transfer);
  *
  * - Submit a transfer to a particular endpoint. The device and endpoint number is specified inside the transfer
  * - The transfer must be properly initialized before submitting
- * - On completion, the transfer's callback will be called from the client's usb_host_client_handle_events() function.
+ * - On completion, the transfer's callback will be called from the client's usb_host_client_handle_events() function,
+ *   or directly from the completion context if enabled with usb_host_endpoint_set_direct_callback()
  *
  * @param[in] transfer Initialized transfer object
  *
@@ -715,6 +868,28 @@ esp_err_t usb_host_transfer_free(usb_transfer_t *transfer);
  */
 esp_err_t usb_host_transfer_submit(usb_transfer_t *transfer);
 
+/**
+ * @brief Resubmit a non-control transfer from its transfer callback
+ *
+ * - Restricted, ISR safe variant of usb_host_transfer_submit() that can be called from direct completion callbacks,
+ *   see usb_host_endpoint_set_direct_callback()
+ * - Must be called from a transfer callback of the endpoint the transfer is resubmitted to, while the transfer
+ *   callback runs. The transfer must have been submitted to this endpoint with usb_host_transfer_submit() before
+ * - The transfer's target (device handle and endpoint address) must not be changed
+ * - The root port is not resumed by this function. If the root port is suspended, the transfer is submitted
+ *   once the root port is resumed
+ *
+ * @param[in] transfer Completed transfer object
+ *
+ * @return
+ *    - ESP_OK: Transfer submitted successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NOT_FINISHED: Transfer already in-flight
+ *    - ESP_ERR_INVALID_STATE: Not called from a transfer callback of the endpoint, or the endpoint pipe is not in
+ *                             a correct state to submit transfer
+ */
+esp_err_t usb_host_transfer_submit_from_isr(usb_transfer_t *transfer);
+
 /**
  * @brief Submit a control transfer
  *
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -200,6 +200,49 @@ struct usb_transfer_s {
  */
 #define USB_TRANSFER_FLAG_ZERO_PACK  0x01           /**< (For bulk OUT only). Indicates that a bulk OUT transfers should always terminate with a short packet, even if it means adding an extra zero length packet */
 
+// ---------------------------------------------------- Statistics -----------------------------------------------------
+
+/**
+ * @brief Transfer statistics of an endpoint
+ *
+ * The counters are always enabled and count since the endpoint was allocated (i.e., since its interface was claimed,
+ * or since the device was connected for the default endpoint).
+ */
+typedef struct {
+    uint32_t num_transfers;                         /**< Number of completed transfers, regardless of their status */
+    uint64_t num_bytes;                             /**< Number of bytes transferred by completed transfers */
+    uint32_t num_errors;                            /**< Transfers completed with USB_TRANSFER_STATUS_ERROR */
+    uint32_t num_stalls;                            /**< Transfers completed with USB_TRANSFER_STATUS_STALL */
+    uint32_t num_overflows;                         /**< Transfers completed with USB_TRANSFER_STATUS_OVERFLOW */
+    uint32_t num_canceled;                          /**< Transfers completed with USB_TRANSFER_STATUS_CANCELED */
+    uint32_t num_no_device;                         /**< Transfers completed with USB_TRANSFER_STATUS_NO_DEVICE */
+    uint32_t num_rejected;                          /**< Submissions rejected because the endpoint or port could not accept transfers */
+    uint32_t num_isoc_packets_skipped;              /**< Isochronous packets not executed in their (micro)frame, i.e., the transfer was late */
+    uint32_t num_isoc_packets_error;                /**< Isochronous packets completed with an error */
+    uint32_t num_isoc_restarts;                     /**< Isochronous schedule restarts, because no transfer was queued when the previous one completed */
+    uint32_t num_buffer_starvations;                /**< Submitted transfers that had to wait for a free DMA buffer of the endpoint */
+    uint32_t max_queue_depth;                       /**< Maximum number of transfers submitted to the endpoint at once */
+    uint32_t num_resubmits;                         /**< Number of transfers submitted again after they had completed */
+    uint64_t resubmit_latency_total_us;             /**< Sum of the times between the completion and the resubmission of a transfer */
+    uint32_t resubmit_latency_max_us;               /**< Maximum time between the completion and the resubmission of a transfer */
+    uint32_t num_cache_syncs;                       /**< Number of cache sync operations. Zero on targets without cache sync of DMA memory */
+    uint64_t cache_sync_time_us;                    /**< Time spent syncing the cache */
+} usb_ep_stats_t;
+
+/**
+ * @brief Statistics of a root port
+ *
+ * The counters are always enabled and count since the USB Host Library was installed.
+ */
+typedef struct {
+    uint32_t frame_num;                             /**< Current (micro)frame number of the port, i.e., its SOF counter. Wraps around */
+    uint32_t num_frame_overruns;                    /**< Isochronous packets of all endpoints that missed their (micro)frame */
+    uint32_t num_transfers;                         /**< Completed transfers of all endpoints */
+    uint32_t num_transfer_errors;                   /**< Transfers of all endpoints completed with an error, stall or overflow */
+    uint32_t num_port_errors;                       /**< Port errors (e.g., babble or an unexpected port disable) */
+    uint32_t num_overcurrents;                      /**< Overcurrent events */
+} usb_port_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -106,6 +106,15 @@ esp_err_t ext_hub_get_speed(ext_hub_handle_t ext_hub_hdl, usb_speed_t *speed);
  */
 hcd_port_handle_t ext_hub_get_root_port(ext_hub_handle_t ext_hub_hdl);
 
+/**
+ * @brief Get the unique ID of an External Hub device
+ *
+ * @param[in] ext_hub_hdl External Hub device handle
+ *
+ * @return Unique ID of the device on success, 0 on error
+ */
+unsigned int ext_hub_get_uid(ext_hub_handle_t ext_hub_hdl);
+
 /**
  * @brief Add new device
  *
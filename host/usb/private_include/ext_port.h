@@ -19,6 +19,12 @@ extern "C" {
 #define ENABLE_MULTIPLE_HUBS             1
 #endif // CONFIG_USB_HOST_HUB_MULTI_LEVEL
 
+#if CONFIG_USB_HOST_EXT_HUB_PORT_REQUESTS
+#define EXT_PORT_PARENT_REQ_MAX          CONFIG_USB_HOST_EXT_HUB_PORT_REQUESTS
+#else
+#define EXT_PORT_PARENT_REQ_MAX          4
+#endif // CONFIG_USB_HOST_EXT_HUB_PORT_REQUESTS
+
 typedef struct ext_port_s  *ext_port_hdl_t;
 
 // ------------------------ External Port API typedefs -------------------------
@@ -38,6 +44,7 @@ typedef struct {
     esp_err_t (*get_status)(void *port_hdl);
     esp_err_t (*set_status)(void *port_hdl, const usb_port_status_t *status);
     esp_err_t (*req_process)(void *port_hdl);
+    esp_err_t (*req_failed)(void *port_hdl);
 } ext_port_driver_api_t;
 
 // ------------------------------ Events ---------------------------------------
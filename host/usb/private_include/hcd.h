@@ -193,6 +193,17 @@ typedef struct {
     uint8_t dev_addr;                       /**< Device address of the pipe */
 } hcd_pipe_config_t;
 
+/**
+ * @brief Cache sync statistics of a pipe
+ *
+ * Only counted on targets that sync the cache of internal memory (SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE), otherwise zero
+ */
+typedef struct {
+    uint32_t num_syncs;                     /**< Number of cache sync operations of data buffers and descriptor lists */
+    uint64_t num_bytes;                     /**< Number of bytes synced, including the cache line alignment */
+    uint64_t num_cycles;                    /**< CPU cycles spent syncing the cache */
+} hcd_pipe_cache_sync_stats_t;
+
 // ---------------------------------------------------- HCD Port -------------------------------------------------------
 
 /**
@@ -276,6 +287,19 @@ hcd_port_state_t hcd_port_get_state(hcd_port_handle_t port_hdl);
  */
 esp_err_t hcd_port_get_speed(hcd_port_handle_t port_hdl, usb_speed_t *speed);
 
+/**
+ * @brief Get the statistics of a port
+ *
+ * @param[in] port_hdl Port handle
+ * @param[out] stats Statistics of the port since it was initialized
+ *
+ * @return
+ *    - ESP_OK: Statistics returned successfully
+ *    - ESP_ERR_INVALID_STATE: Port is not initialized
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t hcd_port_get_stats(hcd_port_handle_t port_hdl, usb_port_stats_t *stats);
+
 /**
  * @brief Handle a ports event
  *
@@ -351,7 +375,7 @@ esp_err_t hcd_port_check_all_pipes_idle(hcd_port_handle_t port_hdl);
  *    - ESP_ERR_NO_MEM: Insufficient memory
  *    - ESP_ERR_INVALID_ARG: Arguments are invalid
  *    - ESP_ERR_INVALID_STATE: Host port is not in the correct state to allocate a pipe
- *    - ESP_ERR_NOT_SUPPORTED: The pipe's configuration cannot be supported
+ *    - ESP_ERR_NOT_SUPPORTED: The pipe's configuration cannot be supported, or not enough periodic bus time
  */
 esp_err_t hcd_pipe_alloc(hcd_port_handle_t port_hdl, const hcd_pipe_config_t *pipe_config, hcd_pipe_handle_t *pipe_hdl);
 
@@ -449,6 +473,33 @@ hcd_pipe_state_t hcd_pipe_get_state(hcd_pipe_handle_t pipe_hdl);
  */
 unsigned int hcd_pipe_get_num_urbs(hcd_pipe_handle_t pipe_hdl);
 
+/**
+ * @brief Get the cache sync statistics of a pipe
+ *
+ * @param[in] pipe_hdl Pipe handle
+ * @param[out] stats Cache sync statistics since the pipe was allocated
+ * @param[out] time_us Time spent syncing the cache in microseconds. Can be NULL
+ *
+ * @return
+ *    - ESP_OK: Statistics returned successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t hcd_pipe_get_cache_sync_stats(hcd_pipe_handle_t pipe_hdl, hcd_pipe_cache_sync_stats_t *stats, uint64_t *time_us);
+
+/**
+ * @brief Get the transfer statistics of a pipe
+ *
+ * The statistics include the pipe's cache sync statistics (see hcd_pipe_get_cache_sync_stats())
+ *
+ * @param[in] pipe_hdl Pipe handle
+ * @param[out] stats Statistics of the pipe since it was allocated
+ *
+ * @return
+ *    - ESP_OK: Statistics returned successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t hcd_pipe_get_stats(hcd_pipe_handle_t pipe_hdl, usb_ep_stats_t *stats);
+
 /**
  * @brief Execute a command on a particular pipe
  *
@@ -507,6 +558,8 @@ hcd_pipe_event_t hcd_pipe_get_event(hcd_pipe_handle_t pipe_hdl);
  * Deferred URBs will be put into a pipe's pending queue
  * Deferred URBs will be executed automatically upon a pipe's clear command, which is a part of a global resume sequence
  *
+ * @note This function can be called from a pipe callback running in ISR context
+ *
  * @param[in] pipe_hdl Pipe handle
  * @param[in] urb URB to enqueue
  *
@@ -524,6 +577,8 @@ esp_err_t hcd_urb_enqueue(hcd_pipe_handle_t pipe_hdl, urb_t *urb);
  * multiple URBs that can be dequeued, this function should be called repeatedly until all URBs are dequeued. If a pipe
  * has no more URBs to dequeue, this function will return NULL.
  *
+ * @note This function can be called from a pipe callback running in ISR context
+ *
  * @param[in] pipe_hdl Pipe handle
  *
  * @return
@@ -139,6 +139,20 @@ esp_err_t hub_root_stop(void);
  */
 bool hub_root_is_suspended(void);
 
+/**
+ * @brief Get the statistics of the root port
+ *
+ * In multi-port configurations, this currently returns the statistics of the first enabled root port only.
+ *
+ * @param[out] stats Root port statistics
+ *
+ * @return
+ *    - ESP_OK: Statistics returned successfully
+ *    - ESP_ERR_INVALID_STATE: Hub driver is not installed
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t hub_root_get_stats(usb_port_stats_t *stats);
+
 /**
  * @brief Check if the Hub driver's root port can be suspended
  *
@@ -295,6 +309,35 @@ esp_err_t hub_node_active(unsigned int node_uid);
  */
 esp_err_t hub_node_disable(unsigned int node_uid);
 
+/**
+ * @brief Device tree node information
+ */
+typedef struct {
+    unsigned int uid;                       /**< Device's node unique ID */
+    unsigned int parent_uid;                /**< Parent Hub's node unique ID, 0 if the device is connected to a root port */
+    uint8_t port_num;                       /**< Root port index or the parent Hub's port number */
+    uint8_t depth;                          /**< Device's tier in the tree, 1 for devices connected to a root port */
+} hub_dev_tree_node_info_t;
+
+/**
+ * @brief Take a snapshot of the device tree
+ *
+ * Fills the list with the nodes of the device tree. Parents are listed before their children.
+ * If there are more nodes than num_nodes, only num_nodes nodes are filled.
+ *
+ * @note Can be called from any task
+ *
+ * @param[in] num_nodes         Length of the list
+ * @param[out] nodes            List to be filled
+ * @param[out] num_nodes_ret    Number of filled nodes
+ *
+ * @return
+ *    - ESP_OK: Snapshot taken successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_INVALID_STATE: Hub driver is not installed
+ */
+esp_err_t hub_dev_tree_snapshot(int num_nodes, hub_dev_tree_node_info_t *nodes, int *num_nodes_ret);
+
 /**
  * @brief Notify Hub driver that new device has been attached
  *
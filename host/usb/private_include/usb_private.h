@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -42,9 +42,11 @@ struct urb_s {
     // HCD Layer: Handler pointer and variables. Must be initialized to NULL and 0 respectively
     void *hcd_ptr;
     uint32_t hcd_var;
+    int64_t hcd_done_time;  // Time (in microseconds) the URB was last done. Used for the resubmit latency statistics
     // Host Lib Layer:
     void *usb_host_client;  // Currently only used when submitted to shared pipes (i.e., Device default pipes)
     bool usb_host_inflight; // Debugging variable, used to prevent re-submitting URBs already inflight
+    void *usb_host_ep;      // Endpoint the URB was last submitted to. Used when resubmitting from ISR context
     // Public transfer structure. Must be last due to variable length array
     usb_transfer_t transfer;
 };
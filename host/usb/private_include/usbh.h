@@ -305,6 +305,21 @@ esp_err_t usbh_devs_remove(unsigned int uid);
  */
 esp_err_t usbh_devs_get_parent_info(unsigned int uid, usb_parent_dev_info_t *parent_info);
 
+/**
+ * @brief Get a device's address
+ *
+ * @note Can be called without opening the device
+ *
+ * @param[in] uid               Unique ID assigned to the device
+ * @param[out] dev_addr         Device's address, 0 if the device has not been addressed yet
+ *
+ * @return
+ *    - ESP_OK: Device address obtained successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NOT_FOUND: Device with provided uid not found
+ */
+esp_err_t usbh_devs_get_addr(unsigned int uid, uint8_t *dev_addr);
+
 /**
  * @brief Mark that all devices should be freed at the next possible opportunity
  *
@@ -416,6 +431,18 @@ esp_err_t usbh_dev_close(usb_device_handle_t dev_hdl);
  */
 esp_err_t usbh_dev_get_addr(usb_device_handle_t dev_hdl, uint8_t *dev_addr);
 
+/**
+ * @brief Get a device's unique ID
+ *
+ * @param[in] dev_hdl Device handle
+ * @param[out] uid Unique ID assigned to the device on creation (see 'usbh_devs_add()')
+ *
+ * @return
+ *    - ESP_OK: Device's unique ID obtained successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t usbh_dev_get_uid(usb_device_handle_t dev_hdl, unsigned int *uid);
+
 /**
  * @brief Get a device's information
  *
@@ -431,6 +458,39 @@ esp_err_t usbh_dev_get_addr(usb_device_handle_t dev_hdl, uint8_t *dev_addr);
  */
 esp_err_t usbh_dev_get_info(usb_device_handle_t dev_hdl, usb_device_info_t *dev_info);
 
+/**
+ * @brief Get the transfer statistics of a device's default endpoint
+ *
+ * @note Callers of this function must have opened the device via usbh_devs_open()
+ *
+ * @param[in] dev_hdl Device handle
+ * @param[out] stats Statistics of the default endpoint
+ *
+ * @return
+ *    - ESP_OK: Statistics obtained successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t usbh_dev_get_ctrl_stats(usb_device_handle_t dev_hdl, usb_ep_stats_t *stats);
+
+/**
+ * @brief Get the transfer statistics of an allocated endpoint of a device
+ *
+ * The statistics are copied while the endpoint is guaranteed not to be freed, thus the endpoint need not be held by
+ * the caller.
+ *
+ * @note Callers of this function must have opened the device via usbh_devs_open()
+ *
+ * @param[in] dev_hdl Device handle
+ * @param[in] bEndpointAddress Endpoint address
+ * @param[out] stats Statistics of the endpoint since it was allocated
+ *
+ * @return
+ *    - ESP_OK: Statistics obtained successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_NOT_FOUND: Endpoint is not allocated
+ */
+esp_err_t usbh_dev_get_ep_stats(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usb_ep_stats_t *stats);
+
 /**
  * @brief Get the root port handle of a device
  *
@@ -752,11 +812,31 @@ esp_err_t usbh_dev_submit_ctrl_urb(usb_device_handle_t dev_hdl, urb_t *urb);
  */
 esp_err_t usbh_ep_enqueue_urb(usbh_ep_handle_t ep_hdl, urb_t *urb);
 
+/**
+ * @brief Enqueue a URB to an endpoint from ISR context
+ *
+ * Same as usbh_ep_enqueue_urb(), but skips the URB argument and USB compliance checks (which log on failure).
+ * Intended for resubmitting a URB that was previously enqueued to the same endpoint, from the endpoint's callback.
+ *
+ * @note This function can be called from ISR context
+ *
+ * @param[in] ep_hdl Endpoint handle
+ * @param[in] urb URB to enqueue
+ *
+ * @return
+ *    - ESP_OK: URB enqueued successfully
+ *    - ESP_ERR_INVALID_ARG: Invalid argument
+ *    - ESP_ERR_INVALID_STATE: The pipe or (and) the root port is not in a correct state
+ */
+esp_err_t usbh_ep_enqueue_urb_from_isr(usbh_ep_handle_t ep_hdl, urb_t *urb);
+
 /**
  * @brief Dequeue a URB from an endpoint
  *
  * Dequeue a completed URB from an endpoint. The USBH_EP_EVENT_URB_DONE indicates that URBs can be dequeued
  *
+ * @note This function can be called from ISR context
+ *
  * @param[in] ep_hdl Endpoint handle
  * @param[out] urb_ret Dequeued URB, or NULL if no more URBs to dequeue
  *
@@ -16,9 +16,10 @@
 #include "usb/usb_helpers.h"
 
 #define EXT_HUB_MAX_STATUS_BYTES_SIZE               (sizeof(uint32_t))
-#define EXT_HUB_STATUS_CHANGE_FLAG                  (1 << 0)
-#define EXT_HUB_STATUS_PORT1_CHANGE_FLAG            (1 << 1)
+#define EXT_HUB_STATUS_CHANGE_FLAG                  (1U << 0)
+#define EXT_HUB_STATUS_PORT1_CHANGE_FLAG            (1U << 1)
 #define EXT_HUB_CTRL_TRANSFER_MAX_DATA_LEN          CONFIG_USB_HOST_CONTROL_TRANSFER_MAX_SIZE
+#define EXT_HUB_PORT_REQ_URB_NUM                    EXT_PORT_PARENT_REQ_MAX
 
 /**
  * @brief Device state
@@ -42,6 +43,8 @@ typedef enum {
  * - After handling the response during EXT_HUB_STAGE_CHECK_HUB_DESCRIPTOR, the External Hub Driver configures the Device according to the data from Hub Descriptor.
  * - After completion of any stage, the Device does back to the IDLE stage and waits for another request. Source of the request could be: EP1 INT callback (the Hub or Ports changes) or external call.
  * - Stages, that don't required response handling could not end up with fail.
+ *
+ * Port requests (Get Port Status, Set Port Feature, Clear Port Feature) don't use the stages. Each of them has its own URB, so requests of several ports are queued on EP0 at the same time.
  */
 typedef enum {
     // Device in IDLE state
@@ -53,9 +56,6 @@ typedef enum {
     EXT_HUB_STAGE_CHECK_HUB_DESCRIPTOR,             /**< Device received the Hub Descriptor and requires its' handling  */
     EXT_HUB_STAGE_GET_HUB_STATUS,                   /**< Device requests Hub Status. For more details, refer to 11.24.2.6 Get Hub Status of usb_20 */
     EXT_HUB_STAGE_CHECK_HUB_STATUS,                 /**< Device received the Hub Status and requires its' handling  */
-    // Stages, don't required get stage handling
-    EXT_HUB_STAGE_CHECK_PORT_FEATURE,               /**< Device completed the Port Feature class-specific request (Set Feature or Clear Feature). For more details, refer to 11.24.2 Class-specific Requests of usb_20 */
-    EXT_HUB_STAGE_CHECK_PORT_STATUS,                /**< Device completed the Port Get Status class-specific request. For more details, refer to 11.24.2 Class-specific Requests of usb_20 */
     EXT_HUB_STAGE_ERROR                             /**< Device has internal error and requires handling */
 } ext_hub_stage_t;
 
@@ -67,8 +67,6 @@ const char *const ext_hub_stage_strings[] = {
     "CHECK_HUB_DESCRIPTOR",
     "GET_HUB_STATUS",
     "CHECK_HUB_STATUS",
-    "PORT_FEATURE",
-    "PORT_STATUS_REQUEST",
     "FAILURE"
 };
 
@@ -84,6 +82,7 @@ typedef enum {
     DEV_ACTION_ERROR                    = (1 << 6),  /**< Device encounters an error */
     DEV_ACTION_RELEASE                  = (1 << 7),  /**< Device should be released */
     DEV_ACTION_FREE                     = (1 << 8),  /**< Device should be freed */
+    DEV_ACTION_EP0_PORT_COMPLETE        = (1 << 9),  /**< Device's Control EP transfer of a port request completed */
 } dev_action_t;
 
 typedef struct ext_hub_s ext_hub_dev_t;
@@ -113,12 +112,15 @@ struct ext_hub_s {
             uint32_t val;                           /**< Device's flags value */
         } flags;
         uint32_t action_flags;                      /**< Device's action flags */
+        TAILQ_HEAD(port_req_done, urb_s) port_req_done_tailq;   /**< Completed port request URBs, waiting to be handled */
     } dynamic;                                      /**< Dynamic members require a critical section */
 
     struct {
         ext_hub_stage_t stage;                      /**< Device's stage */
         uint8_t maxchild;                           /**< Amount of allocated ports. Could be 0 for some Hubs. Is increased when new port is added and decreased when port has been freed. */
         ext_hub_state_t state;                      /**< Device's state */
+        TAILQ_HEAD(port_req_idle, urb_s) port_req_idle_tailq;   /**< Port request URBs, which are not in flight */
+        uint8_t port_req_in_flight;                 /**< Number of port request URBs in flight or waiting to be handled */
     } single_thread;                                /**< Single thread members don't require a critical section, as long as they are never accessed from multiple threads */
 
     struct {
@@ -128,6 +130,7 @@ struct ext_hub_s {
         uint8_t dev_addr;                           /**< Device's bus address */
         usb_device_handle_t dev_hdl;                /**< Device's handle */
         urb_t *ctrl_urb;                            /**< Device's Control pipe transfer URB */
+        urb_t *port_req_urbs[EXT_HUB_PORT_REQ_URB_NUM]; /**< Device's Control pipe transfer URBs for port requests */
         urb_t *in_urb;                              /**< Device's Interrupt pipe URB */
         usbh_ep_handle_t ep_in_hdl;                 /**< Device's Interrupt EP handle */
 
@@ -256,6 +259,29 @@ static void control_transfer_complete_cb(usb_transfer_t *ctrl_xfer)
     }
 }
 
+/**
+ * @brief Control transfer completion callback of a port request
+ *
+ * Port requests complete independently of each other, the URB is queued to be handled by the External Hub Driver process
+ *
+ * @param[in] ctrl_xfer Pointer to a transfer buffer
+ */
+static void port_request_complete_cb(usb_transfer_t *ctrl_xfer)
+{
+    bool call_proc_req_cb = false;
+    ext_hub_dev_t *ext_hub_dev = (ext_hub_dev_t *) ctrl_xfer->context;
+    urb_t *urb = __containerof(ctrl_xfer, urb_t, transfer);
+
+    EXT_HUB_ENTER_CRITICAL();
+    TAILQ_INSERT_TAIL(&ext_hub_dev->dynamic.port_req_done_tailq, urb, tailq_entry);
+    call_proc_req_cb = _device_set_actions(ext_hub_dev, DEV_ACTION_EP0_PORT_COMPLETE);
+    EXT_HUB_EXIT_CRITICAL();
+
+    if (call_proc_req_cb) {
+        p_ext_hub_driver->constant.proc_req_cb(false, p_ext_hub_driver->constant.proc_req_cb_arg);
+    }
+}
+
 static void interrupt_transfer_complete_cb(usb_transfer_t *intr_xfer)
 {
     assert(intr_xfer);
@@ -346,7 +372,6 @@ static void device_has_changed(ext_hub_dev_t *ext_hub_dev)
     // After getting the IRQ about Hub status change we need to request status
     // device_get_status(ext_hub_dev);
     ESP_LOGW(EXT_HUB_TAG, "Hub status change has not been implemented yet");
-    device_enable_int_ep(ext_hub_dev);
 }
 
 //
@@ -367,33 +392,34 @@ static void device_status_change_handle(ext_hub_dev_t *ext_hub_dev, const uint8_
     // Driver does not support Hubs with EP IN wMaxPacketSize > 4
     assert(length <= EXT_HUB_MAX_STATUS_BYTES_SIZE);
 
+    // Decode the whole bitmap at once, bit N of the bitmap is the change bit of Port N (bit 0 is the Hub)
     for (uint32_t i = 0; i < length; i++) {
-        device_status |= (uint32_t)(data[i] << i);
+        device_status |= (uint32_t)data[i] << (i * 8);
     }
 
-    if (device_status) {
-        // If device has a status change, we will re-trigger back the transfer
-        // after all handling will be done
-        if (device_status & EXT_HUB_STATUS_CHANGE_FLAG) {
-            // Check device status
-            device_has_changed(ext_hub_dev);
-        }
-        // HINTs:
-        // - every byte of Data IN has 8 bits of possible port statuses bits: (length * 8)
-        // - very first bit of status is used for Hub status: (length * 8) - 1
-        for (uint8_t i = 0; i < (length * 8) - 1; i++) {
-            // Check ports statuses
-            if (device_status & (EXT_HUB_STATUS_PORT1_CHANGE_FLAG << i)) {
-                assert(i < ext_hub_dev->single_thread.maxchild);        // Port should be in range
-                assert(p_ext_hub_driver->constant.port_driver);         // Port driver call should be valid
-                // Request Port status to handle changes
-                ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->get_status(ext_hub_dev->constant.ports[i]));
-            }
-        }
-    } else {
-        // Device status is 0. Could happen when HS Hub with HS device is connected to HS Hub, connected to FS root port
+    const uint32_t port_changes = device_status & ~EXT_HUB_STATUS_CHANGE_FLAG;
+
+    if (device_status & EXT_HUB_STATUS_CHANGE_FLAG) {
+        // Check device status
+        device_has_changed(ext_hub_dev);
+    }
+
+    if (port_changes == 0) {
+        // No port has changed. Device status is 0 could happen when HS Hub with HS device is connected to HS Hub, connected to FS root port
         // Re-trigger transfer right now
         device_enable_int_ep(ext_hub_dev);
+        return;
+    }
+
+    // Request the status of all changed ports in one pass. The External Port Driver queues the requests on EP0
+    // of the Hub back to back and the transfer is re-triggered after all ports have been handled.
+    assert(p_ext_hub_driver->constant.port_driver);         // Port driver call should be valid
+    for (uint8_t i = 0; i < (length * 8) - 1; i++) {
+        if (port_changes & (EXT_HUB_STATUS_PORT1_CHANGE_FLAG << i)) {
+            assert(i < ext_hub_dev->single_thread.maxchild);        // Port should be in range
+            // Request Port status to handle changes
+            ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->get_status(ext_hub_dev->constant.ports[i]));
+        }
     }
 }
 
@@ -580,12 +606,23 @@ static esp_err_t device_alloc(device_config_t *config, ext_hub_dev_t **ext_hub_d
         goto ctrl_urb_fail;
     }
 
+    // Allocate Control transfer URBs for port requests, ports of the Hub queue their requests on EP0 in parallel
+    for (int i = 0; i < EXT_HUB_PORT_REQ_URB_NUM; i++) {
+        hub_dev->constant.port_req_urbs[i] = urb_alloc(sizeof(usb_setup_packet_t) + sizeof(usb_port_status_t), 0);
+        if (hub_dev->constant.port_req_urbs[i] == NULL) {
+            ESP_LOGE(EXT_HUB_TAG, "[%d] Unable to allocate Control URB for port requests",
+                     config->dev_addr);
+            ret = ESP_ERR_NO_MEM;
+            goto port_req_urb_fail;
+        }
+    }
+
     if (config->ep_in_desc->wMaxPacketSize > EXT_HUB_MAX_STATUS_BYTES_SIZE) {
         ESP_LOGE(EXT_HUB_TAG, "[%d] wMaxPacketSize=%d is not supported",
                  config->dev_addr,
                  config->ep_in_desc->wMaxPacketSize);
         ret = ESP_ERR_NOT_SUPPORTED;
-        goto in_urb_fail;
+        goto port_req_urb_fail;
     }
 
     in_urb = urb_alloc(config->ep_in_desc->wMaxPacketSize, 0);
@@ -594,7 +631,7 @@ static esp_err_t device_alloc(device_config_t *config, ext_hub_dev_t **ext_hub_d
         ESP_LOGE(EXT_HUB_TAG, "[%d] Unable to allocate Interrupt URB",
                  config->dev_addr);
         ret =  ESP_ERR_NO_MEM;
-        goto in_urb_fail;
+        goto port_req_urb_fail;
     }
 
     usbh_ep_handle_t ep_hdl;
@@ -618,6 +655,15 @@ static esp_err_t device_alloc(device_config_t *config, ext_hub_dev_t **ext_hub_d
     ctrl_urb->usb_host_client = (void *) p_ext_hub_driver;
     ctrl_urb->transfer.callback = control_transfer_complete_cb;
     ctrl_urb->transfer.context = (void *) hub_dev;
+    TAILQ_INIT(&hub_dev->single_thread.port_req_idle_tailq);
+    for (int i = 0; i < EXT_HUB_PORT_REQ_URB_NUM; i++) {
+        urb_t *port_req_urb = hub_dev->constant.port_req_urbs[i];
+        port_req_urb->usb_host_client = (void *) p_ext_hub_driver;
+        port_req_urb->transfer.callback = port_request_complete_cb;
+        port_req_urb->transfer.context = (void *) hub_dev;
+        TAILQ_INSERT_TAIL(&hub_dev->single_thread.port_req_idle_tailq, port_req_urb, tailq_entry);
+    }
+    hub_dev->single_thread.port_req_in_flight = 0;
 
     // Client is a memory address of the p_ext_hub_driver driver object
     in_urb->usb_host_client = (void *) p_ext_hub_driver;
@@ -627,6 +673,7 @@ static esp_err_t device_alloc(device_config_t *config, ext_hub_dev_t **ext_hub_d
 
     hub_dev->dynamic.flags.val = 0;
     hub_dev->dynamic.action_flags = 0;
+    TAILQ_INIT(&hub_dev->dynamic.port_req_done_tailq);
     // Mutex protected
     hub_dev->single_thread.state = EXT_HUB_STATE_ATTACHED;
     // Constant members
@@ -652,7 +699,12 @@ static esp_err_t device_alloc(device_config_t *config, ext_hub_dev_t **ext_hub_d
 
 ep_fail:
     urb_free(in_urb);
-in_urb_fail:
+port_req_urb_fail:
+    for (int i = 0; i < EXT_HUB_PORT_REQ_URB_NUM; i++) {
+        if (hub_dev->constant.port_req_urbs[i]) {
+            urb_free(hub_dev->constant.port_req_urbs[i]);
+        }
+    }
     urb_free(ctrl_urb);
 ctrl_urb_fail:
     heap_caps_free(hub_dev);
@@ -778,7 +830,11 @@ static void device_free(ext_hub_dev_t *ext_hub_dev)
         heap_caps_free(ext_hub_dev->constant.ports);
     }
 
+    assert(ext_hub_dev->single_thread.port_req_in_flight == 0); // All port requests should be completed by now
     urb_free(ext_hub_dev->constant.ctrl_urb);
+    for (int i = 0; i < EXT_HUB_PORT_REQ_URB_NUM; i++) {
+        urb_free(ext_hub_dev->constant.port_req_urbs[i]);
+    }
     urb_free(ext_hub_dev->constant.in_urb);
     heap_caps_free(ext_hub_dev);
 }
@@ -841,6 +897,21 @@ exit:
 // -----------------------------------------------------------------------------
 // -------------------------- Device handling  ---------------------------------
 // -----------------------------------------------------------------------------
+
+/**
+ * @brief Device doesn't have any control transfers in flight
+ *
+ * @param[in] ext_hub_dev External Hub device
+ * @return
+ *    - true:   Device is in the IDLE stage and all port requests have been handled
+ *    - false:  Device has a control transfer in flight
+ */
+static inline bool device_is_idle(ext_hub_dev_t *ext_hub_dev)
+{
+    return (ext_hub_dev->single_thread.stage == EXT_HUB_STAGE_IDLE &&
+            ext_hub_dev->single_thread.port_req_in_flight == 0);
+}
+
 static void handle_error(ext_hub_dev_t *ext_hub_dev)
 {
     ESP_LOGE(EXT_HUB_TAG, "[%d] Device is not working properly, wait device removal",
@@ -935,31 +1006,90 @@ static bool handle_hub_status(ext_hub_dev_t *ext_hub_dev)
     return true;
 }
 
-static void handle_port_feature(ext_hub_dev_t *ext_hub_dev)
+static void handle_port_request(ext_hub_dev_t *ext_hub_dev, usb_transfer_t *ctrl_xfer)
 {
-    usb_transfer_t *ctrl_xfer = &ext_hub_dev->constant.ctrl_urb->transfer;
-
-    uint8_t port_num = USB_SETUP_PACKET_GET_PORT((usb_setup_packet_t *)ctrl_xfer->data_buffer);
+    const usb_setup_packet_t *setup_pkt = (const usb_setup_packet_t *)ctrl_xfer->data_buffer;
+    uint8_t port_num = USB_SETUP_PACKET_GET_PORT(setup_pkt);
     uint8_t port_idx = port_num - 1;
 
     assert(port_idx < ext_hub_dev->constant.hub_desc->bNbrPorts);
     assert(p_ext_hub_driver->constant.port_driver);
+
+    if (ctrl_xfer->status != USB_TRANSFER_STATUS_COMPLETED) {
+        ESP_LOGE(EXT_HUB_TAG, "[%d:%d] Port request bad transfer status %d",
+                 ext_hub_dev->constant.dev_addr,
+                 port_num,
+                 ctrl_xfer->status);
+        if (ext_hub_dev->constant.ports[port_idx] != NULL) {
+            // Release the port from waiting for the request completion
+            ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->req_failed(ext_hub_dev->constant.ports[port_idx]));
+        }
+        // Set error and wait device to be removed
+        EXT_HUB_ENTER_CRITICAL();
+        bool call_proc_req_cb = _device_set_actions(ext_hub_dev, DEV_ACTION_ERROR);
+        EXT_HUB_EXIT_CRITICAL();
+        if (call_proc_req_cb) {
+            p_ext_hub_driver->constant.proc_req_cb(false, p_ext_hub_driver->constant.proc_req_cb_arg);
+        }
+        return;
+    }
+
+    if (ext_hub_dev->constant.ports[port_idx] == NULL) {
+        // Port has been freed while the request was in flight
+        return;
+    }
+
+    // Transfer completed, verbose data in ESP_LOG_VERBOSE is set
+    ESP_LOG_BUFFER_HEXDUMP(EXT_HUB_TAG, ctrl_xfer->data_buffer, ctrl_xfer->actual_num_bytes, ESP_LOG_VERBOSE);
+
     // [TODO: IDF-12174] Revisit the External Hub Driver to ensure consistent error handling.
-    ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->req_process(ext_hub_dev->constant.ports[port_idx]));
+    if (setup_pkt->bRequest == USB_B_REQUEST_HUB_GET_PORT_STATUS) {
+        const usb_port_status_t *new_status = (const usb_port_status_t *)(ctrl_xfer->data_buffer + sizeof(usb_setup_packet_t));
+        ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->set_status(ext_hub_dev->constant.ports[port_idx], new_status));
+    } else {
+        // Set Port Feature or Clear Port Feature
+        ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->req_process(ext_hub_dev->constant.ports[port_idx]));
+    }
 }
 
-static void handle_port_status(ext_hub_dev_t *ext_hub_dev)
+/**
+ * @brief Handle all completed port requests of the device
+ *
+ * The URB goes back to the idle list before the port is notified, so the port can issue its next request right away.
+ *
+ * @param[in] ext_hub_dev External Hub device
+ */
+static void handle_port_requests(ext_hub_dev_t *ext_hub_dev)
 {
-    usb_transfer_t *ctrl_xfer = &ext_hub_dev->constant.ctrl_urb->transfer;
+    bool call_proc_req_cb = false;
+    urb_t *urb;
 
-    uint8_t port_num = USB_SETUP_PACKET_GET_PORT((usb_setup_packet_t *)ctrl_xfer->data_buffer);
-    uint8_t port_idx = port_num - 1;
-    const usb_port_status_t *new_status = (const usb_port_status_t *)(ctrl_xfer->data_buffer + sizeof(usb_setup_packet_t));
+    while (1) {
+        EXT_HUB_ENTER_CRITICAL();
+        urb = TAILQ_FIRST(&ext_hub_dev->dynamic.port_req_done_tailq);
+        if (urb != NULL) {
+            TAILQ_REMOVE(&ext_hub_dev->dynamic.port_req_done_tailq, urb, tailq_entry);
+        }
+        EXT_HUB_EXIT_CRITICAL();
+        if (urb == NULL) {
+            break;
+        }
+        assert(ext_hub_dev->single_thread.port_req_in_flight > 0);
+        ext_hub_dev->single_thread.port_req_in_flight--;
+        TAILQ_INSERT_TAIL(&ext_hub_dev->single_thread.port_req_idle_tailq, urb, tailq_entry);
+        handle_port_request(ext_hub_dev, &urb->transfer);
+    }
 
-    assert(port_idx < ext_hub_dev->constant.hub_desc->bNbrPorts);
-    assert(p_ext_hub_driver->constant.port_driver);
-    // [TODO: IDF-12174] Revisit the External Hub Driver to ensure consistent error handling.
-    ESP_ERROR_CHECK(p_ext_hub_driver->constant.port_driver->set_status(ext_hub_dev->constant.ports[port_idx], new_status));
+    // The device could have been marked to be released while the port requests were in flight
+    EXT_HUB_ENTER_CRITICAL();
+    if (ext_hub_dev->dynamic.flags.waiting_release && device_is_idle(ext_hub_dev)) {
+        call_proc_req_cb = _device_set_actions(ext_hub_dev, DEV_ACTION_RELEASE);
+    }
+    EXT_HUB_EXIT_CRITICAL();
+
+    if (call_proc_req_cb) {
+        p_ext_hub_driver->constant.proc_req_cb(false, p_ext_hub_driver->constant.proc_req_cb_arg);
+    }
 }
 
 static bool device_control_request(ext_hub_dev_t *ext_hub_dev)
@@ -1021,14 +1151,6 @@ static bool device_control_response_handling(ext_hub_dev_t *ext_hub_dev)
     case EXT_HUB_STAGE_CHECK_HUB_STATUS:
         stage_pass = handle_hub_status(ext_hub_dev);
         break;
-    case EXT_HUB_STAGE_CHECK_PORT_FEATURE:
-        handle_port_feature(ext_hub_dev);
-        stage_pass =  true;
-        break;
-    case EXT_HUB_STAGE_CHECK_PORT_STATUS:
-        handle_port_status(ext_hub_dev);
-        stage_pass = true;
-        break;
     default:
         // Should never occur
         abort();
@@ -1077,7 +1199,8 @@ static bool device_set_next_stage(ext_hub_dev_t *ext_hub_dev, bool last_stage_pa
             // Terminal stages, move to IDLE
             next_stage = EXT_HUB_STAGE_IDLE;
             EXT_HUB_ENTER_CRITICAL();
-            if (ext_hub_dev->dynamic.flags.waiting_release) {
+            if (ext_hub_dev->dynamic.flags.waiting_release &&
+                    ext_hub_dev->single_thread.port_req_in_flight == 0) {
                 call_proc_req_cb = _device_set_actions(ext_hub_dev, DEV_ACTION_RELEASE);
             }
             EXT_HUB_EXIT_CRITICAL();
@@ -1110,8 +1233,6 @@ static void handle_device(ext_hub_dev_t *ext_hub_dev)
     case EXT_HUB_STAGE_CHECK_DEVICE_STATUS:
     case EXT_HUB_STAGE_CHECK_HUB_DESCRIPTOR:
     case EXT_HUB_STAGE_CHECK_HUB_STATUS:
-    case EXT_HUB_STAGE_CHECK_PORT_FEATURE:
-    case EXT_HUB_STAGE_CHECK_PORT_STATUS:
         stage_pass = device_control_response_handling(ext_hub_dev);
         break;
     default:
@@ -1332,6 +1453,18 @@ hcd_port_handle_t ext_hub_get_root_port(ext_hub_handle_t ext_hub_hdl)
     return root_port_hdl;
 }
 
+unsigned int ext_hub_get_uid(ext_hub_handle_t ext_hub_hdl)
+{
+    EXT_HUB_CHECK(ext_hub_hdl != NULL, 0);
+    EXT_HUB_CHECK(dev_is_in_list(ext_hub_hdl), 0);
+    ext_hub_dev_t *ext_hub_dev = (ext_hub_dev_t *)ext_hub_hdl;
+    unsigned int uid = 0;
+    if (usbh_dev_get_uid(ext_hub_dev->constant.dev_hdl, &uid) != ESP_OK) {
+        return 0;
+    }
+    return uid;
+}
+
 esp_err_t ext_hub_new_dev(uint8_t dev_addr)
 {
     EXT_HUB_ENTER_CRITICAL();
@@ -1468,9 +1601,9 @@ void ext_hub_mark_all_free(void)
             hub_next = TAILQ_NEXT(hub_curr, dynamic.tailq_entry);
             hub_curr->dynamic.flags.waiting_release = 1;
             uint32_t action_flags = DEV_ACTION_EP1_FLUSH | DEV_ACTION_EP1_DEQUEUE;
-            // If device in the IDLE stage, add the release action
-            // otherwise, device will be released when the stage changed to IDLE
-            if (hub_curr->single_thread.stage == EXT_HUB_STAGE_IDLE) {
+            // If device in the IDLE stage without port requests in flight, add the release action
+            // otherwise, device will be released when the stage changed to IDLE or the last port request is handled
+            if (device_is_idle(hub_curr)) {
                 action_flags |= DEV_ACTION_RELEASE;
             }
             call_proc_req_cb = _device_set_actions(hub_curr, action_flags);
@@ -1519,6 +1652,9 @@ esp_err_t ext_hub_process(void)
                 action_flags & DEV_ACTION_EP0_COMPLETE) {
             handle_device(ext_hub_dev);
         }
+        if (action_flags & DEV_ACTION_EP0_PORT_COMPLETE) {
+            handle_port_requests(ext_hub_dev);
+        }
         if (action_flags & DEV_ACTION_EP1_FLUSH) {
             handle_ep1_flush(ext_hub_dev);
         }
@@ -1704,35 +1840,44 @@ esp_err_t ext_hub_port_get_speed(ext_hub_handle_t ext_hub_hdl, uint8_t port_num,
 static esp_err_t ext_hub_control_request(ext_hub_dev_t *ext_hub_dev, uint8_t port1, uint8_t request, uint8_t feature)
 {
     esp_err_t ret;
-    usb_transfer_t *transfer = &ext_hub_dev->constant.ctrl_urb->transfer;
+    urb_t *urb = TAILQ_FIRST(&ext_hub_dev->single_thread.port_req_idle_tailq);
+    if (urb == NULL) {
+        // The External Port Driver postpones the request until another request of this Hub is completed
+        ESP_LOGD(EXT_HUB_TAG, "Request %X, port %d: no free ctrl urb", request, port1);
+        return ESP_ERR_NO_MEM;
+    }
+
+    usb_transfer_t *transfer = &urb->transfer;
     switch (request) {
     case USB_B_REQUEST_HUB_GET_PORT_STATUS:
         USB_SETUP_PACKET_INIT_GET_PORT_STATUS((usb_setup_packet_t *)transfer->data_buffer, port1);
         transfer->num_bytes = sizeof(usb_setup_packet_t) + sizeof(usb_port_status_t);
-        ext_hub_dev->single_thread.stage = EXT_HUB_STAGE_CHECK_PORT_STATUS;
         break;
     case USB_B_REQUEST_HUB_SET_PORT_FEATURE:
         USB_SETUP_PACKET_INIT_SET_PORT_FEATURE((usb_setup_packet_t *)transfer->data_buffer, port1, feature);
         transfer->num_bytes = sizeof(usb_setup_packet_t);
-        ext_hub_dev->single_thread.stage = EXT_HUB_STAGE_CHECK_PORT_FEATURE;
         break;
     case USB_B_REQUEST_HUB_CLEAR_FEATURE:
         USB_SETUP_PACKET_INIT_CLEAR_PORT_FEATURE((usb_setup_packet_t *)transfer->data_buffer, port1, feature);
         transfer->num_bytes = sizeof(usb_setup_packet_t);
-        ext_hub_dev->single_thread.stage = EXT_HUB_STAGE_CHECK_PORT_FEATURE;
         break;
     default:
         ESP_LOGE(EXT_HUB_TAG, "Request %X not supported", request);
         return ESP_ERR_NOT_SUPPORTED;
     }
 
-    ret = usbh_dev_submit_ctrl_urb(ext_hub_dev->constant.dev_hdl, ext_hub_dev->constant.ctrl_urb);
+    // Requests of different ports are queued on EP0 back to back, each one completes with its own URB
+    TAILQ_REMOVE(&ext_hub_dev->single_thread.port_req_idle_tailq, urb, tailq_entry);
+    ret = usbh_dev_submit_ctrl_urb(ext_hub_dev->constant.dev_hdl, urb);
     if (ret != ESP_OK) {
         ESP_LOGE(EXT_HUB_TAG, "Request %X, port %d, feature %d: failed to submit ctrl urb: %s",
                  request, port1, feature,
                  esp_err_to_name(ret));
+        TAILQ_INSERT_HEAD(&ext_hub_dev->single_thread.port_req_idle_tailq, urb, tailq_entry);
         device_error(ext_hub_dev);
+        return ret;
     }
+    ext_hub_dev->single_thread.port_req_in_flight++;
     return ret;
 }
 
@@ -1,16 +1,18 @@
 /*
- * SPDX-FileCopyrightText: 2024-2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2024-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <string.h>
 #include <stdint.h>
+#include <sys/param.h>
 #include "sdkconfig.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
 #include "usb_private.h"
 #include "usb/usb_types_ch9.h"
 #include "usb/usb_types_ch11.h"
@@ -28,6 +30,8 @@
 #define EXT_PORT_RESET_RECOVERY_DELAY_MS       CONFIG_USB_HOST_EXT_PORT_RESET_RECOVERY_DELAY_MS
 #define EXT_PORT_POWER_ON_CUSTOM_DELAY         CONFIG_USB_HOST_EXT_PORT_CUSTOM_POWER_ON_DELAY_ENABLE
 #define EXT_PORT_POWER_ON_CUSTOM_DELAY_MS      CONFIG_USB_HOST_EXT_PORT_CUSTOM_POWER_ON_DELAY_MS
+// Time to wait for a free slot in the timer command queue, when the delay timer is started
+#define EXT_PORT_TIMER_CMD_TIMEOUT_TICKS       pdMS_TO_TICKS(10)
 
 /**
  * @brief External Port driver action flags
@@ -38,6 +42,7 @@ typedef enum {
     PORT_ACTION_RECYCLE         = (1 << 2),     /**< Recycle port */
     PORT_ACTION_RESET           = (1 << 3),     /**< Reset port */
     PORT_ACTION_GET_STATUS      = (1 << 4),     /**< Get status request */
+    PORT_ACTION_SEND_REQ        = (1 << 5),     /**< Send the postponed request to the parent Hub */
 } port_action_t;
 
 /**
@@ -63,7 +68,12 @@ struct ext_port_s {
             uint32_t has_enum_device: 1;    /**< Port has an enumerated device */
             uint32_t waiting_recycle: 1;    /**< Port is waiting to be recycled */
             uint32_t waiting_free: 1;       /**< Port is waiting to be freed */
-            uint32_t reserved25: 25;        /**< Reserved */
+            uint32_t req_in_flight: 1;      /**< Port has a request to the parent Hub, which has not been completed yet */
+            uint32_t delayed: 1;            /**< Port waits for the power on or reset recovery delay to expire */
+            uint32_t wait_enum_slot: 1;     /**< Port waits for another port to release the default address */
+            uint32_t req_postponed: 1;      /**< Port has a request, the parent Hub had no room for */
+            uint32_t wait_parent: 1;        /**< Port waits for a request of the parent Hub to complete, before sending the postponed request */
+            uint32_t reserved20: 20;        /**< Reserved */
         };
         uint32_t val;                       /**< Ports' flags value */
     } flags;                                /**< Ports' flags */
@@ -72,6 +82,8 @@ struct ext_port_s {
     usb_port_status_t status;               /**< Ports' status data */
     port_dev_state_t dev_state;             /**< Ports' device state */
     uint8_t dev_reset_attempts;             /**< Ports' device reset failure */
+    TickType_t delay_until;                 /**< Ports' tick count, when the delay expires */
+    ext_port_parent_request_data_t postponed_req;   /**< Ports' request, waiting for the parent Hub to have room for it */
 
     struct {
         // Port related constant members
@@ -92,6 +104,7 @@ typedef struct ext_port_s ext_port_t;
 typedef struct {
     struct {
         TAILQ_HEAD(ext_ports, ext_port_s)       pending_tailq;           /**< External Ports require handling */
+        ext_port_t *enum_owner;                 /**< External Port, which resets and enumerates a device at the default address */
     } single_thread;                            /**< Single thread members don't require a critical section so long as they are never accessed from multiple threads */
 
     struct {
@@ -101,6 +114,7 @@ typedef struct {
         void *event_cb_arg;                     /**< External Port event callback argument */
         ext_port_parent_request_cb_t hub_request_cb;    /**< External Port Hub request callback */
         void *hub_request_cb_arg;                /**< External Port Hub request callback argument */
+        TimerHandle_t delay_timer;              /**< Timer, requesting the processing when the earliest port delay expires */
     } constant;                                 /**< Constant members. Do not change after installation thus do not require a critical section or mutex */
 } ext_port_driver_t;
 
@@ -209,23 +223,116 @@ static inline bool port_has_finished_reset(ext_port_t *ext_port)
     return ext_port->status.wPortChange.C_PORT_RESET ? true : false;
 }
 
+/**
+ * @brief Delays the further handling of the port
+ *
+ * The delay doesn't block the driver: other ports are handled, while this port waits.
+ * The delay timer requests the processing when the delay expires.
+ *
+ * @param[in] ext_port  Port object
+ * @param[in] delay_ms  Delay in ms
+ */
+static inline void port_delay(ext_port_t *ext_port, int delay_ms)
+{
+    if (delay_ms > 0) {
+        ext_port->delay_until = xTaskGetTickCount() + pdMS_TO_TICKS(delay_ms);
+        ext_port->flags.delayed = 1;
+    }
+}
+
 // -----------------------------------------------------------------------------
 // ------------------------ Parent Hub related logic ---------------------------
 // -----------------------------------------------------------------------------
 
 /**
- * @brief Request the port status for the port object
+ * @brief Updates the port after the request has been handed over to the parent Hub
+ *
+ * @param[in] ext_port  Port object
+ * @param[in] data      Request data
+ * @param[in] sent      The request is in flight. Otherwise, the request has been postponed
+ */
+static void port_request_update(ext_port_t *ext_port, const ext_port_parent_request_data_t *data, bool sent)
+{
+    if (data->control.req == USB_B_REQUEST_HUB_GET_PORT_STATUS) {
+        // Port is requesting status, lock the status
+        ext_port->flags.status_lock = 1;
+    } else {
+        // Every set or clear feature requires status update
+        ext_port->flags.status_outdated = 1;
+    }
+    if (!sent) {
+        return;
+    }
+    ext_port->flags.req_in_flight = 1;
+    if (data->control.req == USB_B_REQUEST_HUB_SET_PORT_FEATURE) {
+        switch (data->control.feature) {
+        case USB_FEATURE_PORT_POWER:
+            // PowerOn to PowerGood delay for port
+            port_delay(ext_port, ext_port->constant.power_on_delay_ms);
+            break;
+        case USB_FEATURE_PORT_RESET:
+            // Port has reset, give the port some time to recover
+            port_delay(ext_port, EXT_PORT_RESET_RECOVERY_DELAY_MS);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Sends the port request to the parent Hub
+ *
+ * When the parent Hub has no free transfer for the request, the request is postponed.
+ * The port sends it again, after another request of the same parent Hub has been completed.
  *
  * @note This call uses the External Hub Driver API
  *
- * @param[in] ext_port Port object
+ * @param[in] ext_port  Port object
+ * @param[in] data      Request data
  * @return
  *    - ESP_ERR_NOT_ALLOWED:    The External Hub Driver has not been installed
  *    - ESP_ERR_INVALID_ARG:    The parent hub handle couldn't be NULL
  *    - ESP_ERR_INVALID_SIZE:   The port number should be in a range: [1, .. , bNbrPort]
- *    - ESP_ERR_INVALID_STATE:  The parent hub device wasn't configured
+ *    - ESP_ERR_INVALID_STATE:  The parent hub device wasn't configured or the port already has a postponed request
  *    - ESP_ERR_NOT_SUPPORTED:  The request type is not supported by the External Hub Driver
- *    - ESP_OK:                 Status has been requested
+ *    - ESP_OK:                 Request has been sent or postponed
+ */
+static esp_err_t port_parent_request(ext_port_t *ext_port, ext_port_parent_request_data_t *data)
+{
+    esp_err_t ret = p_ext_port_driver->constant.hub_request_cb((ext_port_hdl_t)ext_port,
+                                                               data,
+                                                               p_ext_port_driver->constant.hub_request_cb_arg);
+    if (ret == ESP_ERR_NO_MEM) {
+        if (ext_port->flags.req_postponed) {
+            ESP_LOGE(EXT_PORT_TAG, "Port%d request %X dropped, port has a postponed request",
+                     ext_port->constant.port_num,
+                     data->control.req);
+            return ESP_ERR_INVALID_STATE;
+        }
+        ESP_LOGD(EXT_PORT_TAG, "Port%d request %X postponed, parent Hub is busy",
+                 ext_port->constant.port_num,
+                 data->control.req);
+        ext_port->postponed_req = *data;
+        ext_port->flags.req_postponed = 1;
+        ext_port->flags.wait_parent = 1;
+        ext_port->action_flags |= PORT_ACTION_SEND_REQ;
+        port_request_update(ext_port, data, false);
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    port_request_update(ext_port, data, true);
+    return ESP_OK;
+}
+
+/**
+ * @brief Request the port status for the port object
+ *
+ * @param[in] ext_port Port object
+ * @return
+ *    - See port_parent_request()
  */
 static esp_err_t port_request_status(ext_port_t *ext_port)
 {
@@ -235,31 +342,16 @@ static esp_err_t port_request_status(ext_port_t *ext_port)
             .req = USB_B_REQUEST_HUB_GET_PORT_STATUS,
         }
     };
-
-    esp_err_t ret = p_ext_port_driver->constant.hub_request_cb((ext_port_hdl_t)ext_port,
-                                                               &data,
-                                                               p_ext_port_driver->constant.hub_request_cb_arg);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-    // Port is requesting status, lock the status
-    ext_port->flags.status_lock = 1;
-    return ESP_OK;
+    return port_parent_request(ext_port, &data);
 }
 
 /**
  * @brief Sets the feature to the port
  *
- * @note This call uses the External Hub Driver API
- *
  * @param[in] ext_port  Port object
  * @param[in] feature   Port feature to set
  * @return
- *    - ESP_ERR_NOT_ALLOWED:    The External Hub Driver has not been installed
- *    - ESP_ERR_INVALID_ARG:    The parent hub handle couldn't be NULL
- *    - ESP_ERR_INVALID_SIZE:   The port number should be in a range: [1, .. , bNbrPort]
- *    - ESP_ERR_INVALID_STATE:  The parent hub device wasn't configured
- *    - ESP_OK:                 SetPortFeature() has been requested
+ *    - See port_parent_request()
  */
 static esp_err_t port_set_feature(ext_port_t *ext_port, const usb_hub_port_feature_t feature)
 {
@@ -270,43 +362,16 @@ static esp_err_t port_set_feature(ext_port_t *ext_port, const usb_hub_port_featu
             .feature = feature,
         }
     };
-
-    esp_err_t ret = p_ext_port_driver->constant.hub_request_cb((ext_port_hdl_t)ext_port,
-                                                               &data,
-                                                               p_ext_port_driver->constant.hub_request_cb_arg);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-    // Every set feature requires status update
-    ext_port->flags.status_outdated = 1;
-    switch (feature) {
-    case USB_FEATURE_PORT_POWER:
-        // PowerOn to PowerGood delay for port
-        vTaskDelay(pdMS_TO_TICKS(ext_port->constant.power_on_delay_ms));
-        break;
-    case USB_FEATURE_PORT_RESET:
-        // Port has reset, give the port some time to recover
-        vTaskDelay(pdMS_TO_TICKS(EXT_PORT_RESET_RECOVERY_DELAY_MS));
-        break;
-    default:
-        break;
-    }
-    return ret;
+    return port_parent_request(ext_port, &data);
 }
 
 /**
  * @brief Clears the feature to the port
  *
- * @note This call uses the External Hub Driver API
- *
  * @param[in] ext_port  Port object
  * @param[in] feature   Port feature to set
  * @return
- *    - ESP_ERR_NOT_ALLOWED:    The External Hub Driver has not been installed
- *    - ESP_ERR_INVALID_ARG:    The parent hub handle couldn't be NULL
- *    - ESP_ERR_INVALID_SIZE:   The port number should be in a range: [1, .. , bNbrPort]
- *    - ESP_ERR_INVALID_STATE:  The parent hub device wasn't configured
- *    - ESP_OK:                 ClearPortFeature() has been requested
+ *    - See port_parent_request()
  */
 static esp_err_t port_clear_feature(ext_port_t *ext_port, const usb_hub_port_feature_t feature)
 {
@@ -317,16 +382,27 @@ static esp_err_t port_clear_feature(ext_port_t *ext_port, const usb_hub_port_fea
             .feature = feature,
         }
     };
+    return port_parent_request(ext_port, &data);
+}
 
-    esp_err_t ret = p_ext_port_driver->constant.hub_request_cb((ext_port_hdl_t)ext_port,
-                                                               &data,
-                                                               p_ext_port_driver->constant.hub_request_cb_arg);
+/**
+ * @brief Sends the postponed request to the parent Hub
+ *
+ * @param[in] ext_port  Port object
+ */
+static void port_send_postponed_request(ext_port_t *ext_port)
+{
+    if (!ext_port->flags.req_postponed) {
+        return;
+    }
+    ext_port->flags.req_postponed = 0;
+    ext_port_parent_request_data_t data = ext_port->postponed_req;
+    esp_err_t ret = port_parent_request(ext_port, &data);
     if (ret != ESP_OK) {
-        return ret;
+        ESP_LOGE(EXT_PORT_TAG, "Port%d unable to send the postponed request: %s",
+                 ext_port->constant.port_num,
+                 esp_err_to_name(ret));
     }
-    // Every clearing feature requires status update
-    ext_port->flags.status_outdated = 1;
-    return ret;
 }
 
 // -----------------------------------------------------------------------------
@@ -359,6 +435,59 @@ static void port_set_actions(ext_port_t *ext_port, uint32_t action_flags)
     p_ext_port_driver->constant.proc_req_cb(p_ext_port_driver->constant.proc_req_cb_arg);
 }
 
+/**
+ * @brief Acquires the default address for the device, connected to the port
+ *
+ * Only one device can respond to the default address. A port owns it from the first port reset until
+ * the handling of the port is completed, i.e. the device has been enumerated or the port is idle.
+ * When another port owns the default address, the port waits with the reset and keeps the action flags,
+ * that are handled after the owner releases the default address.
+ *
+ * @param[in] ext_port      Port object
+ * @param[in] action_flags  Action flags to handle, when the port acquires the default address
+ * @return
+ *    - true:   Port owns the default address and can be reset
+ *    - false:  Another port owns the default address
+ */
+static bool port_acquire_enum_slot(ext_port_t *ext_port, uint32_t action_flags)
+{
+    ext_port_t *owner = p_ext_port_driver->single_thread.enum_owner;
+    if (owner == NULL || owner == ext_port) {
+        p_ext_port_driver->single_thread.enum_owner = ext_port;
+        return true;
+    }
+    ESP_LOGD(EXT_PORT_TAG, "Port%d waits for Port%d to release the default address",
+             ext_port->constant.port_num,
+             owner->constant.port_num);
+    ext_port->flags.wait_enum_slot = 1;
+    ext_port->action_flags |= action_flags;
+    return false;
+}
+
+/**
+ * @brief Releases the default address, if the port owns it
+ *
+ * The first port, waiting for the default address, continues the handling.
+ *
+ * @param[in] ext_port      Port object
+ */
+static void port_release_enum_slot(ext_port_t *ext_port)
+{
+    if (p_ext_port_driver->single_thread.enum_owner != ext_port) {
+        return;
+    }
+    p_ext_port_driver->single_thread.enum_owner = NULL;
+
+    ext_port_t *port = NULL;
+    TAILQ_FOREACH(port, &p_ext_port_driver->single_thread.pending_tailq, tailq_entry) {
+        if (port->flags.wait_enum_slot) {
+            port->flags.wait_enum_slot = 0;
+            p_ext_port_driver->constant.proc_req_cb(p_ext_port_driver->constant.proc_req_cb_arg);
+            break;
+        }
+    }
+}
+
 /**
  * @brief Stops the handling and remove the port from the pending list
  *
@@ -390,6 +519,12 @@ static void port_stop_handling(ext_port_t *ext_port)
                  ext_port->action_flags);
     }
     ext_port->action_flags = 0;
+    // The request in flight (if any) is still owned by the parent Hub, the flag is cleared on its completion
+    ext_port->flags.delayed = 0;
+    ext_port->flags.wait_enum_slot = 0;
+    ext_port->flags.req_postponed = 0;
+    ext_port->flags.wait_parent = 0;
+    port_release_enum_slot(ext_port);
 }
 
 /**
@@ -411,16 +546,83 @@ static void port_event(ext_port_t *ext_port, ext_port_event_t event)
 }
 
 /**
- * @brief Returns first port from the pending list
+ * @brief Parent Hub of the port has no room for another request
+ *
+ * The parent Hub queues up to EXT_PORT_PARENT_REQ_MAX port requests on its control pipe. Requests of different ports
+ * are pipelined, the rest wait until one of them is completed.
+ *
+ * @param[in] ext_port  Port object
+ * @return
+ *    - true:   Parent Hub has EXT_PORT_PARENT_REQ_MAX requests in flight
+ *    - false:  Parent Hub is ready for the next request
+ */
+static bool port_parent_is_busy(ext_port_t *ext_port)
+{
+    ext_port_t *port = NULL;
+    int num_in_flight = 0;
+    TAILQ_FOREACH(port, &p_ext_port_driver->single_thread.pending_tailq, tailq_entry) {
+        if (port->flags.req_in_flight && port->constant.context == ext_port->constant.context) {
+            num_in_flight++;
+        }
+    }
+    return (num_in_flight >= EXT_PORT_PARENT_REQ_MAX);
+}
+
+/**
+ * @brief Request of the port has been completed by the parent Hub
+ *
+ * The parent Hub has room for another request: ports of the same parent Hub, waiting to send the postponed
+ * request, continue the handling.
+ *
+ * @param[in] ext_port  Port object
+ */
+static void port_parent_request_done(ext_port_t *ext_port)
+{
+    ext_port->flags.req_in_flight = 0;
+
+    ext_port_t *port = NULL;
+    TAILQ_FOREACH(port, &p_ext_port_driver->single_thread.pending_tailq, tailq_entry) {
+        if (port->flags.wait_parent && port->constant.context == ext_port->constant.context) {
+            port->flags.wait_parent = 0;
+        }
+    }
+}
+
+/**
+ * @brief Returns first port from the pending list, which can be handled now
+ *
+ * The port can be handled, when it has actions and:
+ * - its power on or reset recovery delay has expired
+ * - it doesn't wait for the default address
+ * - it doesn't wait for the parent Hub to complete a request
+ * - its parent Hub has room for another request
  *
+ * @param[out] wait_ticks   Ticks until the earliest delay of a port with actions expires, portMAX_DELAY if there is no such port
  * @return
- *    - Port object pointer. NULL if no ports in pending list.
+ *    - Port object pointer. NULL if no port in pending list can be handled now.
  */
-static ext_port_t *get_port_from_pending_list(void)
+static ext_port_t *get_port_from_pending_list(TickType_t *wait_ticks)
 {
+    const TickType_t now = xTaskGetTickCount();
     ext_port_t *ext_port = NULL;
-    if (!TAILQ_EMPTY(&p_ext_port_driver->single_thread.pending_tailq)) {
-        ext_port = TAILQ_FIRST(&p_ext_port_driver->single_thread.pending_tailq);
+
+    *wait_ticks = portMAX_DELAY;
+    TAILQ_FOREACH(ext_port, &p_ext_port_driver->single_thread.pending_tailq, tailq_entry) {
+        if (ext_port->action_flags == 0 || ext_port->flags.wait_enum_slot || ext_port->flags.wait_parent) {
+            continue;
+        }
+        if (ext_port->flags.delayed) {
+            const TickType_t remaining = ext_port->delay_until - now;
+            if ((int32_t)remaining > 0) {
+                *wait_ticks = MIN(*wait_ticks, remaining);
+                continue;
+            }
+            ext_port->flags.delayed = 0;
+        }
+        if (port_parent_is_busy(ext_port)) {
+            continue;
+        }
+        break;
     }
     return ext_port;
 }
@@ -640,8 +842,10 @@ static void handle_port_state(ext_port_t *ext_port)
         if (port_has_connection(ext_port)) {
             if (ext_port->dev_reset_attempts < EXT_PORT_RESET_ATTEMPTS) {
                 // Available, it EXT_PORT_RESET_ATTEMPTS > 1
-                ext_port->dev_reset_attempts++;
-                port_set_feature(ext_port, USB_FEATURE_PORT_RESET);
+                if (port_acquire_enum_slot(ext_port, PORT_ACTION_HANDLE)) {
+                    ext_port->dev_reset_attempts++;
+                    port_set_feature(ext_port, USB_FEATURE_PORT_RESET);
+                }
                 need_handling = true;
             } else {
                 ESP_LOGE(EXT_PORT_TAG, "Port%d unable to reset the device", ext_port->constant.port_num);
@@ -664,8 +868,10 @@ static void handle_port_state(ext_port_t *ext_port)
             // Port in resetting state and has connection
             if (ext_port->dev_state == PORT_DEV_NOT_PRESENT) {
                 assert(ext_port->dev_reset_attempts == 0); // First reset, attempts always should be 0
-                ext_port->dev_reset_attempts++;
-                port_set_feature(ext_port, USB_FEATURE_PORT_RESET);
+                if (port_acquire_enum_slot(ext_port, PORT_ACTION_HANDLE)) {
+                    ext_port->dev_reset_attempts++;
+                    port_set_feature(ext_port, USB_FEATURE_PORT_RESET);
+                }
             } else {
                 assert(port_is_enabled(ext_port)); // Port should be enabled
                 port_event(ext_port, EXT_PORT_RESET_COMPLETED);
@@ -848,6 +1054,88 @@ static void handle_disable(ext_port_t *ext_port)
     }
 }
 
+/**
+ * @brief Port object handling of all the pending actions
+ *
+ * Stops, when the port has to wait for a request completion, a delay or the default address.
+ * The remaining actions stay in the port object and are handled later.
+ *
+ * @param[in] ext_port  Port object
+ */
+static void handle_actions(ext_port_t *ext_port)
+{
+    uint32_t action_flags = ext_port->action_flags;
+    ext_port->action_flags = 0;
+
+    while (action_flags) {
+        // Keep processing until all port's action have been handled
+        ESP_LOGD(EXT_PORT_TAG, "Port%d actions 0x%"PRIx32"", ext_port->constant.port_num, action_flags);
+
+        if (action_flags & PORT_ACTION_SEND_REQ) {
+            port_send_postponed_request(ext_port);
+        }
+        if (action_flags & PORT_ACTION_HANDLE) {
+            handle_port(ext_port);
+        }
+        if (action_flags & PORT_ACTION_DISABLE) {
+            handle_disable(ext_port);
+        }
+        if (action_flags & PORT_ACTION_RECYCLE) {
+            handle_recycle(ext_port);
+        }
+
+        /*
+        * Feature related actions are mutual exclusive and require:
+        * - transfer completion callback
+        * - further request of new port status via get_status(), except PORT_ACTION_GET_STATUS itself
+        * The port has only one request to the parent Hub at a time, the actions wait for the previous request.
+        */
+        if (ext_port->flags.req_in_flight || ext_port->flags.req_postponed) {
+            ext_port->action_flags |= action_flags & (PORT_ACTION_GET_STATUS | PORT_ACTION_RESET);
+        } else if (action_flags & PORT_ACTION_GET_STATUS) {
+            port_request_status(ext_port);
+        } else if ((action_flags & PORT_ACTION_RESET) && port_acquire_enum_slot(ext_port, PORT_ACTION_RESET)) {
+            if (ext_port->state != USB_PORT_STATE_RESETTING) {
+                /*
+                * IMPORTANT NOTE
+                * This is possible, when the reset is requested via port_reset()
+                * Port reset is possible only in two states:
+                * - USB_PORT_STATE_DISCONNECTED (mainly, first reset)
+                * - USB_PORT_STATE_ENABLED      (mainly, second reset)
+                */
+                assert(ext_port->state ==  USB_PORT_STATE_DISCONNECTED ||
+                       ext_port->state == USB_PORT_STATE_ENABLED);
+                ext_port->state = USB_PORT_STATE_RESETTING;
+            }
+            port_set_feature(ext_port, USB_FEATURE_PORT_RESET);
+        }
+
+        if (!ext_port->flags.in_pending_list ||
+                ext_port->flags.req_in_flight ||
+                ext_port->flags.delayed ||
+                ext_port->flags.wait_enum_slot ||
+                ext_port->flags.wait_parent) {
+            // Port has been handled or has to wait, the remaining actions are handled later
+            break;
+        }
+        action_flags = ext_port->action_flags;
+        ext_port->action_flags = 0;
+    }
+}
+
+/**
+ * @brief Delay timer callback
+ *
+ * @param[in] timer     Delay timer handle
+ */
+static void delay_timer_cb(TimerHandle_t timer)
+{
+    ext_port_driver_t *ext_port_drv = p_ext_port_driver;
+    if (ext_port_drv != NULL) {
+        ext_port_drv->constant.proc_req_cb(ext_port_drv->constant.proc_req_cb_arg);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // ------------------------ External Port API ----------------------------------
 // -----------------------------------------------------------------------------
@@ -1174,13 +1462,19 @@ static esp_err_t port_set_status(void *port_hdl, const usb_port_status_t *port_s
     EXT_PORT_CHECK(port_hdl != NULL && port_status != NULL, ESP_ERR_INVALID_ARG);
     ext_port_t *ext_port = (ext_port_t *)port_hdl;
 
+    // Request has been completed, parent Hub is ready for the next request
+    port_parent_request_done(ext_port);
+    // Remove status lock
+    ext_port->flags.status_lock = 0;
+    if (ext_port->flags.is_gone) {
+        // Port is gone, the status has no meaning anymore
+        return ESP_OK;
+    }
     // Update status
     ext_port->status.wPortChange.val = port_status->wPortChange.val;
     ext_port->status.wPortStatus.val = port_status->wPortStatus.val;
     // Status valid
     ext_port->flags.status_outdated = 0;
-    // Remove status lock
-    ext_port->flags.status_lock = 0;
     // Request port handling
     port_set_actions(ext_port, PORT_ACTION_HANDLE);
     return ESP_OK;
@@ -1203,6 +1497,12 @@ static esp_err_t port_req_process(void *port_hdl)
     EXT_PORT_CHECK(port_hdl != NULL, ESP_ERR_INVALID_ARG);
     ext_port_t *ext_port = (ext_port_t *)port_hdl;
 
+    // Request has been completed, parent Hub is ready for the next request
+    port_parent_request_done(ext_port);
+    if (ext_port->flags.is_gone) {
+        // Port is gone, nothing to handle
+        return ESP_OK;
+    }
     if (ext_port->flags.status_outdated) {
         port_set_actions(ext_port, PORT_ACTION_GET_STATUS);
     } else {
@@ -1211,6 +1511,34 @@ static esp_err_t port_req_process(void *port_hdl)
     return ESP_OK;
 }
 
+/**
+ * @brief Indicate to the External Port Driver that the Port request has failed
+ *
+ * The parent Hub runs into an error and waits to be removed. The port doesn't send any further requests,
+ * the port is handled when the parent Hub marks it as gone.
+ *
+ * @note This function should only be called from the External Hub Driver
+ *
+ * @param[in] port_hdl      Port object handle
+ * @return
+ *    - ESP_ERR_NOT_ALLOWED:    The External Port Driver has not been installed
+ *    - ESP_ERR_INVALID_ARG:    The port handle can't be NULL
+ *    - ESP_OK:                 Port request has been dropped
+ */
+static esp_err_t port_req_failed(void *port_hdl)
+{
+    EXT_PORT_CHECK(p_ext_port_driver != NULL, ESP_ERR_NOT_ALLOWED);
+    EXT_PORT_CHECK(port_hdl != NULL, ESP_ERR_INVALID_ARG);
+    ext_port_t *ext_port = (ext_port_t *)port_hdl;
+
+    ESP_LOGD(EXT_PORT_TAG, "Port%d request failed", ext_port->constant.port_num);
+
+    ext_port->flags.req_in_flight = 0;
+    ext_port->flags.status_lock = 0;
+    ext_port->flags.status_outdated = 1;
+    return ESP_OK;
+}
+
 // -----------------------------------------------------------------------------
 // ------------------ External Port Processing Functions -----------------------
 // -----------------------------------------------------------------------------
@@ -1230,6 +1558,7 @@ const ext_port_driver_api_t ext_port_driver = {
     .get_status = port_get_status,
     .set_status = port_set_status,
     .req_process = port_req_process,
+    .req_failed = port_req_failed,
 };
 
 esp_err_t ext_port_install(const ext_port_driver_config_t *config)
@@ -1250,6 +1579,11 @@ esp_err_t ext_port_install(const ext_port_driver_config_t *config)
     ext_port_drv->constant.event_cb_arg = config->event_cb_arg;
     ext_port_drv->constant.hub_request_cb = config->hub_request_cb;
     ext_port_drv->constant.hub_request_cb_arg = config->hub_request_cb_arg;
+    ext_port_drv->constant.delay_timer = xTimerCreate("ext_port_tmr", 1, pdFALSE, NULL, delay_timer_cb);
+    if (ext_port_drv->constant.delay_timer == NULL) {
+        heap_caps_free(ext_port_drv);
+        return ESP_ERR_NO_MEM;
+    }
     TAILQ_INIT(&ext_port_drv->single_thread.pending_tailq);
 
     p_ext_port_driver = ext_port_drv;
@@ -1265,6 +1599,7 @@ esp_err_t ext_port_uninstall(void)
     ext_port_driver_t *ext_port_drv = p_ext_port_driver;
     p_ext_port_driver = NULL;
 
+    xTimerDelete(ext_port_drv->constant.delay_timer, portMAX_DELAY);
     heap_caps_free(ext_port_drv);
     ESP_LOGD(EXT_PORT_TAG, "Driver uninstalled");
     return ESP_OK;
@@ -1274,8 +1609,7 @@ esp_err_t ext_port_process(void)
 {
     EXT_PORT_CHECK(p_ext_port_driver != NULL, ESP_ERR_NOT_ALLOWED);
 
-    ext_port_t *ext_port = get_port_from_pending_list();
-    if (ext_port == NULL) {
+    if (TAILQ_EMPTY(&p_ext_port_driver->single_thread.pending_tailq)) {
         // No more ports in list to handle
         // NOTE:
         // This is possible, when an external Hub detached sooner than being
@@ -1286,48 +1620,22 @@ esp_err_t ext_port_process(void)
         return ESP_OK;
     }
 
-    uint32_t action_flags = ext_port->action_flags;
-    ext_port->action_flags = 0;
-
-    while (action_flags) {
-        // Keep processing until all port's action have been handled
-        ESP_LOGD(EXT_PORT_TAG, "Port%d actions 0x%"PRIx32"", ext_port->constant.port_num, action_flags);
+    // Ports wait for their delays and requests independently, so all ports that can be handled now are handled
+    TickType_t wait_ticks;
+    ext_port_t *ext_port;
+    while ((ext_port = get_port_from_pending_list(&wait_ticks)) != NULL) {
+        handle_actions(ext_port);
+    }
 
-        if (action_flags & PORT_ACTION_HANDLE) {
-            handle_port(ext_port);
-        }
-        if (action_flags & PORT_ACTION_DISABLE) {
-            handle_disable(ext_port);
-        }
-        if (action_flags & PORT_ACTION_RECYCLE) {
-            handle_recycle(ext_port);
+    if (wait_ticks != portMAX_DELAY) {
+        // Request the processing when the earliest delay expires.
+        // When the timer command queue is full, wait for the timer task to take the command.
+        if (xTimerChangePeriod(p_ext_port_driver->constant.delay_timer, MAX(wait_ticks, 1), EXT_PORT_TIMER_CMD_TIMEOUT_TICKS) != pdPASS) {
+            // Without the timer, the delayed ports would never be handled. Request the processing right away
+            // instead: the ports are handled as soon as their delays expire
+            ESP_LOGW(EXT_PORT_TAG, "Unable to start the delay timer");
+            p_ext_port_driver->constant.proc_req_cb(p_ext_port_driver->constant.proc_req_cb_arg);
         }
-
-        /*
-        * Feature related actions are mutual exclusive and require:
-        * - transfer completion callback
-        * - further request of new port status via get_status(), except PORT_ACTION_GET_STATUS itself
-        */
-        if (action_flags & PORT_ACTION_GET_STATUS) {
-            port_request_status(ext_port);
-        } else if (action_flags & PORT_ACTION_RESET) {
-            if (ext_port->state != USB_PORT_STATE_RESETTING) {
-                /*
-                * IMPORTANT NOTE
-                * This is possible, when the reset is requested via port_reset()
-                * Port reset is possible only in two states:
-                * - USB_PORT_STATE_DISCONNECTED (mainly, first reset)
-                * - USB_PORT_STATE_ENABLED      (mainly, second reset)
-                */
-                assert(ext_port->state ==  USB_PORT_STATE_DISCONNECTED ||
-                       ext_port->state == USB_PORT_STATE_ENABLED);
-                ext_port->state = USB_PORT_STATE_RESETTING;
-            }
-            port_set_feature(ext_port, USB_FEATURE_PORT_RESET);
-        }
-
-        action_flags = ext_port->action_flags;
-        ext_port->action_flags = 0;
     }
 
     return ESP_OK;
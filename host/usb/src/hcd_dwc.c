@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <sys/param.h>
+#include <limits.h>
 #include <sys/queue.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
@@ -16,6 +18,7 @@
 #include "esp_intr_alloc.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "hal/usb_dwc_hal.h"
 #include "hcd.h"
@@ -23,6 +26,8 @@
 #include "usb/usb_types_ch9.h"
 
 #include "esp_cache.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
 #include "esp_private/esp_cache_private.h"
 
 #include "esp_idf_version.h"
@@ -36,6 +41,7 @@
 // ----------------------------------------------------- Macros --------------------------------------------------------
 
 #define ALIGN_UP(num, align)    ((align) == 0 ? (num) : (((num) + ((align) - 1)) & ~((align) - 1)))
+#define ALIGN_DOWN(num, align)  ((align) == 0 ? (num) : ((num) & ~((align) - 1)))
 
 // --------------------- Constants -------------------------
 
@@ -69,6 +75,19 @@
 #define XFER_LIST_LEN_ISOC                      64  // Implement longer ISOC transfer list to give us enough space for additional timing margin
 #define XFER_LIST_ISOC_MARGIN                   3   // The 1st ISOC transfer is scheduled 3 (micro)frames later so we have enough timing margin
 
+// Periodic bus time. FS/LS ports count in FS byte times per frame, HS ports in HS byte times per microframe
+// @see USB 2.0 specs, chapter 5.7.4 and 5.8.4: at most 90% of a FS frame and 80% of a HS microframe are periodic
+#define PERIODIC_BUS_TIME_FS                    1350    // 90% of 1500 FS byte times
+#define PERIODIC_BUS_TIME_HS                    6000    // 80% of 7500 HS byte times
+#define PERIODIC_SLOTS_FS                       FRAME_LIST_LEN      // FS/LS ports budget every frame of the frame list
+#define PERIODIC_SLOTS_HS                       (FRAME_LIST_LEN * 8) // HS ports budget every microframe of the frame list
+// Protocol overhead of one transaction in byte times, approximated from the bus time formulas of USB 2.0 chapter 5.11.3
+#define PERIODIC_OVERHEAD_FS_ISOC               11
+#define PERIODIC_OVERHEAD_FS_INTR               14
+#define PERIODIC_OVERHEAD_LS                    97      // In FS byte times, includes the preamble and the hub setup
+#define PERIODIC_OVERHEAD_HS_ISOC               38
+#define PERIODIC_OVERHEAD_HS_INTR               55
+
 // ------------------------ Internal --------------------------
 
 /**
@@ -91,6 +110,8 @@ DEFINE_CRIT_SECTION_LOCK_STATIC(hcd_lock);
 #define HCD_EXIT_CRITICAL_ISR()        esp_os_exit_critical_isr(&hcd_lock)
 #define HCD_ENTER_CRITICAL()           esp_os_enter_critical(&hcd_lock)
 #define HCD_EXIT_CRITICAL()            esp_os_exit_critical(&hcd_lock)
+#define HCD_ENTER_CRITICAL_SAFE()      esp_os_enter_critical_safe(&hcd_lock)
+#define HCD_EXIT_CRITICAL_SAFE()       esp_os_exit_critical_safe(&hcd_lock)
 
 #define HCD_CHECK(cond, ret_val) ({                                         \
             if (!(cond)) {                                                  \
@@ -114,16 +135,18 @@ DEFINE_CRIT_SECTION_LOCK_STATIC(hcd_lock);
  */
 #if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
 #define CACHE_SYNC_FRAME_LIST(frame_list)           cache_sync_frame_list(frame_list)
-#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_M2C(buffer) cache_sync_xfer_descriptor_list(buffer, true)
-#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_C2M(buffer) cache_sync_xfer_descriptor_list(buffer, false)
+#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_M2C(pipe, buffer) cache_sync_xfer_descriptor_list(pipe, buffer, true)
+#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_C2M(pipe, buffer) cache_sync_xfer_descriptor_list(pipe, buffer, false)
 #define CACHE_SYNC_DATA_BUFFER_M2C(pipe, urb)       cache_sync_data_buffer(pipe, urb, true)
 #define CACHE_SYNC_DATA_BUFFER_C2M(pipe, urb)       cache_sync_data_buffer(pipe, urb, false)
+#define CACHE_SYNC_BATCH_FLUSH(pipe)                cache_sync_batch_flush(pipe)
 #else // SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
 #define CACHE_SYNC_FRAME_LIST(frame_list)
-#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_M2C(buffer)
-#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_C2M(buffer)
+#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_M2C(pipe, buffer)
+#define CACHE_SYNC_XFER_DESCRIPTOR_LIST_C2M(pipe, buffer)
 #define CACHE_SYNC_DATA_BUFFER_M2C(pipe, urb)
 #define CACHE_SYNC_DATA_BUFFER_C2M(pipe, urb)
+#define CACHE_SYNC_BATCH_FLUSH(pipe)
 #endif // SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
 
 // ------------------------------------------------------ Types --------------------------------------------------------
@@ -131,6 +154,15 @@ DEFINE_CRIT_SECTION_LOCK_STATIC(hcd_lock);
 typedef struct pipe_obj pipe_t;
 typedef struct port_obj port_t;
 
+/**
+ * @brief Memory range collected for a single cache sync
+ */
+typedef struct {
+    uintptr_t start;                        // Cache line aligned start address
+    uintptr_t end;                          // Cache line aligned end address. Equal to start if the batch is empty
+    int flags;                              // esp_cache_msync() flags of the range
+} cache_sync_batch_t;
+
 /**
  * @brief Object representing a single buffer of a pipe's multi buffer implementation
  */
@@ -203,6 +235,12 @@ struct pipe_obj {
     // HAL related
     usb_dwc_hal_chan_t *chan_obj;
     usb_dwc_hal_ep_char_t ep_char;
+    // Periodic bus time, reserved by the pipe in the (micro)frames of the port's frame list
+    struct {
+        uint16_t bus_time;                  // Bus time of the pipe in each of its (micro)frames. 0 for non-periodic pipes
+        uint16_t interval;                  // Interval of the pipe in frames (FS/LS port) or microframes (HS port)
+        uint16_t offset;                    // First (micro)frame of the pipe in the frame list
+    } periodic_reservation;
     // Port related
     port_t *port;                           // The port to which this pipe is routed through
     TAILQ_ENTRY(pipe_obj) tailq_entry;      // TailQ entry for port's list of pipes
@@ -219,6 +257,11 @@ struct pipe_obj {
         };
         uint32_t val;
     } cs_flags;
+    // Cache sync related
+    cache_sync_batch_t cache_sync_batch;    // Write-backs collected while filling buffers, synced before execution
+    hcd_pipe_cache_sync_stats_t cache_sync_stats;
+    // Transfer statistics. Updated in critical sections
+    usb_ep_stats_t stats;
     // Pipe callback and context
     hcd_pipe_callback_t callback;
     void *callback_arg;
@@ -231,6 +274,7 @@ struct pipe_obj {
 struct port_obj {
     usb_dwc_hal_context_t *hal;
     void *frame_list;
+    uint16_t periodic_bus_time[PERIODIC_SLOTS_HS];  // Bus time reserved by periodic pipes in each frame (FS/LS) or microframe (HS) of the frame list
     // Pipes routed through this port
     TAILQ_HEAD(tailhead_pipes_idle, pipe_obj) pipes_idle_tailq;
     TAILQ_HEAD(tailhead_pipes_queued, pipe_obj) pipes_active_tailq;
@@ -254,6 +298,7 @@ struct port_obj {
         uint32_t val;
     } flags;
     int periph_idx;                                 // Peripheral index of this port. Used for initialization check
+    usb_port_stats_t stats;                         // Port statistics. Updated in critical sections, frame_num is only set when read
     // FIFO related
     usb_dwc_hal_fifo_config_t fifo_config;          // FIFO config to be applied at HAL level
     // Port callback and context
@@ -273,6 +318,8 @@ static bool s_port_inited[HCD_NUM_PORTS] = {0};
 // --------------------- Cache sync ------------------------
 
 #if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+static size_t s_cache_line_size = 0;    // Cache line size of the DMA capable memory. Set on port initialization
+
 /**
  * @brief Sync Frame List from cache to memory
  */
@@ -283,40 +330,136 @@ static inline void cache_sync_frame_list(void *frame_list)
     (void)ret;
 }
 
+/**
+ * @brief Sync a cache line aligned memory range and account it to the pipe's statistics
+ *
+ * @param[in] pipe  Pipe to account the sync to
+ * @param[in] start Cache line aligned start address
+ * @param[in] end   Cache line aligned end address
+ * @param[in] flags esp_cache_msync() flags
+ */
+static void IRAM_ATTR cache_sync_range(pipe_t *pipe, uintptr_t start, uintptr_t end, int flags)
+{
+    const uint32_t start_cycles = esp_cpu_get_cycle_count();
+    esp_err_t ret = esp_cache_msync((void *)start, end - start, flags);
+    assert(ret == ESP_OK);
+    (void)ret;
+    pipe->cache_sync_stats.num_syncs++;
+    pipe->cache_sync_stats.num_bytes += end - start;
+    pipe->cache_sync_stats.num_cycles += esp_cpu_get_cycle_count() - start_cycles;
+}
+
+/**
+ * @brief Sync the collected range of a pipe's cache sync batch
+ *
+ * Must be called before the DMA accesses any of the memory added to the batch
+ *
+ * @param[in] pipe Pipe object
+ */
+static void IRAM_ATTR cache_sync_batch_flush(pipe_t *pipe)
+{
+    cache_sync_batch_t *batch = &pipe->cache_sync_batch;
+    if (batch->end != batch->start) {
+        cache_sync_range(pipe, batch->start, batch->end, batch->flags);
+        batch->start = 0;
+        batch->end = 0;
+    }
+}
+
+/**
+ * @brief Add a memory range to a pipe's cache sync batch
+ *
+ * The range is extended to whole cache lines. If it touches or overlaps the range already collected with the same
+ * flags, the two are merged so that they are synced by a single call. Otherwise the collected range is synced first.
+ *
+ * @param[in] pipe  Pipe object
+ * @param[in] addr  Start address, does not need to be aligned
+ * @param[in] len   Length in bytes
+ * @param[in] flags esp_cache_msync() flags
+ */
+static void IRAM_ATTR cache_sync_batch_add(pipe_t *pipe, const void *addr, size_t len, int flags)
+{
+    if (len == 0) {
+        return;
+    }
+    cache_sync_batch_t *batch = &pipe->cache_sync_batch;
+    const uintptr_t start = ALIGN_DOWN((uintptr_t)addr, s_cache_line_size);
+    const uintptr_t end = ALIGN_UP((uintptr_t)addr + len, s_cache_line_size);
+    if (batch->end != batch->start && batch->flags == flags && start <= batch->end && end >= batch->start) {
+        batch->start = MIN(batch->start, start);
+        batch->end = MAX(batch->end, end);
+        return;
+    }
+    cache_sync_batch_flush(pipe);
+    batch->start = start;
+    batch->end = end;
+    batch->flags = flags;
+}
+
 /**
  * @brief Sync Transfer Descriptor List
  *
+ * Descriptor lists are written back through the pipe's batch, so that lists filled in a row are synced together.
+ * They are invalidated right away, as they are parsed immediately after.
+ *
+ * @param[in] pipe         Pipe owning the buffer
  * @param[in] buffer       Buffer that holds the Transfer Descriptor List
  * @param[in] mem_to_cache Direction of cache sync
  */
-static inline void cache_sync_xfer_descriptor_list(dma_buffer_block_t *buffer, bool mem_to_cache)
+static inline void IRAM_ATTR cache_sync_xfer_descriptor_list(pipe_t *pipe, dma_buffer_block_t *buffer, bool mem_to_cache)
 {
-    esp_err_t ret = esp_cache_msync(buffer->xfer_desc_list, buffer->xfer_desc_list_len_bytes, mem_to_cache ? ESP_CACHE_MSYNC_FLAG_DIR_M2C : 0);
-    assert(ret == ESP_OK);
-    (void)ret;
+    const uintptr_t start = (uintptr_t)buffer->xfer_desc_list;
+    if (mem_to_cache) {
+        cache_sync_range(pipe, start, start + buffer->xfer_desc_list_len_bytes, ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+    } else {
+        cache_sync_batch_add(pipe, buffer->xfer_desc_list, buffer->xfer_desc_list_len_bytes, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+    }
 }
 
 /**
  * @brief Sync Transfer data buffer
  *
- * This function must be called before a URB is enqueued or dequeued.
- * Based on transfer direction (IN/OUT), this function will msync the data buffer associated with this URB.
+ * This function must be called when a URB is filled into a buffer and when it is dequeued.
+ * Only the part of the data buffer the transfer accesses (num_bytes from data_buffer, or the received bytes once done)
+ * is synced, extended to whole cache lines. So data_buffer does not need to be cache line aligned, e.g., a class driver may advance data_buffer
+ * to append data to the previously received data.
  *
- * @note Here we also accept UNALIGNED data, for cases where the class drivers force overwrite the allocated data buffers
+ * - OUT (and CTRL) data is written back before the transfer
+ * - IN (and CTRL) data is invalidated after the transfer. Partial cache lines at the edges of an unaligned IN range
+ *   are written back before the transfer, so that no dirty data sharing these lines is lost by the invalidation.
+ *   The CPU must not write to memory sharing cache lines with the range while the transfer is in flight.
  *
  * @param[in] pipe Pipe belonging to this data buffer
  * @param[in] urb  URB belonging to this data buffer
  * @param[in] done Whether data buffer was just processed or is about to be processed
  */
-static inline void cache_sync_data_buffer(pipe_t *pipe, urb_t *urb, bool done)
+static inline void IRAM_ATTR cache_sync_data_buffer(pipe_t *pipe, urb_t *urb, bool done)
 {
     const bool is_in = pipe->ep_char.bEndpointAddress & USB_B_ENDPOINT_ADDRESS_EP_DIR_MASK;
     const bool is_ctrl = (pipe->ep_char.type == USB_DWC_XFER_TYPE_CTRL);
-    if ((is_in == done) || is_ctrl) {
-        uint32_t flags = (done) ? ESP_CACHE_MSYNC_FLAG_DIR_M2C : ESP_CACHE_MSYNC_FLAG_UNALIGNED;
-        esp_err_t ret = esp_cache_msync(urb->transfer.data_buffer, urb->transfer.data_buffer_size, flags);
-        assert(ret == ESP_OK);
-        (void)ret;
+    const uintptr_t addr = (uintptr_t)urb->transfer.data_buffer;
+    // After the transfer, only the received data needs to be invalidated. Except for ISOC, where the packets are spread
+    // over the whole buffer
+    const bool is_isoc = (pipe->ep_char.type == USB_DWC_XFER_TYPE_ISOCHRONOUS);
+    const size_t len = (done && !is_isoc) ? urb->transfer.actual_num_bytes : urb->transfer.num_bytes;
+    if (len == 0) {
+        return;
+    }
+
+    if (done) {
+        if (is_in || is_ctrl) {
+            cache_sync_range(pipe, ALIGN_DOWN(addr, s_cache_line_size), ALIGN_UP(addr + len, s_cache_line_size), ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+        }
+    } else if (!is_in || is_ctrl) {
+        cache_sync_batch_add(pipe, (void *)addr, len, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+    } else {
+        // IN transfer: Write back only the partial cache lines at the edges
+        if (addr & (s_cache_line_size - 1)) {
+            cache_sync_batch_add(pipe, (void *)addr, 1, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+        }
+        if ((addr + len) & (s_cache_line_size - 1)) {
+            cache_sync_batch_add(pipe, (void *)(addr + len - 1), 1, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+        }
     }
 }
 #endif // SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
@@ -480,6 +623,16 @@ static void _buffer_parse(pipe_t *pipe);
  */
 static bool _buffer_flush_all(pipe_t *pipe, bool canceled);
 
+/**
+ * @brief Account a done URB to the statistics of its pipe and port
+ *
+ * @note The URB's status and actual number of bytes must have been updated before calling this function
+ *
+ * @param pipe Pipe object
+ * @param urb URB that is done
+ */
+static void _stats_urb_done(pipe_t *pipe, urb_t *urb);
+
 // ------------------------ Pipe ---------------------------
 
 /**
@@ -878,6 +1031,7 @@ static hcd_port_event_t _intr_hdlr_hprt(port_t *port, usb_dwc_hal_port_event_t h
                 // Disabled due to a port error
                 port->state = HCD_PORT_STATE_RECOVERY;
                 port_event = HCD_PORT_EVENT_ERROR;
+                port->stats.num_port_errors++;
             }
         }
         break;
@@ -889,6 +1043,7 @@ static hcd_port_event_t _intr_hdlr_hprt(port_t *port, usb_dwc_hal_port_event_t h
             usb_dwc_hal_port_toggle_power(port->hal, false);
             port->state = HCD_PORT_STATE_RECOVERY;
             port_event = HCD_PORT_EVENT_OVERCURRENT;
+            port->stats.num_overcurrents++;
         }
         port->flags.conn_dev_ena = 0;
         break;
@@ -1500,6 +1655,10 @@ esp_err_t hcd_port_init(int port_number, const hcd_port_config_t *port_config, h
         goto clean_up;
     }
 
+#if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+    // Data buffers and transfer descriptor lists are allocated from the same kind of memory
+    esp_cache_get_alignment(XFER_DESC_LIST_CAPS, &s_cache_line_size);
+#endif
     port_obj->periph_idx = port_number;
     TAILQ_INIT(&port_obj->pipes_idle_tailq);
     TAILQ_INIT(&port_obj->pipes_active_tailq);
@@ -1668,6 +1827,18 @@ esp_err_t hcd_port_get_speed(hcd_port_handle_t port_hdl, usb_speed_t *speed)
     return ESP_OK;
 }
 
+esp_err_t hcd_port_get_stats(hcd_port_handle_t port_hdl, usb_port_stats_t *stats)
+{
+    port_t *port = (port_t *)port_hdl;
+    HCD_CHECK(port_hdl != NULL && stats != NULL, ESP_ERR_INVALID_ARG);
+    HCD_ENTER_CRITICAL();
+    HCD_CHECK_FROM_CRIT(s_port_inited[port->periph_idx], ESP_ERR_INVALID_STATE);
+    *stats = port->stats;
+    stats->frame_num = usb_dwc_hal_port_get_cur_frame_num(port->hal);
+    HCD_EXIT_CRITICAL();
+    return ESP_OK;
+}
+
 hcd_port_event_t hcd_port_handle_event(hcd_port_handle_t port_hdl)
 {
     port_t *port = (port_t *)port_hdl;
@@ -1937,6 +2108,106 @@ static void pipe_set_ep_char(const hcd_pipe_config_t *pipe_config, usb_transfer_
     }
 }
 
+/**
+ * @brief Set the periodic bus time, that the pipe requires in each of its (micro)frames
+ *
+ * The bus time includes bit stuffing and the protocol overhead of the transactions. It is counted in units of the
+ * port: FS byte times per frame for FS/LS ports, HS byte times per microframe for HS ports.
+ *
+ * @param[in] pipe          Pipe object with EP characteristics already set
+ * @param[in] pipe_config   Pipe configuration
+ * @param[in] port_speed    Speed of the port
+ */
+static void pipe_set_periodic_reservation(pipe_t *pipe, const hcd_pipe_config_t *pipe_config, usb_speed_t port_speed)
+{
+    const bool is_isoc = (pipe->ep_char.type == USB_DWC_XFER_TYPE_ISOCHRONOUS);
+    const unsigned int interval = pipe->ep_char.periodic.interval;
+    unsigned int data_len = pipe->ep_char.mps;
+    unsigned int bus_time;
+    unsigned int slots;
+
+    if (port_speed == USB_SPEED_HIGH) {
+        // High-bandwidth endpoints have up to 2 additional transactions per microframe
+        data_len *= USB_EP_DESC_GET_MULT(pipe_config->ep_desc) + 1;
+        bus_time = data_len + data_len / 6 + (is_isoc ? PERIODIC_OVERHEAD_HS_ISOC : PERIODIC_OVERHEAD_HS_INTR);
+        slots = PERIODIC_SLOTS_HS;
+    } else {
+        if (pipe_config->dev_speed == USB_SPEED_LOW) {
+            // One LS byte takes 8 FS byte times
+            bus_time = (data_len + data_len / 6) * 8 + PERIODIC_OVERHEAD_LS;
+        } else {
+            bus_time = data_len + data_len / 6 + (is_isoc ? PERIODIC_OVERHEAD_FS_ISOC : PERIODIC_OVERHEAD_FS_INTR);
+        }
+        slots = PERIODIC_SLOTS_FS;
+    }
+    pipe->periodic_reservation.bus_time = bus_time;
+    pipe->periodic_reservation.interval = MIN(interval, slots);
+}
+
+/**
+ * @brief Reserve the periodic bus time of a pipe in the port's frame list
+ *
+ * Picks the phase of the pipe, whose busiest (micro)frame has the least reserved bus time. Periodic pipes are spread
+ * evenly over the frame list and every frame (FS/LS port) or microframe (HS port) keeps within the periodic bus time
+ * limit of the USB 2.0 specification.
+ *
+ * @note This function must be called in a critical section
+ *
+ * @param[in] port  Port object
+ * @param[in] pipe  Pipe object with periodic reservation set
+ * @return
+ *    - true:   Bus time reserved, the pipe's offset is updated
+ *    - false:  Not enough periodic bus time in any phase of the pipe
+ */
+static bool _periodic_reserve(port_t *port, pipe_t *pipe)
+{
+    const bool is_hs_port = (port->speed == USB_SPEED_HIGH);
+    const unsigned int budget = is_hs_port ? PERIODIC_BUS_TIME_HS : PERIODIC_BUS_TIME_FS;
+    const unsigned int slots = is_hs_port ? PERIODIC_SLOTS_HS : PERIODIC_SLOTS_FS;
+    const unsigned int interval = pipe->periodic_reservation.interval;
+    const unsigned int bus_time = pipe->periodic_reservation.bus_time;
+    unsigned int best_load = UINT_MAX;
+    unsigned int best_offset = 0;
+
+    for (unsigned int offset = 0; offset < interval; offset++) {
+        unsigned int load = 0;
+        for (unsigned int i = offset; i < slots; i += interval) {
+            load = MAX(load, port->periodic_bus_time[i]);
+        }
+        if (load < best_load) {
+            best_load = load;
+            best_offset = offset;
+        }
+    }
+    if (best_load + bus_time > budget) {
+        return false;
+    }
+
+    for (unsigned int i = best_offset; i < slots; i += interval) {
+        port->periodic_bus_time[i] += bus_time;
+    }
+    // The offset is in frames for FS/LS pipes and in microframes for HS pipes, same as the reservation
+    pipe->periodic_reservation.offset = best_offset;
+    pipe->ep_char.periodic.offset = best_offset;
+    return true;
+}
+
+/**
+ * @brief Release the periodic bus time of a pipe
+ *
+ * @note This function must be called in a critical section
+ *
+ * @param[in] port  Port object
+ * @param[in] pipe  Pipe object with reserved bus time
+ */
+static void _periodic_release(port_t *port, pipe_t *pipe)
+{
+    const unsigned int slots = (port->speed == USB_SPEED_HIGH) ? PERIODIC_SLOTS_HS : PERIODIC_SLOTS_FS;
+    for (unsigned int i = pipe->periodic_reservation.offset; i < slots; i += pipe->periodic_reservation.interval) {
+        port->periodic_bus_time[i] -= pipe->periodic_reservation.bus_time;
+    }
+}
+
 // ---------------------- Commands -------------------------
 
 static esp_err_t _pipe_cmd_halt(pipe_t *pipe)
@@ -2101,6 +2372,9 @@ esp_err_t hcd_pipe_alloc(hcd_port_handle_t port_hdl, const hcd_pipe_config_t *pi
     usb_dwc_hal_ep_char_t ep_char;
     pipe_set_ep_char(pipe_config, type, is_default, pipe_idx, port_speed, &ep_char);
     memcpy(&pipe->ep_char, &ep_char, sizeof(usb_dwc_hal_ep_char_t));
+    if (type == USB_TRANSFER_TYPE_INTR || type == USB_TRANSFER_TYPE_ISOCHRONOUS) {
+        pipe_set_periodic_reservation(pipe, pipe_config, port_speed);
+    }
     pipe->state = HCD_PIPE_STATE_ACTIVE;
     pipe->callback = pipe_config->callback;
     pipe->callback_arg = pipe_config->callback_arg;
@@ -2113,8 +2387,17 @@ esp_err_t hcd_pipe_alloc(hcd_port_handle_t port_hdl, const hcd_pipe_config_t *pi
         ret = ESP_ERR_INVALID_STATE;
         goto err;
     }
+    if (pipe->periodic_reservation.bus_time > 0 && !_periodic_reserve(port, pipe)) {
+        HCD_EXIT_CRITICAL();
+        ESP_LOGE(HCD_DWC_TAG, "Not enough periodic bus time for EP 0x%02x", pipe->ep_char.bEndpointAddress);
+        ret = ESP_ERR_NOT_SUPPORTED;
+        goto err;
+    }
     bool chan_allocated = usb_dwc_hal_chan_alloc(port->hal, pipe->chan_obj, (void *) pipe);
     if (!chan_allocated) {
+        if (pipe->periodic_reservation.bus_time > 0) {
+            _periodic_release(port, pipe);
+        }
         HCD_EXIT_CRITICAL();
         // The only reason why alloc channel could return false is no more free channels
         ESP_LOGE(HCD_DWC_TAG, "No more HCD channels available");
@@ -2161,6 +2444,9 @@ esp_err_t hcd_pipe_free(hcd_pipe_handle_t pipe_hdl)
     // Remove pipe from the list of idle pipes (it must be in the idle list because it should have no queued URBs)
     TAILQ_REMOVE(&pipe->port->pipes_idle_tailq, pipe, tailq_entry);
     pipe->port->num_pipes_idle--;
+    if (pipe->periodic_reservation.bus_time > 0) {
+        _periodic_release(pipe->port, pipe);
+    }
     usb_dwc_hal_chan_free(pipe->port->hal, pipe->chan_obj);
     HCD_EXIT_CRITICAL();
 
@@ -2233,6 +2519,33 @@ unsigned int hcd_pipe_get_num_urbs(hcd_pipe_handle_t pipe_hdl)
     return ret;
 }
 
+esp_err_t hcd_pipe_get_cache_sync_stats(hcd_pipe_handle_t pipe_hdl, hcd_pipe_cache_sync_stats_t *stats, uint64_t *time_us)
+{
+    HCD_CHECK(pipe_hdl != NULL && stats != NULL, ESP_ERR_INVALID_ARG);
+    pipe_t *pipe = (pipe_t *)pipe_hdl;
+    HCD_ENTER_CRITICAL();
+    *stats = pipe->cache_sync_stats;
+    HCD_EXIT_CRITICAL();
+    if (time_us != NULL) {
+        *time_us = stats->num_cycles / esp_rom_get_cpu_ticks_per_us();
+    }
+    return ESP_OK;
+}
+
+esp_err_t hcd_pipe_get_stats(hcd_pipe_handle_t pipe_hdl, usb_ep_stats_t *stats)
+{
+    HCD_CHECK(pipe_hdl != NULL && stats != NULL, ESP_ERR_INVALID_ARG);
+    pipe_t *pipe = (pipe_t *)pipe_hdl;
+    hcd_pipe_cache_sync_stats_t cache_sync_stats;
+    HCD_ENTER_CRITICAL();
+    *stats = pipe->stats;
+    cache_sync_stats = pipe->cache_sync_stats;
+    HCD_EXIT_CRITICAL();
+    stats->num_cache_syncs = cache_sync_stats.num_syncs;
+    stats->cache_sync_time_us = cache_sync_stats.num_cycles / esp_rom_get_cpu_ticks_per_us();
+    return ESP_OK;
+}
+
 esp_err_t hcd_pipe_command(hcd_pipe_handle_t pipe_hdl, hcd_pipe_cmd_t command)
 {
     pipe_t *pipe = (pipe_t *)pipe_hdl;
@@ -2423,6 +2736,10 @@ static void IRAM_ATTR _buffer_fill(pipe_t *pipe)
         }
         if (pipe->multi_buffer_control.buffer_num_to_exec == 0) {
             // There are no more previously filled buffers to execute. We need to calculate a new start index based on HFNUM and the pipe's schedule
+            if (pipe->stats.num_transfers > 0) {
+                // The schedule ran dry after previous transfers, so the stream has a gap
+                pipe->stats.num_isoc_restarts++;
+            }
             uint16_t cur_frame_num = usb_dwc_hal_port_get_cur_frame_num(pipe->port->hal);
             start_idx = cur_frame_num + 1;      // This is the next frame that the periodic scheduler will fetch
             start_idx += XFER_LIST_ISOC_MARGIN; // Start scheduling with a little delay. This will get us enough timing margin so no transfer is skipped
@@ -2458,8 +2775,10 @@ static void IRAM_ATTR _buffer_fill(pipe_t *pipe)
         break;
     }
     }
-    // Sync transfer descriptor list to memory
-    CACHE_SYNC_XFER_DESCRIPTOR_LIST_C2M(buffer_to_fill);
+    // Sync user's data and the transfer descriptor list to memory. Both are only collected in the pipe's batch here
+    // and are written back before the buffer is executed
+    CACHE_SYNC_DATA_BUFFER_C2M(pipe, urb);
+    CACHE_SYNC_XFER_DESCRIPTOR_LIST_C2M(pipe, buffer_to_fill);
     buffer_to_fill->urb = urb;
     urb->hcd_var = URB_HCD_STATE_INFLIGHT;
     // Update multi buffer flags
@@ -2471,6 +2790,8 @@ static void IRAM_ATTR _buffer_fill(pipe_t *pipe)
 static void IRAM_ATTR _buffer_exec(pipe_t *pipe)
 {
     assert(pipe->multi_buffer_control.rd_idx != pipe->multi_buffer_control.wr_idx || pipe->multi_buffer_control.buffer_num_to_exec > 0);
+    // Everything the DMA is about to access must be written back
+    CACHE_SYNC_BATCH_FLUSH(pipe);
     dma_buffer_block_t *buffer_to_exec = pipe->buffers[pipe->multi_buffer_control.rd_idx];
     assert(buffer_to_exec->urb != NULL);
 
@@ -2710,7 +3031,7 @@ static void _buffer_parse(pipe_t *pipe)
     int mps = pipe->ep_char.mps;
 
     // Sync transfer descriptor list to cache
-    CACHE_SYNC_XFER_DESCRIPTOR_LIST_M2C(buffer_to_parse);
+    CACHE_SYNC_XFER_DESCRIPTOR_LIST_M2C(pipe, buffer_to_parse);
 
     // Parsing the buffer will update the buffer's corresponding URB
     if (buffer_to_parse->status_flags.pipe_event == HCD_PIPE_EVENT_URB_DONE) {
@@ -2743,6 +3064,7 @@ static void _buffer_parse(pipe_t *pipe)
     }
     urb_t *urb = buffer_to_parse->urb;
     urb->hcd_var = URB_HCD_STATE_DONE;
+    _stats_urb_done(pipe, urb);
     buffer_to_parse->urb = NULL;
     buffer_to_parse->flags.val = 0; // Clear flags
     // Move the URB to the done tailq
@@ -2769,6 +3091,50 @@ static bool _buffer_flush_all(pipe_t *pipe, bool canceled)
     return (cur_num_to_parse > 0);
 }
 
+static void _stats_urb_done(pipe_t *pipe, urb_t *urb)
+{
+    usb_ep_stats_t *stats = &pipe->stats;
+    usb_port_stats_t *port_stats = &pipe->port->stats;
+    usb_transfer_t *transfer = &urb->transfer;
+
+    stats->num_transfers++;
+    stats->num_bytes += transfer->actual_num_bytes;
+    port_stats->num_transfers++;
+    switch (transfer->status) {
+    case USB_TRANSFER_STATUS_ERROR:
+        stats->num_errors++;
+        port_stats->num_transfer_errors++;
+        break;
+    case USB_TRANSFER_STATUS_STALL:
+        stats->num_stalls++;
+        port_stats->num_transfer_errors++;
+        break;
+    case USB_TRANSFER_STATUS_OVERFLOW:
+        stats->num_overflows++;
+        port_stats->num_transfer_errors++;
+        break;
+    case USB_TRANSFER_STATUS_CANCELED:
+        stats->num_canceled++;
+        break;
+    case USB_TRANSFER_STATUS_NO_DEVICE:
+        stats->num_no_device++;
+        break;
+    default:
+        break;
+    }
+    for (int pkt_idx = 0; pkt_idx < transfer->num_isoc_packets; pkt_idx++) {
+        if (transfer->isoc_packet_desc[pkt_idx].status == USB_TRANSFER_STATUS_SKIPPED) {
+            // The DWC controller did not execute the packet in its (micro)frame, i.e., a frame overrun
+            stats->num_isoc_packets_skipped++;
+            port_stats->num_frame_overruns++;
+        } else if (transfer->isoc_packet_desc[pkt_idx].status == USB_TRANSFER_STATUS_ERROR) {
+            stats->num_isoc_packets_error++;
+        }
+    }
+    // Timestamp used to measure how long it takes until the URB is resubmitted
+    urb->hcd_done_time = esp_timer_get_time();
+}
+
 // ---------------------------------------------- HCD Transfer Descriptors ---------------------------------------------
 
 // ----------------------- Private -------------------------
@@ -2821,13 +3187,18 @@ esp_err_t hcd_urb_enqueue(hcd_pipe_handle_t pipe_hdl, urb_t *urb)
         ESP_ERR_INVALID_SIZE
     );
 
-    // Sync user's data from cache to memory. For OUT and CTRL transfers
-    CACHE_SYNC_DATA_BUFFER_C2M(pipe, urb);
+    // Time since the URB was last done, if it is being resubmitted
+    const int64_t resubmit_latency_us = (urb->hcd_done_time != 0) ? esp_timer_get_time() - urb->hcd_done_time : -1;
 
-    HCD_ENTER_CRITICAL();
+    // URBs can be enqueued and dequeued from pipe callbacks running in ISR context, thus the safe critical sections
+    HCD_ENTER_CRITICAL_SAFE();
     bool submit_urb;
     // Check that pipe and port are in the correct state to receive URBs
-    HCD_CHECK_FROM_CRIT(_check_port_pipe_state(pipe, &submit_urb), ESP_ERR_INVALID_STATE);
+    if (!_check_port_pipe_state(pipe, &submit_urb)) {
+        pipe->stats.num_rejected++;
+        HCD_EXIT_CRITICAL_SAFE();
+        return ESP_ERR_INVALID_STATE;
+    }
     // Use the URB's reserved_ptr to store the pipe's
     urb->hcd_ptr = (void *)pipe;
     // Add the URB to the pipe's pending tailq
@@ -2840,12 +3211,31 @@ esp_err_t hcd_urb_enqueue(hcd_pipe_handle_t pipe_hdl, urb_t *urb)
         // URB will not be deferred, can be submitted right now
         if (_buffer_can_fill(pipe)) {
             _buffer_fill(pipe);
+        } else {
+            // All buffers of the pipe are in use. The URB waits in the pending tailq
+            pipe->stats.num_buffer_starvations++;
         }
         if (_buffer_can_exec(pipe)) {
             _buffer_exec(pipe);
         }
     }
 
+    // Update statistics
+    const uint32_t queue_depth = pipe->num_urb_pending
+                                 + pipe->multi_buffer_control.buffer_num_to_exec
+                                 + pipe->multi_buffer_control.buffer_num_to_parse;
+    if (queue_depth > pipe->stats.max_queue_depth) {
+        pipe->stats.max_queue_depth = queue_depth;
+    }
+    if (resubmit_latency_us >= 0) {
+        pipe->stats.num_resubmits++;
+        pipe->stats.resubmit_latency_total_us += resubmit_latency_us;
+        if (resubmit_latency_us > pipe->stats.resubmit_latency_max_us) {
+            pipe->stats.resubmit_latency_max_us = (uint32_t)MIN(resubmit_latency_us, UINT32_MAX);
+        }
+    }
+    urb->hcd_done_time = 0;
+
     if (!pipe->cs_flags.has_urb) {
         // This is the first URB to be enqueued into the pipe. Move the pipe to the list of active pipes
         // We also mark a pipe to be active, if its URB is deferred
@@ -2855,7 +3245,7 @@ esp_err_t hcd_urb_enqueue(hcd_pipe_handle_t pipe_hdl, urb_t *urb)
         pipe->port->num_pipes_queued++;
         pipe->cs_flags.has_urb = 1;
     }
-    HCD_EXIT_CRITICAL();
+    HCD_EXIT_CRITICAL_SAFE();
     return ESP_OK;
 }
 
@@ -2864,7 +3254,7 @@ urb_t *hcd_urb_dequeue(hcd_pipe_handle_t pipe_hdl)
     pipe_t *pipe = (pipe_t *)pipe_hdl;
     urb_t *urb;
 
-    HCD_ENTER_CRITICAL();
+    HCD_ENTER_CRITICAL_SAFE();
     if (pipe->num_urb_done > 0) {
         urb = TAILQ_FIRST(&pipe->done_urb_tailq);
         TAILQ_REMOVE(&pipe->done_urb_tailq, urb, tailq_entry);
@@ -2889,7 +3279,7 @@ urb_t *hcd_urb_dequeue(hcd_pipe_handle_t pipe_hdl)
         // No more URBs to dequeue from this pipe
         urb = NULL;
     }
-    HCD_EXIT_CRITICAL();
+    HCD_EXIT_CRITICAL_SAFE();
     return urb;
 }
 
@@ -2919,6 +3309,7 @@ esp_err_t hcd_urb_abort(urb_t *urb)
                 urb->transfer.isoc_packet_desc[i].status = USB_TRANSFER_STATUS_CANCELED;
             }
         }
+        _stats_urb_done(pipe, urb);
     }   // Otherwise, the URB is in-flight or already done thus cannot be aborted
     HCD_EXIT_CRITICAL();
     return ESP_OK;
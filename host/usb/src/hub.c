@@ -7,6 +7,8 @@
 #include "sdkconfig.h"
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <sys/queue.h>
 #include "esp_err.h"
 #include "esp_check.h"
@@ -38,6 +40,10 @@ Implementation of the HUB driver that supports Root HUB with 2 Root Ports.
 #define HUB_ROOT_HCD_PORT_FIFO_BIAS                 HCD_PORT_FIFO_BIAS_BALANCED
 #endif
 
+#define DEV_TREE_HASH_SIZE                          16      // Number of buckets of the device tree hash tables, must be a power of 2
+#define DEV_TREE_UID_HASH(uid)                      ((uid) & (DEV_TREE_HASH_SIZE - 1))
+#define DEV_TREE_PARENT_HASH(parent)                (((uintptr_t)(parent) >> 3) & (DEV_TREE_HASH_SIZE - 1))
+
 #define PORT_REQ_DISABLE                            BIT0
 #define PORT_REQ_RECOVER                            BIT1
 #define PORT_REQ_SUSPEND                            BIT2
@@ -80,14 +86,34 @@ typedef enum {
  */
 struct dev_tree_node_s {
     TAILQ_ENTRY(dev_tree_node_s) tailq_entry;   /**< Entry for the device tree node object tailq */
+    SLIST_ENTRY(dev_tree_node_s) uid_entry;     /**< Entry for the uid hash bucket */
     unsigned int uid;                           /**< Device's unique ID */
     ext_hub_handle_t parent;                    /**< Device's parent context (NULL for root hub ports, ext_hub_handle_t for external hub ports) */
+    unsigned int parent_uid;                    /**< Parent Hub's unique ID (0 for root hub ports) */
     uint8_t port_num;                           /**< Device's parent port number */
+    uint8_t depth;                              /**< Device's tier in the tree (1 for root hub ports) */
     hcd_port_handle_t root_port_hdl;            /**< Root port handle this device ultimately hangs off */
 };
 
 typedef struct dev_tree_node_s dev_tree_node_t;
 
+/**
+ * @brief Children of a parent in the device tree
+ *
+ * Nodes connected to the ports of one parent (a root port or an external Hub), indexed by the port number
+ */
+struct dev_tree_children_s {
+    SLIST_ENTRY(dev_tree_children_s) parent_entry;  /**< Entry for the parent hash bucket */
+    ext_hub_handle_t parent;                    /**< Parent context (NULL for root hub ports) */
+    unsigned int parent_uid;                    /**< Parent Hub's unique ID (0 for root hub ports) */
+    uint8_t parent_depth;                       /**< Parent Hub's tier in the tree (0 for root hub ports) */
+    uint8_t num_ports;                          /**< Length of the nodes array */
+    uint8_t num_nodes;                          /**< Number of nodes in the nodes array */
+    dev_tree_node_t **nodes;                    /**< Nodes, indexed by the port number */
+};
+
+typedef struct dev_tree_children_s dev_tree_children_t;
+
 typedef struct {
     struct {
         hcd_port_handle_t hdl;
@@ -112,8 +138,13 @@ typedef struct {
     } dynamic;                                      /**< Dynamic members. Require a critical section */
 
     struct {
-        TAILQ_HEAD(tailhead_devs, dev_tree_node_s) dev_nodes_tailq;     /**< Tailq of attached devices */
-    } single_thread;                                /**< Single thread members don't require a critical section so long as they are never accessed from multiple threads */
+        TAILQ_HEAD(tailhead_devs, dev_tree_node_s) dev_nodes_tailq;     /**< Tailq of attached devices. Parents are always listed before their children */
+        SLIST_HEAD(uid_bucket, dev_tree_node_s) uid_hash[DEV_TREE_HASH_SIZE];               /**< Device tree nodes, hashed by uid */
+        SLIST_HEAD(parent_bucket, dev_tree_children_s) parent_hash[DEV_TREE_HASH_SIZE];     /**< Children of external Hubs, hashed by parent */
+        dev_tree_children_t root_children;          /**< Children of the root hub ports */
+        dev_tree_node_t *root_nodes[HCD_NUM_PORTS]; /**< Nodes array of the root hub ports children */
+    } single_thread;                                /**< Single thread members don't require a critical section so long as they are never accessed from multiple threads.
+                                                         The device tree is only changed by the Host Library task, changes are done in a critical section to allow hub_dev_tree_snapshot() from other tasks */
 
     root_hub_port_t root_hub_ports[HCD_NUM_PORTS];
 
@@ -170,16 +201,150 @@ static bool root_port_callback(hcd_port_handle_t port_hdl, hcd_port_event_t port
 
 static dev_tree_node_t *dev_tree_node_get_by_uid(unsigned int node_uid)
 {
-    dev_tree_node_t *dev_tree_node = NULL;
     dev_tree_node_t *dev_tree_iter;
-    // Search the device tree nodes list for a device node with the specified parent
-    TAILQ_FOREACH(dev_tree_iter, &p_hub_driver_obj->single_thread.dev_nodes_tailq, tailq_entry) {
+    // Only the nodes with the same hash are searched
+    SLIST_FOREACH(dev_tree_iter, &p_hub_driver_obj->single_thread.uid_hash[DEV_TREE_UID_HASH(node_uid)], uid_entry) {
         if (dev_tree_iter->uid == node_uid) {
-            dev_tree_node = dev_tree_iter;
-            break;
+            return dev_tree_iter;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get the children of a parent
+ *
+ * @param parent Parent hub handle (NULL for root port devices)
+ * @return Children of the parent, NULL if the parent doesn't have any children
+ */
+static dev_tree_children_t *dev_tree_children_get(ext_hub_handle_t parent)
+{
+    if (parent == NULL) {
+        return &p_hub_driver_obj->single_thread.root_children;
+    }
+    dev_tree_children_t *children_iter;
+    SLIST_FOREACH(children_iter, &p_hub_driver_obj->single_thread.parent_hash[DEV_TREE_PARENT_HASH(parent)], parent_entry) {
+        if (children_iter->parent == parent) {
+            return children_iter;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get the device tree node of a port
+ *
+ * @param parent Parent hub handle (NULL for root port devices)
+ * @param port_num Root port index (for root devices) or downstream port number (for external hubs)
+ * @return Device tree node, NULL if there is no node for the port
+ */
+static dev_tree_node_t *dev_tree_node_get_by_parent(ext_hub_handle_t parent, uint8_t port_num)
+{
+    dev_tree_children_t *children = dev_tree_children_get(parent);
+    if (children == NULL || port_num >= children->num_ports) {
+        return NULL;
+    }
+    return children->nodes[port_num];
+}
+
+#if ENABLE_USB_HUBS
+/**
+ * @brief Get the children of an external Hub, allocate them for the first child
+ *
+ * The nodes array is grown to hold the port number.
+ *
+ * @param parent Parent hub handle
+ * @param port_num Downstream port number
+ * @return Children of the parent, NULL if out of memory
+ */
+static dev_tree_children_t *dev_tree_children_alloc(ext_hub_handle_t parent, uint8_t port_num)
+{
+    dev_tree_children_t *children = dev_tree_children_get(parent);
+    const bool is_new = (children == NULL);
+
+    if (is_new) {
+        children = heap_caps_calloc(1, sizeof(dev_tree_children_t), MALLOC_CAP_DEFAULT);
+        if (children == NULL) {
+            return NULL;
         }
+        children->parent = parent;
+        children->parent_uid = ext_hub_get_uid(parent);
+        dev_tree_node_t *parent_node = dev_tree_node_get_by_uid(children->parent_uid);
+        children->parent_depth = (parent_node != NULL) ? parent_node->depth : 1;
+    }
+
+    if (port_num >= children->num_ports) {
+        const uint8_t num_ports = port_num + 1;
+        dev_tree_node_t **nodes = heap_caps_calloc(num_ports, sizeof(dev_tree_node_t *), MALLOC_CAP_DEFAULT);
+        if (nodes == NULL) {
+            if (is_new) {
+                heap_caps_free(children);
+            }
+            return NULL;
+        }
+        dev_tree_node_t **old_nodes = children->nodes;
+        if (old_nodes) {
+            memcpy(nodes, old_nodes, children->num_ports * sizeof(dev_tree_node_t *));
+        }
+        HUB_DRIVER_ENTER_CRITICAL();
+        children->nodes = nodes;
+        children->num_ports = num_ports;
+        HUB_DRIVER_EXIT_CRITICAL();
+        heap_caps_free(old_nodes);
+    }
+
+    if (is_new) {
+        HUB_DRIVER_ENTER_CRITICAL();
+        SLIST_INSERT_HEAD(&p_hub_driver_obj->single_thread.parent_hash[DEV_TREE_PARENT_HASH(parent)], children, parent_entry);
+        HUB_DRIVER_EXIT_CRITICAL();
+    }
+    return children;
+}
+#endif // ENABLE_USB_HUBS
+
+/**
+ * @brief Add a device tree node to the device tree and its indexes
+ *
+ * @param children Children of the node's parent
+ * @param dev_tree_node Device tree node
+ */
+static void dev_tree_node_insert(dev_tree_children_t *children, dev_tree_node_t *dev_tree_node)
+{
+    HUB_DRIVER_ENTER_CRITICAL();
+    TAILQ_INSERT_TAIL(&p_hub_driver_obj->single_thread.dev_nodes_tailq, dev_tree_node, tailq_entry);
+    SLIST_INSERT_HEAD(&p_hub_driver_obj->single_thread.uid_hash[DEV_TREE_UID_HASH(dev_tree_node->uid)], dev_tree_node, uid_entry);
+    children->nodes[dev_tree_node->port_num] = dev_tree_node;
+    children->num_nodes++;
+    HUB_DRIVER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Remove a device tree node from the device tree and its indexes
+ *
+ * The children of an external Hub are freed together with the last node.
+ *
+ * @param children Children of the node's parent
+ * @param dev_tree_node Device tree node
+ */
+static void dev_tree_node_erase(dev_tree_children_t *children, dev_tree_node_t *dev_tree_node)
+{
+    bool free_children = false;
+
+    HUB_DRIVER_ENTER_CRITICAL();
+    TAILQ_REMOVE(&p_hub_driver_obj->single_thread.dev_nodes_tailq, dev_tree_node, tailq_entry);
+    SLIST_REMOVE(&p_hub_driver_obj->single_thread.uid_hash[DEV_TREE_UID_HASH(dev_tree_node->uid)], dev_tree_node, dev_tree_node_s, uid_entry);
+    children->nodes[dev_tree_node->port_num] = NULL;
+    children->num_nodes--;
+    if (children->parent != NULL && children->num_nodes == 0) {
+        SLIST_REMOVE(&p_hub_driver_obj->single_thread.parent_hash[DEV_TREE_PARENT_HASH(children->parent)], children, dev_tree_children_s, parent_entry);
+        free_children = true;
+    }
+    HUB_DRIVER_EXIT_CRITICAL();
+
+    if (free_children) {
+        heap_caps_free(children->nodes);
+        heap_caps_free(children);
     }
-    return dev_tree_node;
 }
 
 /**
@@ -196,22 +361,35 @@ static esp_err_t dev_tree_node_new(ext_hub_handle_t parent, uint8_t port_num, us
 
     // Get root port handle of the new device
     hcd_port_handle_t root_port_hdl = NULL;
+    dev_tree_children_t *children = NULL;
     if (parent == NULL) {
         assert(port_num < HCD_NUM_PORTS);
         root_port_hdl = p_hub_driver_obj->root_hub_ports[port_num].constant.hdl;
+        children = &p_hub_driver_obj->single_thread.root_children;
     } else {
 #ifdef ENABLE_USB_HUBS
         root_port_hdl = ext_hub_get_root_port(parent);
+        HUB_DRIVER_CHECK(root_port_hdl != NULL, ESP_ERR_INVALID_ARG);
+        children = dev_tree_children_alloc(parent, port_num);
+        if (children == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
 #else
         abort(); // External hub support is not enabled. parent must be NULL for root port devices
 #endif // ENABLE_USB_HUBS
     }
     HUB_DRIVER_CHECK(root_port_hdl != NULL, ESP_ERR_INVALID_ARG);
+    if (children->nodes[port_num] != NULL) {
+        ESP_LOGE(HUB_DRIVER_TAG, "Device tree node (port %d, uid %d): port is in use",
+                 port_num, children->nodes[port_num]->uid);
+        return ESP_ERR_INVALID_STATE;
+    }
 
     // Allocate memory for a new device tree node
     dev_tree_node_t *dev_tree_node = heap_caps_calloc(1, sizeof(dev_tree_node_t), MALLOC_CAP_DEFAULT);
     if (dev_tree_node == NULL) {
-        return ESP_ERR_NO_MEM;
+        ret = ESP_ERR_NO_MEM;
+        goto fail;
     }
     // Assign initial UID based on the current number of registered devices
     int device_num = 0;
@@ -224,7 +402,9 @@ static esp_err_t dev_tree_node_new(ext_hub_handle_t parent, uint8_t port_num, us
     }
 
     dev_tree_node->parent = parent;
+    dev_tree_node->parent_uid = children->parent_uid;
     dev_tree_node->port_num = port_num;
+    dev_tree_node->depth = children->parent_depth + 1;
     dev_tree_node->root_port_hdl = root_port_hdl;
 
     // Initialize and register a new USBH Device with the assigned UID
@@ -243,7 +423,7 @@ static esp_err_t dev_tree_node_new(ext_hub_handle_t parent, uint8_t port_num, us
         goto fail;
     }
 
-    TAILQ_INSERT_TAIL(&p_hub_driver_obj->single_thread.dev_nodes_tailq, dev_tree_node, tailq_entry);
+    dev_tree_node_insert(children, dev_tree_node);
 
     ESP_LOGD(HUB_DRIVER_TAG, "Device tree node (port %d, uid %d): new", dev_tree_node->port_num, dev_tree_node->uid);
 
@@ -259,21 +439,20 @@ static esp_err_t dev_tree_node_new(ext_hub_handle_t parent, uint8_t port_num, us
 
 fail:
     heap_caps_free(dev_tree_node);
+    if (children->parent != NULL && children->num_nodes == 0) {
+        // Children were allocated for this node only
+        HUB_DRIVER_ENTER_CRITICAL();
+        SLIST_REMOVE(&p_hub_driver_obj->single_thread.parent_hash[DEV_TREE_PARENT_HASH(parent)], children, dev_tree_children_s, parent_entry);
+        HUB_DRIVER_EXIT_CRITICAL();
+        heap_caps_free(children->nodes);
+        heap_caps_free(children);
+    }
     return ret;
 }
 
 static esp_err_t dev_tree_node_reset_completed(ext_hub_handle_t parent, uint8_t port_num)
 {
-    dev_tree_node_t *dev_tree_node = NULL;
-    dev_tree_node_t *dev_tree_iter;
-    // Search the device tree nodes list for a device node with the specified parent
-    TAILQ_FOREACH(dev_tree_iter, &p_hub_driver_obj->single_thread.dev_nodes_tailq, tailq_entry) {
-        if (dev_tree_iter->parent == parent &&
-                dev_tree_iter->port_num == port_num) {
-            dev_tree_node = dev_tree_iter;
-            break;
-        }
-    }
+    dev_tree_node_t *dev_tree_node = dev_tree_node_get_by_parent(parent, port_num);
 
     if (dev_tree_node == NULL) {
         ESP_LOGE(HUB_DRIVER_TAG, "Reset completed, but device tree node (port %d) not found", port_num);
@@ -292,16 +471,7 @@ static esp_err_t dev_tree_node_reset_completed(ext_hub_handle_t parent, uint8_t
 
 static esp_err_t dev_tree_node_dev_gone(ext_hub_handle_t parent, uint8_t port_num)
 {
-    dev_tree_node_t *dev_tree_node = NULL;
-    dev_tree_node_t *dev_tree_iter;
-    // Search the device tree nodes list for a device node with the specified parent
-    TAILQ_FOREACH(dev_tree_iter, &p_hub_driver_obj->single_thread.dev_nodes_tailq, tailq_entry) {
-        if (dev_tree_iter->parent == parent &&
-                dev_tree_iter->port_num == port_num) {
-            dev_tree_node = dev_tree_iter;
-            break;
-        }
-    }
+    dev_tree_node_t *dev_tree_node = dev_tree_node_get_by_parent(parent, port_num);
 
     if (dev_tree_node == NULL) {
         ESP_LOGW(HUB_DRIVER_TAG, "Device tree node (port %d): not found", port_num);
@@ -328,16 +498,7 @@ static esp_err_t dev_tree_node_dev_gone(ext_hub_handle_t parent, uint8_t port_nu
  */
 static esp_err_t dev_tree_node_remove_by_parent(ext_hub_handle_t parent, uint8_t port_num)
 {
-    dev_tree_node_t *dev_tree_node = NULL;
-    dev_tree_node_t *dev_tree_iter;
-    // Search the device tree nodes list for a device node with the specified parent
-    TAILQ_FOREACH(dev_tree_iter, &p_hub_driver_obj->single_thread.dev_nodes_tailq, tailq_entry) {
-        if (dev_tree_iter->parent == parent &&
-                dev_tree_iter->port_num == port_num) {
-            dev_tree_node = dev_tree_iter;
-            break;
-        }
-    }
+    dev_tree_node_t *dev_tree_node = dev_tree_node_get_by_parent(parent, port_num);
 
     if (dev_tree_node == NULL) {
         ESP_LOGW(HUB_DRIVER_TAG, "Device tree node (port %d): not found", port_num);
@@ -346,7 +507,7 @@ static esp_err_t dev_tree_node_remove_by_parent(ext_hub_handle_t parent, uint8_t
 
     ESP_LOGD(HUB_DRIVER_TAG, "Device tree node (port %d, uid %d): freeing", port_num, dev_tree_node->uid);
 
-    TAILQ_REMOVE(&p_hub_driver_obj->single_thread.dev_nodes_tailq, dev_tree_node, tailq_entry);
+    dev_tree_node_erase(dev_tree_children_get(parent), dev_tree_node);
     heap_caps_free(dev_tree_node);
     return ESP_OK;
 }
@@ -789,6 +950,12 @@ esp_err_t hub_install(hub_config_t *hub_config, void **client_ret)
     hub_driver_obj->constant.event_cb = hub_config->event_cb;
     hub_driver_obj->constant.event_cb_arg = hub_config->event_cb_arg;
     TAILQ_INIT(&hub_driver_obj->single_thread.dev_nodes_tailq);
+    for (int i = 0; i < DEV_TREE_HASH_SIZE; i++) {
+        SLIST_INIT(&hub_driver_obj->single_thread.uid_hash[i]);
+        SLIST_INIT(&hub_driver_obj->single_thread.parent_hash[i]);
+    }
+    hub_driver_obj->single_thread.root_children.num_ports = HCD_NUM_PORTS;
+    hub_driver_obj->single_thread.root_children.nodes = hub_driver_obj->single_thread.root_nodes;
 
     HUB_DRIVER_ENTER_CRITICAL();
     if (p_hub_driver_obj != NULL) {
@@ -946,6 +1113,27 @@ bool hub_root_is_suspended(void)
     return true;
 }
 
+esp_err_t hub_root_get_stats(usb_port_stats_t *stats)
+{
+    HUB_DRIVER_CHECK(stats != NULL, ESP_ERR_INVALID_ARG);
+    HUB_DRIVER_ENTER_CRITICAL();
+    HUB_DRIVER_CHECK_FROM_CRIT(p_hub_driver_obj != NULL, ESP_ERR_INVALID_STATE);
+
+    // TODO: Statistics are currently available only for single host configuration.
+    // Pick the first root port that is enabled
+    root_hub_port_t *root_hub_port = &p_hub_driver_obj->root_hub_ports[0];
+#if HCD_NUM_PORTS > 1
+    if (!root_hub_port->constant.hdl) {
+        root_hub_port = &p_hub_driver_obj->root_hub_ports[1];
+    }
+#endif
+    assert(root_hub_port->constant.hdl);
+    hcd_port_handle_t root_port_hdl = root_hub_port->constant.hdl;
+    HUB_DRIVER_EXIT_CRITICAL();
+
+    return hcd_port_get_stats(root_port_hdl, stats);
+}
+
 esp_err_t hub_root_can_suspend(void)
 {
     HUB_DRIVER_ENTER_CRITICAL();
@@ -1269,6 +1457,31 @@ esp_err_t hub_node_disable(unsigned int node_uid)
     return ret;
 }
 
+esp_err_t hub_dev_tree_snapshot(int num_nodes, hub_dev_tree_node_info_t *nodes, int *num_nodes_ret)
+{
+    HUB_DRIVER_CHECK(num_nodes_ret != NULL && (nodes != NULL || num_nodes == 0), ESP_ERR_INVALID_ARG);
+    int num_filled = 0;
+    dev_tree_node_t *dev_tree_iter;
+
+    HUB_DRIVER_ENTER_CRITICAL();
+    HUB_DRIVER_CHECK_FROM_CRIT(p_hub_driver_obj != NULL, ESP_ERR_INVALID_STATE);
+    // Parents are listed before their children, the list can be copied as is
+    TAILQ_FOREACH(dev_tree_iter, &p_hub_driver_obj->single_thread.dev_nodes_tailq, tailq_entry) {
+        if (num_filled == num_nodes) {
+            break;
+        }
+        nodes[num_filled].uid = dev_tree_iter->uid;
+        nodes[num_filled].parent_uid = dev_tree_iter->parent_uid;
+        nodes[num_filled].port_num = dev_tree_iter->port_num;
+        nodes[num_filled].depth = dev_tree_iter->depth;
+        num_filled++;
+    }
+    HUB_DRIVER_EXIT_CRITICAL();
+
+    *num_nodes_ret = num_filled;
+    return ESP_OK;
+}
+
 esp_err_t hub_dev_new(uint8_t dev_addr)
 {
     HUB_DRIVER_ENTER_CRITICAL();
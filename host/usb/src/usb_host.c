@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <inttypes.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -63,7 +64,9 @@ DEFINE_CRIT_SECTION_LOCK_STATIC(host_lock);
 #define PROCESS_REQUEST_PENDING_FLAG_ENUM       (1 << 2)
 
 #define SHORT_DESC_REQ_LEN                      8
+#define EP_PRIORITY_NUM                         (USB_HOST_EP_PRIORITY_HIGH + 1)
 #define CTRL_TRANSFER_MAX_DATA_LEN              CONFIG_USB_HOST_CONTROL_TRANSFER_MAX_SIZE
+#define STATS_DUMP_MAX_DEVS                     127     // One per possible device address
 
 typedef struct ep_wrapper_s ep_wrapper_t;
 typedef struct interface_s interface_t;
@@ -75,8 +78,11 @@ struct ep_wrapper_s {
         TAILQ_ENTRY(ep_wrapper_s) tailq_entry;
         union {
             struct {
-                uint32_t pending: 1;
-                uint32_t reserved31: 31;
+                uint32_t pending: 1;        // EP has an event waiting to be handled
+                uint32_t handling: 1;       // EP event is being handled. A new event is queued only after handling finishes
+                uint32_t priority: 2;       // usb_host_ep_priority_t
+                uint32_t direct: 1;         // Transfer callbacks are called directly from the completion context
+                uint32_t reserved27: 27;
             };
         } flags;
         uint32_t num_urb_inflight;
@@ -107,14 +113,15 @@ struct client_s {
     // Dynamic members require a critical section
     struct {
         TAILQ_ENTRY(client_s) tailq_entry;
-        TAILQ_HEAD(tailhead_pending_ep, ep_wrapper_s) pending_ep_tailq;
+        TAILQ_HEAD(tailhead_pending_ep, ep_wrapper_s) pending_ep_tailq[EP_PRIORITY_NUM];  // One list per usb_host_ep_priority_t
         TAILQ_HEAD(tailhead_idle_ep, ep_wrapper_s) idle_ep_tailq;
         TAILQ_HEAD(tailhead_done_ctrl_xfers, urb_s) done_ctrl_xfer_tailq;
         union {
             struct {
                 uint32_t handling_events: 1;
                 uint32_t taking_mux: 1;
-                uint32_t reserved6: 6;
+                uint32_t workers_exit: 1;
+                uint32_t reserved5: 5;
                 uint32_t num_intf_claimed: 8;
                 uint32_t reserved16: 16;
             };
@@ -134,6 +141,9 @@ struct client_s {
         void *callback_arg;
         QueueHandle_t event_msg_queue;
         bool notify_dev_removed;
+        int num_workers;                    // Number of completion worker tasks. 0 if EPs are handled by usb_host_client_handle_events()
+        SemaphoreHandle_t worker_sem;       // Counting semaphore that wakes the completion workers
+        SemaphoreHandle_t worker_done_sem;  // Given by each completion worker before it exits
     } constant;
 };
 
@@ -161,11 +171,17 @@ typedef struct {
     struct {
         SemaphoreHandle_t event_sem;
         SemaphoreHandle_t mux_lock;
-        TimerHandle_t auto_suspend_timer;             // Freertos timer used for automatic suspend of the root port
+        TimerHandle_t auto_suspend_timer;             // One-shot Freertos timer used for automatic suspend of the root port, see auto_suspend_timer_cb()
         usb_phy_handle_t phy_handles[HCD_NUM_PORTS];  // One per port; NULL if skip_phy_setup or port not enabled
         void *enum_client;                            // Pointer to Enum driver (acting as a client). Used to reroute completed USBH control transfers
         void *hub_client;                             // Pointer to External Hub driver (acting as a client). Used to reroute completed USBH control transfers. NULL, when External Hub Driver not available.
     } constant;
+    // Auto suspend members are single aligned words, they are accessed without a critical section
+    struct {
+        volatile TickType_t last_activity_tick;       // Tick of the last activity, updated by record_activity()
+        volatile TickType_t interval_ticks;           // Idle time after which the auto suspend event is delivered
+        volatile bool periodic;                       // Re-arm the timer after the auto suspend event is delivered
+    } auto_suspend;
 } host_lib_t;
 
 static host_lib_t *p_host_lib_obj = NULL;
@@ -234,6 +250,43 @@ static bool _unblock_lib(bool in_isr)
     return yield;
 }
 
+static bool _unblock_ep_handler(client_t *client_obj, bool in_isr)
+{
+    if (client_obj->constant.num_workers == 0) {
+        return _unblock_client(client_obj, in_isr);
+    }
+
+    bool yield;
+    HOST_EXIT_CRITICAL_SAFE();
+    if (in_isr) {
+        BaseType_t xTaskWoken = pdFALSE;
+        xSemaphoreGiveFromISR(client_obj->constant.worker_sem, &xTaskWoken);
+        yield = (xTaskWoken == pdTRUE);
+    } else {
+        xSemaphoreGive(client_obj->constant.worker_sem);
+        yield = false;
+    }
+    HOST_ENTER_CRITICAL_SAFE();
+
+    return yield;
+}
+
+static inline void _queue_pending_ep(client_t *client_obj, ep_wrapper_t *ep_wrap)
+{
+    TAILQ_REMOVE(&client_obj->dynamic.idle_ep_tailq, ep_wrap, dynamic.tailq_entry);
+    TAILQ_INSERT_TAIL(&client_obj->dynamic.pending_ep_tailq[ep_wrap->dynamic.flags.priority], ep_wrap, dynamic.tailq_entry);
+}
+
+static bool _client_has_pending_ep(client_t *client_obj)
+{
+    for (int prio = 0; prio < EP_PRIORITY_NUM; prio++) {
+        if (!TAILQ_EMPTY(&client_obj->dynamic.pending_ep_tailq[prio])) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static inline bool is_internal_client(void *client)
 {
     if (p_host_lib_obj->constant.enum_client && (client == p_host_lib_obj->constant.enum_client)) {
@@ -248,15 +301,20 @@ static inline bool is_internal_client(void *client)
 }
 
 /**
- * @brief Reset the automatic suspend timer
+ * @brief Record USB activity for the automatic suspend timer
  *
- * The timer resets automatically, whenever usb host lib or usb host client are handling any events
+ * Called whenever usb host lib or usb host client are handling any events and on every transfer submission.
+ * This is only a timestamp store: the timer is not touched, it checks the idle time when it expires,
+ * see auto_suspend_timer_cb()
+ * Nothing is recorded while the automatic suspend is disabled, usb_host_lib_set_auto_suspend() records the activity
+ * when enabling it.
  */
-static inline void reset_auto_suspend_timer(void)
+static inline void record_activity(void)
 {
-    if (xTimerIsTimerActive(p_host_lib_obj->constant.auto_suspend_timer) == pdTRUE) {
-        xTimerReset(p_host_lib_obj->constant.auto_suspend_timer, portMAX_DELAY);
+    if (p_host_lib_obj->auto_suspend.interval_ticks == 0) {
+        return;
     }
+    p_host_lib_obj->auto_suspend.last_activity_tick = xPortInIsrContext() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
 }
 
 /**
@@ -503,6 +561,38 @@ static void enum_event_callback(enum_event_data_t *event_data, void *arg)
 
 // ------------------- Client Related ----------------------
 
+/**
+ * @brief Run the transfer callbacks of an EP directly from the completion context
+ *
+ * @note The EP must be marked as being handled. Must be called outside of a critical section
+ * @return true if a yield is required
+ */
+static bool _handle_ep_direct(client_t *client_obj, ep_wrapper_t *ep_wrap, bool in_isr)
+{
+    uint32_t num_urb_dequeued = 0;
+    urb_t *urb;
+    usbh_ep_dequeue_urb(ep_wrap->constant.ep_hdl, &urb);
+    while (urb != NULL) {
+        urb->usb_host_inflight = false;
+        urb->transfer.callback(&urb->transfer);
+        num_urb_dequeued++;
+        usbh_ep_dequeue_urb(ep_wrap->constant.ep_hdl, &urb);
+    }
+
+    bool yield = false;
+    HOST_ENTER_CRITICAL_SAFE();
+    assert(num_urb_dequeued <= ep_wrap->dynamic.num_urb_inflight);
+    ep_wrap->dynamic.num_urb_inflight -= num_urb_dequeued;
+    ep_wrap->dynamic.flags.handling = 0;
+    // An event that arrived while the callbacks ran is left to the client's context
+    if (ep_wrap->dynamic.flags.pending) {
+        _queue_pending_ep(client_obj, ep_wrap);
+        yield = _unblock_ep_handler(client_obj, in_isr);
+    }
+    HOST_EXIT_CRITICAL_SAFE();
+    return yield;
+}
+
 static bool endpoint_callback(usbh_ep_handle_t ep_hdl, usbh_ep_event_t ep_event, void *user_arg, bool in_isr)
 {
     ep_wrapper_t *ep_wrap = (ep_wrapper_t *)user_arg;
@@ -511,15 +601,28 @@ static bool endpoint_callback(usbh_ep_handle_t ep_hdl, usbh_ep_event_t ep_event,
     HOST_ENTER_CRITICAL_SAFE();
     // Store the event to be handled later. Note that we allow overwriting of events because more severe will halt the pipe prevent any further events.
     ep_wrap->dynamic.last_event = ep_event;
-    // Add the EP to the client's pending list if it's not in the list already
+    bool yield = false;
+    bool handle_direct = false;
     if (!ep_wrap->dynamic.flags.pending) {
-        ep_wrap->dynamic.flags.pending = 1;
-        TAILQ_REMOVE(&client_obj->dynamic.idle_ep_tailq, ep_wrap, dynamic.tailq_entry);
-        TAILQ_INSERT_TAIL(&client_obj->dynamic.pending_ep_tailq, ep_wrap, dynamic.tailq_entry);
+        if (ep_wrap->dynamic.flags.direct && !ep_wrap->dynamic.flags.handling && ep_event == USBH_EP_EVENT_URB_DONE) {
+            // Completed URBs of a direct EP are handled right here. Errors need a (blocking) flush, thus are left to the client
+            ep_wrap->dynamic.flags.handling = 1;
+            handle_direct = true;
+        } else {
+            // Add the EP to the client's pending list if it's not in the list already.
+            // An EP that is being handled is added once its handling finishes, so that its callbacks never run concurrently
+            ep_wrap->dynamic.flags.pending = 1;
+            if (!ep_wrap->dynamic.flags.handling) {
+                _queue_pending_ep(client_obj, ep_wrap);
+                yield = _unblock_ep_handler(client_obj, in_isr);
+            }
+        }
     }
-    bool yield = _unblock_client(client_obj, in_isr);
     HOST_EXIT_CRITICAL_SAFE();
 
+    if (handle_direct) {
+        yield = _handle_ep_direct(client_obj, ep_wrap, in_isr);
+    }
     return yield;
 }
 
@@ -536,14 +639,35 @@ static void get_config_desc_transfer_cb(usb_transfer_t *transfer)
  *
  * - The callback is called once the timer expires
  * - The timer is configured using usb_host_lib_set_auto_suspend()
+ * - The timer is a one-shot timer that is not reset on activity. If there was activity since the timer was armed,
+ *   the callback re-arms the timer for the rest of the idle interval
  * - Callback unblocks the usb_host_lib_handle_events() and delivers suspend USB Host lib event
  * - Event flag is dellivered, only if:
  *      - A device is connected to the the root port
  *      - The root port is not already in suspended state
+ * - In periodic mode, the timer is re-armed for the whole interval afterwards
  * @param[in] xTimer Timer handle
  */
 static void auto_suspend_timer_cb(TimerHandle_t xTimer)
 {
+    const TickType_t interval = p_host_lib_obj->auto_suspend.interval_ticks;
+    if (interval == 0) {
+        // Timer was disabled in the meantime
+        return;
+    }
+
+    // Check for activity since the timer was armed. Unsigned arithmetic handles tick count overflow
+    const TickType_t idle = xTaskGetTickCount() - p_host_lib_obj->auto_suspend.last_activity_tick;
+    if (idle < interval) {
+        // Called from the timer task: must not block
+        xTimerChangePeriod(xTimer, interval - idle, 0);
+        return;
+    }
+
+    if (p_host_lib_obj->auto_suspend.periodic) {
+        xTimerChangePeriod(xTimer, interval, 0);
+    }
+
     // Check if any device is connected first
     int num_devs;
     if (usbh_devs_num(&num_devs), num_devs == 0) {
@@ -914,7 +1038,7 @@ esp_err_t usb_host_lib_handle_events(TickType_t timeout_ticks, uint32_t *event_f
         }
 
         // Reset the automatic suspend timer, USB Host lib is handling events
-        reset_auto_suspend_timer();
+        record_activity();
 
         // Read and clear process pending flags
         HOST_ENTER_CRITICAL();
@@ -975,6 +1099,65 @@ esp_err_t usb_host_lib_info(usb_host_lib_info_t *info_ret)
     info_ret->num_devices = num_devs_temp;
     info_ret->num_clients = num_clients_temp;
     info_ret->root_port_suspended = hub_root_is_suspended();
+    if (hub_root_get_stats(&info_ret->root_port_stats) != ESP_OK) {
+        memset(&info_ret->root_port_stats, 0, sizeof(usb_port_stats_t));
+    }
+    return ESP_OK;
+}
+
+static void print_ep_stats(FILE *stream, uint8_t dev_addr, uint8_t bEndpointAddress, const usb_ep_stats_t *stats)
+{
+    const uint32_t latency_avg_us = (stats->num_resubmits > 0) ? (uint32_t)(stats->resubmit_latency_total_us / stats->num_resubmits) : 0;
+    fprintf(stream, "Dev %3u EP 0x%02x: xfers %" PRIu32 ", bytes %" PRIu64 ", err %" PRIu32 ", stall %" PRIu32
+            ", ovf %" PRIu32 ", cancel %" PRIu32 ", no dev %" PRIu32 ", rejected %" PRIu32 "\n",
+            dev_addr, bEndpointAddress, stats->num_transfers, stats->num_bytes, stats->num_errors, stats->num_stalls,
+            stats->num_overflows, stats->num_canceled, stats->num_no_device, stats->num_rejected);
+    fprintf(stream, "                 isoc skipped %" PRIu32 ", isoc err %" PRIu32 ", isoc restarts %" PRIu32
+            ", starvations %" PRIu32 ", max depth %" PRIu32 ", resubmit avg %" PRIu32 " us max %" PRIu32 " us"
+            ", cache syncs %" PRIu32 " (%" PRIu64 " us)\n",
+            stats->num_isoc_packets_skipped, stats->num_isoc_packets_error, stats->num_isoc_restarts,
+            stats->num_buffer_starvations, stats->max_queue_depth, latency_avg_us, stats->resubmit_latency_max_us,
+            stats->num_cache_syncs, stats->cache_sync_time_us);
+}
+
+esp_err_t usb_host_lib_dump_stats(FILE *stream)
+{
+    HOST_CHECK(stream != NULL, ESP_ERR_INVALID_ARG);
+    HOST_ENTER_CRITICAL();
+    HOST_CHECK_FROM_CRIT(p_host_lib_obj != NULL, ESP_ERR_INVALID_STATE);
+    HOST_EXIT_CRITICAL();
+
+    usb_port_stats_t port_stats;
+    if (hub_root_get_stats(&port_stats) == ESP_OK) {
+        fprintf(stream, "Root port: frame %" PRIu32 ", frame overruns %" PRIu32 ", xfers %" PRIu32 ", xfer errors %" PRIu32
+                ", port errors %" PRIu32 ", overcurrents %" PRIu32 "\n",
+                port_stats.frame_num, port_stats.num_frame_overruns, port_stats.num_transfers,
+                port_stats.num_transfer_errors, port_stats.num_port_errors, port_stats.num_overcurrents);
+    }
+
+    uint8_t dev_addr_list[STATS_DUMP_MAX_DEVS];
+    int num_devs;
+    ESP_RETURN_ON_ERROR(usbh_devs_addr_list_fill(STATS_DUMP_MAX_DEVS, dev_addr_list, &num_devs), USB_HOST_TAG, "Device list");
+    for (int i = 0; i < num_devs; i++) {
+        usb_device_handle_t dev_hdl;
+        if (usbh_devs_open(dev_addr_list[i], &dev_hdl) != ESP_OK) {
+            continue;   // Device is gone meanwhile
+        }
+        usb_ep_stats_t stats;
+        if (usbh_dev_get_ctrl_stats(dev_hdl, &stats) == ESP_OK) {
+            print_ep_stats(stream, dev_addr_list[i], 0, &stats);
+        }
+        // Only the endpoints of claimed interfaces are allocated
+        for (uint8_t ep_num = 1; ep_num <= USB_B_ENDPOINT_ADDRESS_EP_NUM_MASK; ep_num++) {
+            for (int dir = 0; dir < 2; dir++) {
+                const uint8_t bEndpointAddress = ep_num | (dir ? USB_B_ENDPOINT_ADDRESS_EP_DIR_MASK : 0);
+                if (usbh_dev_get_ep_stats(dev_hdl, bEndpointAddress, &stats) == ESP_OK) {
+                    print_ep_stats(stream, dev_addr_list[i], bEndpointAddress, &stats);
+                }
+            }
+        }
+        ESP_ERROR_CHECK(usbh_dev_close(dev_hdl));
+    }
     return ESP_OK;
 }
 
@@ -1077,6 +1260,7 @@ esp_err_t usb_host_lib_set_auto_suspend(usb_host_lib_auto_suspend_tmr_t timer_ty
 
     // Interval is 0, stop the timer
     if (timer_interval_ms == 0) {
+        p_host_lib_obj->auto_suspend.interval_ticks = 0;
         if (xTimerIsTimerActive(suspend_tmr) == pdTRUE) {
             ESP_RETURN_ON_FALSE(xTimerStop(suspend_tmr, portMAX_DELAY), ESP_FAIL, USB_HOST_TAG, "Timer could not be stopped");
         }
@@ -1084,20 +1268,23 @@ esp_err_t usb_host_lib_set_auto_suspend(usb_host_lib_auto_suspend_tmr_t timer_ty
         return ESP_OK;
     }
 
-    // Set timer reload mode: One-Shot or periodic
+    // Set timer mode: One-Shot or periodic. The FreeRTOS timer itself is always one-shot, it is re-armed by auto_suspend_timer_cb()
     switch (timer_type) {
     case USB_HOST_LIB_AUTO_SUSPEND_ONE_SHOT:
-        vTimerSetReloadMode(suspend_tmr, pdFALSE);
+        p_host_lib_obj->auto_suspend.periodic = false;
         break;
     case USB_HOST_LIB_AUTO_SUSPEND_PERIODIC:
-        vTimerSetReloadMode(suspend_tmr, pdTRUE);
+        p_host_lib_obj->auto_suspend.periodic = true;
         break;
     default:
         return ESP_FAIL;
     }
+    const TickType_t interval_ticks = pdMS_TO_TICKS(timer_interval_ms);
+    p_host_lib_obj->auto_suspend.interval_ticks = (interval_ticks > 0) ? interval_ticks : 1;
 
-    // Change the timer period, this also starts the timer if stopped
-    ESP_RETURN_ON_FALSE(xTimerChangePeriod(suspend_tmr, pdMS_TO_TICKS(timer_interval_ms), portMAX_DELAY),
+    // The idle interval starts now. Change the timer period, this also starts the timer if stopped
+    record_activity();
+    ESP_RETURN_ON_FALSE(xTimerChangePeriod(suspend_tmr, p_host_lib_obj->auto_suspend.interval_ticks, portMAX_DELAY),
                         ESP_FAIL, USB_HOST_TAG, "Timer period could not be changed");
 
     ESP_LOGD(USB_HOST_TAG, "Auto suspend timer set to %d ms, %s mode and started",
@@ -1110,51 +1297,133 @@ esp_err_t usb_host_lib_set_auto_suspend(usb_host_lib_auto_suspend_tmr_t timer_ty
 
 // ----------------------- Private -------------------------
 
+/**
+ * @brief Take the highest priority pending EP of a client
+ *
+ * @note Must be called from a critical section
+ * @return Pending EP marked as being handled, or NULL if no EP is pending
+ */
+static ep_wrapper_t *_take_pending_ep(client_t *client_obj)
+{
+    for (int prio = EP_PRIORITY_NUM - 1; prio >= 0; prio--) {
+        ep_wrapper_t *ep_wrap = TAILQ_FIRST(&client_obj->dynamic.pending_ep_tailq[prio]);
+        if (ep_wrap != NULL) {
+            TAILQ_REMOVE(&client_obj->dynamic.pending_ep_tailq[prio], ep_wrap, dynamic.tailq_entry);
+            TAILQ_INSERT_TAIL(&client_obj->dynamic.idle_ep_tailq, ep_wrap, dynamic.tailq_entry);
+            ep_wrap->dynamic.flags.pending = 0;
+            ep_wrap->dynamic.flags.handling = 1;
+            return ep_wrap;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Handle the last event of an EP taken by _take_pending_ep()
+ *
+ * Only one done URB is dequeued and called back per take. While the EP may have more done URBs, it is queued again
+ * behind the pending EPs of the same priority, so that an EP of higher priority waits for at most one callback.
+ *
+ * @note Must be called from a critical section. The critical section is exited while the transfer callback runs
+ * @return true if the EP was queued again
+ */
+static bool _handle_ep(client_t *client_obj, ep_wrapper_t *ep_wrap)
+{
+    usbh_ep_event_t last_event = ep_wrap->dynamic.last_event;
+    // The EP is flushed only once, the remaining URBs of a flushed EP are dequeued like done URBs
+    ep_wrap->dynamic.last_event = USBH_EP_EVENT_URB_DONE;
+    urb_t *urb = NULL;
+
+    HOST_EXIT_CRITICAL();
+    // Handle pipe event
+    switch (last_event) {
+    case USBH_EP_EVENT_ERROR_XFER:
+    case USBH_EP_EVENT_ERROR_URB_NOT_AVAIL:
+    case USBH_EP_EVENT_ERROR_OVERFLOW:
+    case USBH_EP_EVENT_ERROR_STALL:
+        // The endpoint is now stalled. Flush all pending URBs
+        ESP_ERROR_CHECK(usbh_ep_command(ep_wrap->constant.ep_hdl, USBH_EP_CMD_FLUSH));
+        // All URBs in this pipe are now retired waiting to be dequeued. Fall through to dequeue them
+        __attribute__((fallthrough));
+    case USBH_EP_EVENT_URB_DONE:
+        // Dequeue one URB and run its transfer callback
+        usbh_ep_dequeue_urb(ep_wrap->constant.ep_hdl, &urb);
+        if (urb != NULL) {
+            // Clear the transfer's in-flight flag to indicate the transfer is no longer in-flight
+            urb->usb_host_inflight = false;
+            urb->transfer.callback(&urb->transfer);
+        }
+        break;
+    default:
+        abort();    // Should never occur
+        break;
+    }
+    HOST_ENTER_CRITICAL();
+
+    if (urb != NULL) {
+        // Update the endpoint's number of URB's in-flight
+        assert(ep_wrap->dynamic.num_urb_inflight > 0);
+        ep_wrap->dynamic.num_urb_inflight--;
+        // More URBs may be done, the next take dequeues them
+        ep_wrap->dynamic.flags.pending = 1;
+    }
+    ep_wrap->dynamic.flags.handling = 0;
+    // Queue the EP again if it has more URBs or endpoint_callback() was called while we were handling it
+    if (ep_wrap->dynamic.flags.pending) {
+        _queue_pending_ep(client_obj, ep_wrap);
+        return true;
+    }
+    return false;
+}
+
 static void _handle_pending_ep(client_t *client_obj)
 {
-    // Handle each EP on the pending list
-    while (!TAILQ_EMPTY(&client_obj->dynamic.pending_ep_tailq)) {
-        // Get the next pending EP.
-        ep_wrapper_t *ep_wrap = TAILQ_FIRST(&client_obj->dynamic.pending_ep_tailq);
-        TAILQ_REMOVE(&client_obj->dynamic.pending_ep_tailq, ep_wrap, dynamic.tailq_entry);
-        TAILQ_INSERT_TAIL(&client_obj->dynamic.idle_ep_tailq, ep_wrap, dynamic.tailq_entry);
-        ep_wrap->dynamic.flags.pending = 0;
-        usbh_ep_event_t last_event = ep_wrap->dynamic.last_event;
-        uint32_t num_urb_dequeued = 0;
+    // Handle pending EPs, highest priority first. The priority lists are checked again after each EP,
+    // so an EP of higher priority that completed in the meantime is handled next
+    ep_wrapper_t *ep_wrap;
+    while ((ep_wrap = _take_pending_ep(client_obj)) != NULL) {
+        _handle_ep(client_obj, ep_wrap);
+    }
+}
+
+static void client_worker_task(void *arg)
+{
+    client_t *client_obj = (client_t *)arg;
 
-        HOST_EXIT_CRITICAL();
-        // Handle pipe event
-        switch (last_event) {
-        case USBH_EP_EVENT_ERROR_XFER:
-        case USBH_EP_EVENT_ERROR_URB_NOT_AVAIL:
-        case USBH_EP_EVENT_ERROR_OVERFLOW:
-        case USBH_EP_EVENT_ERROR_STALL:
-            // The endpoint is now stalled. Flush all pending URBs
-            ESP_ERROR_CHECK(usbh_ep_command(ep_wrap->constant.ep_hdl, USBH_EP_CMD_FLUSH));
-            // All URBs in this pipe are now retired waiting to be dequeued. Fall through to dequeue them
-            __attribute__((fallthrough));
-        case USBH_EP_EVENT_URB_DONE: {
-            // Dequeue all URBs and run their transfer callback
-            urb_t *urb;
-            usbh_ep_dequeue_urb(ep_wrap->constant.ep_hdl, &urb);
-            while (urb != NULL) {
-                // Clear the transfer's in-flight flag to indicate the transfer is no longer in-flight
-                urb->usb_host_inflight = false;
-                urb->transfer.callback(&urb->transfer);
-                num_urb_dequeued++;
-                usbh_ep_dequeue_urb(ep_wrap->constant.ep_hdl, &urb);
-            }
+    while (1) {
+        xSemaphoreTake(client_obj->constant.worker_sem, portMAX_DELAY);
+        // Reset the automatic suspend timer, USB Host client is handling events
+        record_activity();
+
+        HOST_ENTER_CRITICAL();
+        if (client_obj->dynamic.flags.workers_exit) {
+            HOST_EXIT_CRITICAL();
             break;
         }
-        default:
-            abort();    // Should never occur
-            break;
+        ep_wrapper_t *ep_wrap;
+        while ((ep_wrap = _take_pending_ep(client_obj)) != NULL) {
+            if (_handle_ep(client_obj, ep_wrap)) {
+                // Let other idle workers pick up the requeued EP, if they are faster
+                _unblock_ep_handler(client_obj, false);
+            }
         }
-        HOST_ENTER_CRITICAL();
+        HOST_EXIT_CRITICAL();
+    }
 
-        // Update the endpoint's number of URB's in-flight
-        assert(num_urb_dequeued <= ep_wrap->dynamic.num_urb_inflight);
-        ep_wrap->dynamic.num_urb_inflight -= num_urb_dequeued;
+    xSemaphoreGive(client_obj->constant.worker_done_sem);
+    vTaskDelete(NULL);
+}
+
+static void client_workers_stop(client_t *client_obj, int num_started)
+{
+    HOST_ENTER_CRITICAL();
+    client_obj->dynamic.flags.workers_exit = 1;
+    HOST_EXIT_CRITICAL();
+    for (int i = 0; i < num_started; i++) {
+        xSemaphoreGive(client_obj->constant.worker_sem);
+    }
+    for (int i = 0; i < num_started; i++) {
+        xSemaphoreTake(client_obj->constant.worker_done_sem, portMAX_DELAY);
     }
 }
 
@@ -1169,18 +1438,32 @@ esp_err_t usb_host_client_register(const usb_host_client_config_t *client_config
         // Asynchronous clients must provide a
         HOST_CHECK(client_config->async.client_event_callback != NULL, ESP_ERR_INVALID_ARG);
     }
+    const int num_workers = client_config->completion_workers.num_tasks;
+    HOST_CHECK(num_workers >= 0, ESP_ERR_INVALID_ARG);
+    HOST_CHECK(num_workers == 0 || client_config->completion_workers.stack_size > 0, ESP_ERR_INVALID_ARG);
 
     esp_err_t ret;
+    int num_workers_started = 0;
     // Create client object
     client_t *client_obj = heap_caps_calloc(1, sizeof(client_t), MALLOC_CAP_DEFAULT);
     SemaphoreHandle_t event_sem = xSemaphoreCreateBinary();
     QueueHandle_t event_msg_queue = xQueueCreate(client_config->max_num_event_msg, sizeof(usb_host_client_event_msg_t));
-    if (client_obj == NULL || event_sem == NULL || event_msg_queue == NULL) {
+    SemaphoreHandle_t worker_sem = NULL;
+    SemaphoreHandle_t worker_done_sem = NULL;
+    if (num_workers > 0) {
+        // One pending wake-up per worker is enough, as each woken worker handles all pending EPs
+        worker_sem = xSemaphoreCreateCounting(num_workers, 0);
+        worker_done_sem = xSemaphoreCreateCounting(num_workers, 0);
+    }
+    if (client_obj == NULL || event_sem == NULL || event_msg_queue == NULL ||
+            (num_workers > 0 && (worker_sem == NULL || worker_done_sem == NULL))) {
         ret = ESP_ERR_NO_MEM;
         goto alloc_err;
     }
     // Initialize client object
-    TAILQ_INIT(&client_obj->dynamic.pending_ep_tailq);
+    for (int prio = 0; prio < EP_PRIORITY_NUM; prio++) {
+        TAILQ_INIT(&client_obj->dynamic.pending_ep_tailq[prio]);
+    }
     TAILQ_INIT(&client_obj->dynamic.idle_ep_tailq);
     TAILQ_INIT(&client_obj->mux_protected.interface_tailq);
     TAILQ_INIT(&client_obj->dynamic.done_ctrl_xfer_tailq);
@@ -1189,6 +1472,23 @@ esp_err_t usb_host_client_register(const usb_host_client_config_t *client_config
     client_obj->constant.callback_arg = client_config->async.callback_arg;
     client_obj->constant.event_msg_queue = event_msg_queue;
     client_obj->constant.notify_dev_removed = client_config->flags.notify_dev_removed;
+    client_obj->constant.num_workers = num_workers;
+    client_obj->constant.worker_sem = worker_sem;
+    client_obj->constant.worker_done_sem = worker_done_sem;
+
+    // Start completion workers
+    for (; num_workers_started < num_workers; num_workers_started++) {
+        BaseType_t task_created = xTaskCreatePinnedToCore(client_worker_task, "usb_client_wrk",
+                                                          client_config->completion_workers.stack_size,
+                                                          (void *)client_obj,
+                                                          client_config->completion_workers.task_priority,
+                                                          NULL,
+                                                          client_config->completion_workers.core_id);
+        if (task_created != pdPASS) {
+            ret = ESP_ERR_NO_MEM;
+            goto alloc_err;
+        }
+    }
 
     // Add client to the host library's list of clients
     xSemaphoreTake(p_host_lib_obj->constant.mux_lock, portMAX_DELAY);
@@ -1204,6 +1504,15 @@ esp_err_t usb_host_client_register(const usb_host_client_config_t *client_config
     return ret;
 
 alloc_err:
+    if (num_workers_started > 0) {
+        client_workers_stop(client_obj, num_workers_started);
+    }
+    if (worker_done_sem) {
+        vSemaphoreDelete(worker_done_sem);
+    }
+    if (worker_sem) {
+        vSemaphoreDelete(worker_sem);
+    }
     if (event_msg_queue) {
         vQueueDelete(event_msg_queue);
     }
@@ -1225,7 +1534,7 @@ esp_err_t usb_host_client_deregister(usb_host_client_handle_t client_hdl)
     HOST_ENTER_CRITICAL();
     // Check that client can currently deregistered
     bool can_deregister;
-    if (!TAILQ_EMPTY(&client_obj->dynamic.pending_ep_tailq) ||
+    if (_client_has_pending_ep(client_obj) ||
             !TAILQ_EMPTY(&client_obj->dynamic.idle_ep_tailq) ||
             !TAILQ_EMPTY(&client_obj->dynamic.done_ctrl_xfer_tailq) ||
             client_obj->dynamic.flags.handling_events ||
@@ -1257,6 +1566,11 @@ esp_err_t usb_host_client_deregister(usb_host_client_handle_t client_hdl)
     }
     HOST_EXIT_CRITICAL();
     // Free client object
+    if (client_obj->constant.num_workers > 0) {
+        client_workers_stop(client_obj, client_obj->constant.num_workers);
+        vSemaphoreDelete(client_obj->constant.worker_done_sem);
+        vSemaphoreDelete(client_obj->constant.worker_sem);
+    }
     vQueueDelete(client_obj->constant.event_msg_queue);
     vSemaphoreDelete(client_obj->constant.event_sem);
     heap_caps_free(client_obj);
@@ -1288,11 +1602,11 @@ esp_err_t usb_host_client_handle_events(usb_host_client_handle_t client_hdl, Tic
         }
 
         // Reset the automatic suspend timer, USB Host client is handling events
-        reset_auto_suspend_timer();
+        record_activity();
 
         HOST_ENTER_CRITICAL();
-        // Handle pending endpoints
-        if (!TAILQ_EMPTY(&client_obj->dynamic.pending_ep_tailq)) {
+        // Handle pending endpoints, unless the client's completion workers do it
+        if (client_obj->constant.num_workers == 0) {
             _handle_pending_ep(client_obj);
         }
         // Handle any done control transfers
@@ -1442,6 +1756,49 @@ esp_err_t usb_host_device_addr_list_fill(int list_len, uint8_t *dev_addr_list, i
     return usbh_devs_addr_list_fill(list_len, dev_addr_list, num_dev_ret);
 }
 
+esp_err_t usb_host_device_topology_get(int num_nodes, usb_host_topology_node_t *nodes, int *num_nodes_ret)
+{
+    HOST_CHECK(num_nodes >= 0 && nodes != NULL && num_nodes_ret != NULL, ESP_ERR_INVALID_ARG);
+    *num_nodes_ret = 0;
+    if (num_nodes == 0) {
+        return ESP_OK;
+    }
+
+    hub_dev_tree_node_info_t *tree_nodes = heap_caps_malloc(num_nodes * sizeof(hub_dev_tree_node_info_t), MALLOC_CAP_DEFAULT);
+    if (tree_nodes == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    int num_tree_nodes;
+    esp_err_t ret = hub_dev_tree_snapshot(num_nodes, tree_nodes, &num_tree_nodes);
+    if (ret != ESP_OK) {
+        goto exit;
+    }
+
+    int num_filled = 0;
+    for (int i = 0; i < num_tree_nodes; i++) {
+        uint8_t dev_addr;
+        uint8_t parent_dev_addr = 0;
+        // Device could have been removed after the snapshot
+        if (usbh_devs_get_addr(tree_nodes[i].uid, &dev_addr) != ESP_OK) {
+            continue;
+        }
+        if (tree_nodes[i].parent_uid != 0 &&
+                usbh_devs_get_addr(tree_nodes[i].parent_uid, &parent_dev_addr) != ESP_OK) {
+            continue;
+        }
+        nodes[num_filled].dev_addr = dev_addr;
+        nodes[num_filled].parent_dev_addr = parent_dev_addr;
+        nodes[num_filled].port_num = tree_nodes[i].port_num;
+        nodes[num_filled].depth = tree_nodes[i].depth;
+        num_filled++;
+    }
+    *num_nodes_ret = num_filled;
+
+exit:
+    heap_caps_free(tree_nodes);
+    return ret;
+}
+
 // ------------------------------------------------- Device Requests ---------------------------------------------------
 
 // ------------------- Cached Requests ---------------------
@@ -1625,6 +1982,7 @@ static esp_err_t ep_wrapper_alloc(usb_device_handle_t dev_hdl, const usb_ep_desc
         goto alloc_err;
     }
     // Initialize endpoint wrapper item
+    ep_wrap->dynamic.flags.priority = USB_HOST_EP_PRIORITY_NORMAL;
     ep_wrap->constant.ep_hdl = ep_hdl;
     ep_wrap->constant.intf_obj = intf_obj;
     // Write back result
@@ -1753,8 +2111,8 @@ static esp_err_t interface_release(client_t *client_obj, usb_device_handle_t dev
     bool can_free = true;
     for (int i = 0; i < intf_obj->constant.intf_desc->bNumEndpoints; i++) {
         ep_wrapper_t *ep_wrap = intf_obj->constant.endpoints[i];
-        // Endpoint must not be on the pending list and must not have in-flight URBs
-        if (ep_wrap->dynamic.num_urb_inflight != 0 || ep_wrap->dynamic.flags.pending) {
+        // Endpoint must not be on the pending list, must not be handled and must not have in-flight URBs
+        if (ep_wrap->dynamic.num_urb_inflight != 0 || ep_wrap->dynamic.flags.pending || ep_wrap->dynamic.flags.handling) {
             can_free = false;
             break;
         }
@@ -1845,7 +2203,7 @@ esp_err_t usb_host_interface_release(usb_host_client_handle_t client_hdl, usb_de
     // usb_host_client_handle_events() may not have had a chance to process the URB yet,
     // in case it is handled from low priority task and we are calling this function from a high priority task.
     HOST_ENTER_CRITICAL();
-    const bool pending_ep = !TAILQ_EMPTY(&client_obj->dynamic.pending_ep_tailq);
+    const bool pending_ep = _client_has_pending_ep(client_obj);
     HOST_EXIT_CRITICAL();
     if (pending_ep) {
         // We wait 10 FreeRTOS ticks to give the class driver task chance to run and process the URB.
@@ -1934,6 +2292,73 @@ exit:
     return ret;
 }
 
+esp_err_t usb_host_endpoint_set_priority(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usb_host_ep_priority_t priority)
+{
+    HOST_CHECK(priority >= USB_HOST_EP_PRIORITY_LOW && priority < EP_PRIORITY_NUM, ESP_ERR_INVALID_ARG);
+    esp_err_t ret;
+    usbh_ep_handle_t ep_hdl;
+    ep_wrapper_t *ep_wrap;
+    client_t *client_obj;
+    bool queued;
+
+    ret = usbh_ep_get_handle(dev_hdl, bEndpointAddress, &ep_hdl);
+    if (ret != ESP_OK) {
+        print_error_ep_get_handle(ret);
+        goto exit;
+    }
+    ep_wrap = usbh_ep_get_context(ep_hdl);
+    client_obj = ep_wrap->constant.intf_obj->constant.client_obj;
+
+    HOST_ENTER_CRITICAL();
+    // Move the EP to the list of its new priority if it is waiting to be handled
+    queued = ep_wrap->dynamic.flags.pending && !ep_wrap->dynamic.flags.handling;
+    if (queued) {
+        TAILQ_REMOVE(&client_obj->dynamic.pending_ep_tailq[ep_wrap->dynamic.flags.priority], ep_wrap, dynamic.tailq_entry);
+    }
+    ep_wrap->dynamic.flags.priority = priority;
+    if (queued) {
+        TAILQ_INSERT_TAIL(&client_obj->dynamic.pending_ep_tailq[priority], ep_wrap, dynamic.tailq_entry);
+    }
+    HOST_EXIT_CRITICAL();
+
+exit:
+    return ret;
+}
+
+esp_err_t usb_host_endpoint_set_direct_callback(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, bool enable)
+{
+    esp_err_t ret;
+    usbh_ep_handle_t ep_hdl;
+    ep_wrapper_t *ep_wrap;
+
+    ret = usbh_ep_get_handle(dev_hdl, bEndpointAddress, &ep_hdl);
+    if (ret != ESP_OK) {
+        print_error_ep_get_handle(ret);
+        goto exit;
+    }
+    ep_wrap = usbh_ep_get_context(ep_hdl);
+
+    HOST_ENTER_CRITICAL();
+    // Takes effect with the next completion event. Events already pending are still handled by the client
+    ep_wrap->dynamic.flags.direct = enable;
+    HOST_EXIT_CRITICAL();
+
+exit:
+    return ret;
+}
+
+esp_err_t usb_host_endpoint_get_stats(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usb_ep_stats_t *stats)
+{
+    HOST_CHECK(dev_hdl != NULL && stats != NULL, ESP_ERR_INVALID_ARG);
+
+    if ((bEndpointAddress & USB_B_ENDPOINT_ADDRESS_EP_NUM_MASK) == 0) {
+        // Default endpoint is owned by the device, not by an interface
+        return usbh_dev_get_ctrl_stats(dev_hdl, stats);
+    }
+    // The endpoint may be freed by its interface release meanwhile, USBH copies the statistics under its lock
+    return usbh_dev_get_ep_stats(dev_hdl, bEndpointAddress, stats);
+}
+
 // ------------------------------------------------ Asynchronous I/O ---------------------------------------------------
 
 // ----------------------- Public --------------------------
@@ -1980,6 +2405,7 @@ esp_err_t usb_host_transfer_submit(usb_transfer_t *transfer)
     // Check that we are not submitting a transfer already in-flight
     HOST_CHECK(!urb_obj->usb_host_inflight, ESP_ERR_NOT_FINISHED);
     urb_obj->usb_host_inflight = true;
+    urb_obj->usb_host_ep = (void *)ep_wrap;
     HOST_ENTER_CRITICAL();
     ep_wrap->dynamic.num_urb_inflight++;
     HOST_EXIT_CRITICAL();
@@ -1996,6 +2422,7 @@ esp_err_t usb_host_transfer_submit(usb_transfer_t *transfer)
         }
     }
 
+    record_activity();
     ret = usbh_ep_enqueue_urb(ep_hdl, urb_obj);
 
     if (ret != ESP_OK) {
@@ -2013,6 +2440,36 @@ err:
     return ret;
 }
 
+esp_err_t usb_host_transfer_submit_from_isr(usb_transfer_t *transfer)
+{
+    HOST_CHECK(transfer != NULL, ESP_ERR_INVALID_ARG);
+    urb_t *urb_obj = __containerof(transfer, urb_t, transfer);
+    ep_wrapper_t *ep_wrap = (ep_wrapper_t *)urb_obj->usb_host_ep;
+    HOST_CHECK(ep_wrap != NULL, ESP_ERR_INVALID_ARG);   // Transfer was never submitted with usb_host_transfer_submit()
+    HOST_CHECK(!urb_obj->usb_host_inflight, ESP_ERR_NOT_FINISHED);
+
+    HOST_ENTER_CRITICAL_SAFE();
+    // The EP cannot be released while its transfer callbacks run, thus it is only safe to use it from there
+    if (!ep_wrap->dynamic.flags.handling) {
+        HOST_EXIT_CRITICAL_SAFE();
+        return ESP_ERR_INVALID_STATE;
+    }
+    ep_wrap->dynamic.num_urb_inflight++;
+    HOST_EXIT_CRITICAL_SAFE();
+    urb_obj->usb_host_inflight = true;
+
+    // The root port cannot be resumed from here. If it is suspended, the URB is deferred until the port is resumed
+    record_activity();
+    esp_err_t ret = usbh_ep_enqueue_urb_from_isr(ep_wrap->constant.ep_hdl, urb_obj);
+    if (ret != ESP_OK) {
+        HOST_ENTER_CRITICAL_SAFE();
+        ep_wrap->dynamic.num_urb_inflight--;
+        HOST_EXIT_CRITICAL_SAFE();
+        urb_obj->usb_host_inflight = false;
+    }
+    return ret;
+}
+
 esp_err_t usb_host_transfer_submit_control(usb_host_client_handle_t client_hdl, usb_transfer_t *transfer)
 {
     HOST_CHECK(client_hdl != NULL && transfer != NULL, ESP_ERR_INVALID_ARG);
@@ -2042,6 +2499,7 @@ esp_err_t usb_host_transfer_submit_control(usb_host_client_handle_t client_hdl,
         }
     }
 
+    record_activity();
     ret = usbh_dev_submit_ctrl_urb(dev_hdl, urb_obj);
 
     if (ret != ESP_OK) {
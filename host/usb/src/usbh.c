@@ -1089,6 +1089,24 @@ exit:
     return ret;
 }
 
+esp_err_t usbh_devs_get_addr(unsigned int uid, uint8_t *dev_addr)
+{
+    USBH_CHECK(dev_addr, ESP_ERR_INVALID_ARG);
+    esp_err_t ret;
+    device_t *dev_obj = NULL;
+
+    USBH_ENTER_CRITICAL();
+    dev_obj = _find_dev_from_uid(uid);
+    if (dev_obj == NULL) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else {
+        *dev_addr = dev_obj->constant.address;
+        ret = ESP_OK;
+    }
+    USBH_EXIT_CRITICAL();
+    return ret;
+}
+
 esp_err_t usbh_devs_mark_all_free(void)
 {
     USBH_ENTER_CRITICAL();
@@ -1363,6 +1381,14 @@ esp_err_t usbh_dev_get_addr(usb_device_handle_t dev_hdl, uint8_t *dev_addr)
     return ESP_OK;
 }
 
+esp_err_t usbh_dev_get_uid(usb_device_handle_t dev_hdl, unsigned int *uid)
+{
+    USBH_CHECK(dev_hdl != NULL && uid != NULL, ESP_ERR_INVALID_ARG);
+    device_t *dev_obj = (device_t *)dev_hdl;
+    *uid = dev_obj->constant.uid;
+    return ESP_OK;
+}
+
 esp_err_t usbh_dev_get_info(usb_device_handle_t dev_hdl, usb_device_info_t *dev_info)
 {
     USBH_CHECK(dev_hdl != NULL && dev_info != NULL, ESP_ERR_INVALID_ARG);
@@ -1392,6 +1418,34 @@ esp_err_t usbh_dev_get_info(usb_device_handle_t dev_hdl, usb_device_info_t *dev_
     return ESP_OK;
 }
 
+esp_err_t usbh_dev_get_ctrl_stats(usb_device_handle_t dev_hdl, usb_ep_stats_t *stats)
+{
+    USBH_CHECK(dev_hdl != NULL && stats != NULL, ESP_ERR_INVALID_ARG);
+    device_t *dev_obj = (device_t *)dev_hdl;
+
+    return hcd_pipe_get_stats(dev_obj->constant.default_pipe, stats);
+}
+
+esp_err_t usbh_dev_get_ep_stats(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usb_ep_stats_t *stats)
+{
+    USBH_CHECK(dev_hdl != NULL && stats != NULL, ESP_ERR_INVALID_ARG);
+    USBH_CHECK(check_ep_addr(bEndpointAddress), ESP_ERR_INVALID_ARG);
+
+    esp_err_t ret;
+    device_t *dev_obj = (device_t *)dev_hdl;
+
+    // Copy the statistics under the mux_lock, so that the endpoint cannot be freed meanwhile
+    xSemaphoreTake(p_usbh_obj->constant.mux_lock, portMAX_DELAY);
+    endpoint_t *ep_obj = get_ep_from_addr(dev_obj, bEndpointAddress);
+    if (ep_obj != NULL) {
+        ret = hcd_pipe_get_stats(ep_obj->constant.pipe_hdl, stats);
+    } else {
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    xSemaphoreGive(p_usbh_obj->constant.mux_lock);
+    return ret;
+}
+
 esp_err_t usbh_dev_get_root_port_hdl(usb_device_handle_t dev_hdl, hcd_port_handle_t *root_port_hdl)
 {
     USBH_CHECK(dev_hdl != NULL && root_port_hdl != NULL, ESP_ERR_INVALID_ARG);
@@ -1859,6 +1913,15 @@ esp_err_t usbh_ep_enqueue_urb(usbh_ep_handle_t ep_hdl, urb_t *urb)
     return hcd_urb_enqueue(ep_obj->constant.pipe_hdl, urb);
 }
 
+esp_err_t usbh_ep_enqueue_urb_from_isr(usbh_ep_handle_t ep_hdl, urb_t *urb)
+{
+    USBH_CHECK(ep_hdl != NULL && urb != NULL, ESP_ERR_INVALID_ARG);
+
+    endpoint_t *ep_obj = (endpoint_t *)ep_hdl;
+    // The URB was already checked when it was first enqueued to this EP
+    return hcd_urb_enqueue(ep_obj->constant.pipe_hdl, urb);
+}
+
 esp_err_t usbh_ep_dequeue_urb(usbh_ep_handle_t ep_hdl, urb_t **urb_ret)
 {
     USBH_CHECK(ep_hdl != NULL && urb_ret != NULL, ESP_ERR_INVALID_ARG);
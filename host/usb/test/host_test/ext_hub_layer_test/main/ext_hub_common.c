@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ext_hub.h"
+#include "ext_port.h"
+#include "ext_hub_common.h"
+
+static bool ext_hub_proc_req;
+static volatile bool ext_port_proc_req;     // Also requested by the delay timer
+static int hub_request_no_mem;
+static int ext_port_num_events;
+static uint32_t ext_port_connected;
+static ext_hub_handle_t ext_port_parent;
+
+static bool ext_hub_proc_req_cb(bool in_isr, void *arg)
+{
+    ext_hub_proc_req = true;
+    return false;
+}
+
+static void ext_port_proc_req_cb(void *arg)
+{
+    ext_port_proc_req = true;
+}
+
+static void ext_port_event_cb(ext_port_hdl_t port_hdl, ext_port_event_t event, void *arg)
+{
+    uint8_t port_num = 0;
+    ext_port_get_port_num(port_hdl, &port_num);
+    ext_port_parent = (ext_hub_handle_t)ext_port_get_context(port_hdl);
+
+    switch (event) {
+    case EXT_PORT_CONNECTED:
+        ext_port_connected |= (1UL << port_num);
+        break;
+    case EXT_PORT_DISCONNECTED:
+        ext_port_connected &= ~(1UL << port_num);
+        break;
+    default:
+        break;
+    }
+    ext_port_num_events++;
+}
+
+static esp_err_t ext_port_hub_request_cb(ext_port_hdl_t port_hdl, ext_port_parent_request_data_t *data, void *user_arg)
+{
+    if (data->type == EXT_PORT_PARENT_REQ_CONTROL && hub_request_no_mem > 0) {
+        // Imitate the Hub, which has no free transfer for the port request
+        hub_request_no_mem--;
+        return ESP_ERR_NO_MEM;
+    }
+    return ext_hub_request(port_hdl, data, user_arg);
+}
+
+esp_err_t test_ext_hub_install(void)
+{
+    ext_hub_proc_req = false;
+    ext_port_proc_req = false;
+    hub_request_no_mem = 0;
+    ext_port_num_events = 0;
+    ext_port_connected = 0;
+    ext_port_parent = NULL;
+
+    const ext_port_driver_config_t ext_port_config = {
+        .proc_req_cb = ext_port_proc_req_cb,
+        .event_cb = ext_port_event_cb,
+        .hub_request_cb = ext_port_hub_request_cb,
+    };
+    esp_err_t ret = ext_port_install(&ext_port_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    const ext_hub_config_t ext_hub_config = {
+        .proc_req_cb = ext_hub_proc_req_cb,
+        .port_driver = ext_port_get_driver(),
+    };
+    ret = ext_hub_install(&ext_hub_config);
+    if (ret != ESP_OK) {
+        ext_port_uninstall();
+    }
+    return ret;
+}
+
+esp_err_t test_ext_hub_uninstall(void)
+{
+    esp_err_t ret = ext_hub_uninstall();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return ext_port_uninstall();
+}
+
+esp_err_t test_ext_hub_new_dev(uint8_t dev_addr)
+{
+    return ext_hub_new_dev(dev_addr);
+}
+
+esp_err_t test_ext_hub_dev_gone(uint8_t dev_addr)
+{
+    return ext_hub_dev_gone(dev_addr);
+}
+
+esp_err_t test_ext_hub_process(void)
+{
+    // Processing loop of the Hub Driver
+    while (ext_hub_proc_req || ext_port_proc_req) {
+        esp_err_t ret;
+        if (ext_hub_proc_req) {
+            ext_hub_proc_req = false;
+            ret = ext_hub_process();
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        if (ext_port_proc_req) {
+            ext_port_proc_req = false;
+            ret = ext_port_process();
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t test_ext_hub_wait_process(uint32_t timeout_ms)
+{
+    const TickType_t start = xTaskGetTickCount();
+    while (!ext_hub_proc_req && !ext_port_proc_req) {
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms)) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+    return test_ext_hub_process();
+}
+
+esp_err_t test_ext_hub_port_active(uint8_t port_num)
+{
+    return ext_hub_port_active(ext_port_parent, port_num);
+}
+
+esp_err_t test_ext_hub_port_recycle(uint8_t port_num)
+{
+    return ext_hub_port_recycle(ext_port_parent, port_num);
+}
+
+void test_ext_hub_set_no_mem(int num_requests)
+{
+    hub_request_no_mem = num_requests;
+}
+
+int test_ext_port_get_num_events(void)
+{
+    return ext_port_num_events;
+}
+
+uint32_t test_ext_port_get_connected(void)
+{
+    return ext_port_connected;
+}
+
+int test_ext_port_parent_req_max(void)
+{
+    return EXT_PORT_PARENT_REQ_MAX;
+}
@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The External Port Driver API has a member named 'new', so ext_hub.h and ext_port.h can't be included from C++.
+ * The test calls the drivers through these C wrappers.
+ */
+
+/**
+ * @brief Install the External Port and the External Hub Drivers
+ *
+ * @return
+ *    - ESP_OK: Both drivers have been installed
+ */
+esp_err_t test_ext_hub_install(void);
+
+/**
+ * @brief Uninstall the External Hub and the External Port Drivers
+ *
+ * @return
+ *    - ESP_OK: Both drivers have been uninstalled
+ */
+esp_err_t test_ext_hub_uninstall(void);
+
+/**
+ * @brief Add new Hub device
+ *
+ * @param[in] dev_addr Device address
+ * @return
+ *    - Result of ext_hub_new_dev()
+ */
+esp_err_t test_ext_hub_new_dev(uint8_t dev_addr);
+
+/**
+ * @brief Hub device has been detached
+ *
+ * @param[in] dev_addr Device address
+ * @return
+ *    - Result of ext_hub_dev_gone()
+ */
+esp_err_t test_ext_hub_dev_gone(uint8_t dev_addr);
+
+/**
+ * @brief Process both drivers until none of them requests the processing
+ *
+ * @return
+ *    - ESP_OK: Processing completed
+ */
+esp_err_t test_ext_hub_process(void);
+
+/**
+ * @brief Wait for a processing request and process both drivers
+ *
+ * The delay timer of the External Port Driver requests the processing, when the delay of a port expires.
+ *
+ * @param[in] timeout_ms Time to wait for the processing request, ms
+ * @return
+ *    - ESP_OK: Processing completed
+ *    - ESP_ERR_TIMEOUT: No processing request in time
+ */
+esp_err_t test_ext_hub_wait_process(uint32_t timeout_ms);
+
+/**
+ * @brief Indicate that the device on the port has been enumerated
+ *
+ * @param[in] port_num Port number
+ * @return
+ *    - Result of ext_hub_port_active()
+ */
+esp_err_t test_ext_hub_port_active(uint8_t port_num);
+
+/**
+ * @brief Indicate that the device on the port has been freed
+ *
+ * @param[in] port_num Port number
+ * @return
+ *    - Result of ext_hub_port_recycle()
+ */
+esp_err_t test_ext_hub_port_recycle(uint8_t port_num);
+
+/**
+ * @brief Imitate the Hub without a free transfer for the next port requests
+ *
+ * @param[in] num_requests Number of port requests, which fail with ESP_ERR_NO_MEM
+ */
+void test_ext_hub_set_no_mem(int num_requests);
+
+/**
+ * @brief Number of events, the External Port Driver has propagated
+ *
+ * @return
+ *    - Number of port events
+ */
+int test_ext_port_get_num_events(void);
+
+/**
+ * @brief Ports with a connected device
+ *
+ * @return
+ *    - Bitmap of the ports, bit N is set after the EXT_PORT_CONNECTED event of the Port N and cleared after its
+ *      EXT_PORT_DISCONNECTED event
+ */
+uint32_t test_ext_port_get_connected(void);
+
+/**
+ * @brief Maximum number of port requests in flight per Hub
+ *
+ * @return
+ *    - EXT_PORT_PARENT_REQ_MAX
+ */
+int test_ext_port_parent_req_max(void);
+
+#ifdef __cplusplus
+}
+#endif
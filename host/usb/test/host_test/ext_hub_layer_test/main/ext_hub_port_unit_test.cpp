@@ -0,0 +1,430 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <set>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "usb_private.h"
+#include "usb/usb_types_ch9.h"
+#include "usb/usb_types_ch11.h"
+#include "ext_hub_common.h"     // Real implementation of ext_hub.h and ext_port.h
+
+// Test all the mocked headers defined for this mock
+extern "C" {
+#include "Mockusbh.h"
+}
+
+#define HUB_DEV_ADDR            1
+#define HUB_NUM_PORTS           10
+#define HUB_POWER_ON_DELAY_MS   200     // Power on delay of the Hub with the power on delay
+#define PORT_DELAY_TIMEOUT_MS   (2 * HUB_POWER_ON_DELAY_MS)
+
+// Hub with 10 ports: the status change bitmap of the Interrupt IN EP takes 2 bytes
+static const uint8_t hub_config_desc[] = {
+    // Configuration Descriptor
+    0x09, 0x02, 0x19, 0x00, 0x01, 0x01, 0x00, 0xE0, 0x32,
+    // Interface Descriptor: Hub class, 1 endpoint
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x09, 0x00, 0x00, 0x00,
+    // Endpoint Descriptor: EP1 IN, Interrupt, wMaxPacketSize 2
+    0x07, 0x05, 0x81, 0x03, 0x02, 0x00, 0xFF,
+};
+
+static usb_hub_descriptor_t hub_desc = {
+    .bDescLength = USB_HUB_DESCRIPTOR_SIZE,
+    .bDescriptorType = USB_CLASS_DESCRIPTOR_TYPE_HUB,
+    .bNbrPorts = HUB_NUM_PORTS,
+    .wHubCharacteristics = { .val = USB_W_HUB_CHARS_PORT_PWR_CTRL_INDV },
+    .bPwrOn2PwrGood = 0,    // No power on delay, ports are handled without the delay timer
+    .bHubContrCurrent = 100,
+};
+
+static usb_device_handle_t const hub_dev_hdl = (usb_device_handle_t)0x1000;
+static usbh_ep_handle_t const hub_ep_hdl = (usbh_ep_handle_t)0x2000;
+
+// Ports of the Hub, the reset completes as soon as it is requested
+struct hub_port_t {
+    bool connected;
+    bool enabled;
+    bool c_connection;
+    bool c_reset;
+};
+
+static hub_port_t hub_ports[HUB_NUM_PORTS + 1];
+static std::deque<urb_t *> ctrl_urbs;       // Control transfers in flight, in submission order
+static std::vector<usb_setup_packet_t> ctrl_log;    // All submitted control transfers
+static urb_t *in_urb;
+static int in_urb_enqueued;
+
+// ---------------------------------------- USBH stubs -------------------------------------------------
+
+static esp_err_t usbh_devs_open_cb(uint8_t dev_addr, usb_device_handle_t *dev_hdl, int cmock_num_calls)
+{
+    *dev_hdl = hub_dev_hdl;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_dev_get_config_desc_cb(usb_device_handle_t dev_hdl, const usb_config_desc_t **config_desc_ret, int cmock_num_calls)
+{
+    *config_desc_ret = (const usb_config_desc_t *)hub_config_desc;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_dev_get_info_cb(usb_device_handle_t dev_hdl, usb_device_info_t *dev_info, int cmock_num_calls)
+{
+    memset(dev_info, 0, sizeof(usb_device_info_t));
+    dev_info->dev_addr = HUB_DEV_ADDR;
+    dev_info->speed = USB_SPEED_FULL;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_ep_alloc_cb(usb_device_handle_t dev_hdl, usbh_ep_config_t *ep_config, usbh_ep_handle_t *ep_hdl_ret, int cmock_num_calls)
+{
+    *ep_hdl_ret = hub_ep_hdl;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_dev_submit_ctrl_urb_cb(usb_device_handle_t dev_hdl, urb_t *urb, int cmock_num_calls)
+{
+    ctrl_urbs.push_back(urb);
+    ctrl_log.push_back(*(const usb_setup_packet_t *)urb->transfer.data_buffer);
+    return ESP_OK;
+}
+
+static esp_err_t usbh_ep_enqueue_urb_cb(usbh_ep_handle_t ep_hdl, urb_t *urb, int cmock_num_calls)
+{
+    in_urb = urb;
+    in_urb_enqueued++;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_ep_dequeue_urb_cb(usbh_ep_handle_t ep_hdl, urb_t **urb_ret, int cmock_num_calls)
+{
+    *urb_ret = NULL;
+    return ESP_OK;
+}
+
+// ------------------------------------------ Helpers --------------------------------------------------
+
+static void process(void)
+{
+    REQUIRE(ESP_OK == test_ext_hub_process());
+}
+
+static const usb_setup_packet_t *urb_setup(const urb_t *urb)
+{
+    return (const usb_setup_packet_t *)urb->transfer.data_buffer;
+}
+
+static std::set<uint16_t> ports_in_flight(void)
+{
+    std::set<uint16_t> ports;
+    for (const urb_t *urb : ctrl_urbs) {
+        ports.insert(urb_setup(urb)->wIndex);
+    }
+    return ports;
+}
+
+static urb_t *take_ctrl_urb(uint16_t port)
+{
+    for (auto it = ctrl_urbs.begin(); it != ctrl_urbs.end(); it++) {
+        if (urb_setup(*it)->wIndex == port) {
+            urb_t *urb = *it;
+            ctrl_urbs.erase(it);
+            return urb;
+        }
+    }
+    FAIL("No control transfer in flight for the port");
+    return nullptr;
+}
+
+// Number of submitted port requests, port 0 counts the requests of all ports
+static int num_requests(uint8_t bRequest, uint16_t wValue, uint16_t port = 0)
+{
+    int num = 0;
+    for (const usb_setup_packet_t &setup : ctrl_log) {
+        if (setup.bRequest == bRequest && setup.wValue == wValue && (port == 0 || setup.wIndex == port)) {
+            num++;
+        }
+    }
+    return num;
+}
+
+// Completes the control transfer as a Hub with powered ports would do
+static void complete_ctrl_urb(urb_t *urb, usb_transfer_status_t status)
+{
+    usb_transfer_t *transfer = &urb->transfer;
+    uint8_t *data = transfer->data_buffer + sizeof(usb_setup_packet_t);
+    const usb_setup_packet_t *setup = urb_setup(urb);
+    hub_port_t *port = (setup->wIndex <= HUB_NUM_PORTS) ? &hub_ports[setup->wIndex] : nullptr;
+
+    switch (setup->bRequest) {
+    case USB_B_REQUEST_GET_DESCRIPTOR:
+        memcpy(data, &hub_desc, sizeof(hub_desc));
+        break;
+    case USB_B_REQUEST_HUB_GET_PORT_STATUS: {
+        usb_port_status_t port_status = {};
+        port_status.wPortStatus.PORT_POWER = 1;
+        port_status.wPortStatus.PORT_CONNECTION = port->connected;
+        port_status.wPortStatus.PORT_ENABLE = port->enabled;
+        port_status.wPortChange.C_PORT_CONNECTION = port->c_connection;
+        port_status.wPortChange.C_PORT_RESET = port->c_reset;
+        memcpy(data, &port_status, sizeof(port_status));
+        break;
+    }
+    case USB_B_REQUEST_HUB_SET_PORT_FEATURE:
+        if (setup->wValue == USB_FEATURE_PORT_RESET) {
+            port->enabled = port->connected;
+            port->c_reset = true;
+        }
+        break;
+    case USB_B_REQUEST_HUB_CLEAR_FEATURE:
+        switch (setup->wValue) {
+        case USB_FEATURE_PORT_ENABLE:
+            port->enabled = false;
+            break;
+        case USB_FEATURE_C_PORT_CONNECTION:
+            port->c_connection = false;
+            break;
+        case USB_FEATURE_C_PORT_RESET:
+            port->c_reset = false;
+            break;
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+    transfer->actual_num_bytes = transfer->num_bytes;
+    transfer->status = status;
+    transfer->callback(transfer);
+}
+
+// Completes all port requests in submission order, the requests of one port never overlap
+static void complete_all_ctrl_urbs(void)
+{
+    while (!ctrl_urbs.empty()) {
+        REQUIRE(ctrl_urbs.size() <= (size_t)test_ext_port_parent_req_max());
+        REQUIRE(ports_in_flight().size() == ctrl_urbs.size());
+        urb_t *urb = ctrl_urbs.front();
+        ctrl_urbs.pop_front();
+        complete_ctrl_urb(urb, USB_TRANSFER_STATUS_COMPLETED);
+        process();
+    }
+}
+
+// Completes all port requests, the delay timer requests the processing when the delay of a port expires
+static void complete_all_ctrl_urbs_and_delays(void)
+{
+    complete_all_ctrl_urbs();
+    while (ESP_OK == test_ext_hub_wait_process(PORT_DELAY_TIMEOUT_MS)) {
+        complete_all_ctrl_urbs();
+    }
+}
+
+// Hub reports the changed ports via the Interrupt IN EP
+static void hub_status_change(uint16_t bitmap)
+{
+    REQUIRE(in_urb != nullptr);
+    usb_transfer_t *transfer = &in_urb->transfer;
+    transfer->data_buffer[0] = bitmap & 0xFF;
+    transfer->data_buffer[1] = bitmap >> 8;
+    transfer->actual_num_bytes = 2;
+    transfer->status = USB_TRANSFER_STATUS_COMPLETED;
+    transfer->callback(transfer);
+    process();
+}
+
+// Device is connected to the port of the Hub
+static void hub_port_connect(uint8_t port_num)
+{
+    hub_ports[port_num].connected = true;
+    hub_ports[port_num].c_connection = true;
+}
+
+// Hub has been attached and has sent the Hub Descriptor, ports are created and start the handling
+static void hub_attach(void)
+{
+    REQUIRE(ESP_OK == test_ext_hub_new_dev(HUB_DEV_ADDR));
+    process();
+    // Get Hub Descriptor
+    REQUIRE(ctrl_urbs.size() == 1);
+    urb_t *urb = ctrl_urbs.front();
+    ctrl_urbs.pop_front();
+    REQUIRE(urb_setup(urb)->bRequest == USB_B_REQUEST_GET_DESCRIPTOR);
+    complete_ctrl_urb(urb, USB_TRANSFER_STATUS_COMPLETED);
+    process();
+}
+
+SCENARIO("External Hub ports handling")
+{
+    usbh_devs_open_Stub(usbh_devs_open_cb);
+    usbh_dev_get_config_desc_Stub(usbh_dev_get_config_desc_cb);
+    usbh_dev_get_info_Stub(usbh_dev_get_info_cb);
+    usbh_ep_alloc_Stub(usbh_ep_alloc_cb);
+    usbh_dev_submit_ctrl_urb_Stub(usbh_dev_submit_ctrl_urb_cb);
+    usbh_ep_enqueue_urb_Stub(usbh_ep_enqueue_urb_cb);
+    usbh_ep_dequeue_urb_Stub(usbh_ep_dequeue_urb_cb);
+    usbh_ep_command_IgnoreAndReturn(ESP_OK);
+    usbh_ep_free_IgnoreAndReturn(ESP_OK);
+    usbh_dev_close_IgnoreAndReturn(ESP_OK);
+
+    hub_desc.bPwrOn2PwrGood = 0;
+    memset(hub_ports, 0, sizeof(hub_ports));
+    ctrl_urbs.clear();
+    ctrl_log.clear();
+    in_urb = nullptr;
+    in_urb_enqueued = 0;
+    REQUIRE(ESP_OK == test_ext_hub_install());
+
+    GIVEN("Hub with more ports than the parent Hub has port requests") {
+        hub_attach();
+
+        THEN("Port requests of different ports are pipelined") {
+            REQUIRE(ctrl_urbs.size() == (size_t)test_ext_port_parent_req_max());
+            REQUIRE((ports_in_flight() == std::set<uint16_t> {1, 2, 3, 4}));
+
+            // Completion out of order, the port sends its next request right away
+            complete_ctrl_urb(take_ctrl_urb(2), USB_TRANSFER_STATUS_COMPLETED);
+            process();
+            REQUIRE(ctrl_urbs.size() == (size_t)test_ext_port_parent_req_max());
+            REQUIRE((ports_in_flight() == std::set<uint16_t> {1, 2, 3, 4}));
+            REQUIRE(urb_setup(ctrl_urbs.back())->wIndex == 2);
+            REQUIRE(urb_setup(ctrl_urbs.back())->bRequest == USB_B_REQUEST_HUB_SET_PORT_FEATURE);
+
+            // All ports are handled, the Interrupt IN EP is enabled
+            complete_all_ctrl_urbs();
+            REQUIRE(in_urb_enqueued == 1);
+        }
+    }
+
+    GIVEN("Hub without a free transfer for the first port request") {
+        test_ext_hub_set_no_mem(1);
+        hub_attach();
+
+        THEN("The request is sent after another request of the Hub is completed") {
+            REQUIRE((ports_in_flight() == std::set<uint16_t> {2, 3, 4, 5}));
+
+            complete_ctrl_urb(take_ctrl_urb(3), USB_TRANSFER_STATUS_COMPLETED);
+            process();
+            REQUIRE((ports_in_flight() == std::set<uint16_t> {1, 2, 4, 5}));
+            REQUIRE(urb_setup(ctrl_urbs.back())->wIndex == 1);
+            REQUIRE(urb_setup(ctrl_urbs.back())->bRequest == USB_B_REQUEST_HUB_GET_PORT_STATUS);
+
+            complete_all_ctrl_urbs();
+            REQUIRE(in_urb_enqueued == 1);
+        }
+    }
+
+    GIVEN("Hub with a power on delay") {
+        hub_desc.bPwrOn2PwrGood = HUB_POWER_ON_DELAY_MS / 2;
+        hub_attach();
+        complete_all_ctrl_urbs();
+
+        THEN("Ports wait for the power on delay at the same time") {
+            // All ports are powered on, before the delay of the first port expires
+            REQUIRE(num_requests(USB_B_REQUEST_HUB_SET_PORT_FEATURE, USB_FEATURE_PORT_POWER) == HUB_NUM_PORTS);
+            REQUIRE(num_requests(USB_B_REQUEST_HUB_GET_PORT_STATUS, 0) == HUB_NUM_PORTS);
+            REQUIRE(ctrl_urbs.empty());
+            REQUIRE(in_urb_enqueued == 0);
+
+            // After the delay, the ports request the status and complete the handling
+            complete_all_ctrl_urbs_and_delays();
+            REQUIRE(num_requests(USB_B_REQUEST_HUB_GET_PORT_STATUS, 0) == 2 * HUB_NUM_PORTS);
+            REQUIRE(in_urb_enqueued == 1);
+        }
+    }
+
+    GIVEN("Hub with all ports handled") {
+        hub_attach();
+        complete_all_ctrl_urbs();
+        REQUIRE(in_urb_enqueued == 1);
+
+        WHEN("Ports above 8 have changed") {
+            // Bit 0 is the Hub, bit N is the Port N
+            hub_status_change((1 << 9) | (1 << 10));
+
+            THEN("Status of the ports is requested") {
+                REQUIRE((ports_in_flight() == std::set<uint16_t> {9, 10}));
+                for (const urb_t *urb : ctrl_urbs) {
+                    REQUIRE(urb_setup(urb)->bRequest == USB_B_REQUEST_HUB_GET_PORT_STATUS);
+                }
+                complete_all_ctrl_urbs();
+                REQUIRE(in_urb_enqueued == 2);
+            }
+        }
+
+        WHEN("Ports from both bytes of the bitmap have changed") {
+            hub_status_change((1 << 1) | (1 << 8) | (1 << 9));
+
+            THEN("Status of the ports is requested") {
+                REQUIRE((ports_in_flight() == std::set<uint16_t> {1, 8, 9}));
+                complete_all_ctrl_urbs();
+                REQUIRE(in_urb_enqueued == 2);
+            }
+        }
+
+        WHEN("Devices are connected to two ports") {
+            hub_port_connect(3);
+            hub_port_connect(5);
+            hub_status_change((1 << 3) | (1 << 5));
+            complete_all_ctrl_urbs_and_delays();
+
+            THEN("Only one port at a time resets its device") {
+                // Port 5 has handled the connection, but waits for Port 3 to release the default address
+                REQUIRE(test_ext_port_get_connected() == (1 << 3));
+                REQUIRE(num_requests(USB_B_REQUEST_HUB_CLEAR_FEATURE, USB_FEATURE_C_PORT_CONNECTION, 5) == 1);
+                REQUIRE(num_requests(USB_B_REQUEST_HUB_SET_PORT_FEATURE, USB_FEATURE_PORT_RESET, 5) == 0);
+
+                // Device on Port 3 has been enumerated, Port 5 resets its device
+                REQUIRE(ESP_OK == test_ext_hub_port_active(3));
+                process();
+                complete_all_ctrl_urbs_and_delays();
+                REQUIRE(test_ext_port_get_connected() == ((1 << 3) | (1 << 5)));
+                REQUIRE(num_requests(USB_B_REQUEST_HUB_SET_PORT_FEATURE, USB_FEATURE_PORT_RESET, 5) == 1);
+                REQUIRE(ESP_OK == test_ext_hub_port_active(5));
+                process();
+            }
+        }
+
+        WHEN("Port request fails") {
+            hub_status_change(1 << 9);
+            REQUIRE((ports_in_flight() == std::set<uint16_t> {9}));
+            complete_ctrl_urb(take_ctrl_urb(9), USB_TRANSFER_STATUS_ERROR);
+            process();
+
+            THEN("The port doesn't wait for the failed request anymore") {
+                REQUIRE(ctrl_urbs.empty());
+                hub_status_change(1 << 9);
+                REQUIRE((ports_in_flight() == std::set<uint16_t> {9}));
+                complete_all_ctrl_urbs();
+            }
+        }
+    }
+
+    // Teardown: Hub is detached, all ports are freed
+    complete_all_ctrl_urbs();
+    const uint32_t connected = test_ext_port_get_connected();
+    REQUIRE(ESP_OK == test_ext_hub_dev_gone(HUB_DEV_ADDR));
+    process();
+    REQUIRE(0 == test_ext_port_get_connected());
+    // Devices are freed, the ports are released
+    int num_connected = 0;
+    for (uint8_t port_num = 1; port_num <= HUB_NUM_PORTS; port_num++) {
+        if (connected & (1 << port_num)) {
+            REQUIRE(ESP_OK == test_ext_hub_port_recycle(port_num));
+            process();
+            num_connected++;
+        }
+    }
+    // Every device had a connection and a disconnection event
+    REQUIRE(2 * num_connected == test_ext_port_get_num_events());
+    REQUIRE(ESP_OK == test_ext_hub_uninstall());
+}
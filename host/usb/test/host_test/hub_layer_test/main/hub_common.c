@@ -0,0 +1,349 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "esp_bit_defs.h"
+#include "hub.h"
+#include "Mockhcd.h"
+#include "Mockusbh.h"
+#include "Mockext_hub.h"
+#include "Mockext_port.h"
+#include "hub_common.h"
+
+// External Hub handles are 128 bytes apart, so all of them fall into the same bucket of the Hub driver parent hash
+typedef struct {
+    unsigned int uid;
+} __attribute__((aligned(128))) test_ext_hub_t;
+
+typedef struct {
+    int hub_idx;
+    uint8_t port_num;
+} test_ext_port_t;
+
+static test_ext_hub_t test_ext_hubs[TEST_HUB_NUM_EXT_HUBS];
+static int test_root_port;
+static hcd_port_config_t root_port_config;
+static hcd_port_event_t root_port_event;
+static ext_port_driver_config_t ext_port_config;
+
+static bool uid_in_use[TEST_HUB_MAX_UID];
+static unsigned int next_uid;
+static esp_err_t devs_add_err;
+
+static bool event_received;
+static hub_event_data_t last_event;
+static int last_port_reset_hub_idx;
+static uint8_t last_port_reset_port_num;
+static int num_port_disables;
+
+// ------------------------------------------------ Hub driver callbacks -----------------------------------------------
+
+static bool hub_proc_req_cb(usb_proc_req_source_t source, bool in_isr, void *context)
+{
+    return false;
+}
+
+static void hub_event_cb(hub_event_data_t *event_data, void *arg)
+{
+    event_received = true;
+    last_event = *event_data;
+}
+
+// ------------------------------------------------------ HCD stubs ----------------------------------------------------
+
+static esp_err_t hcd_port_init_cb(int port_number, const hcd_port_config_t *port_config, hcd_port_handle_t *port_hdl, int cmock_num_calls)
+{
+    root_port_config = *port_config;
+    *port_hdl = (hcd_port_handle_t)&test_root_port;
+    return ESP_OK;
+}
+
+static esp_err_t hcd_port_deinit_cb(hcd_port_handle_t port_hdl, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t hcd_port_command_cb(hcd_port_handle_t port_hdl, hcd_port_cmd_t command, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static hcd_port_state_t hcd_port_get_state_cb(hcd_port_handle_t port_hdl, int cmock_num_calls)
+{
+    return HCD_PORT_STATE_ENABLED;
+}
+
+static esp_err_t hcd_port_get_speed_cb(hcd_port_handle_t port_hdl, usb_speed_t *speed, int cmock_num_calls)
+{
+    *speed = USB_SPEED_FULL;
+    return ESP_OK;
+}
+
+static hcd_port_event_t hcd_port_handle_event_cb(hcd_port_handle_t port_hdl, int cmock_num_calls)
+{
+    hcd_port_event_t event = root_port_event;
+    root_port_event = HCD_PORT_EVENT_NONE;
+    return event;
+}
+
+static void *hcd_port_get_context_cb(hcd_port_handle_t port_hdl, int cmock_num_calls)
+{
+    return root_port_config.context;
+}
+
+// ------------------------------------------------------ USBH stubs ---------------------------------------------------
+
+static esp_err_t usbh_devs_num_cb(int *num_devs_ret, int cmock_num_calls)
+{
+    int num_devs = 0;
+    for (int i = 0; i < TEST_HUB_MAX_UID; i++) {
+        num_devs += uid_in_use[i];
+    }
+    if (next_uid != 0) {
+        // The Hub driver starts the UID search from the number of devices + 1
+        num_devs = next_uid - 1;
+        next_uid = 0;
+    }
+    *num_devs_ret = num_devs;
+    return ESP_OK;
+}
+
+static bool usbh_devs_is_uid_in_use_cb(uint32_t uid, int cmock_num_calls)
+{
+    return (uid < TEST_HUB_MAX_UID) ? uid_in_use[uid] : false;
+}
+
+static esp_err_t usbh_devs_add_cb(usbh_dev_params_t *params, int cmock_num_calls)
+{
+    if (devs_add_err != ESP_OK) {
+        return devs_add_err;
+    }
+    if (params->uid >= TEST_HUB_MAX_UID) {
+        return ESP_ERR_NO_MEM;
+    }
+    uid_in_use[params->uid] = true;
+    return ESP_OK;
+}
+
+// --------------------------------------------- External Hub and Port stubs -------------------------------------------
+
+static esp_err_t ext_port_install_cb(const ext_port_driver_config_t *config, int cmock_num_calls)
+{
+    ext_port_config = *config;
+    return ESP_OK;
+}
+
+static esp_err_t ext_port_uninstall_cb(int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static const ext_port_driver_api_t *ext_port_get_driver_cb(int cmock_num_calls)
+{
+    return NULL;
+}
+
+static void *ext_port_get_context_cb(ext_port_hdl_t port_hdl, int cmock_num_calls)
+{
+    return &test_ext_hubs[((test_ext_port_t *)port_hdl)->hub_idx];
+}
+
+static esp_err_t ext_port_get_port_num_cb(ext_port_hdl_t port_hdl, uint8_t *port1, int cmock_num_calls)
+{
+    *port1 = ((test_ext_port_t *)port_hdl)->port_num;
+    return ESP_OK;
+}
+
+static esp_err_t ext_hub_install_cb(const ext_hub_config_t *config, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t ext_hub_uninstall_cb(int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static void *ext_hub_get_client_cb(int cmock_num_calls)
+{
+    return NULL;
+}
+
+static esp_err_t ext_hub_get_speed_cb(ext_hub_handle_t ext_hub_hdl, usb_speed_t *speed, int cmock_num_calls)
+{
+    *speed = USB_SPEED_FULL;
+    return ESP_OK;
+}
+
+static esp_err_t ext_hub_port_get_speed_cb(ext_hub_handle_t ext_hub_hdl, uint8_t port_num, usb_speed_t *speed, int cmock_num_calls)
+{
+    *speed = USB_SPEED_FULL;
+    return ESP_OK;
+}
+
+static hcd_port_handle_t ext_hub_get_root_port_cb(ext_hub_handle_t ext_hub_hdl, int cmock_num_calls)
+{
+    return (hcd_port_handle_t)&test_root_port;
+}
+
+static unsigned int ext_hub_get_uid_cb(ext_hub_handle_t ext_hub_hdl, int cmock_num_calls)
+{
+    return ((test_ext_hub_t *)ext_hub_hdl)->uid;
+}
+
+static esp_err_t ext_hub_port_recycle_cb(ext_hub_handle_t ext_hub_hdl, uint8_t port_num, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t ext_hub_port_reset_cb(ext_hub_handle_t ext_hub_hdl, uint8_t port_num, int cmock_num_calls)
+{
+    last_port_reset_hub_idx = (test_ext_hub_t *)ext_hub_hdl - test_ext_hubs;
+    last_port_reset_port_num = port_num;
+    return ESP_OK;
+}
+
+static esp_err_t ext_hub_port_disable_cb(ext_hub_handle_t ext_hub_hdl, uint8_t port_num, int cmock_num_calls)
+{
+    num_port_disables++;
+    return ESP_OK;
+}
+
+static void set_stubs(bool enable)
+{
+    hcd_port_init_Stub(enable ? hcd_port_init_cb : NULL);
+    hcd_port_deinit_Stub(enable ? hcd_port_deinit_cb : NULL);
+    hcd_port_command_Stub(enable ? hcd_port_command_cb : NULL);
+    hcd_port_get_state_Stub(enable ? hcd_port_get_state_cb : NULL);
+    hcd_port_get_speed_Stub(enable ? hcd_port_get_speed_cb : NULL);
+    hcd_port_handle_event_Stub(enable ? hcd_port_handle_event_cb : NULL);
+    hcd_port_get_context_Stub(enable ? hcd_port_get_context_cb : NULL);
+    usbh_devs_num_Stub(enable ? usbh_devs_num_cb : NULL);
+    usbh_devs_is_uid_in_use_Stub(enable ? usbh_devs_is_uid_in_use_cb : NULL);
+    usbh_devs_add_Stub(enable ? usbh_devs_add_cb : NULL);
+    ext_port_install_Stub(enable ? ext_port_install_cb : NULL);
+    ext_port_uninstall_Stub(enable ? ext_port_uninstall_cb : NULL);
+    ext_port_get_driver_Stub(enable ? ext_port_get_driver_cb : NULL);
+    ext_port_get_context_Stub(enable ? ext_port_get_context_cb : NULL);
+    ext_port_get_port_num_Stub(enable ? ext_port_get_port_num_cb : NULL);
+    ext_hub_install_Stub(enable ? ext_hub_install_cb : NULL);
+    ext_hub_uninstall_Stub(enable ? ext_hub_uninstall_cb : NULL);
+    ext_hub_get_client_Stub(enable ? ext_hub_get_client_cb : NULL);
+    ext_hub_get_speed_Stub(enable ? ext_hub_get_speed_cb : NULL);
+    ext_hub_port_get_speed_Stub(enable ? ext_hub_port_get_speed_cb : NULL);
+    ext_hub_get_root_port_Stub(enable ? ext_hub_get_root_port_cb : NULL);
+    ext_hub_get_uid_Stub(enable ? ext_hub_get_uid_cb : NULL);
+    ext_hub_port_recycle_Stub(enable ? ext_hub_port_recycle_cb : NULL);
+    ext_hub_port_reset_Stub(enable ? ext_hub_port_reset_cb : NULL);
+    ext_hub_port_disable_Stub(enable ? ext_hub_port_disable_cb : NULL);
+}
+
+// ------------------------------------------------------ Test API -----------------------------------------------------
+
+esp_err_t test_hub_install(void)
+{
+    memset(test_ext_hubs, 0, sizeof(test_ext_hubs));
+    memset(uid_in_use, 0, sizeof(uid_in_use));
+    root_port_event = HCD_PORT_EVENT_NONE;
+    next_uid = 0;
+    devs_add_err = ESP_OK;
+    event_received = false;
+    last_port_reset_hub_idx = -1;
+    last_port_reset_port_num = 0;
+    num_port_disables = 0;
+    set_stubs(true);
+
+    hub_config_t hub_config = {
+        .port_map = BIT0,
+        .proc_req_cb = hub_proc_req_cb,
+        .event_cb = hub_event_cb,
+    };
+    void *client = NULL;
+    esp_err_t ret = hub_install(&hub_config, &client);
+    if (ret != ESP_OK) {
+        set_stubs(false);
+    }
+    return ret;
+}
+
+esp_err_t test_hub_uninstall(void)
+{
+    esp_err_t ret = hub_root_stop();
+    if (ret == ESP_OK) {
+        ret = hub_uninstall();
+    }
+    set_stubs(false);
+    return ret;
+}
+
+void test_hub_ext_hub_set_uid(int hub_idx, unsigned int uid)
+{
+    test_ext_hubs[hub_idx].uid = uid;
+}
+
+void test_hub_set_next_uid(unsigned int uid)
+{
+    next_uid = uid;
+}
+
+void test_hub_set_devs_add_err(esp_err_t err)
+{
+    devs_add_err = err;
+}
+
+unsigned int test_hub_root_connect(void)
+{
+    event_received = false;
+    root_port_event = HCD_PORT_EVENT_CONNECTION;
+    root_port_config.callback((hcd_port_handle_t)&test_root_port, HCD_PORT_EVENT_CONNECTION, root_port_config.callback_arg, true);
+    hub_process();
+    return (event_received && last_event.event == HUB_EVENT_CONNECTED) ? last_event.connected.uid : 0;
+}
+
+unsigned int test_hub_ext_port_connect(int hub_idx, uint8_t port_num)
+{
+    test_ext_port_t port = {
+        .hub_idx = hub_idx,
+        .port_num = port_num,
+    };
+    event_received = false;
+    ext_port_config.event_cb((ext_port_hdl_t)&port, EXT_PORT_CONNECTED, ext_port_config.event_cb_arg);
+    return (event_received && last_event.event == HUB_EVENT_CONNECTED) ? last_event.connected.uid : 0;
+}
+
+unsigned int test_hub_ext_port_disconnect(int hub_idx, uint8_t port_num)
+{
+    test_ext_port_t port = {
+        .hub_idx = hub_idx,
+        .port_num = port_num,
+    };
+    event_received = false;
+    ext_port_config.event_cb((ext_port_hdl_t)&port, EXT_PORT_DISCONNECTED, ext_port_config.event_cb_arg);
+    return (event_received && last_event.event == HUB_EVENT_DISCONNECTED) ? last_event.disconnected.uid : 0;
+}
+
+esp_err_t test_hub_node_free(unsigned int uid)
+{
+    if (uid < TEST_HUB_MAX_UID) {
+        uid_in_use[uid] = false;
+    }
+    esp_err_t ret = hub_node_recycle(uid);
+    // Root port is disabled from hub_process()
+    hub_process();
+    return ret;
+}
+
+void test_hub_get_last_port_reset(int *hub_idx, uint8_t *port_num)
+{
+    *hub_idx = last_port_reset_hub_idx;
+    *port_num = last_port_reset_port_num;
+}
+
+int test_hub_get_num_port_disables(void)
+{
+    return num_port_disables;
+}
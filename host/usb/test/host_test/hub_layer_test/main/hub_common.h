@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The External Port Driver API has a member named 'new', so ext_hub.h and ext_port.h (and their mocks) can't be included from C++.
+ * The test drives the Hub driver through these C wrappers, which also stub the mocked layers.
+ */
+
+#define TEST_HUB_NUM_EXT_HUBS           3       // Number of external Hub handles available to the test
+#define TEST_HUB_MAX_UID                64      // Largest device UID tracked by the USBH stubs
+
+/**
+ * @brief Install the Hub driver with the root port 0 enabled
+ *
+ * All the functions of the mocked layers, which the Hub driver calls, are stubbed.
+ *
+ * @return
+ *    - Result of hub_install()
+ */
+esp_err_t test_hub_install(void);
+
+/**
+ * @brief Stop the root port, uninstall the Hub driver and clear the stubs
+ *
+ * @return
+ *    - Result of hub_uninstall()
+ */
+esp_err_t test_hub_uninstall(void);
+
+/**
+ * @brief Set the UID of the device, which is the external Hub
+ *
+ * @param[in] hub_idx External Hub index, less than TEST_HUB_NUM_EXT_HUBS
+ * @param[in] uid Device tree UID of the Hub device
+ */
+void test_hub_ext_hub_set_uid(int hub_idx, unsigned int uid);
+
+/**
+ * @brief Assign the next device a UID, starting the search from the given value
+ *
+ * @param[in] uid UID, which the next device gets, if it is not in use
+ */
+void test_hub_set_next_uid(unsigned int uid);
+
+/**
+ * @brief Imitate USBH, which fails to add new devices
+ *
+ * @param[in] err Error returned by usbh_devs_add(), ESP_OK to add devices again
+ */
+void test_hub_set_devs_add_err(esp_err_t err);
+
+/**
+ * @brief Connect a device to the root port 0
+ *
+ * The connection is propagated through the root port callback and hub_process()
+ *
+ * @return
+ *    - UID of the connected device, 0 if the Hub driver did not report the connection
+ */
+unsigned int test_hub_root_connect(void);
+
+/**
+ * @brief Connect a device to a port of an external Hub
+ *
+ * @param[in] hub_idx External Hub index
+ * @param[in] port_num Port number
+ * @return
+ *    - UID of the connected device, 0 if the Hub driver did not report the connection
+ */
+unsigned int test_hub_ext_port_connect(int hub_idx, uint8_t port_num);
+
+/**
+ * @brief Disconnect a device from a port of an external Hub
+ *
+ * @param[in] hub_idx External Hub index
+ * @param[in] port_num Port number
+ * @return
+ *    - UID of the disconnected device, 0 if the Hub driver did not report the disconnection
+ */
+unsigned int test_hub_ext_port_disconnect(int hub_idx, uint8_t port_num);
+
+/**
+ * @brief Free the device in USBH and recycle its device tree node
+ *
+ * @param[in] uid Device UID
+ * @return
+ *    - Result of hub_node_recycle()
+ */
+esp_err_t test_hub_node_free(unsigned int uid);
+
+/**
+ * @brief Get the port of the last external Hub port reset
+ *
+ * @param[out] hub_idx External Hub index, -1 if no port has been reset
+ * @param[out] port_num Port number
+ */
+void test_hub_get_last_port_reset(int *hub_idx, uint8_t *port_num);
+
+/**
+ * @brief Number of external Hub ports, the Hub driver has disabled
+ *
+ * @return
+ *    - Number of ext_hub_port_disable() calls
+ */
+int test_hub_get_num_port_disables(void);
+
+#ifdef __cplusplus
+}
+#endif
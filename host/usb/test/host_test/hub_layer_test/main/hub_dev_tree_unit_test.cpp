@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "hub.h"
+#include "hub_common.h"
+
+#define TEST_MAX_NODES      10
+
+static void require_dev_tree(const std::vector<hub_dev_tree_node_info_t> &expected)
+{
+    hub_dev_tree_node_info_t nodes[TEST_MAX_NODES];
+    int num_nodes = 0;
+    REQUIRE(hub_dev_tree_snapshot(TEST_MAX_NODES, nodes, &num_nodes) == ESP_OK);
+    REQUIRE(num_nodes == (int)expected.size());
+    for (int i = 0; i < num_nodes; i++) {
+        INFO("Node " << i);
+        REQUIRE(nodes[i].uid == expected[i].uid);
+        REQUIRE(nodes[i].parent_uid == expected[i].parent_uid);
+        REQUIRE(nodes[i].port_num == expected[i].port_num);
+        REQUIRE(nodes[i].depth == expected[i].depth);
+    }
+}
+
+static void require_port_reset(unsigned int uid, int hub_idx, uint8_t port_num)
+{
+    int reset_hub_idx;
+    uint8_t reset_port_num;
+    REQUIRE(hub_node_reset(uid) == ESP_OK);
+    test_hub_get_last_port_reset(&reset_hub_idx, &reset_port_num);
+    REQUIRE(reset_hub_idx == hub_idx);
+    REQUIRE(reset_port_num == port_num);
+}
+
+static void free_dev_tree(void)
+{
+    hub_dev_tree_node_info_t nodes[TEST_MAX_NODES];
+    int num_nodes = 0;
+    REQUIRE(hub_dev_tree_snapshot(TEST_MAX_NODES, nodes, &num_nodes) == ESP_OK);
+    // Parents are listed before their children, free the children first
+    for (int i = num_nodes - 1; i >= 0; i--) {
+        REQUIRE(test_hub_node_free(nodes[i].uid) == ESP_OK);
+        REQUIRE(hub_node_active(nodes[i].uid) == ESP_ERR_NOT_FOUND);
+    }
+    require_dev_tree({});
+}
+
+SCENARIO("Hub driver device tree", "[hub][dev_tree]")
+{
+    GIVEN("Hub driver is installed and a Hub is connected to the root port") {
+        REQUIRE(test_hub_install() == ESP_OK);
+        REQUIRE(test_hub_root_connect() == 1);
+        test_hub_ext_hub_set_uid(0, 1);
+        require_dev_tree({{1, 0, 0, 1}});
+
+        WHEN("Devices are connected to growing port numbers of the Hub") {
+            // Port 9 grows the nodes array of the Hub children, port 4 fits in it
+            REQUIRE(test_hub_ext_port_connect(0, 1) == 2);
+            REQUIRE(test_hub_ext_port_connect(0, 9) == 3);
+            REQUIRE(test_hub_ext_port_connect(0, 4) == 4);
+
+            THEN("The tree lists the nodes in the connection order") {
+                require_dev_tree({{1, 0, 0, 1}, {2, 1, 1, 2}, {3, 1, 9, 2}, {4, 1, 4, 2}});
+
+                hub_dev_tree_node_info_t nodes[2];
+                int num_nodes = 0;
+                REQUIRE(hub_dev_tree_snapshot(2, nodes, &num_nodes) == ESP_OK);
+                REQUIRE(num_nodes == 2);
+                REQUIRE(nodes[0].uid == 1);
+                REQUIRE(nodes[1].uid == 2);
+                REQUIRE(hub_dev_tree_snapshot(2, NULL, &num_nodes) == ESP_ERR_INVALID_ARG);
+            }
+
+            THEN("The nodes are found by uid and by port number") {
+                require_port_reset(2, 0, 1);
+                require_port_reset(3, 0, 9);
+                require_port_reset(4, 0, 4);
+                REQUIRE(test_hub_ext_port_disconnect(0, 1) == 2);
+                REQUIRE(test_hub_ext_port_disconnect(0, 9) == 3);
+                REQUIRE(test_hub_ext_port_disconnect(0, 5) == 0);
+                REQUIRE(test_hub_ext_port_disconnect(0, 12) == 0);
+            }
+
+            THEN("A port in use is not connected again") {
+                REQUIRE(test_hub_ext_port_connect(0, 9) == 0);
+                REQUIRE(test_hub_get_num_port_disables() == 1);
+                require_dev_tree({{1, 0, 0, 1}, {2, 1, 1, 2}, {3, 1, 9, 2}, {4, 1, 4, 2}});
+            }
+        }
+
+        WHEN("Hubs share a bucket of the parent hash") {
+            // External Hub handles 1 and 2 have the same parent hash
+            REQUIRE(test_hub_ext_port_connect(0, 1) == 2);
+            REQUIRE(test_hub_ext_port_connect(0, 2) == 3);
+            test_hub_ext_hub_set_uid(1, 2);
+            test_hub_ext_hub_set_uid(2, 3);
+            REQUIRE(test_hub_ext_port_connect(1, 1) == 4);
+            REQUIRE(test_hub_ext_port_connect(2, 1) == 5);
+            REQUIRE(test_hub_ext_port_connect(2, 3) == 6);
+
+            THEN("Each Hub has its own children") {
+                require_dev_tree({{1, 0, 0, 1}, {2, 1, 1, 2}, {3, 1, 2, 2}, {4, 2, 1, 3}, {5, 3, 1, 3}, {6, 3, 3, 3}});
+                require_port_reset(4, 1, 1);
+                require_port_reset(5, 2, 1);
+                require_port_reset(6, 2, 3);
+            }
+
+            AND_WHEN("The last child of a Hub is removed") {
+                REQUIRE(test_hub_node_free(4) == ESP_OK);
+
+                THEN("Only the children of that Hub are freed") {
+                    REQUIRE(test_hub_ext_port_disconnect(1, 1) == 0);
+                    REQUIRE(test_hub_ext_port_disconnect(2, 1) == 5);
+                    REQUIRE(test_hub_ext_port_disconnect(2, 3) == 6);
+                }
+
+                THEN("A new Hub with the same handle gets new children") {
+                    REQUIRE(test_hub_node_free(2) == ESP_OK);
+                    test_hub_set_next_uid(7);
+                    REQUIRE(test_hub_ext_port_connect(0, 1) == 7);
+                    test_hub_ext_hub_set_uid(1, 7);
+                    REQUIRE(test_hub_ext_port_connect(1, 2) == 8);
+                    require_dev_tree({{1, 0, 0, 1}, {3, 1, 2, 2}, {5, 3, 1, 3}, {6, 3, 3, 3}, {7, 1, 1, 2}, {8, 7, 2, 3}});
+                }
+            }
+        }
+
+        WHEN("UIDs share a bucket of the uid hash") {
+            // UIDs 1, 17 and 33 have the same uid hash
+            test_hub_set_next_uid(17);
+            REQUIRE(test_hub_ext_port_connect(0, 1) == 17);
+            test_hub_set_next_uid(33);
+            REQUIRE(test_hub_ext_port_connect(0, 2) == 33);
+
+            THEN("The nodes are found by uid") {
+                require_port_reset(17, 0, 1);
+                require_port_reset(33, 0, 2);
+                REQUIRE(hub_node_active(1) == ESP_OK);
+                REQUIRE(hub_node_active(49) == ESP_ERR_NOT_FOUND);
+            }
+
+            AND_WHEN("A node in the middle of the bucket is removed") {
+                REQUIRE(test_hub_node_free(17) == ESP_OK);
+
+                THEN("The other nodes of the bucket are still found") {
+                    REQUIRE(hub_node_reset(17) == ESP_ERR_NOT_FOUND);
+                    require_port_reset(33, 0, 2);
+                    REQUIRE(hub_node_active(1) == ESP_OK);
+                    require_dev_tree({{1, 0, 0, 1}, {33, 1, 2, 2}});
+                }
+            }
+        }
+
+        WHEN("USBH fails to add the first child of a Hub") {
+            REQUIRE(test_hub_ext_port_connect(0, 1) == 2);
+            test_hub_ext_hub_set_uid(1, 2);
+            test_hub_set_devs_add_err(ESP_ERR_NOT_SUPPORTED);
+            REQUIRE(test_hub_ext_port_connect(1, 1) == 0);
+            test_hub_set_devs_add_err(ESP_OK);
+
+            THEN("The port is disabled and the children of the Hub are freed") {
+                REQUIRE(test_hub_get_num_port_disables() == 1);
+                require_dev_tree({{1, 0, 0, 1}, {2, 1, 1, 2}});
+
+                // A new Hub with the same handle doesn't get the stale children
+                REQUIRE(test_hub_node_free(2) == ESP_OK);
+                test_hub_set_next_uid(5);
+                REQUIRE(test_hub_ext_port_connect(0, 1) == 5);
+                test_hub_ext_hub_set_uid(1, 5);
+                REQUIRE(test_hub_ext_port_connect(1, 1) == 3);
+                require_dev_tree({{1, 0, 0, 1}, {5, 1, 1, 2}, {3, 5, 1, 3}});
+            }
+        }
+
+        // Teardown
+        free_dev_tree();
+        REQUIRE(test_hub_uninstall() == ESP_OK);
+    }
+}
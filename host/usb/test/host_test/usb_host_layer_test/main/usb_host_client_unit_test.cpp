@@ -0,0 +1,433 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_bit_defs.h"
+#include "usb_private.h"
+#include "usb_host.h"   // Real implementation of usb_host.h
+
+// Test all the mocked headers defined for this mock
+extern "C" {
+#include "Mockusb_phy.h"
+#include "Mockhcd.h"
+#include "Mockusbh.h"
+#include "Mockenum.h"
+#include "Mockhub.h"
+}
+
+static void client_event_cb(const usb_host_client_event_msg_t *event_msg, void *arg)
+{
+    (void)event_msg;
+    (void)arg;
+}
+
+SCENARIO("USB Host client register")
+{
+    usb_host_config_t usb_host_config = {
+        .skip_phy_setup = true,
+        .root_port_unpowered = false,
+        .intr_flags = 1,
+        .enum_filter_cb = nullptr,
+        .fifo_settings_custom = {},
+        .peripheral_map = BIT0,
+    };
+    usbh_install_ExpectAnyArgsAndReturn(ESP_OK);
+    enum_install_ExpectAnyArgsAndReturn(ESP_OK);
+    hub_install_ExpectAnyArgsAndReturn(ESP_OK);
+    hub_root_start_ExpectAndReturn(ESP_OK);
+    REQUIRE(ESP_OK == usb_host_install(&usb_host_config));
+
+    usb_host_client_config_t client_config = {};
+    client_config.is_synchronous = false;
+    client_config.max_num_event_msg = 3;
+    client_config.async.client_event_callback = client_event_cb;
+    client_config.async.callback_arg = nullptr;
+    usb_host_client_handle_t client_hdl = nullptr;
+
+    GIVEN("Client without completion workers") {
+        SECTION("Register and deregister the client") {
+            REQUIRE(ESP_OK == usb_host_client_register(&client_config, &client_hdl));
+            REQUIRE(ESP_OK == usb_host_client_handle_events(client_hdl, 0));
+            REQUIRE(ESP_OK == usb_host_client_deregister(client_hdl));
+        }
+    }
+
+    GIVEN("Client with completion workers") {
+        client_config.completion_workers.num_tasks = 2;
+        client_config.completion_workers.stack_size = 4096;
+        client_config.completion_workers.task_priority = 5;
+        client_config.completion_workers.core_id = tskNO_AFFINITY;
+
+        SECTION("Negative number of workers") {
+            client_config.completion_workers.num_tasks = -1;
+            REQUIRE(ESP_ERR_INVALID_ARG == usb_host_client_register(&client_config, &client_hdl));
+        }
+
+        SECTION("Workers without stack size") {
+            client_config.completion_workers.stack_size = 0;
+            REQUIRE(ESP_ERR_INVALID_ARG == usb_host_client_register(&client_config, &client_hdl));
+        }
+
+        SECTION("Register and deregister the client") {
+            REQUIRE(ESP_OK == usb_host_client_register(&client_config, &client_hdl));
+            REQUIRE(ESP_OK == usb_host_client_handle_events(client_hdl, 0));
+            // Deregistration stops the workers
+            REQUIRE(ESP_OK == usb_host_client_deregister(client_hdl));
+        }
+    }
+
+    // Clear USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS, otherwise the USB Host Library can not be uninstalled
+    uint32_t event_flags;
+    REQUIRE(ESP_OK == usb_host_lib_handle_events(0, &event_flags));
+
+    hub_root_stop_ExpectAndReturn(ESP_OK);
+    hub_uninstall_ExpectAndReturn(ESP_OK);
+    enum_uninstall_ExpectAndReturn(ESP_OK);
+    usbh_uninstall_ExpectAndReturn(ESP_OK);
+    REQUIRE(ESP_OK == usb_host_uninstall());
+}
+
+// Vendor specific device with one interface and two Bulk IN EPs
+static const uint8_t test_config_desc[] = {
+    // Configuration Descriptor
+    0x09, 0x02, 0x20, 0x00, 0x01, 0x01, 0x00, 0x80, 0x32,
+    // Interface Descriptor: Vendor specific, 2 endpoints
+    0x09, 0x04, 0x00, 0x00, 0x02, 0xFF, 0x00, 0x00, 0x00,
+    // Endpoint Descriptor: EP1 IN, Bulk, wMaxPacketSize 64
+    0x07, 0x05, 0x81, 0x02, 0x40, 0x00, 0x00,
+    // Endpoint Descriptor: EP2 IN, Bulk, wMaxPacketSize 64
+    0x07, 0x05, 0x82, 0x02, 0x40, 0x00, 0x00,
+};
+
+#define TEST_NUM_DEVS       2
+#define TEST_NUM_EPS        2
+
+struct fake_dev_t {
+    uint8_t addr;
+};
+
+struct fake_ep_t {
+    usb_device_handle_t dev_hdl;
+    uint8_t bEndpointAddress;
+    usbh_ep_cb_t ep_cb;
+    void *ep_cb_arg;
+    void *context;
+    std::deque<urb_t *> inflight;   // URBs enqueued to the EP
+    std::deque<urb_t *> done;       // URBs completed, waiting to be dequeued
+};
+
+struct completed_transfer_t {
+    uint8_t dev_addr;
+    uint8_t bEndpointAddress;
+    TaskHandle_t task;
+};
+
+static fake_dev_t fake_devs[TEST_NUM_DEVS] = { { .addr = 1 }, { .addr = 2 } };
+static fake_ep_t fake_eps[TEST_NUM_DEVS * TEST_NUM_EPS];
+static std::vector<completed_transfer_t> completed_transfers;
+static SemaphoreHandle_t transfer_done_sem;
+// EP completed by USBH while the next transfer callback runs
+static fake_ep_t *complete_in_cb_ep;
+
+// ---------------------------------------- USBH stubs -------------------------------------------------
+
+static esp_err_t usbh_devs_open_cb(uint8_t dev_addr, usb_device_handle_t *dev_hdl, int cmock_num_calls)
+{
+    *dev_hdl = (usb_device_handle_t)&fake_devs[dev_addr - 1];
+    return ESP_OK;
+}
+
+static esp_err_t usbh_dev_close_cb(usb_device_handle_t dev_hdl, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t usbh_dev_get_addr_cb(usb_device_handle_t dev_hdl, uint8_t *dev_addr, int cmock_num_calls)
+{
+    *dev_addr = ((fake_dev_t *)dev_hdl)->addr;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_dev_get_config_desc_cb(usb_device_handle_t dev_hdl, const usb_config_desc_t **config_desc_ret, int cmock_num_calls)
+{
+    *config_desc_ret = (const usb_config_desc_t *)test_config_desc;
+    return ESP_OK;
+}
+
+static fake_ep_t *fake_ep_find(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress)
+{
+    const int dev_idx = ((fake_dev_t *)dev_hdl)->addr - 1;
+    return &fake_eps[dev_idx * TEST_NUM_EPS + (bEndpointAddress & USB_B_ENDPOINT_ADDRESS_EP_NUM_MASK) - 1];
+}
+
+static esp_err_t usbh_ep_alloc_cb(usb_device_handle_t dev_hdl, usbh_ep_config_t *ep_config, usbh_ep_handle_t *ep_hdl_ret, int cmock_num_calls)
+{
+    fake_ep_t *ep = fake_ep_find(dev_hdl, ep_config->bEndpointAddress);
+    ep->dev_hdl = dev_hdl;
+    ep->bEndpointAddress = ep_config->bEndpointAddress;
+    ep->ep_cb = ep_config->ep_cb;
+    ep->ep_cb_arg = ep_config->ep_cb_arg;
+    ep->context = ep_config->context;
+    *ep_hdl_ret = (usbh_ep_handle_t)ep;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_ep_free_cb(usbh_ep_handle_t ep_hdl, int cmock_num_calls)
+{
+    ((fake_ep_t *)ep_hdl)->context = nullptr;
+    return ESP_OK;
+}
+
+static esp_err_t usbh_ep_get_handle_cb(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, usbh_ep_handle_t *ep_hdl_ret, int cmock_num_calls)
+{
+    *ep_hdl_ret = (usbh_ep_handle_t)fake_ep_find(dev_hdl, bEndpointAddress);
+    return ESP_OK;
+}
+
+static void *usbh_ep_get_context_cb(usbh_ep_handle_t ep_hdl, int cmock_num_calls)
+{
+    return ((fake_ep_t *)ep_hdl)->context;
+}
+
+static esp_err_t usbh_ep_enqueue_urb_cb(usbh_ep_handle_t ep_hdl, urb_t *urb, int cmock_num_calls)
+{
+    ((fake_ep_t *)ep_hdl)->inflight.push_back(urb);
+    return ESP_OK;
+}
+
+static esp_err_t usbh_ep_dequeue_urb_cb(usbh_ep_handle_t ep_hdl, urb_t **urb_ret, int cmock_num_calls)
+{
+    fake_ep_t *ep = (fake_ep_t *)ep_hdl;
+    if (ep->done.empty()) {
+        *urb_ret = nullptr;
+    } else {
+        *urb_ret = ep->done.front();
+        ep->done.pop_front();
+    }
+    return ESP_OK;
+}
+
+static bool hub_root_is_suspended_cb(int cmock_num_calls)
+{
+    return false;
+}
+
+static void usbh_stubs_set(bool set)
+{
+    usbh_devs_open_Stub(set ? usbh_devs_open_cb : nullptr);
+    usbh_dev_close_Stub(set ? usbh_dev_close_cb : nullptr);
+    usbh_dev_get_addr_Stub(set ? usbh_dev_get_addr_cb : nullptr);
+    usbh_dev_get_config_desc_Stub(set ? usbh_dev_get_config_desc_cb : nullptr);
+    usbh_ep_alloc_Stub(set ? usbh_ep_alloc_cb : nullptr);
+    usbh_ep_free_Stub(set ? usbh_ep_free_cb : nullptr);
+    usbh_ep_get_handle_Stub(set ? usbh_ep_get_handle_cb : nullptr);
+    usbh_ep_get_context_Stub(set ? usbh_ep_get_context_cb : nullptr);
+    usbh_ep_enqueue_urb_Stub(set ? usbh_ep_enqueue_urb_cb : nullptr);
+    usbh_ep_dequeue_urb_Stub(set ? usbh_ep_dequeue_urb_cb : nullptr);
+    hub_root_is_suspended_Stub(set ? hub_root_is_suspended_cb : nullptr);
+}
+
+// ------------------------------------------ Helpers --------------------------------------------------
+
+static void complete_transfers(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress);
+
+static void transfer_cb(usb_transfer_t *transfer)
+{
+    uint8_t dev_addr = ((fake_dev_t *)transfer->device_handle)->addr;
+    completed_transfers.push_back({ dev_addr, transfer->bEndpointAddress, xTaskGetCurrentTaskHandle() });
+    xSemaphoreGive(transfer_done_sem);
+    if (complete_in_cb_ep != nullptr) {
+        fake_ep_t *ep = complete_in_cb_ep;
+        complete_in_cb_ep = nullptr;
+        complete_transfers(ep->dev_hdl, ep->bEndpointAddress);
+    }
+}
+
+static usb_transfer_t *submit_transfer(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress)
+{
+    usb_transfer_t *transfer;
+    REQUIRE(ESP_OK == usb_host_transfer_alloc(64, 0, &transfer));
+    transfer->device_handle = dev_hdl;
+    transfer->bEndpointAddress = bEndpointAddress;
+    transfer->num_bytes = 64;
+    transfer->callback = transfer_cb;
+    REQUIRE(ESP_OK == usb_host_transfer_submit(transfer));
+    return transfer;
+}
+
+// USBH completes the transfers in flight on the EP and reports it to the USB Host Library
+static void complete_transfers(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress)
+{
+    fake_ep_t *ep = fake_ep_find(dev_hdl, bEndpointAddress);
+    while (!ep->inflight.empty()) {
+        urb_t *urb = ep->inflight.front();
+        ep->inflight.pop_front();
+        urb->transfer.actual_num_bytes = urb->transfer.num_bytes;
+        urb->transfer.status = USB_TRANSFER_STATUS_COMPLETED;
+        ep->done.push_back(urb);
+    }
+    ep->ep_cb((usbh_ep_handle_t)ep, USBH_EP_EVENT_URB_DONE, ep->ep_cb_arg, false);
+}
+
+SCENARIO("USB Host client endpoint handling")
+{
+    usb_host_config_t usb_host_config = {
+        .skip_phy_setup = true,
+        .root_port_unpowered = false,
+        .intr_flags = 1,
+        .enum_filter_cb = nullptr,
+        .fifo_settings_custom = {},
+        .peripheral_map = BIT0,
+    };
+    usbh_install_ExpectAnyArgsAndReturn(ESP_OK);
+    enum_install_ExpectAnyArgsAndReturn(ESP_OK);
+    hub_install_ExpectAnyArgsAndReturn(ESP_OK);
+    hub_root_start_ExpectAndReturn(ESP_OK);
+    REQUIRE(ESP_OK == usb_host_install(&usb_host_config));
+    usbh_stubs_set(true);
+    for (auto &ep : fake_eps) {
+        ep = {};
+    }
+    completed_transfers.clear();
+    complete_in_cb_ep = nullptr;
+    transfer_done_sem = xSemaphoreCreateCounting(8, 0);
+    REQUIRE(transfer_done_sem != nullptr);
+
+    // Client 1 handles its endpoints in usb_host_client_handle_events(), client 2 in a completion worker
+    usb_host_client_config_t client_config = {};
+    client_config.is_synchronous = false;
+    client_config.max_num_event_msg = 3;
+    client_config.async.client_event_callback = client_event_cb;
+    client_config.async.callback_arg = nullptr;
+    usb_host_client_handle_t client_task_hdl = nullptr;
+    usb_host_client_handle_t client_worker_hdl = nullptr;
+    REQUIRE(ESP_OK == usb_host_client_register(&client_config, &client_task_hdl));
+    client_config.completion_workers.num_tasks = 1;
+    client_config.completion_workers.stack_size = 4096;
+    client_config.completion_workers.task_priority = 5;
+    client_config.completion_workers.core_id = tskNO_AFFINITY;
+    REQUIRE(ESP_OK == usb_host_client_register(&client_config, &client_worker_hdl));
+
+    usb_device_handle_t dev_task_hdl = nullptr;
+    usb_device_handle_t dev_worker_hdl = nullptr;
+    REQUIRE(ESP_OK == usb_host_device_open(client_task_hdl, 1, &dev_task_hdl));
+    REQUIRE(ESP_OK == usb_host_device_open(client_worker_hdl, 2, &dev_worker_hdl));
+    REQUIRE(ESP_OK == usb_host_interface_claim(client_task_hdl, dev_task_hdl, 0, 0));
+    REQUIRE(ESP_OK == usb_host_interface_claim(client_worker_hdl, dev_worker_hdl, 0, 0));
+
+    std::vector<usb_transfer_t *> transfers;
+
+    GIVEN("Both clients have completed transfers pending") {
+        transfers.push_back(submit_transfer(dev_task_hdl, 0x81));
+        transfers.push_back(submit_transfer(dev_task_hdl, 0x82));
+        transfers.push_back(submit_transfer(dev_worker_hdl, 0x81));
+        // EP1 completes first, then EP2 is raised to high priority while it is pending
+        complete_transfers(dev_task_hdl, 0x81);
+        complete_transfers(dev_task_hdl, 0x82);
+        REQUIRE(ESP_OK == usb_host_endpoint_set_priority(dev_task_hdl, 0x82, USB_HOST_EP_PRIORITY_HIGH));
+        complete_transfers(dev_worker_hdl, 0x81);
+
+        THEN("The completion worker runs the transfer callback of its client") {
+            REQUIRE(pdTRUE == xSemaphoreTake(transfer_done_sem, pdMS_TO_TICKS(1000)));
+            REQUIRE(completed_transfers.size() == 1);
+            REQUIRE(completed_transfers[0].dev_addr == 2);
+            REQUIRE(completed_transfers[0].bEndpointAddress == 0x81);
+            REQUIRE(completed_transfers[0].task != xTaskGetCurrentTaskHandle());
+            REQUIRE(strcmp(pcTaskGetName(completed_transfers[0].task), "usb_client_wrk") == 0);
+
+            AND_THEN("The client task runs the transfer callbacks of its client, highest priority first") {
+                // Completion worker's client has nothing to handle in the client task
+                REQUIRE(ESP_OK == usb_host_client_handle_events(client_worker_hdl, 0));
+                REQUIRE(completed_transfers.size() == 1);
+
+                REQUIRE(ESP_OK == usb_host_client_handle_events(client_task_hdl, 0));
+                REQUIRE(completed_transfers.size() == 3);
+                REQUIRE(completed_transfers[1].dev_addr == 1);
+                REQUIRE(completed_transfers[1].bEndpointAddress == 0x82);
+                REQUIRE(completed_transfers[1].task == xTaskGetCurrentTaskHandle());
+                REQUIRE(completed_transfers[2].dev_addr == 1);
+                REQUIRE(completed_transfers[2].bEndpointAddress == 0x81);
+                REQUIRE(completed_transfers[2].task == xTaskGetCurrentTaskHandle());
+            }
+        }
+    }
+
+    GIVEN("Endpoints of different priority complete in priority order") {
+        REQUIRE(ESP_OK == usb_host_endpoint_set_priority(dev_task_hdl, 0x81, USB_HOST_EP_PRIORITY_HIGH));
+        REQUIRE(ESP_OK == usb_host_endpoint_set_priority(dev_task_hdl, 0x82, USB_HOST_EP_PRIORITY_LOW));
+        transfers.push_back(submit_transfer(dev_task_hdl, 0x81));
+        transfers.push_back(submit_transfer(dev_task_hdl, 0x82));
+        // Low priority EP completes first
+        complete_transfers(dev_task_hdl, 0x82);
+        complete_transfers(dev_task_hdl, 0x81);
+
+        THEN("The high priority endpoint is handled first") {
+            REQUIRE(ESP_OK == usb_host_client_handle_events(client_task_hdl, 0));
+            REQUIRE(completed_transfers.size() == 2);
+            REQUIRE(completed_transfers[0].bEndpointAddress == 0x81);
+            REQUIRE(completed_transfers[1].bEndpointAddress == 0x82);
+        }
+    }
+
+    GIVEN("A low priority endpoint has several transfers completed") {
+        REQUIRE(ESP_OK == usb_host_endpoint_set_priority(dev_task_hdl, 0x81, USB_HOST_EP_PRIORITY_HIGH));
+        REQUIRE(ESP_OK == usb_host_endpoint_set_priority(dev_task_hdl, 0x82, USB_HOST_EP_PRIORITY_LOW));
+        for (int i = 0; i < 3; i++) {
+            transfers.push_back(submit_transfer(dev_task_hdl, 0x82));
+        }
+        transfers.push_back(submit_transfer(dev_task_hdl, 0x81));
+        complete_transfers(dev_task_hdl, 0x82);
+        // High priority EP completes while the first transfer callback of the low priority EP runs
+        complete_in_cb_ep = fake_ep_find(dev_task_hdl, 0x81);
+
+        THEN("The high priority endpoint waits for at most one callback of the low priority endpoint") {
+            REQUIRE(ESP_OK == usb_host_client_handle_events(client_task_hdl, 0));
+            REQUIRE(complete_in_cb_ep == nullptr);
+            REQUIRE(completed_transfers.size() == 4);
+            REQUIRE(completed_transfers[0].bEndpointAddress == 0x82);
+            REQUIRE(completed_transfers[1].bEndpointAddress == 0x81);
+            REQUIRE(completed_transfers[2].bEndpointAddress == 0x82);
+            REQUIRE(completed_transfers[3].bEndpointAddress == 0x82);
+        }
+    }
+
+    // Teardown: handle everything that is still pending, release the interfaces and deregister the clients
+    REQUIRE(ESP_OK == usb_host_client_handle_events(client_task_hdl, 0));
+    while (xSemaphoreTake(transfer_done_sem, 0) == pdTRUE) {
+    }
+    // The completion worker finishes the handling of its EP after the transfer callback returned
+    vTaskDelay(pdMS_TO_TICKS(10));
+    for (usb_transfer_t *transfer : transfers) {
+        REQUIRE(ESP_OK == usb_host_transfer_free(transfer));
+    }
+    REQUIRE(ESP_OK == usb_host_interface_release(client_task_hdl, dev_task_hdl, 0));
+    REQUIRE(ESP_OK == usb_host_interface_release(client_worker_hdl, dev_worker_hdl, 0));
+    REQUIRE(ESP_OK == usb_host_device_close(client_task_hdl, dev_task_hdl));
+    REQUIRE(ESP_OK == usb_host_device_close(client_worker_hdl, dev_worker_hdl));
+    REQUIRE(ESP_OK == usb_host_client_deregister(client_worker_hdl));
+    REQUIRE(ESP_OK == usb_host_client_deregister(client_task_hdl));
+    usbh_stubs_set(false);
+    vSemaphoreDelete(transfer_done_sem);
+
+    // Clear USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS, otherwise the USB Host Library can not be uninstalled
+    uint32_t event_flags;
+    REQUIRE(ESP_OK == usb_host_lib_handle_events(0, &event_flags));
+
+    hub_root_stop_ExpectAndReturn(ESP_OK);
+    hub_uninstall_ExpectAndReturn(ESP_OK);
+    enum_uninstall_ExpectAndReturn(ESP_OK);
+    usbh_uninstall_ExpectAndReturn(ESP_OK);
+    REQUIRE(ESP_OK == usb_host_uninstall());
+}
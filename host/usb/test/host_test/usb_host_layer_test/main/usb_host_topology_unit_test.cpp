@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <catch2/catch_test_macros.hpp>
+
+#include "usb_host.h"   // Real implementation of usb_host.h
+
+// Test all the mocked headers defined for this mock
+extern "C" {
+#include "Mockusb_phy.h"
+#include "Mockhcd.h"
+#include "Mockusbh.h"
+#include "Mockenum.h"
+#include "Mockhub.h"
+}
+
+SCENARIO("USB Host device topology")
+{
+    usb_host_topology_node_t nodes[4] = {};
+    int num_nodes = -1;
+
+    GIVEN("Invalid arguments") {
+        SECTION("List is nullptr") {
+            REQUIRE(ESP_ERR_INVALID_ARG == usb_host_device_topology_get(4, nullptr, &num_nodes));
+        }
+        SECTION("Number of nodes is nullptr") {
+            REQUIRE(ESP_ERR_INVALID_ARG == usb_host_device_topology_get(4, nodes, nullptr));
+        }
+    }
+
+    GIVEN("Hub driver is not installed") {
+        SECTION("Snapshot error is returned") {
+            hub_dev_tree_snapshot_ExpectAnyArgsAndReturn(ESP_ERR_INVALID_STATE);
+            REQUIRE(ESP_ERR_INVALID_STATE == usb_host_device_topology_get(4, nodes, &num_nodes));
+            REQUIRE(0 == num_nodes);
+        }
+    }
+
+    GIVEN("Hub with two devices connected to the root port") {
+        // uid 1: Hub on the root port, uid 2 and 3: devices on ports 1 and 3 of the Hub
+        hub_dev_tree_node_info_t tree_nodes[3] = {
+            { .uid = 1, .parent_uid = 0, .port_num = 0, .depth = 1 },
+            { .uid = 2, .parent_uid = 1, .port_num = 1, .depth = 2 },
+            { .uid = 3, .parent_uid = 1, .port_num = 3, .depth = 2 },
+        };
+        int num_tree_nodes = 3;
+        uint8_t addr_hub = 1;
+        uint8_t addr_dev2 = 2;
+        uint8_t addr_dev3 = 3;
+
+        hub_dev_tree_snapshot_ExpectAnyArgsAndReturn(ESP_OK);
+        hub_dev_tree_snapshot_ReturnArrayThruPtr_nodes(tree_nodes, 3);
+        hub_dev_tree_snapshot_ReturnThruPtr_num_nodes_ret(&num_tree_nodes);
+
+        SECTION("All devices are listed with their parents") {
+            usbh_devs_get_addr_ExpectAndReturn(1, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_hub);
+
+            usbh_devs_get_addr_ExpectAndReturn(2, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_dev2);
+            usbh_devs_get_addr_ExpectAndReturn(1, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_hub);
+
+            usbh_devs_get_addr_ExpectAndReturn(3, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_dev3);
+            usbh_devs_get_addr_ExpectAndReturn(1, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_hub);
+
+            REQUIRE(ESP_OK == usb_host_device_topology_get(4, nodes, &num_nodes));
+            REQUIRE(3 == num_nodes);
+            REQUIRE(1 == nodes[0].dev_addr);
+            REQUIRE(0 == nodes[0].parent_dev_addr);
+            REQUIRE(1 == nodes[0].depth);
+            REQUIRE(2 == nodes[1].dev_addr);
+            REQUIRE(1 == nodes[1].parent_dev_addr);
+            REQUIRE(1 == nodes[1].port_num);
+            REQUIRE(2 == nodes[1].depth);
+            REQUIRE(3 == nodes[2].dev_addr);
+            REQUIRE(1 == nodes[2].parent_dev_addr);
+            REQUIRE(3 == nodes[2].port_num);
+        }
+
+        SECTION("Device removed after the snapshot is skipped") {
+            usbh_devs_get_addr_ExpectAndReturn(1, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_hub);
+
+            usbh_devs_get_addr_ExpectAndReturn(2, nullptr, ESP_ERR_NOT_FOUND);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+
+            usbh_devs_get_addr_ExpectAndReturn(3, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_dev3);
+            usbh_devs_get_addr_ExpectAndReturn(1, nullptr, ESP_OK);
+            usbh_devs_get_addr_IgnoreArg_dev_addr();
+            usbh_devs_get_addr_ReturnThruPtr_dev_addr(&addr_hub);
+
+            REQUIRE(ESP_OK == usb_host_device_topology_get(4, nodes, &num_nodes));
+            REQUIRE(2 == num_nodes);
+            REQUIRE(1 == nodes[0].dev_addr);
+            REQUIRE(3 == nodes[1].dev_addr);
+            REQUIRE(3 == nodes[1].port_num);
+        }
+    }
+}
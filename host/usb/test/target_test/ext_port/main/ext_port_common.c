@@ -5,6 +5,7 @@
  */
 #include <stdio.h>
 #include <string.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 // USB Host Lib
@@ -247,7 +248,8 @@ void test_ext_port_power_on(uint8_t port1, ext_port_hdl_t port_hdl)
                                                              USB_B_REQUEST_HUB_SET_PORT_FEATURE));
     // Power on the port
     hub_port_power_on(port1);
-    vTaskDelay(pdMS_TO_TICKS(30)); // TODO: change to power power on delay
+    // The port waits for the PwrOn2PwrGood delay, before it requests the status
+    vTaskDelay(pdMS_TO_TICKS(hub_get_port_poweron_delay_ms()));
     // After powering the port, trigger the port processing
     TEST_ASSERT_EQUAL(ESP_OK, port_api->req_process(port_hdl));
     test_wait_ext_port_process_request();
@@ -335,8 +337,8 @@ usb_speed_t test_ext_port_connected(uint8_t port1, ext_port_hdl_t port_hdl)
                                                              USB_B_REQUEST_HUB_SET_PORT_FEATURE));
     // Port Reset
     hub_port_reset(port1);
-    // Give port some time to process the reset
-    vTaskDelay(pdMS_TO_TICKS(30)); // TODO: Port Reset recovery
+    // The port waits for the reset recovery delay, before it requests the status
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_USB_HOST_EXT_PORT_RESET_RECOVERY_DELAY_MS));
     // After resetting the port, trigger the port processing
     TEST_ASSERT_EQUAL(ESP_OK, port_api->req_process(port_hdl));
     test_wait_ext_port_process_request();
@@ -1,11 +1,14 @@
 /*
- * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include "soc/soc_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "unity.h"
@@ -215,3 +218,116 @@ TEST_CASE("Test HCD bulk pipe URBs deferred", "[bulk][full_speed][high_speed]")
     // Cleanup
     test_hcd_wait_for_disconn(port_hdl, false);
 }
+
+/*
+Test HCD bulk pipe URBs with unaligned data buffer
+
+Purpose:
+    - Test that the data buffer of an IN URB does not need to be cache line aligned
+    - Test that data sharing cache lines with the data buffer is preserved
+    - Test that the cache sync statistics of a pipe are counted
+
+Procedure:
+    - Setup HCD and wait for connection
+    - Allocate default pipe and enumerate the device
+    - Read TEST_NUM_SECTORS_PER_XFER sectors into an aligned data buffer
+    - Read the same sectors again, one sector per URB, appending each sector to the previous one in a data buffer
+      that starts at an unaligned offset
+    - Expect the same data and unchanged guard bytes in front of the data
+    - Teardown
+*/
+
+#define TEST_UNALIGNED_OFFSET           4       // USB-DWC DMA requires word aligned buffers
+#define TEST_UNALIGNED_GUARD            0x5A
+
+static void mock_msc_read_sectors(hcd_pipe_handle_t bulk_out_pipe, hcd_pipe_handle_t bulk_in_pipe, urb_t *urb_cbw, urb_t *urb_data, urb_t *urb_csw,
+                                  int num_sectors, int num_sectors_per_urb)
+{
+    const dev_msc_info_t *dev_info = dev_msc_get_info();
+    mock_msc_scsi_init_cbw((mock_msc_bulk_cbw_t *)urb_cbw->transfer.data_buffer, true, 0, num_sectors, dev_info->scsi_sector_size, 0xAAAAAAAA);
+    TEST_ASSERT_EQUAL(ESP_OK, hcd_urb_enqueue(bulk_out_pipe, urb_cbw));
+    test_hcd_expect_pipe_event(bulk_out_pipe, HCD_PIPE_EVENT_URB_DONE);
+    TEST_ASSERT_EQUAL_PTR(urb_cbw, hcd_urb_dequeue(bulk_out_pipe));
+    TEST_ASSERT_EQUAL_MESSAGE(USB_TRANSFER_STATUS_COMPLETED, urb_cbw->transfer.status, "Transfer NOT completed");
+
+    uint8_t *const data_buffer_base = urb_data->transfer.data_buffer;
+    uint8_t **data_buffer = (uint8_t **)&urb_data->transfer.data_buffer;
+    urb_data->transfer.num_bytes = num_sectors_per_urb * dev_info->scsi_sector_size;
+    for (int i = 0; i < num_sectors; i += num_sectors_per_urb) {
+        TEST_ASSERT_EQUAL(ESP_OK, hcd_urb_enqueue(bulk_in_pipe, urb_data));
+        test_hcd_expect_pipe_event(bulk_in_pipe, HCD_PIPE_EVENT_URB_DONE);
+        TEST_ASSERT_EQUAL_PTR(urb_data, hcd_urb_dequeue(bulk_in_pipe));
+        TEST_ASSERT_EQUAL_MESSAGE(USB_TRANSFER_STATUS_COMPLETED, urb_data->transfer.status, "Transfer NOT completed");
+        TEST_ASSERT_EQUAL(urb_data->transfer.num_bytes, urb_data->transfer.actual_num_bytes);
+        *data_buffer += urb_data->transfer.actual_num_bytes;    // Append the next sector
+    }
+    *data_buffer = data_buffer_base;
+
+    TEST_ASSERT_EQUAL(ESP_OK, hcd_urb_enqueue(bulk_in_pipe, urb_csw));
+    test_hcd_expect_pipe_event(bulk_in_pipe, HCD_PIPE_EVENT_URB_DONE);
+    TEST_ASSERT_EQUAL_PTR(urb_csw, hcd_urb_dequeue(bulk_in_pipe));
+    TEST_ASSERT_TRUE(mock_msc_scsi_check_csw((mock_msc_bulk_csw_t *)urb_csw->transfer.data_buffer, 0xAAAAAAAA));
+}
+
+TEST_CASE("Test HCD bulk pipe URBs unaligned data buffer", "[bulk][full_speed][high_speed]")
+{
+    usb_speed_t port_speed = test_hcd_wait_for_conn(port_hdl);  // Trigger a connection
+    vTaskDelay(pdMS_TO_TICKS(100)); // Short delay send of SOF (for FS) or EOPs (for LS)
+
+    // Enumerate and reset MSC SCSI device
+    hcd_pipe_handle_t default_pipe = test_hcd_pipe_alloc(port_hdl, NULL, 0, port_speed); // Create a default pipe (using a NULL EP descriptor)
+    uint8_t dev_addr = test_hcd_enum_device(default_pipe);
+    const dev_msc_info_t *dev_info = dev_msc_get_info();
+    mock_msc_reset_req(default_pipe, dev_info->bInterfaceNumber);
+
+    // Create BULK IN and BULK OUT pipes for SCSI
+    const usb_ep_desc_t *out_ep_desc = dev_msc_get_out_ep_desc(port_speed);
+    const usb_ep_desc_t *in_ep_desc = dev_msc_get_in_ep_desc(port_speed);
+    const uint16_t mps = USB_EP_DESC_GET_MPS(in_ep_desc) ;
+    hcd_pipe_handle_t bulk_out_pipe = test_hcd_pipe_alloc(port_hdl, out_ep_desc, dev_addr, port_speed);
+    hcd_pipe_handle_t bulk_in_pipe = test_hcd_pipe_alloc(port_hdl, in_ep_desc, dev_addr, port_speed);
+    const size_t data_size = TEST_NUM_SECTORS_PER_XFER * dev_info->scsi_sector_size;
+    urb_t *urb_cbw = test_hcd_alloc_urb(0, sizeof(mock_msc_bulk_cbw_t));
+    urb_t *urb_aligned = test_hcd_alloc_urb(0, data_size);
+    urb_t *urb_unaligned = test_hcd_alloc_urb(0, data_size + TEST_UNALIGNED_OFFSET);
+    urb_t *urb_csw = test_hcd_alloc_urb(0, sizeof(mock_msc_bulk_csw_t) + (mps - (sizeof(mock_msc_bulk_csw_t) % mps)));
+    urb_cbw->transfer.num_bytes = sizeof(mock_msc_bulk_cbw_t);
+    urb_csw->transfer.num_bytes = sizeof(mock_msc_bulk_csw_t) + (mps - (sizeof(mock_msc_bulk_csw_t) % mps));
+
+    // Reference read into an aligned data buffer
+    mock_msc_read_sectors(bulk_out_pipe, bulk_in_pipe, urb_cbw, urb_aligned, urb_csw, TEST_NUM_SECTORS_PER_XFER, TEST_NUM_SECTORS_PER_XFER);
+
+    // Read the same sectors one by one into a data buffer at an unaligned offset. The guard bytes share a cache line
+    // with the data buffer
+    uint8_t *const unaligned_base = urb_unaligned->transfer.data_buffer;
+    memset(unaligned_base, TEST_UNALIGNED_GUARD, TEST_UNALIGNED_OFFSET);
+    uint8_t **data_buffer = (uint8_t **)&urb_unaligned->transfer.data_buffer;
+    *data_buffer += TEST_UNALIGNED_OFFSET;
+    mock_msc_read_sectors(bulk_out_pipe, bulk_in_pipe, urb_cbw, urb_unaligned, urb_csw, TEST_NUM_SECTORS_PER_XFER, 1);
+    for (int i = 0; i < TEST_UNALIGNED_OFFSET; i++) {
+        TEST_ASSERT_EQUAL_HEX8(TEST_UNALIGNED_GUARD, unaligned_base[i]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(urb_aligned->transfer.data_buffer, urb_unaligned->transfer.data_buffer, data_size);
+    *data_buffer = unaligned_base;
+
+    // Check cache sync statistics
+    hcd_pipe_cache_sync_stats_t stats;
+    uint64_t time_us;
+    TEST_ASSERT_EQUAL(ESP_OK, hcd_pipe_get_cache_sync_stats(bulk_in_pipe, &stats, &time_us));
+    printf("Cache sync of bulk IN pipe: %"PRIu32" syncs, %"PRIu64" bytes, %"PRIu64" us\n", stats.num_syncs, stats.num_bytes, time_us);
+#if SOC_CACHE_INTERNAL_MEM_VIA_L1CACHE
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.num_syncs);
+#else
+    TEST_ASSERT_EQUAL_UINT32(0, stats.num_syncs);
+#endif
+
+    test_hcd_free_urb(urb_cbw);
+    test_hcd_free_urb(urb_aligned);
+    test_hcd_free_urb(urb_unaligned);
+    test_hcd_free_urb(urb_csw);
+    test_hcd_pipe_free(bulk_out_pipe);
+    test_hcd_pipe_free(bulk_in_pipe);
+    test_hcd_pipe_free(default_pipe);
+    // Cleanup
+    test_hcd_wait_for_disconn(port_hdl, false);
+}
@@ -127,12 +127,21 @@ TEST_CASE("Test HCD isochronous pipe URBs all", "[isoc][full_speed][high_speed]"
     hcd_pipe_handle_t unused_pipes[16];
     const usb_ep_desc_t *out_ep_desc = dev_isoc_get_out_ep_desc(port_speed);
     const int isoc_packet_size = USB_EP_DESC_GET_MPS(out_ep_desc);
+    // Unused pipes only occupy channels. Bulk pipes don't reserve periodic bus time, that the isoc_out_pipe needs
+    const usb_ep_desc_t unused_ep_desc = {
+        .bLength = sizeof(usb_ep_desc_t),
+        .bDescriptorType = USB_B_DESCRIPTOR_TYPE_ENDPOINT,
+        .bEndpointAddress = 0x01,
+        .bmAttributes = USB_BM_ATTRIBUTES_XFER_BULK,
+        .wMaxPacketSize = (port_speed == USB_SPEED_HIGH) ? 512 : 64,
+        .bInterval = 0,
+    };
 
     // For all channels (except channel allocated for EP0)
     for (int channel = 0; channel < usb_dwc_ll_ghwcfg_get_channel_num(USB_DWC_LL_GET_HW(TEST_PORT_NUM)) - 1; channel++) {
         // Allocate unused pipes, so the active isoc_out_pipe uses different channel index
         for (int ch = 0; ch < channel; ch++) {
-            unused_pipes[ch] = test_hcd_pipe_alloc(port_hdl, out_ep_desc, dev_addr + 1, port_speed);
+            unused_pipes[ch] = test_hcd_pipe_alloc(port_hdl, &unused_ep_desc, dev_addr + 1, port_speed);
         }
 
         // For all intervals
@@ -293,3 +302,72 @@ TEST_CASE("Test HCD isochronous pipe sudden disconnect", "[isoc][full_speed][hig
     test_hcd_pipe_free(isoc_out_pipe);
     test_hcd_pipe_free(default_pipe);
 }
+
+/*
+Test HCD periodic bus time budget
+
+Purpose:
+    - Test that periodic pipes are rejected with ESP_ERR_NOT_SUPPORTED if the periodic bus time would be exceeded
+    - Test that HS ports budget each microframe, not only the sum of the frame
+    - Test that the bus time is released when a pipe is freed
+
+Procedure:
+    - Setup HCD and wait for connection
+    - Allocate an ISOC IN pipe with an interval of one frame. It takes one (micro)frame of each frame
+    - Allocate ISOC IN pipes with an interval of one (micro)frame until the busiest (micro)frame is full.
+      FS: 309 byte times per frame out of 1350, HS: 1830 byte times per microframe out of 6000
+    - Allocation of the next pipe must fail, although a HS frame would still have enough bus time in total
+    - Free the first pipe and check that the next pipe can be allocated now
+    - Teardown
+*/
+TEST_CASE("Test HCD isochronous pipe alloc: periodic bus time", "[isoc][full_speed][high_speed]")
+{
+    usb_speed_t port_speed = test_hcd_wait_for_conn(port_hdl);  // Trigger a connection
+    vTaskDelay(pdMS_TO_TICKS(100)); // Short delay send of SOF (for FS) or EOPs (for LS)
+
+    const bool is_hs = (port_speed == USB_SPEED_HIGH);
+    // HS: 3 transactions of 512 bytes per microframe
+    usb_ep_desc_t every_interval_desc = {
+        .bLength = USB_EP_DESC_SIZE,
+        .bDescriptorType = USB_B_DESCRIPTOR_TYPE_ENDPOINT,
+        .bEndpointAddress = 0x81,
+        .bmAttributes = USB_BM_ATTRIBUTES_XFER_ISOC,
+        .wMaxPacketSize = is_hs ? (512 | (2 << 11)) : 256,
+        .bInterval = 1,
+    };
+    usb_ep_desc_t every_frame_desc = every_interval_desc;
+    every_frame_desc.bEndpointAddress = 0x82;
+    every_frame_desc.bInterval = is_hs ? 4 : 1;  // Interval of 8 microframes or 1 frame
+    // Pipes of the first (micro)frame, including the first pipe, that fit in the budget
+    const int num_fit = is_hs ? 3 : 4;
+
+    hcd_pipe_config_t pipe_config = {
+        .callback = NULL,
+        .callback_arg = NULL,
+        .context = NULL,
+        .ep_desc = &every_frame_desc,
+        .dev_addr = 1,
+        .dev_speed = port_speed,
+    };
+    hcd_pipe_handle_t first_pipe = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, hcd_pipe_alloc(port_hdl, &pipe_config, &first_pipe));
+
+    hcd_pipe_handle_t pipes[4] = {NULL};
+    pipe_config.ep_desc = &every_interval_desc;
+    for (int i = 0; i < num_fit - 1; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, hcd_pipe_alloc(port_hdl, &pipe_config, &pipes[i]));
+    }
+    hcd_pipe_handle_t rejected_pipe = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, hcd_pipe_alloc(port_hdl, &pipe_config, &rejected_pipe));
+    TEST_ASSERT_NULL(rejected_pipe);
+
+    // Freeing the first pipe releases its bus time
+    TEST_ASSERT_EQUAL(ESP_OK, hcd_pipe_free(first_pipe));
+    TEST_ASSERT_EQUAL(ESP_OK, hcd_pipe_alloc(port_hdl, &pipe_config, &pipes[num_fit - 1]));
+
+    for (int i = 0; i < num_fit; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, hcd_pipe_free(pipes[i]));
+    }
+    // Cleanup
+    test_hcd_wait_for_disconn(port_hdl, false);
+}
@@ -16,6 +16,8 @@ typedef struct {
 
 void msc_client_async_seq_task(void *arg);
 
+void msc_client_async_direct_task(void *arg);
+
 void msc_client_async_dconn_task(void *arg);
 
 void msc_client_async_enum_task(void *arg);
@@ -0,0 +1,231 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "mock_msc.h"
+#include "dev_msc.h"
+#include "msc_client.h"
+#include "usb/usb_host.h"
+#include "unity.h"
+
+/*
+Implementation of an MSC client using direct completion callbacks
+
+- The CBW is sent on the OUT EP, whose transfer callbacks are dispatched from usb_host_client_handle_events()
+- The IN EP has direct completion callbacks enabled. Its callback reads the data one sector at a time and then the CSW,
+  resubmitting the IN transfer with usb_host_transfer_submit_from_isr() each time
+- The callback cannot use test assertions, it records errors which are checked by the client task
+*/
+
+#define NEW_DEV_EVENT_MS                1000    // Delay to wait for a device to be connected
+#define XFER_DONE_MS                    1000    // Delay to wait for the data and CSW of one SCSI command
+
+typedef struct {
+    // Test parameters
+    msc_client_test_param_t test_param;
+    // MSC device info
+    const dev_msc_info_t *dev_info;
+    uint8_t dev_addr;
+    int in_ep_mps;
+    // Client variables
+    usb_host_client_handle_t client_hdl;
+    usb_device_handle_t dev_hdl;
+    TaskHandle_t task_hdl;
+    // Test state, updated from transfer callbacks
+    volatile bool cbw_done;
+    volatile int num_sectors_left;      // Sectors left to read in the current SCSI command
+    volatile int num_sectors_read;
+    volatile int num_errors;
+    volatile int num_task_callbacks;    // Callbacks of the IN EP that did not run in ISR context
+} msc_client_obj_t;
+
+static void msc_out_transfer_cb(usb_transfer_t *transfer)
+{
+    msc_client_obj_t *msc_obj = (msc_client_obj_t *)transfer->context;
+    TEST_ASSERT_EQUAL_MESSAGE(USB_TRANSFER_STATUS_COMPLETED, transfer->status, "Transfer NOT completed");
+    TEST_ASSERT_EQUAL(sizeof(mock_msc_bulk_cbw_t), transfer->actual_num_bytes);
+    msc_obj->cbw_done = true;
+}
+
+static void msc_in_direct_transfer_cb(usb_transfer_t *transfer)
+{
+    msc_client_obj_t *msc_obj = (msc_client_obj_t *)transfer->context;
+    if (!xPortInIsrContext()) {
+        msc_obj->num_task_callbacks++;
+    }
+    if (transfer->status != USB_TRANSFER_STATUS_COMPLETED) {
+        msc_obj->num_errors++;
+        goto done;
+    }
+
+    if (msc_obj->num_sectors_left > 0) {
+        // Data stage, one sector per transfer
+        if (transfer->actual_num_bytes != msc_obj->dev_info->scsi_sector_size) {
+            msc_obj->num_errors++;
+            goto done;
+        }
+        msc_obj->num_sectors_left--;
+        msc_obj->num_sectors_read++;
+        if (msc_obj->num_sectors_left == 0) {
+            // Next is the CSW
+            transfer->num_bytes = usb_round_up_to_mps(sizeof(mock_msc_bulk_csw_t), msc_obj->in_ep_mps);
+        }
+        if (usb_host_transfer_submit_from_isr(transfer) != ESP_OK) {
+            msc_obj->num_errors++;
+            goto done;
+        }
+        return;
+    }
+
+    // CSW stage
+    if (!mock_msc_scsi_check_csw((mock_msc_bulk_csw_t *)transfer->data_buffer, msc_obj->test_param.msc_scsi_xfer_tag)) {
+        msc_obj->num_errors++;
+    }
+done:
+    if (xPortInIsrContext()) {
+        BaseType_t xTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(msc_obj->task_hdl, &xTaskWoken);
+        if (xTaskWoken == pdTRUE) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        xTaskNotifyGive(msc_obj->task_hdl);
+    }
+}
+
+static void msc_client_event_cb(const usb_host_client_event_msg_t *event_msg, void *arg)
+{
+    msc_client_obj_t *msc_obj = (msc_client_obj_t *)arg;
+    switch (event_msg->event) {
+    case USB_HOST_CLIENT_EVENT_NEW_DEV:
+        ESP_LOGI(MSC_CLIENT_TAG, "Client event -> New device");
+        msc_obj->dev_addr = event_msg->new_dev.address;
+        break;
+    default:
+        abort();    // Should never occur in this test
+        break;
+    }
+}
+
+void msc_client_async_direct_task(void *arg)
+{
+    msc_client_obj_t msc_obj = {0};
+    memcpy(&msc_obj.test_param, arg, sizeof(msc_client_test_param_t));
+    msc_obj.dev_info = dev_msc_get_info();
+    msc_obj.task_hdl = xTaskGetCurrentTaskHandle();
+
+    // Register client
+    usb_host_client_config_t client_config = {
+        .is_synchronous = false,
+        .max_num_event_msg = MSC_ASYNC_CLIENT_MAX_EVENT_MSGS,
+        .async = {
+            .client_event_callback = msc_client_event_cb,
+            .callback_arg = (void *) &msc_obj,
+        },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_client_register(&client_config, &msc_obj.client_hdl));
+
+    // Wait to be started by main thread
+    TEST_ASSERT_EQUAL_MESSAGE(pdTRUE, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)), "MSC client not started from main thread");
+    ESP_LOGI(MSC_CLIENT_TAG, "Starting");
+    TEST_ASSERT_EQUAL_MESSAGE(ESP_OK, usb_host_client_handle_events(msc_obj.client_hdl, pdMS_TO_TICKS(NEW_DEV_EVENT_MS)), "Client handle events timed out");
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(0, msc_obj.dev_addr, "USB_HOST_CLIENT_EVENT_NEW_DEV not generated on time");
+
+    // Open the device, claim the MSC interface and enable direct callbacks of the IN EP
+    ESP_LOGI(MSC_CLIENT_TAG, "Open");
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_device_open(msc_obj.client_hdl, msc_obj.dev_addr, &msc_obj.dev_hdl));
+    usb_device_info_t dev_info;
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_device_info(msc_obj.dev_hdl, &dev_info));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_interface_claim(msc_obj.client_hdl,
+                                                       msc_obj.dev_hdl,
+                                                       msc_obj.dev_info->bInterfaceNumber,
+                                                       msc_obj.dev_info->bAlternateSetting));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_endpoint_set_direct_callback(msc_obj.dev_hdl, msc_obj.dev_info->in_ep_addr, true));
+
+    // Allocate transfers. The IN transfer holds one sector or the CSW
+    msc_obj.in_ep_mps = USB_EP_DESC_GET_MPS(dev_msc_get_in_ep_desc(dev_info.speed));
+    const size_t in_worst_case_size = usb_round_up_to_mps(MAX(msc_obj.dev_info->scsi_sector_size, sizeof(mock_msc_bulk_csw_t)),
+                                                          msc_obj.in_ep_mps);
+    usb_transfer_t *xfer_out = NULL;
+    usb_transfer_t *xfer_in = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_transfer_alloc(sizeof(mock_msc_bulk_cbw_t), 0, &xfer_out));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_transfer_alloc(in_worst_case_size, 0, &xfer_in));
+    xfer_out->callback = msc_out_transfer_cb;
+    xfer_in->callback = msc_in_direct_transfer_cb;
+    xfer_out->context = (void *)&msc_obj;
+    xfer_in->context = (void *)&msc_obj;
+    xfer_out->device_handle = msc_obj.dev_hdl;
+    xfer_in->device_handle = msc_obj.dev_hdl;
+    xfer_out->bEndpointAddress = msc_obj.dev_info->out_ep_addr;
+    xfer_in->bEndpointAddress = msc_obj.dev_info->in_ep_addr;
+
+    // Resubmission from ISR requires a transfer that was submitted to the EP before
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, usb_host_transfer_submit_from_isr(xfer_in));
+
+    while (msc_obj.num_sectors_read < msc_obj.test_param.num_sectors_to_read) {
+        // CBW, dispatched from the client
+        mock_msc_scsi_init_cbw((mock_msc_bulk_cbw_t *)xfer_out->data_buffer,
+                               true,
+                               msc_obj.num_sectors_read,
+                               msc_obj.test_param.num_sectors_per_xfer,
+                               msc_obj.dev_info->scsi_sector_size,
+                               msc_obj.test_param.msc_scsi_xfer_tag);
+        xfer_out->num_bytes = sizeof(mock_msc_bulk_cbw_t);
+        msc_obj.cbw_done = false;
+        TEST_ASSERT_EQUAL(ESP_OK, usb_host_transfer_submit(xfer_out));
+        while (!msc_obj.cbw_done) {
+            TEST_ASSERT_EQUAL(ESP_OK, usb_host_client_handle_events(msc_obj.client_hdl, portMAX_DELAY));
+        }
+
+        // Data and CSW, resubmitted from the direct callback
+        msc_obj.num_sectors_left = msc_obj.test_param.num_sectors_per_xfer;
+        xfer_in->num_bytes = msc_obj.dev_info->scsi_sector_size;
+        TEST_ASSERT_EQUAL(ESP_OK, usb_host_transfer_submit(xfer_in));
+        TEST_ASSERT_EQUAL_MESSAGE(pdTRUE, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(XFER_DONE_MS)), "Data and CSW not received on time");
+        TEST_ASSERT_EQUAL(0, msc_obj.num_errors);
+        TEST_ASSERT_EQUAL(0, msc_obj.num_sectors_left);
+    }
+    TEST_ASSERT_EQUAL(0, msc_obj.num_task_callbacks);
+    vTaskDelay(10); // Let the completion context return from the last callback
+
+    // Resubmission from ISR is only allowed from the transfer callbacks of the EP
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, usb_host_transfer_submit_from_isr(xfer_in));
+
+    // Check the endpoint statistics. Each SCSI command is one CBW, then the data sectors and the CSW
+    const uint32_t num_cmds = msc_obj.test_param.num_sectors_to_read / msc_obj.test_param.num_sectors_per_xfer;
+    usb_ep_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_endpoint_get_stats(msc_obj.dev_hdl, msc_obj.dev_info->out_ep_addr, &stats));
+    TEST_ASSERT_EQUAL(num_cmds, stats.num_transfers);
+    TEST_ASSERT_EQUAL(num_cmds * sizeof(mock_msc_bulk_cbw_t), stats.num_bytes);
+    TEST_ASSERT_EQUAL(num_cmds - 1, stats.num_resubmits);
+    TEST_ASSERT_EQUAL(0, stats.num_errors + stats.num_stalls + stats.num_overflows + stats.num_rejected);
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_endpoint_get_stats(msc_obj.dev_hdl, msc_obj.dev_info->in_ep_addr, &stats));
+    TEST_ASSERT_EQUAL(num_cmds * (msc_obj.test_param.num_sectors_per_xfer + 1), stats.num_transfers);
+    TEST_ASSERT_EQUAL(stats.num_transfers - 1, stats.num_resubmits);
+    TEST_ASSERT_EQUAL(1, stats.max_queue_depth);
+    TEST_ASSERT_EQUAL(0, stats.num_errors + stats.num_stalls + stats.num_overflows + stats.num_rejected);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(stats.resubmit_latency_total_us, stats.resubmit_latency_max_us);
+    // The default endpoint was used for the enumeration
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_endpoint_get_stats(msc_obj.dev_hdl, 0, &stats));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.num_transfers);
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_lib_dump_stats(stdout));
+
+    ESP_LOGI(MSC_CLIENT_TAG, "Close");
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_interface_release(msc_obj.client_hdl, msc_obj.dev_hdl, msc_obj.dev_info->bInterfaceNumber));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_device_close(msc_obj.client_hdl, msc_obj.dev_hdl));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_transfer_free(xfer_out));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_transfer_free(xfer_in));
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_client_deregister(msc_obj.client_hdl));
+    ESP_LOGI(MSC_CLIENT_TAG, "Done");
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,201 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "usb/usb_host.h"
+#include "unity.h"
+
+#define TEST_ACTIVITY_ITERATIONS            1000
+#define TEST_ACTIVITY_SUSPEND_INTERVAL_MS   10000   // Long enough to never expire during the measurement
+#define TEST_ACTIVITY_IDLE_INTERVAL_MS      500     // Auto suspend interval of the activity tracking test
+#define TEST_ACTIVITY_PERIOD_MS             50      // Period of the client activity, much shorter than the interval
+#define TEST_ACTIVITY_DURATION_MS           (3 * TEST_ACTIVITY_IDLE_INTERVAL_MS)
+
+static volatile int auto_suspend_events;            // Number of auto suspend events handled by the host lib task
+static volatile TickType_t auto_suspend_tick;       // Tick of the last auto suspend event
+
+static void activity_host_lib_task(void *arg)
+{
+    TaskHandle_t pending_task = (TaskHandle_t)arg;
+    while (1) {
+        uint32_t event_flags;
+        usb_host_lib_handle_events(portMAX_DELAY, &event_flags);
+        if (event_flags & USB_HOST_LIB_EVENT_FLAGS_AUTO_SUSPEND) {
+            auto_suspend_tick = xTaskGetTickCount();
+            auto_suspend_events++;
+        }
+        if (event_flags & USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS) {
+            TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, usb_host_device_free_all());
+        }
+        if (event_flags & USB_HOST_LIB_EVENT_FLAGS_ALL_FREE) {
+            break;
+        }
+    }
+    xTaskNotifyGive(pending_task);
+    vTaskDelete(NULL);
+}
+
+static void activity_client_event_cb(const usb_host_client_event_msg_t *event_msg, void *arg)
+{
+    (void)event_msg;
+    (void)arg;
+}
+
+static void activity_test_setup(TaskHandle_t *host_lib_task_hdl, usb_host_client_handle_t *client_hdl)
+{
+    auto_suspend_events = 0;
+    TEST_ASSERT_EQUAL(pdTRUE, xTaskCreate(activity_host_lib_task, "host lib", 4096, xTaskGetCurrentTaskHandle(), 2, host_lib_task_hdl));
+    TEST_ASSERT_NOT_NULL(*host_lib_task_hdl);
+    vTaskDelay(100); // Some time for the device to enumerate
+
+    const usb_host_client_config_t client_config = {
+        .is_synchronous = false,
+        .max_num_event_msg = 5,
+        .async = {
+            .client_event_callback = activity_client_event_cb,
+            .callback_arg = NULL,
+        },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_client_register(&client_config, client_hdl));
+}
+
+static void activity_test_teardown(usb_host_client_handle_t client_hdl)
+{
+    // Deregister the client, the host lib task frees the device
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_client_deregister(client_hdl));
+    TEST_ASSERT_MESSAGE(ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(1000)), "usb host lib task did not finish");
+}
+
+/**
+ * @brief Average CPU cycles of one usb_host_client_handle_events() call that handles one event
+ */
+static uint32_t measure_client_event_cycles(usb_host_client_handle_t client_hdl)
+{
+    const uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < TEST_ACTIVITY_ITERATIONS; i++) {
+        usb_host_client_unblock(client_hdl);
+        usb_host_client_handle_events(client_hdl, 0);
+    }
+    return (esp_cpu_get_cycle_count() - start) / TEST_ACTIVITY_ITERATIONS;
+}
+
+static void dummy_timer_cb(TimerHandle_t xTimer)
+{
+    (void)xTimer;
+}
+
+/**
+ * @brief Average CPU cycles of resetting an active FreeRTOS timer
+ *
+ * This is what every handled event used to cost while the auto suspend timer was running
+ */
+static uint32_t measure_timer_reset_cycles(void)
+{
+    TimerHandle_t timer = xTimerCreate("activity_tmr", pdMS_TO_TICKS(TEST_ACTIVITY_SUSPEND_INTERVAL_MS), pdFALSE, NULL, dummy_timer_cb);
+    TEST_ASSERT_NOT_NULL(timer);
+    TEST_ASSERT_EQUAL(pdPASS, xTimerStart(timer, portMAX_DELAY));
+    vTaskDelay(1); // Let the timer task process the start command
+
+    const uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < TEST_ACTIVITY_ITERATIONS; i++) {
+        if (xTimerIsTimerActive(timer) == pdTRUE) {
+            xTimerReset(timer, portMAX_DELAY);
+        }
+    }
+    const uint32_t cycles = (esp_cpu_get_cycle_count() - start) / TEST_ACTIVITY_ITERATIONS;
+
+    TEST_ASSERT_EQUAL(pdPASS, xTimerDelete(timer, portMAX_DELAY));
+    return cycles;
+}
+
+/*
+Test USB Host activity tracking postpones the auto suspend
+
+Purpose:
+- Test that the one-shot auto suspend timer is not reset on activity, but still postpones the auto suspend event
+  until the host has been idle for the whole interval
+
+Procedure:
+    - Install USB Host Library, register a client
+    - Set the one-shot auto suspend timer
+    - Handle client events periodically for several timer intervals, expect no auto suspend event
+    - Stop handling client events, expect exactly one auto suspend event, not earlier than one interval after
+      the last activity
+    - Teardown
+*/
+TEST_CASE("Test USB Host activity tracking", "[usb_host][low_speed][full_speed][high_speed]")
+{
+    TaskHandle_t host_lib_task_hdl = NULL;
+    usb_host_client_handle_t client_hdl;
+    activity_test_setup(&host_lib_task_hdl, &client_hdl);
+
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_lib_set_auto_suspend(USB_HOST_LIB_AUTO_SUSPEND_ONE_SHOT, TEST_ACTIVITY_IDLE_INTERVAL_MS));
+    const TickType_t start_tick = xTaskGetTickCount();
+    TickType_t last_activity_tick;
+    do {
+        // Read the tick first: the activity recorded by the client is not older than this tick
+        last_activity_tick = xTaskGetTickCount();
+        usb_host_client_unblock(client_hdl);
+        usb_host_client_handle_events(client_hdl, 0);
+        vTaskDelay(pdMS_TO_TICKS(TEST_ACTIVITY_PERIOD_MS));
+    } while (last_activity_tick - start_tick < pdMS_TO_TICKS(TEST_ACTIVITY_DURATION_MS));
+    TEST_ASSERT_EQUAL_MESSAGE(0, auto_suspend_events, "Auto suspend event delivered during activity");
+
+    // Host is idle now, the one-shot timer delivers the event once
+    vTaskDelay(pdMS_TO_TICKS(3 * TEST_ACTIVITY_IDLE_INTERVAL_MS));
+    TEST_ASSERT_EQUAL(1, auto_suspend_events);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(pdMS_TO_TICKS(TEST_ACTIVITY_IDLE_INTERVAL_MS), auto_suspend_tick - last_activity_tick);
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_lib_set_auto_suspend(USB_HOST_LIB_AUTO_SUSPEND_ONE_SHOT, 0));
+
+    activity_test_teardown(client_hdl);
+}
+
+/*
+Test USB Host activity tracking overhead
+
+Purpose:
+- Measure per-event overhead of the auto suspend activity tracking in usb_host_client_handle_events()
+- Compare it with resetting the FreeRTOS timer on every event
+
+Procedure:
+    - Install USB Host Library, register a client
+    - Measure cycles of handling one client event with auto suspend disabled and enabled
+    - Measure cycles of resetting an active FreeRTOS timer
+    - Print the results, the cycle counts depend on caches and interrupts, thus they are not asserted
+    - Teardown
+*/
+TEST_CASE("Test USB Host activity tracking overhead", "[usb_host][low_speed][full_speed][high_speed]")
+{
+    TaskHandle_t host_lib_task_hdl = NULL;
+    usb_host_client_handle_t client_hdl;
+    activity_test_setup(&host_lib_task_hdl, &client_hdl);
+
+    // Measure with the task at high priority, so that only interrupts can preempt it
+    const UBaseType_t prio = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
+    measure_client_event_cycles(client_hdl); // Warm up the caches
+
+    const uint32_t disabled_cycles = measure_client_event_cycles(client_hdl);
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_lib_set_auto_suspend(USB_HOST_LIB_AUTO_SUSPEND_ONE_SHOT, TEST_ACTIVITY_SUSPEND_INTERVAL_MS));
+    const uint32_t enabled_cycles = measure_client_event_cycles(client_hdl);
+    TEST_ASSERT_EQUAL(ESP_OK, usb_host_lib_set_auto_suspend(USB_HOST_LIB_AUTO_SUSPEND_ONE_SHOT, 0));
+    const uint32_t timer_reset_cycles = measure_timer_reset_cycles();
+    vTaskPrioritySet(NULL, prio);
+
+    const uint32_t overhead_cycles = (enabled_cycles > disabled_cycles) ? (enabled_cycles - disabled_cycles) : 0;
+    printf("Client event: %"PRIu32" cycles, auto suspend enabled: %"PRIu32" cycles\n", disabled_cycles, enabled_cycles);
+    printf("Auto suspend overhead per event: %"PRIu32" cycles, timer reset per event: %"PRIu32" cycles\n",
+           overhead_cycles, timer_reset_cycles);
+    TEST_ASSERT_EQUAL(0, auto_suspend_events);
+
+    activity_test_teardown(client_hdl);
+}
@@ -78,6 +78,51 @@ TEST_CASE("Test USB Host async client (single client)", "[usb_host][full_speed][
     }
 }
 
+/*
+Test USB Host direct completion callbacks
+
+Requires: This test requires an MSC SCSI device to be attached (see the MSC mock class)
+
+Purpose:
+    - Test that transfer callbacks of an EP with direct callbacks enabled are called from ISR context
+    - Test that a transfer can be resubmitted from its direct callback with usb_host_transfer_submit_from_isr()
+
+Procedure:
+    - Install USB Host Library
+    - Create a task to run an MSC client with direct callbacks enabled on the IN EP
+    - Start the MSC client task. It will execute a bunch of MSC SCSI sector reads, reading the data and CSW from ISR
+    - Wait for the host library event handler to report a USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS event
+    - Free all devices
+    - Uninstall USB Host Library
+*/
+
+TEST_CASE("Test USB Host direct completion callbacks", "[usb_host][full_speed][high_speed]")
+{
+    msc_client_test_param_t params = {
+        .num_sectors_to_read = TEST_MSC_NUM_SECTORS_TOTAL,
+        .num_sectors_per_xfer = TEST_MSC_NUM_SECTORS_PER_XFER,
+        .msc_scsi_xfer_tag = TEST_MSC_SCSI_TAG,
+    };
+    TaskHandle_t task_hdl = NULL;
+    xTaskCreatePinnedToCore(msc_client_async_direct_task, "async", 4096, (void *)&params, 2, &task_hdl, 0);
+    TEST_ASSERT_NOT_NULL_MESSAGE(task_hdl, "Failed to create async task");
+    // Start the task
+    xTaskNotifyGive(task_hdl);
+
+    while (1) {
+        // Start handling system events
+        uint32_t event_flags;
+        usb_host_lib_handle_events(portMAX_DELAY, &event_flags);
+        if (event_flags & USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS) {
+            printf("No more clients\n");
+            TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, usb_host_device_free_all());
+        }
+        if (event_flags & USB_HOST_LIB_EVENT_FLAGS_ALL_FREE) {
+            break;
+        }
+    }
+}
+
 /*
 Test USB Host Asynchronous API with multiple clients
 
@@ -105,6 +105,13 @@ void app_main(void)
         ESP_LOGI(TAG, "status: attached=%d cc2=%d rp=%u mA role=%d",
                  status.attached, status.cc2_active, (unsigned)status.rp_current_ma, (int)status.role);
     }
+    usb_tcpm_port_stats_t stats = {0};
+    if (usb_tcpm_get_stats(port, &stats) == ESP_OK) {
+        ESP_LOGI(TAG, "stats: attach=%u (last %u us, %u I2C transactions) i2c rd=%u wr=%u skipped=%u",
+                 (unsigned)stats.attach_count, (unsigned)stats.last_attach_latency_us,
+                 (unsigned)stats.last_attach_bus_transactions, (unsigned)stats.bus_reads,
+                 (unsigned)stats.bus_writes, (unsigned)stats.bus_writes_skipped);
+    }
 
     /* App can idle; the Type-C task & ISR do the work */
     while (true) {
@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+
+extern "C" {
+#include "usb/usb_tcpm.h"
+#include "tcpc_sim.h"
+}
+
+using test_clock = std::chrono::steady_clock;
+
+#define SIM_BUS_LATENCY_US      (100)   // ~3 byte I2C transaction at 400 kHz
+#define SINK_CYCLES             (2000)
+#define DRP_ROLE_SWAP_CYCLES    (20)
+#define EVENT_TIMEOUT_MS        (1000)
+#define SRC_DETACH_GRACE_WAIT_MS (250)  // Longer than the core source detach grace period
+
+typedef struct {
+    int32_t id;
+    test_clock::time_point timestamp;
+    bool cc2_active;
+    uint32_t rp_current_ma;
+} test_event_t;
+
+static QueueHandle_t s_event_queue;
+
+static void test_event_handler(void *handler_arg, esp_event_base_t base, int32_t id, void *event_data)
+{
+    test_event_t evt = {
+        .id = id,
+        .timestamp = test_clock::now(),
+        .cc2_active = false,
+        .rp_current_ma = 0,
+    };
+    if (id == USB_TCPM_EVENT_SINK_ATTACHED || id == USB_TCPM_EVENT_SOURCE_ATTACHED) {
+        const usb_tcpm_evt_attached_t *attached = (const usb_tcpm_evt_attached_t *)event_data;
+        evt.cc2_active = attached->cc2_active;
+        evt.rp_current_ma = attached->rp_current_ma;
+    }
+    xQueueSend(s_event_queue, &evt, portMAX_DELAY);
+}
+
+/**
+ * @brief Installs the TCPM library and creates one port on the simulated controller
+ */
+class SimPortFixture {
+public:
+    explicit SimPortFixture(usb_tcpm_power_role_t role)
+    {
+        s_event_queue = xQueueCreate(8, sizeof(test_event_t));
+        REQUIRE(s_event_queue != nullptr);
+        const esp_err_t loop_err = esp_event_loop_create_default();
+        REQUIRE((loop_err == ESP_OK || loop_err == ESP_ERR_INVALID_STATE));
+        REQUIRE(ESP_OK == esp_event_handler_register(USB_TCPM_EVENT, ESP_EVENT_ANY_ID, test_event_handler, nullptr));
+        REQUIRE(ESP_OK == usb_tcpm_install(nullptr));
+
+        const usb_tcpm_port_config_t port_cfg = {
+            .default_power_role = role,
+            .rp_current = USB_TCPM_RP_1A5,
+            .src_vbus_gpio = GPIO_NUM_NC,
+            .src_vbus_gpio_n = GPIO_NUM_NC,
+        };
+        const tcpc_sim_config_t sim_cfg = {
+            .bus_latency_us = SIM_BUS_LATENCY_US,
+        };
+        REQUIRE(ESP_OK == usb_tcpm_port_create_sim(&port_cfg, &sim_cfg, &port, &sim));
+    }
+
+    ~SimPortFixture()
+    {
+        CHECK(ESP_OK == usb_tcpm_port_destroy(port));
+        CHECK(ESP_OK == usb_tcpm_uninstall());
+        CHECK(ESP_OK == esp_event_handler_unregister(USB_TCPM_EVENT, ESP_EVENT_ANY_ID, test_event_handler));
+        vQueueDelete(s_event_queue);
+        s_event_queue = nullptr;
+    }
+
+    usb_tcpm_port_handle_t port = nullptr;
+    tcpc_sim_handle_t sim = nullptr;
+};
+
+/**
+ * @brief Wait for the next event, check its ID and return the latency from t0 in microseconds
+ */
+static uint32_t expect_event(int32_t id, test_clock::time_point t0, test_event_t *evt_out = nullptr)
+{
+    test_event_t evt;
+    REQUIRE(pdTRUE == xQueueReceive(s_event_queue, &evt, pdMS_TO_TICKS(EVENT_TIMEOUT_MS)));
+    REQUIRE(evt.id == id);
+    if (evt_out) {
+        *evt_out = evt;
+    }
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(evt.timestamp - t0).count();
+}
+
+static void print_latency(const char *name, std::vector<uint32_t> &samples_us)
+{
+    REQUIRE(!samples_us.empty());
+    std::sort(samples_us.begin(), samples_us.end());
+    const size_t n = samples_us.size();
+    printf("%-22s n=%-5zu min=%-6u p50=%-6u p90=%-6u p99=%-6u max=%u [us]\n", name, n,
+           (unsigned)samples_us[0], (unsigned)samples_us[n / 2], (unsigned)samples_us[(n * 90) / 100],
+           (unsigned)samples_us[(n * 99) / 100], (unsigned)samples_us[n - 1]);
+}
+
+static void print_stats(usb_tcpm_port_handle_t port)
+{
+    usb_tcpm_port_stats_t stats = {};
+    // Stats are recorded after the event has been posted, give the TCPM task time to record the last event
+    for (int i = 0; i < EVENT_TIMEOUT_MS; i++) {
+        REQUIRE(ESP_OK == usb_tcpm_get_stats(port, &stats));
+        if (stats.attach_count == stats.detach_count) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    printf("core: attach=%u detach=%u max_attach=%uus max_detach=%uus last_attach_bus_tx=%u bus rd=%u wr=%u\n",
+           (unsigned)stats.attach_count, (unsigned)stats.detach_count,
+           (unsigned)stats.max_attach_latency_us, (unsigned)stats.max_detach_latency_us,
+           (unsigned)stats.last_attach_bus_transactions, (unsigned)stats.bus_reads, (unsigned)stats.bus_writes);
+    REQUIRE(stats.attach_count == stats.detach_count);
+    REQUIRE(stats.bus_errors == 0);
+}
+
+SCENARIO("Sink attach/detach cycles on simulated TCPC")
+{
+    SimPortFixture fixture(USB_TCPM_PWR_SINK);
+    std::vector<uint32_t> attach_us;
+    std::vector<uint32_t> detach_us;
+    attach_us.reserve(SINK_CYCLES);
+    detach_us.reserve(SINK_CYCLES);
+
+    for (int i = 0; i < SINK_CYCLES; i++) {
+        const bool cc2 = (i & 1);
+        test_event_t evt;
+
+        // Plug: Rp appears on CC, then the partner turns on VBUS
+        auto t0 = test_clock::now();
+        REQUIRE(ESP_OK == tcpc_sim_connect(fixture.sim, TCPC_SIM_PARTNER_SOURCE, cc2, USB_TCPM_RP_3A0));
+        REQUIRE(ESP_OK == tcpc_sim_set_vbus(fixture.sim, true));
+        attach_us.push_back(expect_event(USB_TCPM_EVENT_SINK_ATTACHED, t0, &evt));
+        REQUIRE(evt.cc2_active == cc2);
+        REQUIRE(evt.rp_current_ma == 3000);
+
+        // Unplug: CC opens, then VBUS drops
+        t0 = test_clock::now();
+        REQUIRE(ESP_OK == tcpc_sim_disconnect(fixture.sim));
+        REQUIRE(ESP_OK == tcpc_sim_set_vbus(fixture.sim, false));
+        detach_us.push_back(expect_event(USB_TCPM_EVENT_SINK_DETACHED, t0));
+    }
+
+    print_latency("sink attach", attach_us);
+    print_latency("sink detach", detach_us);
+    print_stats(fixture.port);
+}
+
+SCENARIO("DRP role swap cycles on simulated TCPC")
+{
+    SimPortFixture fixture(USB_TCPM_PWR_DRP);
+    std::vector<uint32_t> snk_attach_us;
+    std::vector<uint32_t> src_attach_us;
+    std::vector<uint32_t> detach_us;
+
+    for (int i = 0; i < DRP_ROLE_SWAP_CYCLES; i++) {
+        // Partner is a Source: DRP resolves to Sink
+        auto t0 = test_clock::now();
+        REQUIRE(ESP_OK == tcpc_sim_connect(fixture.sim, TCPC_SIM_PARTNER_SOURCE, false, USB_TCPM_RP_DEFAULT));
+        REQUIRE(ESP_OK == tcpc_sim_set_vbus(fixture.sim, true));
+        snk_attach_us.push_back(expect_event(USB_TCPM_EVENT_SINK_ATTACHED, t0));
+
+        t0 = test_clock::now();
+        REQUIRE(ESP_OK == tcpc_sim_disconnect(fixture.sim));
+        REQUIRE(ESP_OK == tcpc_sim_set_vbus(fixture.sim, false));
+        detach_us.push_back(expect_event(USB_TCPM_EVENT_SINK_DETACHED, t0));
+
+        // Partner is a Sink: DRP resolves to Source
+        t0 = test_clock::now();
+        REQUIRE(ESP_OK == tcpc_sim_connect(fixture.sim, TCPC_SIM_PARTNER_SINK, true, USB_TCPM_RP_DEFAULT));
+        src_attach_us.push_back(expect_event(USB_TCPM_EVENT_SOURCE_ATTACHED, t0));
+
+        // Detach is masked during the source startup grace period
+        vTaskDelay(pdMS_TO_TICKS(SRC_DETACH_GRACE_WAIT_MS));
+        t0 = test_clock::now();
+        REQUIRE(ESP_OK == tcpc_sim_disconnect(fixture.sim));
+        detach_us.push_back(expect_event(USB_TCPM_EVENT_SOURCE_DETACHED, t0));
+
+        usb_tcpm_port_status_t status = {};
+        REQUIRE(ESP_OK == usb_tcpm_get_status(fixture.port, &status));
+        REQUIRE_FALSE(status.attached);
+    }
+
+    print_latency("drp sink attach", snk_attach_us);
+    print_latency("drp source attach", src_attach_us);
+    print_latency("drp detach", detach_us);
+    print_stats(fixture.port);
+}
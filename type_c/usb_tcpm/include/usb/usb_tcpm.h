@@ -108,6 +108,26 @@ typedef struct {
     usb_tcpm_power_role_t role; /**< Current power role. */
 } usb_tcpm_port_status_t;
 
+/**
+ * @brief Type-C port statistics.
+ *
+ * Latencies are measured from the controller interrupt that led to the event
+ * until the event is posted to the event loop.
+ */
+typedef struct {
+    uint32_t attach_count;                 /**< Number of ATTACHED events posted. */
+    uint32_t detach_count;                 /**< Number of DETACHED events posted. */
+    uint32_t last_attach_latency_us;       /**< IRQ to ATTACHED latency of the last attach. */
+    uint32_t max_attach_latency_us;        /**< Worst IRQ to ATTACHED latency seen. */
+    uint32_t last_detach_latency_us;       /**< IRQ to DETACHED latency of the last detach. */
+    uint32_t max_detach_latency_us;        /**< Worst IRQ to DETACHED latency seen. */
+    uint32_t last_attach_bus_transactions; /**< Controller bus transactions between IRQ and the last ATTACHED event. */
+    uint32_t bus_reads;                    /**< Total controller read transactions. */
+    uint32_t bus_writes;                   /**< Total controller write transactions. */
+    uint32_t bus_writes_skipped;           /**< Writes elided by the backend register cache. */
+    uint32_t bus_errors;                   /**< Failed controller bus transactions. */
+} usb_tcpm_port_stats_t;
+
 /**
  * @brief Install and initialize the Type-C library.
  *
@@ -149,6 +169,19 @@ esp_err_t usb_tcpm_port_destroy(usb_tcpm_port_handle_t port_hdl);
  */
 esp_err_t usb_tcpm_get_status(usb_tcpm_port_handle_t port_hdl, usb_tcpm_port_status_t *status);
 
+/**
+ * @brief Get Type-C port statistics.
+ *
+ * Bus counters are reported as 0 if the backend does not provide them.
+ *
+ * @param[in] port_hdl Port handle.
+ * @param[out] stats Pointer to statistics output.
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if port_hdl or stats is NULL
+ */
+esp_err_t usb_tcpm_get_stats(usb_tcpm_port_handle_t port_hdl, usb_tcpm_port_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
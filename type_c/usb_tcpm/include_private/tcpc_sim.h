@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "usb/usb_tcpm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handle of a simulated Type-C port controller.
+ */
+typedef struct tcpc_sim *tcpc_sim_handle_t;
+
+/**
+ * @brief Port partner presented on the simulated CC lines.
+ */
+typedef enum {
+    TCPC_SIM_PARTNER_NONE = 0, /**< Nothing connected */
+    TCPC_SIM_PARTNER_SOURCE,   /**< Partner presents Rp; local port resolves to Sink */
+    TCPC_SIM_PARTNER_SINK,     /**< Partner presents Rd; local port resolves to Source */
+} tcpc_sim_partner_t;
+
+/**
+ * @brief Simulated controller configuration.
+ */
+typedef struct {
+    uint32_t bus_latency_us; /**< Busy time of one simulated register transaction (0 = instant) */
+} tcpc_sim_config_t;
+
+/**
+ * @brief Create a Type-C port backed by a software-simulated controller.
+ *
+ * Only built for the linux target, where it backs the host tests.
+ *
+ * The simulated controller has no INT GPIO; CC/VBUS changes injected with
+ * tcpc_sim_connect(), tcpc_sim_disconnect() and tcpc_sim_set_vbus() latch
+ * events and signal the port via typec_port_notify_irq(). Every backend
+ * operation costs a fixed number of simulated bus transactions, modelled on
+ * the FUSB302 backend, each taking bus_latency_us.
+ *
+ * @note src_vbus_gpio and src_vbus_gpio_n in port_cfg should be GPIO_NUM_NC.
+ *
+ * @param[in] port_cfg Port configuration.
+ * @param[in] sim_cfg Simulation configuration (NULL for defaults).
+ * @param[out] port_hdl_ret Port handle output.
+ * @param[out] sim_ret Simulator handle output, used to inject events.
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if any required argument is NULL
+ *      - ESP_ERR_INVALID_STATE if usb_tcpm_install() has not been called
+ *      - ESP_ERR_NO_MEM if allocation fails
+ */
+esp_err_t usb_tcpm_port_create_sim(const usb_tcpm_port_config_t *port_cfg,
+                                   const tcpc_sim_config_t *sim_cfg,
+                                   usb_tcpm_port_handle_t *port_hdl_ret,
+                                   tcpc_sim_handle_t *sim_ret);
+
+/**
+ * @brief Connect a port partner to the simulated CC lines.
+ *
+ * @param[in] sim Simulator handle.
+ * @param[in] partner Partner type (must not be TCPC_SIM_PARTNER_NONE).
+ * @param[in] cc2 True if the partner is connected on CC2.
+ * @param[in] partner_rp Rp current advertised by a Source partner (ignored for Sink partners).
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if sim is NULL or partner is invalid
+ */
+esp_err_t tcpc_sim_connect(tcpc_sim_handle_t sim, tcpc_sim_partner_t partner, bool cc2,
+                           usb_tcpm_rp_current_t partner_rp);
+
+/**
+ * @brief Remove the port partner from the simulated CC lines.
+ *
+ * @note VBUS supplied by a Source partner is not removed; call tcpc_sim_set_vbus() as well.
+ *
+ * @param[in] sim Simulator handle.
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if sim is NULL
+ */
+esp_err_t tcpc_sim_disconnect(tcpc_sim_handle_t sim);
+
+/**
+ * @brief Change the simulated VBUS presence.
+ *
+ * @param[in] sim Simulator handle.
+ * @param[in] present True if VBUS is above the VBUSOK threshold.
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if sim is NULL
+ */
+esp_err_t tcpc_sim_set_vbus(tcpc_sim_handle_t sim, bool present);
+
+#ifdef __cplusplus
+}
+#endif
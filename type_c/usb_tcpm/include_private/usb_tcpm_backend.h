@@ -48,6 +48,16 @@ typedef enum {
     TYPEC_EVT_TOG   = (1u << 5),  /**< Toggle state change (TOG_DONE) */
 } typec_evt_mask_t;
 
+/**
+ * @brief Bus transaction counters of a Type-C controller backend.
+ */
+typedef struct {
+    uint32_t reads;          /**< Read transactions (single register or burst) */
+    uint32_t writes;         /**< Write transactions */
+    uint32_t writes_skipped; /**< Writes elided because the register already held the value */
+    uint32_t errors;         /**< Failed transactions */
+} typec_bus_stats_t;
+
 /**
  * @brief Backend operations for a Type-C port controller.
  */
@@ -58,7 +68,8 @@ typedef struct typec_port_backend {
     esp_err_t (*service_irq)(void *device, typec_evt_mask_t *events); /**< Service IRQ and return events. */
     esp_err_t (*get_status)(void *device, typec_cc_status_t *status); /**< Read CC/VBUS status snapshot. */
     esp_err_t (*commit_attach)(void *device, bool cc2_active, bool is_source); /**< Commit orientation/role after attach. */
-    esp_err_t (*get_irq_gpio)(void *device, gpio_num_t *gpio_num); /**< Return IRQ GPIO number. */
+    esp_err_t (*get_irq_gpio)(void *device, gpio_num_t *gpio_num); /**< Return IRQ GPIO number, or GPIO_NUM_NC to signal IRQs with typec_port_notify_irq(). */
+    esp_err_t (*get_bus_stats)(void *device, typec_bus_stats_t *stats); /**< Optional: return bus transaction counters. */
 } typec_port_backend_t;
 
 /**
@@ -84,6 +95,20 @@ esp_err_t typec_port_new(const typec_port_backend_t *backend,
                          const usb_tcpm_port_config_t *port_cfg,
                          typec_port_handle_t *out);
 
+/**
+ * @brief Signal a controller interrupt from software.
+ *
+ * Used by backends without an INT GPIO (get_irq_gpio() returns GPIO_NUM_NC).
+ * The shared worker then calls service_irq() for the port as if the INT line
+ * had been asserted. Must be called from task context.
+ *
+ * @param[in] port Port handle returned by typec_port_new().
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if port is NULL
+ */
+esp_err_t typec_port_notify_irq(typec_port_handle_t port);
+
 #ifdef __cplusplus
 }
 #endif
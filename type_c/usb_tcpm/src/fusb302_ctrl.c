@@ -27,6 +27,15 @@ static const char *TAG = "fusb302";
 #define MAX_INT_READS 8 /* Maximum number of interrupt register reads to avoid infinite loops */
 #define SRC_ATTACH_DEBOUNCE_MS 10
 
+/* CONTROL/SWITCHES/MASK block mirrored in the shadow cache (SWITCHES0..MASKB) */
+#define SHADOW_FIRST_REG   0x02 /* REG_SWITCHES0 */
+#define SHADOW_LAST_REG    0x0F /* REG_MASKB */
+#define SHADOW_LEN         (SHADOW_LAST_REG - SHADOW_FIRST_REG + 1)
+
+/* STATUS0A..INTERRUPT is contiguous and read in a single auto-increment burst */
+#define STATUS_BLK_FIRST_REG REG_STATUS0A
+#define STATUS_BLK_LEN       (REG_INTERRUPT - REG_STATUS0A + 1)
+
 typedef struct fusb302_dev fusb302_dev_t;
 
 typedef struct {
@@ -42,6 +51,16 @@ struct fusb302_dev {
     fusb302_hw_cfg_t hw;             /**< Hardware configuration */
     usb_tcpm_power_role_t role;      /**< Current power role */
     usb_tcpm_rp_current_t rp_current;/**< Advertised Rp current when sourcing */
+    struct {
+        uint8_t regs[SHADOW_LEN];    /**< Last value written to (or read from) SWITCHES0..MASKB */
+        bool valid;                  /**< Shadow has been loaded from the chip */
+    } shadow;                        /**< Control register shadow cache */
+    struct {
+        uint8_t status1a;            /**< STATUS1A captured by the last IRQ burst */
+        uint8_t status0;             /**< STATUS0 captured by the last IRQ burst */
+        bool valid;                  /**< No register has been written since the snapshot */
+    } status_snap;                   /**< Status captured while draining interrupts */
+    typec_bus_stats_t stats;         /**< I2C transaction counters */
 };
 
 /**
@@ -54,13 +73,13 @@ typedef struct {
 } fusb302_port_ctx_t;
 
 /* Internal device functions */
-static esp_err_t fusb302_commit_attach(const fusb302_dev_t *device, bool cc2_active, bool is_source);
+static esp_err_t fusb302_commit_attach(fusb302_dev_t *device, bool cc2_active, bool is_source);
 static esp_err_t fusb302_init(const fusb302_hw_cfg_t *hw, fusb302_dev_t **out);
 static esp_err_t fusb302_deinit(fusb302_dev_t *device);
 static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t role);
-static esp_err_t fusb302_service_irq(const fusb302_dev_t *device, typec_evt_mask_t *events);
-static esp_err_t fusb302_enable_irq(const fusb302_dev_t *device, bool enable);
-static esp_err_t fusb302_get_status(const fusb302_dev_t *device, typec_cc_status_t *status);
+static esp_err_t fusb302_service_irq(fusb302_dev_t *device, typec_evt_mask_t *events);
+static esp_err_t fusb302_enable_irq(fusb302_dev_t *device, bool enable);
+static esp_err_t fusb302_get_status(fusb302_dev_t *device, typec_cc_status_t *status);
 
 /* FUSB302 registers */
 enum {
@@ -107,11 +126,16 @@ enum {
 #define SW1_TXCC1_EN    (1u << 0)
 
 /* CONTROL0 */
+#define CTL0_TX_FLUSH   (1u << 6)   /* self-clearing */
 #define CTL0_INT_MASK   (1u << 5)   /* 0 = INT pin enabled, 1 = masked */
 #define CTL0_HOST_CUR_MASK   (0x3 << 2)
 #define CTL0_HOST_CUR_DEFAULT  (0x1u << 2)       /* 01b -> Default */
 #define CTL0_HOST_CUR_MEDIUM   (0x2u << 2)       /* 10b -> 1.5A */
 #define CTL0_HOST_CUR_HIGH     (0x3u << 2)       /* 11b -> 3A  */
+#define CTL0_TX_START   (1u << 0)   /* self-clearing */
+
+/* CONTROL1 */
+#define CTL1_RX_FLUSH   (1u << 2)   /* self-clearing */
 
 /* CONTROL2 MODE bits */
 #define CTL2_MODE_MASK  (0x3u << 1)
@@ -121,6 +145,9 @@ enum {
 #define CTL2_MODE_NONE  (0x0)
 #define CTL2_TOGGLE     (1u << 0)
 
+/* CONTROL3 */
+#define CTL3_SEND_HARD_RESET (1u << 6)  /* self-clearing */
+
 /* POWER levels */
 #define PWR_PWR_ALL     0x0F  /* full on */
 #define PWR_PWR_HIGH    0x07
@@ -232,96 +259,197 @@ static inline uint32_t bclvl_to_ma(uint8_t bclvl)
     }
 }
 
-// Write 8-bit value to a FUSB302 register via I2C.
-static inline esp_err_t i2c_wr8(i2c_master_dev_handle_t device, uint8_t reg, uint8_t val)
+/* ---------------- Register access layer ----------------
+ *
+ * All chip accesses go through the helpers below so that they are counted.
+ * Control registers (SWITCHES0..MASKB) are only ever modified by the host,
+ * so their last written value is kept in a shadow cache: reads are served
+ * from the cache and writes of an unchanged value are not sent on the bus.
+ * Self-clearing command bits (reset, flush, TX start) are never kept in the
+ * shadow: they read back as 0 and a write setting them always goes to the bus.
+ * Status and interrupt registers are never cached; STATUS0A..INTERRUPT are
+ * fetched in a single auto-increment burst when servicing the IRQ.
+ */
+
+static inline bool reg_is_shadowed(uint8_t reg)
 {
-    const uint8_t buf[2] = { reg, val };
-    return i2c_master_transmit(device, buf, sizeof(buf), 100 /*ms*/);
+    return reg >= SHADOW_FIRST_REG && reg <= SHADOW_LAST_REG;
 }
 
-// Read 8-bit value from a FUSB302 register via I2C.
-static inline esp_err_t i2c_rd8(i2c_master_dev_handle_t device, uint8_t reg, uint8_t *val)
+// Self-clearing bits of a shadowed register: the chip clears them once the command has been executed.
+static inline uint8_t reg_self_clearing_bits(uint8_t reg)
 {
-    if (!val) {
+    switch (reg) {
+    case REG_CONTROL0:
+        return CTL0_TX_FLUSH | CTL0_TX_START;
+    case REG_CONTROL1:
+        return CTL1_RX_FLUSH;
+    case REG_CONTROL3:
+        return CTL3_SEND_HARD_RESET;
+    case REG_RESET:
+        return RST_PD_RESET | RST_SW_RESET;
+    default:
+        return 0;
+    }
+}
+
+static inline void fusb302_account(fusb302_dev_t *device, esp_err_t err, uint32_t *counter)
+{
+    (*counter)++;
+    if (err != ESP_OK) {
+        device->stats.errors++;
+    }
+}
+
+// Read len consecutive FUSB302 registers starting at reg in one I2C transaction.
+static esp_err_t fusb302_reg_read_burst(fusb302_dev_t *device, uint8_t reg, uint8_t *buf, size_t len)
+{
+    if (!buf || len == 0) {
         return ESP_ERR_INVALID_ARG;
     }
-    return i2c_master_transmit_receive(device, &reg, 1, val, 1, 100);
+    const esp_err_t err = i2c_master_transmit_receive(device->hw.i2c_dev, &reg, 1, buf, len, 100 /*ms*/);
+    fusb302_account(device, err, &device->stats.reads);
+    return err;
 }
 
-static esp_err_t fusb302_set_host_cur(const fusb302_dev_t *device, uint8_t host_cur_bits)
+// Write 8-bit value to a FUSB302 register via I2C, bypassing the shadow cache.
+static esp_err_t fusb302_reg_write_raw(fusb302_dev_t *device, uint8_t reg, uint8_t val)
 {
-    if (!device) {
+    const uint8_t buf[2] = { reg, val };
+    const esp_err_t err = i2c_master_transmit(device->hw.i2c_dev, buf, sizeof(buf), 100 /*ms*/);
+    fusb302_account(device, err, &device->stats.writes);
+    /* Any write may change what STATUSx reports */
+    device->status_snap.valid = false;
+    if (err == ESP_OK && device->shadow.valid && reg_is_shadowed(reg)) {
+        device->shadow.regs[reg - SHADOW_FIRST_REG] = val & ~reg_self_clearing_bits(reg);
+    }
+    return err;
+}
+
+// Write 8-bit value to a FUSB302 register, skipping the bus if the shadow already holds it.
+// A write setting a self-clearing bit is a command and is always sent.
+static esp_err_t fusb302_reg_write(fusb302_dev_t *device, uint8_t reg, uint8_t val)
+{
+    if (device->shadow.valid && reg_is_shadowed(reg) &&
+            (val & reg_self_clearing_bits(reg)) == 0 &&
+            device->shadow.regs[reg - SHADOW_FIRST_REG] == val) {
+        device->stats.writes_skipped++;
+        return ESP_OK;
+    }
+    return fusb302_reg_write_raw(device, reg, val);
+}
+
+// Read 8-bit value from a FUSB302 register, served from the shadow for control registers.
+static esp_err_t fusb302_reg_read(fusb302_dev_t *device, uint8_t reg, uint8_t *val)
+{
+    if (!val) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (device->shadow.valid && reg_is_shadowed(reg)) {
+        *val = device->shadow.regs[reg - SHADOW_FIRST_REG];
+        return ESP_OK;
+    }
+    return fusb302_reg_read_burst(device, reg, val, 1);
+}
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
-    uint8_t ctl0 = 0;
+// Read-modify-write of the bits in mask; no bus traffic if the result is unchanged.
+static esp_err_t fusb302_reg_update(fusb302_dev_t *device, uint8_t reg, uint8_t mask, uint8_t val)
+{
+    uint8_t cur = 0;
+    ESP_RETURN_ON_ERROR(fusb302_reg_read(device, reg, &cur), TAG, "read 0x%02x", reg);
+    return fusb302_reg_write(device, reg, (cur & ~mask) | (val & mask));
+}
 
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_CONTROL0, &ctl0), TAG, "read CONTROL0");
-    ctl0 = (ctl0 & ~CTL0_HOST_CUR_MASK) | host_cur_bits;
-    return i2c_wr8(i2c_dev, REG_CONTROL0, ctl0);
+// (Re)load the shadow cache from the chip with one burst read.
+static esp_err_t fusb302_shadow_load(fusb302_dev_t *device)
+{
+    device->shadow.valid = false;
+    ESP_RETURN_ON_ERROR(fusb302_reg_read_burst(device, SHADOW_FIRST_REG, device->shadow.regs, SHADOW_LEN),
+                        TAG, "shadow load");
+    // A command still in progress may read back its self-clearing bit
+    for (uint8_t reg = SHADOW_FIRST_REG; reg <= SHADOW_LAST_REG; reg++) {
+        device->shadow.regs[reg - SHADOW_FIRST_REG] &= ~reg_self_clearing_bits(reg);
+    }
+    device->shadow.valid = true;
+    return ESP_OK;
 }
 
-static esp_err_t fusb302_toggle_disable(const fusb302_dev_t *device)
+// Read STATUS1A or STATUS0, served from the last IRQ burst while no register has been written since.
+static esp_err_t fusb302_status_read(fusb302_dev_t *device, uint8_t reg, uint8_t *val)
+{
+    if (device->status_snap.valid) {
+        if (reg == REG_STATUS1A) {
+            *val = device->status_snap.status1a;
+            return ESP_OK;
+        }
+        if (reg == REG_STATUS0) {
+            *val = device->status_snap.status0;
+            return ESP_OK;
+        }
+    }
+    return fusb302_reg_read(device, reg, val);
+}
+
+// Clear all latched interrupt causes (INTERRUPTA..INTERRUPT) in one burst.
+static esp_err_t fusb302_clear_interrupts(fusb302_dev_t *device)
+{
+    uint8_t blk[STATUS_BLK_LEN];
+    return fusb302_reg_read_burst(device, REG_INTERRUPTA, blk, REG_INTERRUPT - REG_INTERRUPTA + 1);
+}
+
+static esp_err_t fusb302_set_host_cur(fusb302_dev_t *device, uint8_t host_cur_bits)
 {
     if (!device) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
-    uint8_t ctl2 = 0;
+    return fusb302_reg_update(device, REG_CONTROL0, CTL0_HOST_CUR_MASK, host_cur_bits);
+}
 
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_CONTROL2, &ctl2), TAG, "read CONTROL2");
-    if (ctl2 & CTL2_TOGGLE) {
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, ctl2 & ~CTL2_TOGGLE), TAG, "disable toggle");
+static esp_err_t fusb302_toggle_disable(fusb302_dev_t *device)
+{
+    if (!device) {
+        return ESP_ERR_INVALID_ARG;
     }
-    return ESP_OK;
+
+    return fusb302_reg_update(device, REG_CONTROL2, CTL2_TOGGLE, 0);
 }
 
-static esp_err_t fusb302_toggle_enable(const fusb302_dev_t *device)
+static esp_err_t fusb302_toggle_enable(fusb302_dev_t *device)
 {
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
     uint8_t ctl2;
 
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_CONTROL2, &ctl2), TAG, "read CONTROL2");
+    ESP_RETURN_ON_ERROR(fusb302_reg_read(device, REG_CONTROL2, &ctl2), TAG, "read CONTROL2");
 
     const uint8_t base = ctl2 & ~CTL2_TOGGLE;
 
     // Clear any latched toggle-related causes
-    uint8_t tmp;
-    (void)i2c_rd8(i2c_dev, REG_INTERRUPTA, &tmp);
-    (void)i2c_rd8(i2c_dev, REG_INTERRUPT,  &tmp);
-    (void)i2c_rd8(i2c_dev, REG_INTERRUPTB, &tmp);
+    (void)fusb302_clear_interrupts(device);
 
-    // Force a clean 0 -> 1 edge
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, base), TAG, "disable toggle");
+    // Force a clean 0 -> 1 edge (the first write is skipped if TOGGLE is already 0)
+    ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_CONTROL2, base), TAG, "disable toggle");
     esp_rom_delay_us(50);
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, base | CTL2_TOGGLE), TAG, "enable toggle");
+    ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_CONTROL2, base | CTL2_TOGGLE), TAG, "enable toggle");
 
     return ESP_OK;
 }
 
-static esp_err_t fusb302_apply_polarity(const fusb302_dev_t *device, bool cc2_active, bool is_source)
+static esp_err_t fusb302_apply_polarity(fusb302_dev_t *device, bool cc2_active, bool is_source)
 {
     if (!device) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
-
     if (is_source) {
-        uint8_t sw1 = 0;
-        ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_SWITCHES1, &sw1), TAG, "read SWITCHES1");
-        sw1 = (sw1 & ~(SW1_TXCC1_EN | SW1_TXCC2_EN)) | SW1_POWERROLE |
-              (cc2_active ? SW1_TXCC2_EN : SW1_TXCC1_EN);
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES1, sw1), TAG, "write SWITCHES1 TXCC");
-    }
-
-    uint8_t sw0 = 0;
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_SWITCHES0, &sw0), TAG, "read SWITCHES0");
-    sw0 = (sw0 & ~(SW0_MEAS_CC1 | SW0_MEAS_CC2)) |
-          (cc2_active ? SW0_MEAS_CC2 : SW0_MEAS_CC1);
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES0, sw0), TAG, "write SWITCHES0 MEAS");
+        ESP_RETURN_ON_ERROR(fusb302_reg_update(device, REG_SWITCHES1,
+                                               SW1_TXCC1_EN | SW1_TXCC2_EN | SW1_POWERROLE,
+                                               SW1_POWERROLE | (cc2_active ? SW1_TXCC2_EN : SW1_TXCC1_EN)),
+                            TAG, "write SWITCHES1 TXCC");
+    }
+
+    ESP_RETURN_ON_ERROR(fusb302_reg_update(device, REG_SWITCHES0, SW0_MEAS_CC1 | SW0_MEAS_CC2,
+                                           cc2_active ? SW0_MEAS_CC2 : SW0_MEAS_CC1),
+                        TAG, "write SWITCHES0 MEAS");
     esp_rom_delay_us(50);
 
     return ESP_OK;
@@ -329,7 +457,7 @@ static esp_err_t fusb302_apply_polarity(const fusb302_dev_t *device, bool cc2_ac
 
 /* ---------------- Internal device functions ---------------- */
 
-static esp_err_t fusb302_commit_attach(const fusb302_dev_t *device, bool cc2_active, bool is_source)
+static esp_err_t fusb302_commit_attach(fusb302_dev_t *device, bool cc2_active, bool is_source)
 {
     if (!device) {
         return ESP_ERR_INVALID_ARG;
@@ -343,8 +471,7 @@ static esp_err_t fusb302_commit_attach(const fusb302_dev_t *device, bool cc2_act
         /* Advertise the configured Rp current after attach. */
         ESP_RETURN_ON_ERROR(fusb302_set_host_cur(device, rp_current_to_host_cur_bits(device->rp_current)),
                             TAG, "set HOST_CUR attach");
-        ESP_RETURN_ON_ERROR(i2c_wr8(device->hw.i2c_dev, REG_MEASURE,
-                                    rp_current_to_mdac(device->rp_current)),
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MEASURE, rp_current_to_mdac(device->rp_current)),
                             TAG, "set MDAC attach");
         /* Debounce to avoid false detach during the first few ms after attach. */
         vTaskDelay(pdMS_TO_TICKS(SRC_ATTACH_DEBOUNCE_MS));
@@ -371,15 +498,18 @@ static esp_err_t fusb302_init(const fusb302_hw_cfg_t *hw, fusb302_dev_t **out)
     uint8_t device_id;
 
     // Probe
-    ESP_GOTO_ON_ERROR(i2c_rd8(hw->i2c_dev, REG_DEVICE_ID, &device_id), fail, TAG, "probe");
+    ESP_GOTO_ON_ERROR(fusb302_reg_read(device, REG_DEVICE_ID, &device_id), fail, TAG, "probe");
     ESP_LOGI(TAG, "FUSB302 DEVICE_ID=0x%02x", device_id);
 
     // Soft reset
-    ESP_GOTO_ON_ERROR(i2c_wr8(hw->i2c_dev, REG_RESET, RST_SW_RESET), fail, TAG, "reset");
+    ESP_GOTO_ON_ERROR(fusb302_reg_write_raw(device, REG_RESET, RST_SW_RESET), fail, TAG, "reset");
     vTaskDelay(pdMS_TO_TICKS(10));
 
+    // Registers are back at their reset values; mirror them before any cached access
+    ESP_GOTO_ON_ERROR(fusb302_shadow_load(device), fail, TAG, "shadow load");
+
     // Power all relevant blocks
-    ESP_GOTO_ON_ERROR(i2c_wr8(hw->i2c_dev, REG_POWER, PWR_PWR_ALL), fail, TAG, "power");
+    ESP_GOTO_ON_ERROR(fusb302_reg_write(device, REG_POWER, PWR_PWR_ALL), fail, TAG, "power");
 
     ESP_GOTO_ON_ERROR(fusb302_enable_irq(device, true), fail, TAG, "enable irq");
     ESP_LOGI(TAG, "init done");
@@ -397,12 +527,11 @@ static esp_err_t fusb302_deinit(fusb302_dev_t *device)
     if (!device) {
         return ESP_ERR_INVALID_ARG;
     }
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
 
     ESP_GOTO_ON_ERROR(fusb302_enable_irq(device, false), fail, TAG, "disable irq");
-    ESP_GOTO_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES0, 0x00), fail, TAG, "SWITCHES0 Hi-Z");
-    ESP_GOTO_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, CTL2_MODE_NONE), fail, TAG, "CONTROL2 mode none");
-    ESP_GOTO_ON_ERROR(i2c_wr8(i2c_dev, REG_POWER, PWR_PWR_LOW), fail, TAG, "power down");
+    ESP_GOTO_ON_ERROR(fusb302_reg_write(device, REG_SWITCHES0, 0x00), fail, TAG, "SWITCHES0 Hi-Z");
+    ESP_GOTO_ON_ERROR(fusb302_reg_write(device, REG_CONTROL2, CTL2_MODE_NONE), fail, TAG, "CONTROL2 mode none");
+    ESP_GOTO_ON_ERROR(fusb302_reg_write(device, REG_POWER, PWR_PWR_LOW), fail, TAG, "power down");
 
 fail:
     free(device);
@@ -415,9 +544,6 @@ static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t r
         return ESP_ERR_INVALID_ARG;
     }
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
-    uint8_t value;
-
     switch (role) {
     case USB_TCPM_PWR_SINK: {
         uint8_t prev_status1a = 0;
@@ -425,7 +551,7 @@ static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t r
         const bool from_drp = (device->role == USB_TCPM_PWR_DRP);
 
         if (from_drp) {
-            (void)i2c_rd8(i2c_dev, REG_STATUS1A, &prev_status1a);
+            (void)fusb302_status_read(device, REG_STATUS1A, &prev_status1a);
             prev_togss = (prev_status1a >> ST1A_TOGSS_SHIFT) & 0x07;
 
             /*
@@ -433,15 +559,15 @@ static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t r
              * Preload Rd so manual pull state is correct as soon as control
              * returns to SWITCHES0 bits while leaving autonomous toggle mode.
              */
-            ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES0, SW0_CC1_PD_EN | SW0_CC2_PD_EN),
+            ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_SWITCHES0, SW0_CC1_PD_EN | SW0_CC2_PD_EN),
                                 TAG, "SWITCHES0 Rd preload");
         }
 
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, CTL2_MODE_UFP), TAG, "set UFP mode");
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_CONTROL2, CTL2_MODE_UFP), TAG, "set UFP mode");
 
         if (!from_drp) {
             /* Rd on both CC pins */
-            ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES0, SW0_CC1_PD_EN | SW0_CC2_PD_EN),
+            ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_SWITCHES0, SW0_CC1_PD_EN | SW0_CC2_PD_EN),
                                 TAG, "SWITCHES0 Rd");
         }
 
@@ -462,32 +588,30 @@ static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t r
         const bool from_drp = (device->role == USB_TCPM_PWR_DRP);
 
         if (from_drp) {
-            (void)i2c_rd8(i2c_dev, REG_STATUS1A, &prev_status1a);
+            (void)fusb302_status_read(device, REG_STATUS1A, &prev_status1a);
             prev_togss = (prev_status1a >> 3) & 0x07;
         }
         const bool already_src = from_drp &&
                                  (prev_togss == ST1A_TOGSS_SRC1 || prev_togss == ST1A_TOGSS_SRC2);
 
         // Set DFP mode WITHOUT toggle first
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, CTL2_MODE_DFP), TAG, "set DFP mode");
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_CONTROL2, CTL2_MODE_DFP), TAG, "set DFP mode");
 
         /* Rp on both CC pins, clear any Rd leftover from sink */
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES0, SW0_CC1_PU_EN | SW0_CC2_PU_EN),
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_SWITCHES0, SW0_CC1_PU_EN | SW0_CC2_PU_EN),
                             TAG, "SWITCHES0 Rp");
 
         if (!already_src) {
             /* Use Default Rp while toggling for reliable TOG_DONE */
             ESP_RETURN_ON_ERROR(fusb302_set_host_cur(device, CTL0_HOST_CUR_DEFAULT), TAG, "set HOST_CUR toggle");
-            ESP_RETURN_ON_ERROR(i2c_wr8(device->hw.i2c_dev, REG_MEASURE,
-                                        rp_current_to_mdac(USB_TCPM_RP_DEFAULT)),
+            ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MEASURE, rp_current_to_mdac(USB_TCPM_RP_DEFAULT)),
                                 TAG, "set MDAC toggle");
         }
 
         /* POWERROLE=1, TXCC disabled until polarity is applied */
-        uint8_t sw1 = 0;
-        ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_SWITCHES1, &sw1), TAG, "read SWITCHES1");
-        sw1 = (sw1 & ~(SW1_TXCC1_EN | SW1_TXCC2_EN)) | SW1_POWERROLE;
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES1, sw1), TAG, "write SWITCHES1 role");
+        ESP_RETURN_ON_ERROR(fusb302_reg_update(device, REG_SWITCHES1,
+                                               SW1_TXCC1_EN | SW1_TXCC2_EN | SW1_POWERROLE, SW1_POWERROLE),
+                            TAG, "write SWITCHES1 role");
 
         if (!already_src) {
             // Not already attached: arm toggle normally
@@ -505,25 +629,19 @@ static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t r
          *  - Policy layer (later) can look at TOGSS to decide final role.
          */
         /* Set DRP mode first; then force a clean 0->1 toggle edge. */
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL2, CTL2_MODE_DRP),
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_CONTROL2, CTL2_MODE_DRP),
                             TAG, "set DRP");
 
         /* Enable Rp when acting as DFP */
-        value = SW0_CC1_PU_EN | SW0_CC2_PU_EN;
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_SWITCHES0, value),
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_SWITCHES0, SW0_CC1_PU_EN | SW0_CC2_PU_EN),
                             TAG, "SWITCHES0 DRP Rp");
 
         /* HOST_CUR for DFP phases */
-        ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_CONTROL0, &value),
-                            TAG, "read CONTROL0");
-        value &= ~CTL0_HOST_CUR_MASK;
-        value |= CTL0_HOST_CUR_DEFAULT;
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL0, value),
+        ESP_RETURN_ON_ERROR(fusb302_set_host_cur(device, CTL0_HOST_CUR_DEFAULT),
                             TAG, "set HOST_CUR DRP");
 
         /* Use Default Rp MDAC while toggling (datasheet toggle example). */
-        ESP_RETURN_ON_ERROR(i2c_wr8(device->hw.i2c_dev, REG_MEASURE,
-                                    rp_current_to_mdac(USB_TCPM_RP_DEFAULT)),
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MEASURE, rp_current_to_mdac(USB_TCPM_RP_DEFAULT)),
                             TAG, "set MDAC DRP (default)");
 
         /* Ensure toggle restarts even if it was already set in a prior role. */
@@ -543,26 +661,30 @@ static esp_err_t fusb302_set_role(fusb302_dev_t *device, usb_tcpm_power_role_t r
     return ESP_OK;
 }
 
-static esp_err_t fusb302_service_irq(const fusb302_dev_t *device,
+static esp_err_t fusb302_service_irq(fusb302_dev_t *device,
                                      typec_evt_mask_t *events)
 {
     if (!device || !events) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
     *events = 0;
 
     // Drain latched causes; exit when no causes AND pin is high
     for (int read_idx = 0; read_idx < MAX_INT_READS; ++read_idx) {
-        uint8_t intr_reg = 0;
-        uint8_t intr_a_reg = 0;
-        uint8_t intr_b_reg = 0;
+        uint8_t blk[STATUS_BLK_LEN];
 
-        // Read-to-clear
-        ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_INTERRUPT, &intr_reg), TAG, "read INTERRUPT");
-        (void)i2c_rd8(i2c_dev, REG_INTERRUPTA, &intr_a_reg);
-        (void)i2c_rd8(i2c_dev, REG_INTERRUPTB, &intr_b_reg);
+        // STATUS0A..INTERRUPT in one transaction; the interrupt registers are read-to-clear
+        ESP_RETURN_ON_ERROR(fusb302_reg_read_burst(device, STATUS_BLK_FIRST_REG, blk, sizeof(blk)),
+                            TAG, "read STATUS/INTERRUPT block");
+        const uint8_t intr_reg = blk[REG_INTERRUPT - STATUS_BLK_FIRST_REG];
+        const uint8_t intr_a_reg = blk[REG_INTERRUPTA - STATUS_BLK_FIRST_REG];
+        const uint8_t intr_b_reg = blk[REG_INTERRUPTB - STATUS_BLK_FIRST_REG];
+
+        /* Keep the status bytes so that the following get_status() needs no bus access */
+        device->status_snap.status1a = blk[REG_STATUS1A - STATUS_BLK_FIRST_REG];
+        device->status_snap.status0 = blk[REG_STATUS0 - STATUS_BLK_FIRST_REG];
+        device->status_snap.valid = true;
 
         if (intr_reg & INT_COMP_CHNG) {
             *events |= TYPEC_EVT_CC;
@@ -590,64 +712,54 @@ static esp_err_t fusb302_service_irq(const fusb302_dev_t *device,
     return ESP_OK;
 }
 
-static esp_err_t fusb302_enable_irq(const fusb302_dev_t *device, bool enable)
+static esp_err_t fusb302_enable_irq(fusb302_dev_t *device, bool enable)
 {
     if (!device) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
-    uint8_t control0 = 0;
-
     if (!enable) {
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_MASK,  0xFF), TAG, "mask INTERRUPT");
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_MASKA, 0xFF), TAG, "mask INTERRUPTA");
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_MASKB, 0xFF), TAG, "mask INTERRUPTB");
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MASK,  0xFF), TAG, "mask INTERRUPT");
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MASKA, 0xFF), TAG, "mask INTERRUPTA");
+        ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MASKB, 0xFF), TAG, "mask INTERRUPTB");
 
-        ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_CONTROL0, &control0), TAG, "read CONTROL0");
-        control0 |= CTL0_INT_MASK;
-        ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL0, control0), TAG, "write CONTROL0");
+        ESP_RETURN_ON_ERROR(fusb302_reg_update(device, REG_CONTROL0, CTL0_INT_MASK, CTL0_INT_MASK),
+                            TAG, "write CONTROL0");
         return ESP_OK;
     }
 
     // INT pin enabled: CONTROL0.INT_MASK = 0
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_CONTROL0, &control0), TAG, "read CONTROL0");
-    control0 &= ~CTL0_INT_MASK;
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_CONTROL0, control0), TAG, "write CONTROL0");
+    ESP_RETURN_ON_ERROR(fusb302_reg_update(device, REG_CONTROL0, CTL0_INT_MASK, 0), TAG, "write CONTROL0");
 
     // Clear any latched interrupts (read-to-clear)
-    uint8_t tmp;
-    (void)i2c_rd8(i2c_dev, REG_INTERRUPT,  &tmp);
-    (void)i2c_rd8(i2c_dev, REG_INTERRUPTA, &tmp);
-    (void)i2c_rd8(i2c_dev, REG_INTERRUPTB, &tmp);
+    (void)fusb302_clear_interrupts(device);
 
     // REG_MASK: only what we actually use
     uint8_t mask = 0xFF;
     mask &= ~INT_VBUSOK;        // sink attach/detach, useful globally
     mask &= ~INT_COMP_CHNG;     // source detach (after MEAS points to active CC)
 
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_MASK, mask), TAG, "write MASK");
+    ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MASK, mask), TAG, "write MASK");
 
     // REG_MASKA: TOG_DONE for toggle attach/orientation
     uint8_t maska = 0xFF;
     maska &= ~INTA_TOG_DONE;
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_MASKA, maska), TAG, "write MASKA");
+    ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MASKA, maska), TAG, "write MASKA");
 
     // REG_MASKB: RX_SOP when RX handling is enabled
     uint8_t maskb = 0xFF;
     maskb &= ~INTB_RX_SOP;
-    ESP_RETURN_ON_ERROR(i2c_wr8(i2c_dev, REG_MASKB, maskb), TAG, "write MASKB");
+    ESP_RETURN_ON_ERROR(fusb302_reg_write(device, REG_MASKB, maskb), TAG, "write MASKB");
 
     return ESP_OK;
 }
 
-static esp_err_t fusb302_get_status(const fusb302_dev_t *device, typec_cc_status_t *status)
+static esp_err_t fusb302_get_status(fusb302_dev_t *device, typec_cc_status_t *status)
 {
     if (!device || !status) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    const i2c_master_dev_handle_t i2c_dev = device->hw.i2c_dev;
     memset(status, 0, sizeof(*status));
 
     status->tog_result = TYPEC_TOG_RESULT_NONE;
@@ -655,7 +767,9 @@ static esp_err_t fusb302_get_status(const fusb302_dev_t *device, typec_cc_status
     uint8_t status0 = 0;
     uint8_t status1a = 0;
 
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_STATUS1A, &status1a), TAG, "read STATUS1A");
+    /* Normally served from the IRQ burst that produced the events being handled */
+    ESP_RETURN_ON_ERROR(fusb302_status_read(device, REG_STATUS1A, &status1a), TAG, "read STATUS1A");
+    ESP_RETURN_ON_ERROR(fusb302_status_read(device, REG_STATUS0, &status0), TAG, "read STATUS0");
     const uint8_t togss = (status1a >> ST1A_TOGSS_SHIFT) & 0x07;
 
     const bool src_att = (togss == ST1A_TOGSS_SRC1) || (togss == ST1A_TOGSS_SRC2);
@@ -670,14 +784,13 @@ static esp_err_t fusb302_get_status(const fusb302_dev_t *device, typec_cc_status
     status->attached = src_att || snk_att;
     status->cc2_active = (togss == ST1A_TOGSS_SRC2) || (togss == ST1A_TOGSS_SNK2);
 
-    ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_STATUS0, &status0), TAG, "read STATUS0");
     status->vbus_ok = (status0 & ST0_VBUSOK) != 0;
 
     if (device->role == USB_TCPM_PWR_SINK) {
         uint8_t bclvl = (status0 & ST0_BC_LVL_MASK);
         if (status->attached && status->vbus_ok) {
             esp_rom_delay_us(1000);
-            ESP_RETURN_ON_ERROR(i2c_rd8(i2c_dev, REG_STATUS0, &status0), TAG, "read STATUS0 retry");
+            ESP_RETURN_ON_ERROR(fusb302_reg_read(device, REG_STATUS0, &status0), TAG, "read STATUS0 retry");
             status->vbus_ok = (status0 & ST0_VBUSOK) != 0;
             bclvl = (status0 & ST0_BC_LVL_MASK);
         }
@@ -813,6 +926,19 @@ static esp_err_t fusb302_backend_commit_attach(void *ctx, bool cc2_active, bool
     return fusb302_commit_attach(port->device, cc2_active, is_source);
 }
 
+static esp_err_t fusb302_backend_get_bus_stats(void *ctx, typec_bus_stats_t *stats)
+{
+    if (!ctx || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const fusb302_port_ctx_t *port = (const fusb302_port_ctx_t *)ctx;
+    if (!port->device) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *stats = port->device->stats;
+    return ESP_OK;
+}
+
 static esp_err_t fusb302_backend_get_irq_gpio(void *ctx, gpio_num_t *gpio_num)
 {
     if (!ctx || !gpio_num) {
@@ -831,6 +957,7 @@ static const typec_port_backend_t s_fusb302_backend = {
     .get_status = fusb302_backend_get_status,
     .commit_attach = fusb302_backend_commit_attach,
     .get_irq_gpio = fusb302_backend_get_irq_gpio,
+    .get_bus_stats = fusb302_backend_get_bus_stats,
 };
 
 esp_err_t usb_tcpm_port_create_fusb302(const usb_tcpm_port_config_t *port_cfg,
@@ -0,0 +1,323 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include "usb/usb_tcpm.h"
+
+#include "tcpc_sim.h"
+#include "usb_tcpm_backend.h"
+
+static const char *TAG = "tcpc_sim";
+
+static portMUX_TYPE s_sim_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+ * Bus cost of each backend operation, modelled on the FUSB302 backend:
+ * one burst per IRQ drain, STATUS served from that burst until the next
+ * register write, and a handful of control register writes per role change.
+ */
+#define SIM_IRQ_READS           1
+#define SIM_STATUS_READS        2
+#define SIM_SET_ROLE_READS      1
+#define SIM_SET_ROLE_WRITES     3
+#define SIM_COMMIT_WRITES       2
+#define SIM_COMMIT_SRC_WRITES   2
+
+/**
+ * @brief Simulated controller context (backend context of the port).
+ */
+struct tcpc_sim {
+    struct {
+        tcpc_sim_partner_t partner;       /**< Partner currently on the CC lines */
+        bool cc2;                         /**< Partner connected on CC2 */
+        usb_tcpm_rp_current_t partner_rp; /**< Rp advertised by a Source partner */
+        bool vbus;                        /**< VBUS above VBUSOK threshold */
+        typec_evt_mask_t latched;         /**< Events latched since the last service_irq() */
+    } line;                               /**< Protected by s_sim_lock (injecting task vs. worker) */
+    struct {
+        usb_tcpm_power_role_t role;       /**< Role last set by the core */
+        bool toggling;                    /**< Toggle engine running (cleared by commit_attach) */
+        bool status_snap_valid;           /**< STATUS can be served without bus access */
+        typec_bus_stats_t stats;          /**< Simulated bus transaction counters */
+    } chip;                               /**< Accessed by the shared worker only */
+    usb_tcpm_rp_current_t rp_current;     /**< Advertised Rp current when sourcing */
+    uint32_t bus_latency_us;              /**< Busy time of one transaction */
+    typec_port_handle_t port;             /**< Port signalled on injected events */
+};
+
+static inline uint32_t rp_current_to_ma(usb_tcpm_rp_current_t rp)
+{
+    switch (rp) {
+    case USB_TCPM_RP_1A5:
+        return 1500;
+    case USB_TCPM_RP_3A0:
+        return 3000;
+    case USB_TCPM_RP_DEFAULT:
+    default:
+        return 500;
+    }
+}
+
+static void sim_bus(struct tcpc_sim *sim, uint32_t reads, uint32_t writes)
+{
+    sim->chip.stats.reads += reads;
+    sim->chip.stats.writes += writes;
+    if (writes) {
+        sim->chip.status_snap_valid = false;
+    }
+    if (sim->bus_latency_us) {
+        esp_rom_delay_us(sim->bus_latency_us * (reads + writes));
+    }
+}
+
+static typec_tog_result_t sim_tog_result(usb_tcpm_power_role_t role, tcpc_sim_partner_t partner)
+{
+    if (partner == TCPC_SIM_PARTNER_SOURCE && (role == USB_TCPM_PWR_SINK || role == USB_TCPM_PWR_DRP)) {
+        return TYPEC_TOG_RESULT_SNK;
+    }
+    if (partner == TCPC_SIM_PARTNER_SINK && (role == USB_TCPM_PWR_SOURCE || role == USB_TCPM_PWR_DRP)) {
+        return TYPEC_TOG_RESULT_SRC;
+    }
+    return TYPEC_TOG_RESULT_NONE;
+}
+
+static void sim_latch(struct tcpc_sim *sim, typec_evt_mask_t events)
+{
+    portENTER_CRITICAL(&s_sim_lock);
+    sim->line.latched |= events;
+    const typec_port_handle_t port = sim->port;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    if (port) {
+        (void)typec_port_notify_irq(port);
+    }
+}
+
+/* ---------------- Backend ops ---------------- */
+
+static esp_err_t sim_backend_init(void *ctx, const usb_tcpm_port_config_t *cfg)
+{
+    if (!ctx || !cfg) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct tcpc_sim *sim = (struct tcpc_sim *)ctx;
+    sim->rp_current = (cfg->rp_current <= USB_TCPM_RP_3A0) ? cfg->rp_current : USB_TCPM_RP_DEFAULT;
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_deinit(void *ctx)
+{
+    if (!ctx) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free(ctx);
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_set_role(void *ctx, usb_tcpm_power_role_t role)
+{
+    if (!ctx || role > USB_TCPM_PWR_DRP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct tcpc_sim *sim = (struct tcpc_sim *)ctx;
+    /* Leaving a resolved DRP toggle keeps its result, as the FUSB302 backend does */
+    const bool from_drp = (sim->chip.role == USB_TCPM_PWR_DRP) && sim->chip.toggling;
+
+    sim_bus(sim, SIM_SET_ROLE_READS, SIM_SET_ROLE_WRITES);
+    sim->chip.role = role;
+    sim->chip.toggling = true;
+
+    portENTER_CRITICAL(&s_sim_lock);
+    const tcpc_sim_partner_t partner = sim->line.partner;
+    portEXIT_CRITICAL(&s_sim_lock);
+    if (!from_drp && sim_tog_result(role, partner) != TYPEC_TOG_RESULT_NONE) {
+        /* A partner that is already present resolves the restarted toggle right away */
+        sim_latch(sim, TYPEC_EVT_TOG);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_service_irq(void *ctx, typec_evt_mask_t *events)
+{
+    if (!ctx || !events) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct tcpc_sim *sim = (struct tcpc_sim *)ctx;
+    sim_bus(sim, SIM_IRQ_READS, 0);
+
+    portENTER_CRITICAL(&s_sim_lock);
+    *events = sim->line.latched;
+    sim->line.latched = 0;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    sim->chip.status_snap_valid = true;
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_get_status(void *ctx, typec_cc_status_t *status)
+{
+    if (!ctx || !status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct tcpc_sim *sim = (struct tcpc_sim *)ctx;
+    if (!sim->chip.status_snap_valid) {
+        sim_bus(sim, SIM_STATUS_READS, 0);
+    }
+
+    portENTER_CRITICAL(&s_sim_lock);
+    const tcpc_sim_partner_t partner = sim->line.partner;
+    const bool cc2 = sim->line.cc2;
+    const usb_tcpm_rp_current_t partner_rp = sim->line.partner_rp;
+    const bool vbus = sim->line.vbus;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    const usb_tcpm_power_role_t role = sim->chip.role;
+    const typec_tog_result_t tog = sim->chip.toggling ? sim_tog_result(role, partner) : TYPEC_TOG_RESULT_NONE;
+
+    memset(status, 0, sizeof(*status));
+    status->tog_result = tog;
+    status->attached = (tog != TYPEC_TOG_RESULT_NONE);
+    status->cc2_active = (partner != TCPC_SIM_PARTNER_NONE) && cc2;
+    status->vbus_ok = vbus;
+
+    if (role == USB_TCPM_PWR_SINK) {
+        if (status->attached && status->vbus_ok) {
+            sim_bus(sim, 1, 0); /* BC_LVL re-read */
+        }
+        status->rp_current_ma = (partner == TCPC_SIM_PARTNER_SOURCE) ? rp_current_to_ma(partner_rp) : 0;
+        return ESP_OK;
+    }
+
+    status->rp_current_ma = (tog == TYPEC_TOG_RESULT_SNK) ? 0 : rp_current_to_ma(sim->rp_current);
+    if (role == USB_TCPM_PWR_SOURCE) {
+        status->attached = (partner == TCPC_SIM_PARTNER_SINK);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_commit_attach(void *ctx, bool cc2_active, bool is_source)
+{
+    if (!ctx) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct tcpc_sim *sim = (struct tcpc_sim *)ctx;
+    (void)cc2_active;
+    sim_bus(sim, 0, SIM_COMMIT_WRITES + (is_source ? SIM_COMMIT_SRC_WRITES : 0));
+    sim->chip.toggling = false;
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_get_irq_gpio(void *ctx, gpio_num_t *gpio_num)
+{
+    if (!ctx || !gpio_num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *gpio_num = GPIO_NUM_NC;
+    return ESP_OK;
+}
+
+static esp_err_t sim_backend_get_bus_stats(void *ctx, typec_bus_stats_t *stats)
+{
+    if (!ctx || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const struct tcpc_sim *sim = (const struct tcpc_sim *)ctx;
+    *stats = sim->chip.stats;
+    return ESP_OK;
+}
+
+static const typec_port_backend_t s_sim_backend = {
+    .init = sim_backend_init,
+    .deinit = sim_backend_deinit,
+    .set_role = sim_backend_set_role,
+    .service_irq = sim_backend_service_irq,
+    .get_status = sim_backend_get_status,
+    .commit_attach = sim_backend_commit_attach,
+    .get_irq_gpio = sim_backend_get_irq_gpio,
+    .get_bus_stats = sim_backend_get_bus_stats,
+};
+
+/* ---------------- Public API ---------------- */
+
+esp_err_t usb_tcpm_port_create_sim(const usb_tcpm_port_config_t *port_cfg,
+                                   const tcpc_sim_config_t *sim_cfg,
+                                   usb_tcpm_port_handle_t *port_hdl_ret,
+                                   tcpc_sim_handle_t *sim_ret)
+{
+    ESP_RETURN_ON_FALSE(port_cfg && port_hdl_ret && sim_ret, ESP_ERR_INVALID_ARG, TAG, "bad args");
+
+    struct tcpc_sim *sim = (struct tcpc_sim *)calloc(1, sizeof(*sim));
+    ESP_RETURN_ON_FALSE(sim, ESP_ERR_NO_MEM, TAG, "no mem");
+    sim->bus_latency_us = sim_cfg ? sim_cfg->bus_latency_us : 0;
+
+    typec_port_handle_t port = NULL;
+    const esp_err_t ret = typec_port_new(&s_sim_backend, sim, port_cfg, &port);
+    if (ret != ESP_OK) {
+        free(sim);
+        return ret;
+    }
+
+    portENTER_CRITICAL(&s_sim_lock);
+    sim->port = port;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    *port_hdl_ret = (usb_tcpm_port_handle_t)port;
+    *sim_ret = sim;
+    return ESP_OK;
+}
+
+esp_err_t tcpc_sim_connect(tcpc_sim_handle_t sim, tcpc_sim_partner_t partner, bool cc2,
+                           usb_tcpm_rp_current_t partner_rp)
+{
+    ESP_RETURN_ON_FALSE(sim && (partner == TCPC_SIM_PARTNER_SOURCE || partner == TCPC_SIM_PARTNER_SINK),
+                        ESP_ERR_INVALID_ARG, TAG, "bad args");
+
+    portENTER_CRITICAL(&s_sim_lock);
+    sim->line.partner = partner;
+    sim->line.cc2 = cc2;
+    sim->line.partner_rp = partner_rp;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    /* The toggle engine reports TOG_DONE; a committed port only sees the comparator change */
+    sim_latch(sim, TYPEC_EVT_TOG | TYPEC_EVT_CC);
+    return ESP_OK;
+}
+
+esp_err_t tcpc_sim_disconnect(tcpc_sim_handle_t sim)
+{
+    ESP_RETURN_ON_FALSE(sim, ESP_ERR_INVALID_ARG, TAG, "bad args");
+
+    portENTER_CRITICAL(&s_sim_lock);
+    sim->line.partner = TCPC_SIM_PARTNER_NONE;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    sim_latch(sim, TYPEC_EVT_CC);
+    return ESP_OK;
+}
+
+esp_err_t tcpc_sim_set_vbus(tcpc_sim_handle_t sim, bool present)
+{
+    ESP_RETURN_ON_FALSE(sim, ESP_ERR_INVALID_ARG, TAG, "bad args");
+
+    portENTER_CRITICAL(&s_sim_lock);
+    const bool changed = (sim->line.vbus != present);
+    sim->line.vbus = present;
+    portEXIT_CRITICAL(&s_sim_lock);
+
+    if (changed) {
+        sim_latch(sim, TYPEC_EVT_VBUS);
+    }
+    return ESP_OK;
+}
@@ -4,11 +4,13 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "esp_check.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
@@ -32,6 +34,7 @@ typedef struct typec_port {
         bool irq_pending; /**< IRQ pending for shared worker. */
         bool irq_processing; /**< Shared worker is processing this port. */
         bool deleting; /**< Port is being deleted. */
+        int64_t irq_timestamp_us; /**< Time of the IRQ edge that set irq_pending. */
     } dynamic; /**< Fields protected by s_lock. */
 
     struct {
@@ -39,19 +42,22 @@ typedef struct typec_port {
         bool cc2_active; /**< True if CC2 is active. */
         uint32_t rp_current_ma; /**< Advertised/observed Rp current in mA. */
         usb_tcpm_power_role_t role; /**< Current power role. */
+        usb_tcpm_port_stats_t stats; /**< Attach/detach statistics (bus counters are filled on read). */
     } mux_protected; /**< Fields protected by status_lock. */
 
     struct {
         bool pending_attach; /**< True while waiting for VBUS after commit. */
         bool source_detach_grace_active; /**< True while source detach detection is in startup grace period. */
         TickType_t source_detach_grace_start_tick; /**< Tick when source detach grace was armed. */
+        int64_t irq_start_us; /**< Time of the IRQ currently being handled. */
+        uint32_t irq_bus_transactions; /**< Backend bus transaction count when IRQ handling started. */
     } single_thread; /**< Accessed by shared worker task. */
 
     struct {
         usb_tcpm_power_role_t policy_role; /**< Policy role for fallback decisions. */
         void *backend_ctx; /**< Backend device handle. */
         const typec_port_backend_t *backend; /**< Backend operations. */
-        gpio_num_t gpio_int; /**< INT GPIO (active-low). */
+        gpio_num_t gpio_int; /**< INT GPIO (active-low), GPIO_NUM_NC if the backend signals IRQs in software. */
         usb_tcpm_port_config_t cfg; /**< Configuration snapshot. */
     } constant; /**< Initialized during create, then treated as read-only. */
 
@@ -106,7 +112,50 @@ static void usb_tcpm_port_list_remove(typec_port_t *ctx)
 } while (0)
 
 /* ---------- Tiny helpers ---------- */
-static inline void usb_tcpm_emit_attached(const typec_port_t *ctx)
+static inline uint32_t usb_tcpm_bus_transactions(const typec_port_t *ctx)
+{
+    typec_bus_stats_t bus = {0};
+    if (ctx->constant.backend->get_bus_stats &&
+            ctx->constant.backend->get_bus_stats(ctx->constant.backend_ctx, &bus) == ESP_OK) {
+        return bus.reads + bus.writes;
+    }
+    return 0;
+}
+
+/* Mark the start of IRQ handling; attach/detach latencies are measured from here. */
+static inline void usb_tcpm_irq_start(typec_port_t *ctx, int64_t irq_timestamp_us)
+{
+    ctx->single_thread.irq_start_us = irq_timestamp_us;
+    ctx->single_thread.irq_bus_transactions = usb_tcpm_bus_transactions(ctx);
+}
+
+static inline void usb_tcpm_stats_record(typec_port_t *ctx, bool attach)
+{
+    const uint32_t latency_us = (uint32_t)(esp_timer_get_time() - ctx->single_thread.irq_start_us);
+    const uint32_t bus_transactions = usb_tcpm_bus_transactions(ctx) - ctx->single_thread.irq_bus_transactions;
+    usb_tcpm_port_stats_t *stats = &ctx->mux_protected.stats;
+
+    USB_TCPM_STATUS_LOCK(ctx);
+    if (attach) {
+        stats->attach_count++;
+        stats->last_attach_latency_us = latency_us;
+        stats->last_attach_bus_transactions = bus_transactions;
+        if (latency_us > stats->max_attach_latency_us) {
+            stats->max_attach_latency_us = latency_us;
+        }
+    } else {
+        stats->detach_count++;
+        stats->last_detach_latency_us = latency_us;
+        if (latency_us > stats->max_detach_latency_us) {
+            stats->max_detach_latency_us = latency_us;
+        }
+    }
+    USB_TCPM_STATUS_UNLOCK(ctx);
+    ESP_LOGD(TAG, "%s latency=%" PRIu32 "us bus_transactions=%" PRIu32,
+             attach ? "attach" : "detach", latency_us, bus_transactions);
+}
+
+static inline void usb_tcpm_emit_attached(typec_port_t *ctx)
 {
     usb_tcpm_evt_attached_t evt = {
         .port       = (usb_tcpm_port_handle_t)ctx,
@@ -129,9 +178,11 @@ static inline void usb_tcpm_emit_attached(const typec_port_t *ctx)
                                          sizeof(evt),
                                          portMAX_DELAY);
     ESP_RETURN_VOID_ON_ERROR(err, TAG, "Failed to post typec ATTACHED event: %s", esp_err_to_name(err));
+    // Only the events delivered to the application are accounted
+    usb_tcpm_stats_record(ctx, true);
 }
 
-static inline void usb_tcpm_emit_detached(const typec_port_t *ctx)
+static inline void usb_tcpm_emit_detached(typec_port_t *ctx)
 {
     usb_tcpm_evt_detached_t evt = {
         .port = (usb_tcpm_port_handle_t)ctx,
@@ -152,6 +203,8 @@ static inline void usb_tcpm_emit_detached(const typec_port_t *ctx)
                                          sizeof(evt),
                                          portMAX_DELAY);
     ESP_RETURN_VOID_ON_ERROR(err, TAG, "Failed to post typec DETACHED event: %s", esp_err_to_name(err));
+    // Only the events delivered to the application are accounted
+    usb_tcpm_stats_record(ctx, false);
 }
 
 static inline void usb_tcpm_set_vbus_source(const typec_port_t *ctx, bool enable)
@@ -453,6 +506,25 @@ static void usb_tcpm_handle_events(typec_port_t *ctx, typec_evt_mask_t events)
 }
 
 /* ---------- ISR & Task ---------- */
+
+/* Must be called with s_lock held. Returns the worker task to notify, or NULL. */
+static inline TaskHandle_t usb_tcpm_mark_irq_pending(typec_port_t *ctx, int64_t now_us)
+{
+    if (ctx->dynamic.deleting) {
+        return NULL;
+    }
+    if (!ctx->dynamic.irq_pending) {
+        ctx->dynamic.irq_timestamp_us = now_us;
+    }
+    ctx->dynamic.irq_pending = true;
+    return s_task;
+}
+
+static inline bool usb_tcpm_has_irq_gpio(const typec_port_t *ctx)
+{
+    return ctx->constant.gpio_int != GPIO_NUM_NC;
+}
+
 static void IRAM_ATTR usb_tcpm_gpio_isr(void *arg)
 {
     typec_port_t *ctx = (typec_port_t *)arg;
@@ -460,13 +532,10 @@ static void IRAM_ATTR usb_tcpm_gpio_isr(void *arg)
     gpio_intr_disable(ctx->constant.gpio_int);
 
     BaseType_t higher_priority_task_woken = pdFALSE;
-    TaskHandle_t task = NULL;
+    const int64_t now_us = esp_timer_get_time();
 
     portENTER_CRITICAL_ISR(&s_lock);
-    if (!ctx->dynamic.deleting) {
-        ctx->dynamic.irq_pending = true;
-        task = s_task;
-    }
+    const TaskHandle_t task = usb_tcpm_mark_irq_pending(ctx, now_us);
     portEXIT_CRITICAL_ISR(&s_lock);
 
     if (task) {
@@ -487,12 +556,14 @@ static void usb_tcpm_task(void *arg)
 
         for (;;) {
             typec_port_t *ctx = NULL;
+            int64_t irq_timestamp_us = 0;
 
             portENTER_CRITICAL(&s_lock);
             for (typec_port_t *it = s_ports; it; it = it->dynamic.next) {
                 if (it->dynamic.irq_pending && !it->dynamic.irq_processing && !it->dynamic.deleting) {
                     it->dynamic.irq_pending = false;
                     it->dynamic.irq_processing = true;
+                    irq_timestamp_us = it->dynamic.irq_timestamp_us;
                     ctx = it;
                     break;
                 }
@@ -502,6 +573,7 @@ static void usb_tcpm_task(void *arg)
             if (!ctx) {
                 break;
             }
+            usb_tcpm_irq_start(ctx, irq_timestamp_us);
 
             typec_evt_mask_t events = 0;
 
@@ -514,7 +586,7 @@ static void usb_tcpm_task(void *arg)
                 usb_tcpm_handle_events(ctx, events);
 
                 /* Handle rare stuck-low INT: drain and process any new events */
-                if (gpio_get_level(ctx->constant.gpio_int) == 0) {
+                if (usb_tcpm_has_irq_gpio(ctx) && gpio_get_level(ctx->constant.gpio_int) == 0) {
                     vTaskDelay(pdMS_TO_TICKS(10));
                     typec_evt_mask_t extra_events = 0;
                     if (ctx->constant.backend->service_irq(ctx->constant.backend_ctx, &extra_events) == ESP_OK && extra_events) {
@@ -533,7 +605,7 @@ static void usb_tcpm_task(void *arg)
             ctx->dynamic.irq_processing = false;
             portEXIT_CRITICAL(&s_lock);
 
-            if (!deleting) {
+            if (!deleting && gpio_int != GPIO_NUM_NC) {
                 gpio_intr_enable(gpio_int);
             }
         }
@@ -697,42 +769,52 @@ esp_err_t typec_port_new(const typec_port_backend_t *backend,
     ESP_GOTO_ON_ERROR(ctx->constant.backend->get_irq_gpio(ctx->constant.backend_ctx, &ctx->constant.gpio_int),
                       fail, TAG, "get irq gpio failed");
 
-    // Configure INT GPIO as input with pull-up; enable interrupt later
-    const gpio_config_t gc = {
-        .pin_bit_mask = 1ULL << ctx->constant.gpio_int,
-                             .mode = GPIO_MODE_INPUT,
-                             .pull_up_en = GPIO_PULLUP_ENABLE,
-                             .pull_down_en = GPIO_PULLDOWN_DISABLE,
-                             .intr_type = GPIO_INTR_DISABLE,
-    };
-    ESP_GOTO_ON_ERROR(gpio_config(&gc), fail, TAG, "gpio_config");
+    /* Without an INT GPIO the backend signals IRQs through typec_port_notify_irq() */
+    if (usb_tcpm_has_irq_gpio(ctx)) {
+        // Configure INT GPIO as input with pull-up; enable interrupt later
+        const gpio_config_t gc = {
+            .pin_bit_mask = 1ULL << ctx->constant.gpio_int,
+                                 .mode = GPIO_MODE_INPUT,
+                                 .pull_up_en = GPIO_PULLUP_ENABLE,
+                                 .pull_down_en = GPIO_PULLDOWN_DISABLE,
+                                 .intr_type = GPIO_INTR_DISABLE,
+        };
+        ESP_GOTO_ON_ERROR(gpio_config(&gc), fail, TAG, "gpio_config");
 
-    const esp_err_t isr_ret = gpio_install_isr_service(0);
-    if (isr_ret != ESP_ERR_INVALID_STATE) {
-        ESP_GOTO_ON_ERROR(isr_ret, fail, TAG, "gpio_install_isr_service failed");
+        const esp_err_t isr_ret = gpio_install_isr_service(0);
+        if (isr_ret != ESP_ERR_INVALID_STATE) {
+            ESP_GOTO_ON_ERROR(isr_ret, fail, TAG, "gpio_install_isr_service failed");
+        }
+        ESP_GOTO_ON_ERROR(gpio_isr_handler_add(ctx->constant.gpio_int, usb_tcpm_gpio_isr, ctx), fail, TAG, "gpio_isr_add");
     }
-    ESP_GOTO_ON_ERROR(gpio_isr_handler_add(ctx->constant.gpio_int, usb_tcpm_gpio_isr, ctx), fail, TAG, "gpio_isr_add");
 
     /* Drain and process any pre-existing latched causes before arming GPIO */
     typec_evt_mask_t events = 0;
 
+    usb_tcpm_irq_start(ctx, esp_timer_get_time());
     ESP_GOTO_ON_ERROR(ctx->constant.backend->service_irq(ctx->constant.backend_ctx, &events), fail_isr, TAG, "prime irq");
     if (events) {
         usb_tcpm_handle_events(ctx, events);
     }
 
     /* Now arm the GPIO */
-    ESP_GOTO_ON_ERROR(gpio_set_intr_type(ctx->constant.gpio_int, GPIO_INTR_LOW_LEVEL),
-                      fail_isr, TAG, "gpio_set_intr_type");
+    if (usb_tcpm_has_irq_gpio(ctx)) {
+        ESP_GOTO_ON_ERROR(gpio_set_intr_type(ctx->constant.gpio_int, GPIO_INTR_LOW_LEVEL),
+                          fail_isr, TAG, "gpio_set_intr_type");
+    }
     usb_tcpm_port_list_add(ctx);
-    gpio_intr_enable(ctx->constant.gpio_int);
+    if (usb_tcpm_has_irq_gpio(ctx)) {
+        gpio_intr_enable(ctx->constant.gpio_int);
+    }
 
     *out = (typec_port_handle_t)ctx;
     ESP_LOGI(TAG, "Type-C port started");
     return ESP_OK;
 fail_isr:
-    gpio_intr_disable(ctx->constant.gpio_int);
-    gpio_isr_handler_remove(ctx->constant.gpio_int);
+    if (usb_tcpm_has_irq_gpio(ctx)) {
+        gpio_intr_disable(ctx->constant.gpio_int);
+        gpio_isr_handler_remove(ctx->constant.gpio_int);
+    }
 fail:
     ESP_LOGE(TAG, "Init failed, err=%d", ret);
     if (ctx) {
@@ -741,6 +823,22 @@ fail:
     return ret;
 }
 
+esp_err_t typec_port_notify_irq(typec_port_handle_t port)
+{
+    typec_port_t *ctx = (typec_port_t *)port;
+    ESP_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_ARG, TAG, "bad args");
+
+    const int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    const TaskHandle_t task = usb_tcpm_mark_irq_pending(ctx, now_us);
+    portEXIT_CRITICAL(&s_lock);
+
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+    return ESP_OK;
+}
+
 esp_err_t usb_tcpm_port_destroy(usb_tcpm_port_handle_t port_hdl)
 {
     typec_port_t *ctx = (typec_port_t *)port_hdl;
@@ -753,8 +851,10 @@ esp_err_t usb_tcpm_port_destroy(usb_tcpm_port_handle_t port_hdl)
     ctx->dynamic.irq_pending = false;
     portEXIT_CRITICAL(&s_lock);
 
-    gpio_intr_disable(ctx->constant.gpio_int);
-    gpio_isr_handler_remove(ctx->constant.gpio_int);
+    if (usb_tcpm_has_irq_gpio(ctx)) {
+        gpio_intr_disable(ctx->constant.gpio_int);
+        gpio_isr_handler_remove(ctx->constant.gpio_int);
+    }
 
     usb_tcpm_port_list_remove(ctx);
 
@@ -796,3 +896,24 @@ esp_err_t usb_tcpm_get_status(usb_tcpm_port_handle_t port_hdl, usb_tcpm_port_sta
     USB_TCPM_STATUS_UNLOCK(ctx);
     return ESP_OK;
 }
+
+esp_err_t usb_tcpm_get_stats(usb_tcpm_port_handle_t port_hdl, usb_tcpm_port_stats_t *stats)
+{
+    typec_port_t *ctx = (typec_port_t *)port_hdl;
+    if (!ctx || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    USB_TCPM_STATUS_LOCK(ctx);
+    *stats = ctx->mux_protected.stats;
+    USB_TCPM_STATUS_UNLOCK(ctx);
+
+    typec_bus_stats_t bus = {0};
+    if (ctx->constant.backend->get_bus_stats &&
+            ctx->constant.backend->get_bus_stats(ctx->constant.backend_ctx, &bus) == ESP_OK) {
+        stats->bus_reads = bus.reads;
+        stats->bus_writes = bus.writes;
+        stats->bus_writes_skipped = bus.writes_skipped;
+        stats->bus_errors = bus.errors;
+    }
+    return ESP_OK;
+}
@@ -154,3 +154,18 @@ TEST_CASE("memory_leakage", "[type_c]")
 
     vTaskDelay(pdMS_TO_TICKS(200));
 }
+
+TEST_CASE("bus_stats", "[type_c]")
+{
+    usb_tcpm_port_stats_t stats = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, usb_tcpm_get_stats(s_port, &stats));
+    ESP_LOGI(TAG, "bus: reads=%u writes=%u skipped=%u errors=%u",
+             (unsigned)stats.bus_reads, (unsigned)stats.bus_writes,
+             (unsigned)stats.bus_writes_skipped, (unsigned)stats.bus_errors);
+
+    /* Bring-up must have talked to the chip, without any failed transaction */
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.bus_reads);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.bus_writes);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.bus_errors);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, usb_tcpm_get_stats(s_port, NULL));
+}